@@ -26,8 +26,12 @@
 #include "graphics/sysfont.hpp"
 #include "resources/resourcemanager.hpp"
 #include "audio/bassmusicinterface.hpp"
+#include "audio/miniaudiosoundmanager.hpp"
+#include "audio/miniaudiomusicinterface.hpp"
 #include "audio/bass.h"
 #include "misc/autocrit.hpp"
+#include "misc/jobsystem.hpp"
+#include "misc/filewatcher.hpp"
 #include "debug/debug.hpp"
 #include "debug/errorhandler.hpp"
 #include "paklib/pakinterface.hpp"
@@ -112,6 +116,8 @@ AppBase::AppBase()
 	mMusicInterface = nullptr;
 	mErrorHandler = nullptr;
 	mIGUIManager = nullptr;
+	mJobSystem = nullptr;
+	mFileWatcher = nullptr;
 	mFrameTime = 10;
 	mNonDrawCount = 0;
 	mDrawCount = 0;
@@ -125,6 +131,7 @@ AppBase::AppBase()
 	mIsDrawing = false;
 	mLastDrawWasEmpty = false;
 	mLastTimeCheck = 0;
+	mUpdateInterpolation = 0;
 	mUpdateMultiplier = 1;
 	mPaused = false;
 	mFastForwardToUpdateNum = 0;
@@ -145,7 +152,7 @@ AppBase::AppBase()
 	mLoadingThreadStarted = false;
 	mAutoStartLoadingThread = true;
 	mLoadingThreadCompleted = false;
-	mCursorThreadRunning = false;
+	mCursorInputLatencyNS = 0;
 	mNumLoadingThreadTasks = 0;
 	mCompletedLoadingThreadTasks = 0;
 	mLastDrawTick = SDL_GetTicks();
@@ -167,7 +174,12 @@ AppBase::AppBase()
 	mCtrlDown = false;
 	mAltDown = false;
 	mStepMode = 0;
+	mMaxEventsPerFrame = 256;
+	mFrameEventCount = 0;
+	mEventsProcessed = 0;
+	mMouseMotionCoalesced = 0;
 	mCleanupSharedImages = false;
+	mFontCacheEnabled = true;
 	mStandardWordWrap = true;
 	mbAllowExtendedChars = true;
 	mEnableMaximizeButton = false;
@@ -188,7 +200,9 @@ AppBase::AppBase()
 	mScreenBltTime = 0;
 	mAlphaDisabled = false;
 	mDebugKeysEnabled = false;
+	mHotReload = false;
 	mNoSoundNeeded = false;
+	mUseMiniaudio = false;
 
 	mSyncRefreshRate = 100;
 	mVSyncUpdates = false;
@@ -364,19 +378,18 @@ AppBase::~AppBase()
 	mDialogMap.clear();
 	mDialogList.clear();
 
+	// Stop the workers before anything their jobs might be using goes away, loading included
+	WaitForLoadingThread();
+	delete mJobSystem;
+	mJobSystem = nullptr;
+
 	delete mWidgetManager;
 	delete mResourceManager;
+	delete mFileWatcher;
 	delete gFPSImage;
 	gFPSImage = nullptr;
 
-	SharedImageMap::iterator aSharedImageItr = mSharedImageMap.begin();
-	while (aSharedImageItr != mSharedImageMap.end())
-	{
-		SharedImage *aSharedImage = &aSharedImageItr->second;
-		DBG_ASSERTE(aSharedImage->mRefCount == 0);
-		delete aSharedImage->mImage;
-		mSharedImageMap.erase(aSharedImageItr++);
-	}
+	mSharedImageMap.Clear();
 
 	delete mSDLInterface;
 	delete mMusicInterface;
@@ -386,8 +399,6 @@ AppBase::~AppBase()
 
 	BASS_Stop();
 
-	WaitForLoadingThread();
-
 	SDL_DestroyCursor(mHandCursor);
 	SDL_DestroyCursor(mDraggingCursor);
 
@@ -396,7 +407,7 @@ AppBase::~AppBase()
 
 void AppBase::ClearUpdateBacklog(bool relaxForASecond)
 {
-	mLastTimeCheck = SDL_GetTicks();
+	mLastTimeCheck = mFramePacer.GetTime();
 	mUpdateFTimeAcc = 0.0;
 
 	if (relaxForASecond)
@@ -642,7 +653,13 @@ std::string AppBase::GetProductVersion(const std::string &thePath)
 void AppBase::WaitForLoadingThread()
 {
 	while ((mLoadingThreadStarted) && (!mLoadingThreadCompleted))
+	{
+		// Loading may be waiting on something it handed to the main thread, which is stuck in here now
+		if (mJobSystem != nullptr)
+			mJobSystem->ProcessMainThreadJobs();
+
 		SDL_Delay(20);
+	}
 }
 
 void AppBase::SetCursorImage(int theCursorNum, Image *theImage)
@@ -1388,11 +1405,46 @@ bool AppBase::WriteBytesToFile(const std::string &theFileName, const void *theDa
 	return true;
 }
 
+std::string AppBase::GetCacheFolder()
+{
+	if (mRegKey.empty())
+		return GetAppDataFolder() + "cache/";
+
+	return GetAppDataFolder() + mRegKey + "/cache/";
+}
+
 bool AppBase::WriteBufferToFile(const std::string &theFileName, const Buffer *theBuffer)
 {
 	return WriteBytesToFile(theFileName, theBuffer->GetDataPtr(), theBuffer->GetDataLen());
 }
 
+// Written off to the side and moved into place, so a half written file never gets read back
+bool AppBase::WriteBufferToFileAtomic(const std::string &theFileName, const Buffer *theBuffer)
+{
+	std::string aTempFileName = theFileName + ".tmp";
+
+	MkDir(GetFileDir(theFileName));
+	FILE *aFP = fopen(aTempFileName.c_str(), "wb");
+	if (aFP == nullptr)
+		return false;
+
+	size_t aDataLen = theBuffer->GetDataLen();
+	bool isWritten = (fwrite(theBuffer->GetDataPtr(), 1, aDataLen, aFP) == aDataLen);
+	isWritten = (fclose(aFP) == 0) && isWritten;
+
+	std::error_code anError;
+	if (isWritten)
+	{
+		std::filesystem::rename(aTempFileName, theFileName, anError);
+		isWritten = !anError;
+	}
+
+	if (!isWritten)
+		std::filesystem::remove(aTempFileName, anError);
+
+	return isWritten;
+}
+
 bool AppBase::ReadBufferFromFile(const std::string &theFileName, Buffer *theBuffer)
 {
 	FILE *aFP = fopen(theFileName.c_str(), "rb");
@@ -1483,12 +1535,6 @@ void AppBase::Shutdown()
 		mShutdown = true;
 		ShutdownHook();
 
-		// Blah
-		while (mCursorThreadRunning)
-		{
-			SDL_Delay(10);
-		}
-
 		if (mMusicInterface != nullptr)
 			mMusicInterface->StopAllMusic();
 
@@ -1533,7 +1579,7 @@ void AppBase::UpdateFrames()
 void AppBase::DoUpdateFramesF(float theFrac)
 {
 	if ((mVSyncUpdates) && (!mMinimized))
-		mWidgetManager->UpdateFrameF(theFrac);
+		mWidgetManager->UpdateFrameF(theFrac, (float)mUpdateInterpolation);
 }
 
 bool AppBase::DoUpdateFrames()
@@ -1650,6 +1696,32 @@ static void FPSDrawCoords(int theX, int theY)
 	gFPSImage->mBitsChangedCount++;
 }
 
+///////////////////////////// FPS Stuff to draw frame pacing
+static void FPSDrawFrameTimes(const FramePacer &thePacer)
+{
+	static SysFont aFont(gAppBase, LiberationSans_Regular, LiberationSans_Regular_Size, 8);
+	if ((gFPSImage == nullptr) || (gFPSImage->GetWidth() < 140))
+	{
+		delete gFPSImage;
+		gFPSImage = new SDLImage(gAppBase->mSDLInterface);
+		gFPSImage->Create(140, aFont.GetHeight() + 4);
+		gFPSImage->SetImageMode(false, false);
+		gFPSImage->SetVolatile(true);
+		gFPSImage->mPurgeBits = false;
+		gFPSImage->PurgeBits();
+	}
+
+	Graphics aDrawG(gFPSImage);
+	aDrawG.SetFont(&aFont);
+	PopString aFrameTimes = StrFormat("%.2f +/- %.2f ms, %d missed", thePacer.mFrameTimeMean,
+									  thePacer.mFrameTimeStdDev, thePacer.mFrameTimeMissed);
+	aDrawG.SetColor(0x000000);
+	aDrawG.FillRect(0, 0, gFPSImage->GetWidth(), gFPSImage->GetHeight());
+	aDrawG.SetColor(0xFFFFFF);
+	aDrawG.DrawString(aFrameTimes, 2, aFont.GetAscent());
+	gFPSImage->mBitsChangedCount++;
+}
+
 static void UpdateScreenSaverInfo(uint32_t theTick)
 {
 	if (gAppBase->IsScreenSaver() || !gAppBase->mIsPhysWindowed)
@@ -1680,6 +1752,9 @@ bool AppBase::DrawDirtyStuff()
 			if (mWidgetManager != nullptr)
 				FPSDrawCoords(mWidgetManager->mLastMouseX, mWidgetManager->mLastMouseY);
 			break;
+		case FPS_ShowFrameTimes:
+			FPSDrawFrameTimes(mFramePacer);
+			break;
 		}
 	}
 
@@ -1724,21 +1799,25 @@ bool AppBase::DrawDirtyStuff()
 			g.DrawImage(gFPSImage, mWidth - gFPSImage->GetWidth() - 10, mHeight - gFPSImage->GetHeight() - 10);
 		}
 
-		if (mWaitForVSync && mIsPhysWindowed && mSoftVSyncWait)
-		{
-			uint32_t aTick = SDL_GetTicks();
-			if (aTick - mLastDrawTick < mSDLInterface->mMillisecondsPerFrame)
-				SDL_Delay(mSDLInterface->mMillisecondsPerFrame - (aTick - mLastDrawTick));
-		}
+		double aRefreshTime = 1000.0 / std::max(mSDLInterface->mRefreshRate, 1);
+		if (mWaitForVSync && mIsPhysWindowed && mSoftVSyncWait && (mFramePacer.mLastPresentTime > 0))
+			mFramePacer.WaitUntil(mFramePacer.mLastPresentTime + aRefreshTime);
 
 		uint32_t aPreScreenBltTime = SDL_GetTicks();
 		mLastDrawTick = aPreScreenBltTime;
 
 		Redraw(nullptr);
 
+		if (mVSyncUpdates || mWaitForVSync)
+			mFramePacer.FramePresented(std::max(aRefreshTime, mFrameTime / mUpdateMultiplier));
+		else
+			mFramePacer.FramePresented(mFrameTime / mUpdateMultiplier);
+
 		// This is our one UpdateFTimeAcc if we are vsynched
 		UpdateFTimeAcc();
 
+		mImageMemoryManager.Update();
+
 		uint32_t aEndTime = SDL_GetTicks();
 
 		mScreenBltTime = aEndTime - aPreScreenBltTime;
@@ -1786,6 +1865,7 @@ bool AppBase::DrawDirtyStuff()
 	{
 		mHasPendingDraw = false;
 		mLastDrawWasEmpty = true;
+		mFramePacer.FrameSkipped();
 		return false;
 	}
 }
@@ -1986,70 +2066,85 @@ void AppBase::ClearKeysDown()
 
 void AppBase::ShowMemoryUsage()
 {
-	/*
-	uint32_t aTotal = 0;
-	uint32_t aFree = 0;
-
-	if (mDDInterface->mDD7 != nullptr)
-	{
-		DDSCAPS2 aCaps;
-		ZeroMemory(&aCaps,sizeof(aCaps));
-		aCaps.dwCaps = DDSCAPS_VIDEOMEMORY;
-		mDDInterface->mDD7->GetAvailableVidMem(&aCaps,&aTotal,&aFree);
-	}
-
-	MemoryImageSet::iterator anItr = mMemoryImageSet.begin();
-	typedef std::pair<int,int> FormatUsage;
-	typedef std::map<PixelFormat,FormatUsage> FormatMap;
+	typedef std::pair<int, int> FormatUsage;
+	typedef std::map<SDL_PixelFormat, FormatUsage> FormatMap;
 	FormatMap aFormatMap;
 	int aTextureMemory = 0;
-	while (anItr != mMemoryImageSet.end())
+	int aTextureSaved = 0;
+	int aPalletizedCount = 0;
+	int aPalletizedSaved = 0;
+
 	{
-		MemoryImage* aMemoryImage = *anItr;
-		if (aMemoryImage->mD3DData != nullptr)
+		AutoCrit anAutoCrit(mSDLInterface->mCritSect);
+		for (ImageSet::iterator anItr = mSDLInterface->mImageSet.begin(); anItr != mSDLInterface->mImageSet.end();
+			 ++anItr)
 		{
-			TextureData *aData = (TextureData*)aMemoryImage->mD3DData;
+			SDLTextureData *aData = (SDLTextureData *)(*anItr)->mD3DData;
+			if ((aData == nullptr) || (aData->mTexture == nullptr))
+				continue;
+
 			aTextureMemory += aData->mTexMemSize;
+			aTextureSaved += aData->mWidth * aData->mHeight * 4 - aData->mTexMemSize;
 
 			FormatUsage &aUsage = aFormatMap[aData->mPixelFormat];
 			aUsage.first++;
 			aUsage.second += aData->mTexMemSize;
 		}
+	}
 
-		++anItr;
+	for (MemoryImageSet::iterator anItr = mMemoryImageSet.begin(); anItr != mMemoryImageSet.end(); ++anItr)
+	{
+		MemoryImage *aMemoryImage = *anItr;
+		if ((aMemoryImage->mColorTable == nullptr) || (aMemoryImage->mBits != nullptr))
+			continue;
+
+		int aNumPixels = aMemoryImage->mWidth * aMemoryImage->mHeight;
+		aPalletizedCount++;
+		aPalletizedSaved += aNumPixels * 4 - (aNumPixels + 256 * 4);
 	}
 
 	std::string aStr;
 
-	const char *aDesc;
-	if (Is3DAccelerationRecommended())
-		aDesc = "Recommended";
-	else if (Is3DAccelerationSupported())
-		aDesc = "Supported";
-	else
-		aDesc = "Unsupported";
-
-	aStr += StrFormat("3D-Mode is %s (3D is %s on this system)\r\n\r\n",Is3DAccelerated()?"On":"Off",aDesc);
-
-	aStr += StrFormat("Num Images: %d\r\n",(int)mMemoryImageSet.size());
-	aStr += StrFormat("Num Sounds: %d\r\n",mSoundManager->GetNumSounds());
-	aStr += StrFormat("Video Memory: %s/%s KB\r\n", PopStringToString(CommaSeperate((aTotal-aFree)/1024)).c_str(),
-	PopStringToString(CommaSeperate(aTotal/1024)).c_str()); aStr += StrFormat("Texture Memory: %s
-	KB\r\n",CommaSeperate(aTextureMemory/1024).c_str());
-
-	FormatUsage aUsage = aFormatMap[PixelFormat_A8R8G8B8];
-	aStr += StrFormat("A8R8G8B8: %d - %s
-	KB\r\n",aUsage.first,PopStringToString(CommaSeperate(aUsage.second/1024)).c_str()); aUsage =
-	aFormatMap[PixelFormat_A4R4G4B4]; aStr += StrFormat("A4R4G4B4: %d - %s
-	KB\r\n",aUsage.first,PopStringToString(CommaSeperate(aUsage.second/1024)).c_str()); aUsage =
-	aFormatMap[PixelFormat_R5G6B5]; aStr += StrFormat("R5G6B5: %d - %s
-	KB\r\n",aUsage.first,PopStringToString(CommaSeperate(aUsage.second/1024)).c_str()); aUsage =
-	aFormatMap[PixelFormat_Palette8]; aStr += StrFormat("Palette8: %d - %s
-	KB\r\n",aUsage.first,PopStringToString(CommaSeperate(aUsage.second/1024)).c_str());
-
-	MsgBox(aStr,"Video Stats",MB_OK);
+	aStr += StrFormat("Num Images: %d\r\n", (int)mMemoryImageSet.size());
+	aStr += StrFormat("Num Sounds: %d\r\n", mSoundManager->GetNumSounds());
+	aStr += StrFormat("Texture Memory: %s KB\r\n\r\n", CommaSeperate(aTextureMemory / 1024).c_str());
+
+	FormatUsage aUsage = aFormatMap[SDL_PIXELFORMAT_ARGB8888];
+	aStr += StrFormat("A8R8G8B8: %d - %s KB\r\n", aUsage.first, CommaSeperate(aUsage.second / 1024).c_str());
+	aUsage = aFormatMap[SDL_PIXELFORMAT_ARGB4444];
+	aStr += StrFormat("A4R4G4B4: %d - %s KB\r\n", aUsage.first, CommaSeperate(aUsage.second / 1024).c_str());
+	aUsage = aFormatMap[SDL_PIXELFORMAT_RGB565];
+	aStr += StrFormat("R5G6B5: %d - %s KB\r\n", aUsage.first, CommaSeperate(aUsage.second / 1024).c_str());
+	aStr += StrFormat("Palette8: %d\r\n\r\n", aPalletizedCount);
+
+	aStr += StrFormat("Saved by 16 bit textures: %s KB\r\n", CommaSeperate(aTextureSaved / 1024).c_str());
+	aStr += StrFormat("Saved by palletized bits: %s KB\r\n\r\n", CommaSeperate(aPalletizedSaved / 1024).c_str());
+
+	mImageMemoryManager.Update(true);
+	aStr += StrFormat("Image Memory: %s KB bits, %s KB textures\r\n",
+					  CommaSeperate((int)(mImageMemoryManager.mCPUMemory / 1024)).c_str(),
+					  CommaSeperate((int)(mImageMemoryManager.mTextureMemory / 1024)).c_str());
+	if (mImageMemoryManager.mBudget > 0)
+		aStr += StrFormat("Budget: %s KB, %d evicted (%d evictions, %d reloads)\r\n",
+						  CommaSeperate((int)(mImageMemoryManager.mBudget / 1024)).c_str(),
+						  mImageMemoryManager.mNumEvictedImages, mImageMemoryManager.mEvictCount,
+						  mImageMemoryManager.mReloadCount);
+
+	if (mResourceManager != nullptr)
+	{
+		ResourceManager::GroupMemoryMap aGroupMap;
+		mResourceManager->GetImageMemoryByGroup(aGroupMap);
+
+		aStr += "\r\n";
+		for (ResourceManager::GroupMemoryMap::iterator anItr = aGroupMap.begin(); anItr != aGroupMap.end(); ++anItr)
+			aStr += StrFormat("%s: %s KB bits, %s KB textures\r\n",
+							  anItr->first.empty() ? "(no group)" : anItr->first.c_str(),
+							  CommaSeperate((int)(anItr->second.first / 1024)).c_str(),
+							  CommaSeperate((int)(anItr->second.second / 1024)).c_str());
+	}
+
+	MsgBox(aStr, "Video Stats", MsgBox_OK);
 	mLastTime = SDL_GetTicks();
-	*/
 }
 
 bool AppBase::IsAltKeyUsed(long wParam)
@@ -2194,123 +2289,180 @@ void AppBase::CloseRequestAsync()
 //  it won't keep crashing and stuff
 bool AppBase::ProcessDeferredMessages(bool singleMessage)
 {
-	SDL_Event event;
-	if (SDL_PollEvent(&event))
+	SDL_Event anEvents[EVENT_BATCH_SIZE];
+
+	SDL_PumpEvents();
+
+	for (;;)
 	{
-		ImGui_ImplSDL3_ProcessEvent(&event);
+		int aMaxEvents = EVENT_BATCH_SIZE;
+		if (mMaxEventsPerFrame > 0)
+		{
+			// Let an update and a draw through before handling any more input
+			if (mFrameEventCount >= mMaxEventsPerFrame)
+				return false;
+			aMaxEvents = std::min(aMaxEvents, mMaxEventsPerFrame - mFrameEventCount);
+		}
+
+		int aNumEvents = SDL_PeepEvents(anEvents, aMaxEvents, SDL_GETEVENT, SDL_EVENT_FIRST, SDL_EVENT_LAST);
+		if (aNumEvents <= 0)
+			return false;
 
-		switch (event.type)
+		mFrameEventCount += aNumEvents;
+
+		for (int i = 0; i < aNumEvents; i++)
 		{
-		case SDL_EVENT_QUIT:
-			Shutdown();
-			break;
-		case SDL_EVENT_WINDOW_FOCUS_GAINED:
-			mActive = true;
-			RehupFocus();
-			if (!mIsWindowed)
-				mWidgetManager->MarkAllDirty();
-			if (mIsOpeningURL && !mActive)
-				URLOpenSucceeded(mOpeningURL);
-			break;
-		case SDL_EVENT_WINDOW_FOCUS_LOST:
-			mActive = false;
-			RehupFocus();
-			if (mIsOpeningURL && mActive)
-				URLOpenFailed(mOpeningURL);
-			break;
-		case SDL_EVENT_WINDOW_MINIMIZED:
-			mMinimized = true;
-			if (mMuteOnLostFocus)
-				Mute(true);
-			break;
-		case SDL_EVENT_WINDOW_RESTORED:
-			mMinimized = false;
-			if (mMuteOnLostFocus)
-				Unmute(true);
-			mWidgetManager->MarkAllDirty();
-			break;
-		case SDL_EVENT_MOUSE_MOTION:
-			if (!gInAssert && !mSEHOccured)
+			SDL_Event &anEvent = anEvents[i];
+
+			// A motion event immediately followed by another one from the same mouse would just be
+			//  overridden before anything got drawn.  Button events carry their own position, so
+			//  only back-to-back motion is folded and presses still land where they happened.
+			if ((anEvent.type == SDL_EVENT_MOUSE_MOTION) && (i + 1 < aNumEvents) &&
+				(anEvents[i + 1].type == SDL_EVENT_MOUSE_MOTION) && (anEvents[i + 1].motion.which == anEvent.motion.which))
 			{
-				int x = event.motion.x;
-				int y = event.motion.y;
-				mWidgetManager->RemapMouse(x, y);
-				mLastUserInputTick = mLastTimerTime;
-				mWidgetManager->MouseMove(x, y);
-				if (!mMouseIn)
-				{
-					mMouseIn = true;
-					EnforceCursor();
-				}
+				anEvents[i + 1].motion.xrel += anEvent.motion.xrel;
+				anEvents[i + 1].motion.yrel += anEvent.motion.yrel;
+				mMouseMotionCoalesced++;
+				continue;
 			}
+
+			ProcessSDLEvent(anEvent);
+			mEventsProcessed++;
+		}
+
+		if (singleMessage || (aNumEvents < aMaxEvents))
 			break;
-		case SDL_EVENT_MOUSE_BUTTON_DOWN:
-		case SDL_EVENT_MOUSE_BUTTON_UP:
-			if (!gInAssert && !mSEHOccured)
-			{
-				int btnCode = 0;
-				bool down = event.type == SDL_EVENT_MOUSE_BUTTON_DOWN;
+	}
 
-				switch (event.button.button)
-				{
-				case SDL_BUTTON_LEFT:
-					btnCode = 1;
-					break;
-				case SDL_BUTTON_RIGHT:
-					btnCode = -1;
-					break;
-				case SDL_BUTTON_MIDDLE:
-					btnCode = 3;
-					break;
-				}
+	if ((mMaxEventsPerFrame > 0) && (mFrameEventCount >= mMaxEventsPerFrame))
+		return false;
 
-				int x = event.button.x;
-				int y = event.button.y;
+	return SDL_HasEvents(SDL_EVENT_FIRST, SDL_EVENT_LAST);
+}
 
-				int renderWidth, renderHeight;
-				SDL_GetCurrentRenderOutputSize(mSDLInterface->mRenderer, &renderWidth, &renderHeight);
+void AppBase::ProcessSDLEvent(SDL_Event &event)
+{
+	ImGui_ImplSDL3_ProcessEvent(&event);
 
-				int scaledX = static_cast<int>(event.button.x * ((float)mWidth / renderWidth));
-				int scaledY = static_cast<int>(event.button.y * ((float)mHeight / renderHeight));
+	switch (event.type)
+	{
+	case SDL_EVENT_QUIT:
+		Shutdown();
+		break;
+	case SDL_EVENT_WINDOW_FOCUS_GAINED:
+		mActive = true;
+		RehupFocus();
+		if (!mIsWindowed)
+			mWidgetManager->MarkAllDirty();
+		if (mIsOpeningURL && !mActive)
+			URLOpenSucceeded(mOpeningURL);
+		break;
+	case SDL_EVENT_WINDOW_FOCUS_LOST:
+		mActive = false;
+		RehupFocus();
+		if (mIsOpeningURL && mActive)
+			URLOpenFailed(mOpeningURL);
+		break;
+	case SDL_EVENT_WINDOW_MINIMIZED:
+		mMinimized = true;
+		if (mMuteOnLostFocus)
+			Mute(true);
+		break;
+	case SDL_EVENT_WINDOW_RESTORED:
+		mMinimized = false;
+		if (mMuteOnLostFocus)
+			Unmute(true);
+		mWidgetManager->MarkAllDirty();
+		break;
+	case SDL_EVENT_RENDER_TARGETS_RESET:
+		mWidgetManager->InvalidateDrawCaches();
+		mWidgetManager->MarkAllDirty();
+		break;
+	case SDL_EVENT_RENDER_DEVICE_RESET:
+	case SDL_EVENT_RENDER_DEVICE_LOST:
+		mWidgetManager->ReleaseAllDrawCaches();
+		mWidgetManager->MarkAllDirty();
+		break;
+	case SDL_EVENT_MOUSE_MOTION:
+		if (!gInAssert && !mSEHOccured)
+		{
+			int x = event.motion.x;
+			int y = event.motion.y;
+			mWidgetManager->RemapMouse(x, y);
+			mLastUserInputTick = mLastTimerTime;
+			mWidgetManager->MouseMove(x, y);
+			mCursorInputLatencyNS = SDL_GetTicksNS() - event.motion.timestamp;
+			if (!mMouseIn)
+			{
+				mMouseIn = true;
+				EnforceCursor();
+			}
+		}
+		break;
+	case SDL_EVENT_MOUSE_BUTTON_DOWN:
+	case SDL_EVENT_MOUSE_BUTTON_UP:
+		if (!gInAssert && !mSEHOccured)
+		{
+			int btnCode = 0;
+			bool down = event.type == SDL_EVENT_MOUSE_BUTTON_DOWN;
 
-				if (down)
-					mWidgetManager->MouseDown(scaledX, scaledY, btnCode);
-				else
-					mWidgetManager->MouseUp(scaledX, scaledY, btnCode);
+			switch (event.button.button)
+			{
+			case SDL_BUTTON_LEFT:
+				btnCode = 1;
+				break;
+			case SDL_BUTTON_RIGHT:
+				btnCode = -1;
+				break;
+			case SDL_BUTTON_MIDDLE:
+				btnCode = 3;
+				break;
 			}
-			break;
-		case SDL_EVENT_MOUSE_WHEEL:
-			mWidgetManager->MouseWheel(event.wheel.y);
 
-			break;
-		case SDL_EVENT_KEY_DOWN:
-		case SDL_EVENT_KEY_UP: {
-			bool isDown = event.type == SDL_EVENT_KEY_DOWN;
-			SDL_Keycode key = event.key.key;
+			int x = event.button.x;
+			int y = event.button.y;
 
-			mLastUserInputTick = mLastTimerTime;
+			int renderWidth, renderHeight;
+			SDL_GetCurrentRenderOutputSize(mSDLInterface->mRenderer, &renderWidth, &renderHeight);
 
-			if (isDown && mDebugKeysEnabled && DebugKeyDown(key))
-				break;
+			int scaledX = static_cast<int>(event.button.x * ((float)mWidth / renderWidth));
+			int scaledY = static_cast<int>(event.button.y * ((float)mHeight / renderHeight));
 
-			if (isDown)
-				mWidgetManager->KeyDown(GetKeyCodeFromSDLKeycode(key));
+			if (down)
+				mWidgetManager->MouseDown(scaledX, scaledY, btnCode);
 			else
-				mWidgetManager->KeyUp(GetKeyCodeFromSDLKeycode(key));
+				mWidgetManager->MouseUp(scaledX, scaledY, btnCode);
 		}
 		break;
-		case SDL_EVENT_TEXT_INPUT: {
-			mLastUserInputTick = mLastTimerTime;
+	case SDL_EVENT_MOUSE_WHEEL:
+		mWidgetManager->MouseWheel(event.wheel.y);
 
-			PopChar aChar = event.text.text[0]; // assumes UTF-8 safe
+		break;
+	case SDL_EVENT_KEY_DOWN:
+	case SDL_EVENT_KEY_UP: {
+		bool isDown = event.type == SDL_EVENT_KEY_DOWN;
+		SDL_Keycode key = event.key.key;
+
+		mLastUserInputTick = mLastTimerTime;
 
-			mWidgetManager->KeyChar((PopChar)aChar);
+		if (isDown && mDebugKeysEnabled && DebugKeyDown(key))
 			break;
-		}
-		}
+
+		if (isDown)
+			mWidgetManager->KeyDown(GetKeyCodeFromSDLKeycode(key));
+		else
+			mWidgetManager->KeyUp(GetKeyCodeFromSDLKeycode(key));
 	}
+	break;
+	case SDL_EVENT_TEXT_INPUT: {
+		mLastUserInputTick = mLastTimerTime;
 
-	return SDL_HasEvents(SDL_EVENT_FIRST, SDL_EVENT_LAST);
+		PopChar aChar = event.text.text[0]; // assumes UTF-8 safe
+
+		mWidgetManager->KeyChar((PopChar)aChar);
+		break;
+	}
+	}
 }
 
 void AppBase::Done3dTesting()
@@ -2438,73 +2590,9 @@ void AppBase::StartLoadingThread()
 		mYieldMainThread = true;
 		SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_HIGH);
 		mLoadingThreadStarted = true;
-		SDL_Thread *aThread = SDL_CreateThread(LoadingThreadProcStub, "LoadingThread", (void *)this);
-		SDL_DetachThread(aThread);
-	}
-}
-void AppBase::CursorThreadProc()
-{
-	SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_HIGH);
-	SDL_Point aLastCursorPos = {0, 0};
-	int aLastDrawCount = 0;
-
-	while (!mShutdown)
-	{
-
-		SDL_Point aCursorPos;
-
-		float x, y;
-
-		SDL_GetMouseState(&x, &y);
-
-		aCursorPos.x = (int)x;
-		aCursorPos.y = (int)y;
-
-		if (aLastDrawCount != mDrawCount)
-		{
-			// We did a draw so we may have committed a pending mNextCursorX/Y
-			aLastCursorPos.x = mSDLInterface->mCursorX;
-			aLastCursorPos.y = mSDLInterface->mCursorY;
-		}
-
-		if ((aCursorPos.x != aLastCursorPos.x) || (aCursorPos.y != aLastCursorPos.y))
-		{
-			Uint32 aTimeNow = SDL_GetTicks();
-			if (aTimeNow - mNextDrawTick > mSDLInterface->mMillisecondsPerFrame + 5)
-			{
-				// Do the special drawing if we are rendering at less than full framerate
-				mSDLInterface->SetCursorPos(aCursorPos.x, aCursorPos.y);
-				aLastCursorPos = aCursorPos;
-			}
-			else
-			{
-				// Set them up to get assigned in the next screen redraw
-				mSDLInterface->mNextCursorX = aCursorPos.x;
-				mSDLInterface->mNextCursorY = aCursorPos.y;
-			}
-		}
-
-		SDL_Delay(10);
-	}
-
-	mCursorThreadRunning = false;
-}
-
-int AppBase::CursorThreadProcStub(void *theArg)
-{
-	AppBase *aPopLibApp = (AppBase *)theArg;
-	aPopLibApp->CursorThreadProc();
-	return 0;
-}
 
-void AppBase::StartCursorThread()
-{
-	if (!mCursorThreadRunning)
-	{
-		mCursorThreadRunning = true;
-		SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_HIGH);
-		SDL_Thread *aThread = SDL_CreateThread(CursorThreadProcStub, "CursorThread", (void *)this);
-		SDL_DetachThread(aThread);
+		// Holds on to one worker until it's done, JobSystem always has another for what loading queues up
+		mJobSystem->Run([this]() { LoadingThreadProcStub(this); });
 	}
 }
 
@@ -2657,18 +2745,58 @@ void AppBase::ProcessSafeDeleteList()
 	}
 }
 
+void AppBase::UpdateHotReload()
+{
+	// Reloading changes the resources the loading thread is working through, so changes wait until it's done
+	if ((mLoadingThreadStarted) && (!mLoadingThreadCompleted))
+		return;
+
+	if (mFileWatcher == nullptr)
+	{
+		mFileWatcher = new FileWatcher();
+		mResourceManager->SetFileWatcher(mFileWatcher);
+	}
+
+	// M()s register their source file the first time they're hit
+	std::vector<std::string> aModValFiles;
+	GetNewModValFiles(aModValFiles);
+	for (const std::string &aFileName : aModValFiles)
+	{
+		if (mFileWatcher->WatchFile(aFileName))
+			mModValFiles[FileWatcher::GetWatchPath(aFileName)] = aFileName;
+	}
+
+	std::vector<std::string> aChangedFiles;
+	mFileWatcher->GetChangedFiles(aChangedFiles);
+	if (aChangedFiles.empty())
+		return;
+
+	// Saving through a rename can leave a stale directory listing behind
+	if (gPakInterface != nullptr)
+		gPakInterface->InvalidateFileIndex();
+
+	for (const std::string &aFileName : aChangedFiles)
+	{
+		std::map<std::string, std::string>::iterator anItr = mModValFiles.find(aFileName);
+		if (anItr != mModValFiles.end())
+			ReparseModValueFile(anItr->second);
+		else
+			mResourceManager->ReloadChangedFile(aFileName);
+	}
+}
+
 void AppBase::UpdateFTimeAcc()
 {
-	uint32_t aCurTime = SDL_GetTicks();
+	double aCurTime = mFramePacer.GetTime();
 
 	if (mLastTimeCheck != 0)
 	{
-		int aDeltaTime = aCurTime - mLastTimeCheck;
+		double aDeltaTime = aCurTime - mLastTimeCheck;
 
 		mUpdateFTimeAcc = std::min(mUpdateFTimeAcc + aDeltaTime, 200.0);
 
 		if (mRelaxUpdateBacklogCount > 0)
-			mRelaxUpdateBacklogCount = std::max(mRelaxUpdateBacklogCount - aDeltaTime, 0);
+			mRelaxUpdateBacklogCount = std::max(mRelaxUpdateBacklogCount - aDeltaTime, 0.0);
 	}
 
 	mLastTimeCheck = aCurTime;
@@ -2690,6 +2818,15 @@ bool AppBase::Process(bool allowSleep)
 	if (mLoadingFailed)
 		Shutdown();
 
+	if (mJobSystem != nullptr)
+	{
+		mJobSystem->ProcessMainThreadJobs();
+		mJobSystem->UpdateStats();
+	}
+
+	if (mHotReload)
+		UpdateHotReload();
+
 	bool isVSynched = mVSyncUpdates && (!mLastDrawWasEmpty) && (!mVSyncBroken) &&
 					  ((!mIsPhysWindowed) || (mIsPhysWindowed && mWaitForVSync && !mSoftVSyncWait));
 	double aFrameFTime;
@@ -2711,8 +2848,7 @@ bool AppBase::Process(bool allowSleep)
 	{
 		ulong aStartTime = SDL_GetTicks();
 
-		ulong aCurTime = aStartTime;
-		int aCumSleepTime = 0;
+		double aCumSleepTime = 0;
 
 		// When we are VSynching, only calculate this FTimeAcc right after drawing
 
@@ -2799,10 +2935,6 @@ bool AppBase::Process(bool allowSleep)
 				mPendingUpdatesAcc -= 1.0;
 			}
 
-			// aNumCalls++;
-			DoUpdateFramesF((float)anUpdatesPerUpdateF);
-			ProcessSafeDeleteList();
-
 			// Don't let mUpdateFTimeAcc dip below 0
 			//  Subtract an extra 0.2ms, because sometimes refresh rates have some
 			//  fractional component that gets truncated, and it's better to take off
@@ -2816,6 +2948,12 @@ bool AppBase::Process(bool allowSleep)
 			if (mRelaxUpdateBacklogCount > 0)
 				mUpdateFTimeAcc = 0;
 
+			mUpdateInterpolation = std::min(std::max(mUpdateFTimeAcc / aFrameFTime, 0.0), 1.0);
+
+			// aNumCalls++;
+			DoUpdateFramesF((float)anUpdatesPerUpdateF);
+			ProcessSafeDeleteList();
+
 			didUpdate = true;
 		}
 
@@ -2832,7 +2970,7 @@ bool AppBase::Process(bool allowSleep)
 			else
 			{
 				// Let us take into account the time it took to draw dirty stuff
-				int aTimeToNextFrame = (int)(aFrameFTime - mUpdateFTimeAcc);
+				double aTimeToNextFrame = aFrameFTime - mUpdateFTimeAcc;
 				if (aTimeToNextFrame > 0)
 				{
 					if (!allowSleep)
@@ -2840,7 +2978,7 @@ bool AppBase::Process(bool allowSleep)
 
 					// Wait till next processing cycle
 					++mSleepCount;
-					SDL_Delay(aTimeToNextFrame);
+					mFramePacer.Wait(aTimeToNextFrame);
 
 					aCumSleepTime += aTimeToNextFrame;
 				}
@@ -2853,15 +2991,16 @@ bool AppBase::Process(bool allowSleep)
 			// 1/3 of the processor time
 
 			ulong anEndTime = SDL_GetTicks();
-			int anElapsedTime = (anEndTime - aStartTime) - aCumSleepTime;
-			int aLoadingYieldSleepTime = std::min(250, (anElapsedTime * 2) - aCumSleepTime);
+			double anElapsedTime = (anEndTime - aStartTime) - aCumSleepTime;
+			double aLoadingYieldSleepTime = std::min(250.0, (anElapsedTime * 2) - aCumSleepTime);
 
 			if (aLoadingYieldSleepTime >= 0)
 			{
 				if (!allowSleep)
 					return false;
 
-				SDL_Delay(aLoadingYieldSleepTime);
+				// Giving the time away is the point here, so this mustn't spin like the frame pacer does
+				SDL_DelayNS((Uint64)(aLoadingYieldSleepTime * SDL_NS_PER_MS));
 			}
 		}
 	}
@@ -2933,6 +3072,7 @@ bool AppBase::UpdateAppStep(bool *updated)
 	{
 		if (!ProcessDeferredMessages(true))
 		{
+			mFrameEventCount = 0;
 			mUpdateAppState = UPDATESTATE_PROCESS_1;
 		}
 	}
@@ -3013,8 +3153,6 @@ void AppBase::Start()
 	if (mShutdown)
 		return;
 
-	StartCursorThread();
-
 	if (mAutoStartLoadingThread)
 		StartLoadingThread();
 
@@ -3386,8 +3524,12 @@ MusicInterface *AppBase::CreateMusicInterface()
 {
 	if (mNoSoundNeeded)
 		return new MusicInterface;
-	else
-		return new BassMusicInterface();
+
+	MiniaudioSoundManager *aMiniaudioSoundManager = dynamic_cast<MiniaudioSoundManager *>(mSoundManager);
+	if (aMiniaudioSoundManager != nullptr)
+		return new MiniaudioMusicInterface(aMiniaudioSoundManager->mMixer);
+
+	return new BassMusicInterface();
 }
 
 void AppBase::InitPropertiesHook()
@@ -3402,6 +3544,7 @@ void AppBase::Init()
 {
 	mPrimaryThreadId = SDL_GetCurrentThreadID();
 	mErrorHandler = new ErrorHandler(this);
+	mJobSystem = new JobSystem();
 
 	if (mShutdown)
 		return;
@@ -3456,7 +3599,12 @@ void AppBase::Init()
 	MakeWindow();
 
 	if (mSoundManager == nullptr)
-		mSoundManager = new OpenALSoundManager();
+	{
+		if (mUseMiniaudio)
+			mSoundManager = new MiniaudioSoundManager();
+		else
+			mSoundManager = new OpenALSoundManager();
+	}
 
 	SetSfxVolume(mSfxVolume);
 
@@ -3547,9 +3695,12 @@ PopLib::SDLImage *AppBase::GetImage(const std::string &theFileName, bool commitB
 
 	SDLImage *anImage = new SDLImage(mSDLInterface);
 	anImage->mFilePath = theFileName;
-	anImage->SetBits((uint32_t*)aLoadedImage->GetBits(), aLoadedImage->GetWidth(), aLoadedImage->GetHeight(), commitBits);
+	anImage->TakeBits(aLoadedImage->GetBits(), aLoadedImage->GetWidth(), aLoadedImage->GetHeight(), commitBits);
+	aLoadedImage->mBits = nullptr;
 	delete aLoadedImage;
 
+	mImageMemoryManager.SetReloadable(anImage, true);
+
 	return anImage;
 }
 
@@ -4141,6 +4292,7 @@ void AppBase::RemoveMemoryImage(MemoryImage *theMemoryImage)
 	if (anItr != mMemoryImageSet.end())
 		mMemoryImageSet.erase(anItr);
 
+	mImageMemoryManager.RemoveImage(theMemoryImage);
 	Remove3DData(theMemoryImage);
 }
 
@@ -4202,28 +4354,19 @@ void AppBase::Set3DAcclerated(bool is3D, bool reinit)
 	}
 }
 
-SharedImageRef AppBase::GetSharedImage(const std::string &theFileName, const std::string &theVariant, bool *isNew)
+SharedImageRef AppBase::GetSharedImage(const std::string &theFileName, const std::string &theVariant, bool *isNew,
+									   bool loadImage)
 {
-	std::string anUpperFileName = StringToUpper(theFileName);
-	std::string anUpperVariant = StringToUpper(theVariant);
-
-	std::pair<SharedImageMap::iterator, bool> aResultPair;
-	SharedImageRef aSharedImageRef;
-
-	{
-		AutoCrit anAutoCrit(mSDLInterface->mCritSect);
-		aResultPair = mSharedImageMap.insert(
-			SharedImageMap::value_type(SharedImageMap::key_type(anUpperFileName, anUpperVariant), SharedImage()));
-		aSharedImageRef = &aResultPair.first->second;
-	}
+	bool aIsNew;
+	SharedImageRef aSharedImageRef = mSharedImageMap.Find(theFileName, theVariant, &aIsNew);
 
 	if (isNew != nullptr)
-		*isNew = aResultPair.second;
+		*isNew = aIsNew;
 
-	if (aResultPair.second)
+	if (aIsNew)
 	{
 		// Pass in a '!' as the first char of the file name to create a new image
-		if ((theFileName.length() > 0) && (theFileName[0] == '!'))
+		if (((theFileName.length() > 0) && (theFileName[0] == '!')) || (!loadImage))
 			aSharedImageRef.mSharedImage->mImage = new SDLImage(mSDLInterface);
 		else
 			aSharedImageRef.mSharedImage->mImage = GetImage(theFileName, false);
@@ -4234,28 +4377,11 @@ SharedImageRef AppBase::GetSharedImage(const std::string &theFileName, const std
 
 void AppBase::CleanSharedImages()
 {
-	AutoCrit anAutoCrit(mSDLInterface->mCritSect);
-
-	if (mCleanupSharedImages)
-	{
-		// Delete shared images with reference counts of 0
-		// This doesn't occur in ~SharedImageRef because sometimes we can not only access the image
-		//  through the SharedImageRef returned by GetSharedImage, but also by calling GetSharedImage
-		//  again with the same params -- so we can have instances where we do the 'final' deref on
-		//  an image but immediately re-request it via GetSharedImage
-		SharedImageMap::iterator aSharedImageItr = mSharedImageMap.begin();
-		while (aSharedImageItr != mSharedImageMap.end())
-		{
-			SharedImage *aSharedImage = &aSharedImageItr->second;
-			if (aSharedImage->mRefCount == 0)
-			{
-				delete aSharedImage->mImage;
-				mSharedImageMap.erase(aSharedImageItr++);
-			}
-			else
-				++aSharedImageItr;
-		}
-
-		mCleanupSharedImages = false;
-	}
+	// Delete shared images with reference counts of 0
+	// This doesn't occur in ~SharedImageRef because sometimes we can not only access the image
+	//  through the SharedImageRef returned by GetSharedImage, but also by calling GetSharedImage
+	//  again with the same params -- so we can have instances where we do the 'final' deref on
+	//  an image but immediately re-request it via GetSharedImage
+	if (mCleanupSharedImages.exchange(false))
+		mSharedImageMap.Cleanup();
 }
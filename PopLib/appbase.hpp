@@ -11,9 +11,12 @@
 #include "widget/dialoglistener.hpp"
 #include "misc/buffer.hpp"
 #include "misc/critsect.hpp"
+#include "misc/framepacer.hpp"
+#include "graphics/imagememorymanager.hpp"
 #include "graphics/sharedimage.hpp"
 #include "math/ratio.hpp"
 #include <mutex>
+#include <atomic>
 
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
@@ -52,6 +55,8 @@ class MemoryImage;
 class HTTPTransfer;
 class ErrorHandler;
 class ImGuiManager;
+class JobSystem;
+class FileWatcher;
 class Dialog;
 
 class ResourceManager;
@@ -105,9 +110,15 @@ enum
 {
 	FPS_ShowFPS,
 	FPS_ShowCoords,
+	FPS_ShowFrameTimes,
 	Num_FPS_Types
 };
 
+/**
+ * @brief how many SDL events are pulled off the queue at a time
+ */
+const int EVENT_BATCH_SIZE = 64;
+
 /**
  * @brief update states
  */
@@ -158,7 +169,7 @@ class AppBase : public ButtonListener, public DialogListener
 	std::string mChangeDirTo;
 
 	/// @brief TBA
-	int mRelaxUpdateBacklogCount; // app doesn't try to catch up for this many frames
+	double mRelaxUpdateBacklogCount; // app doesn't try to catch up for this many milliseconds
 	/// @brief preferred X position of window
 	int mPreferredX;
 	/// @brief preferred Y position of window
@@ -175,6 +186,8 @@ class AppBase : public ButtonListener, public DialogListener
 	double mSfxVolume;
 	/// @brief returns true if no sound is needed
 	bool mNoSoundNeeded;
+	/// @brief true to play sounds and music through one miniaudio mixer instead of OpenAL and BASS
+	bool mUseMiniaudio;
 	/// @brief returns true if arguments given when running the game
 	bool mCmdLineParsed;
 	/// @brief skips signature checks
@@ -188,6 +201,12 @@ class AppBase : public ButtonListener, public DialogListener
 	ErrorHandler *mErrorHandler;
 	/// @brief imgui manager object, IGUI = ImGui
 	ImGuiManager *mIGUIManager;
+	/// @brief worker threads for jobs, also runs the jobs queued for the main thread each frame
+	JobSystem *mJobSystem;
+	/// @brief watches resource and M() source files while mHotReload is set
+	FileWatcher *mFileWatcher;
+	/// @brief watch paths of the M() source files, to the name ReparseModValueFile knows them by
+	std::map<std::string, std::string> mModValFiles;
 
 	/// @brief TBA
 	std::mutex *mMutex;
@@ -281,10 +300,14 @@ class AppBase : public ButtonListener, public DialogListener
 	bool mMuteOnLostFocus;
 	/// @brief TBA
 	MemoryImageSet mMemoryImageSet;
-	/// @brief TBA
+	/// @brief CPU and texture memory accounting for mMemoryImageSet, with an optional budget
+	ImageMemoryManager mImageMemoryManager;
+	/// @brief images shared by file name and variant, see GetSharedImage
 	SharedImageMap mSharedImageMap;
-	/// @brief TBA
-	bool mCleanupSharedImages;
+	/// @brief set when a shared image drops to 0 refs, so CleanSharedImages has work to do
+	std::atomic<bool> mCleanupSharedImages;
+	/// @brief reuse parsed ImageFont descriptors from cache/fonts, see FontData::Load
+	bool mFontCacheEnabled;
 
 	/// @brief TBA
 	int mNonDrawCount;
@@ -301,12 +324,24 @@ class AppBase : public ButtonListener, public DialogListener
 	double mPendingUpdatesAcc;
 	/// @brief TBA
 	double mUpdateFTimeAcc;
-	/// @brief TBA
-	uint64_t mLastTimeCheck;
+	/// @brief last time the update accumulator was advanced, on the frame pacer clock
+	double mLastTimeCheck;
+	/// @brief how far into the next update the last draw was, 0 to 1
+	double mUpdateInterpolation;
+	/// @brief high resolution timing for sleeping between frames
+	FramePacer mFramePacer;
 	/// @brief last time
 	uint64_t mLastTime;
 	/// @brief last user input tick
 	uint64_t mLastUserInputTick;
+	/// @brief max events handled before an update is let through, 0 for no limit
+	int mMaxEventsPerFrame;
+	/// @brief events handled since the last update
+	int mFrameEventCount;
+	/// @brief total events dispatched
+	uint64_t mEventsProcessed;
+	/// @brief total mouse motion events folded into a following one
+	uint64_t mMouseMotionCoalesced;
 
 	/// @brief (total?) sleep count
 	int mSleepCount;
@@ -389,8 +424,8 @@ class AppBase : public ButtonListener, public DialogListener
 	bool mYieldMainThread;
 	/// @brief true if loading failed
 	bool mLoadingFailed;
-	/// @brief true if cursor thread running
-	bool mCursorThreadRunning;
+	/// @brief time between the OS seeing the last mouse motion and the widgets getting it, in nanoseconds
+	uint64_t mCursorInputLatencyNS;
 	/// @brief true if has system cursor
 	bool mSysCursor;
 	/// @brief true if custom cursors are enabled
@@ -409,6 +444,8 @@ class AppBase : public ButtonListener, public DialogListener
 
 	/// @brief true if debug keys are enabled
 	bool mDebugKeysEnabled;
+	/// @brief true to reload loaded resources and M() values as soon as their files are saved (Linux only)
+	bool mHotReload;
 	/// @brief true if the maximize button is enabled
 	bool mEnableMaximizeButton;
 	/// @brief true if the ctrl key is down
@@ -475,12 +512,17 @@ class AppBase : public ButtonListener, public DialogListener
 	void RehupFocus();
 	/// @brief TBA
 	void ClearKeysDown();
-	/// @brief processes deferred messages, unused
-	/// @param singleMessage 
-	/// @return true if success
+	/// @brief drains pending SDL events in batches, folding back-to-back mouse motion
+	/// @param singleMessage only handle a single batch
+	/// @return true if there are events left to handle this frame
 	bool ProcessDeferredMessages(bool singleMessage);
+	/// @brief dispatches a single SDL event
+	/// @param event 
+	void ProcessSDLEvent(SDL_Event &event);
 	/// @brief TBA
 	void UpdateFTimeAcc();
+	/// @brief reloads whatever mFileWatcher has seen change since the last frame
+	void UpdateHotReload();
 	/// @brief process
 	/// @param allowSleep 
 	/// @return true if success
@@ -511,15 +553,6 @@ class AppBase : public ButtonListener, public DialogListener
 	/// @brief stub for loading thread
 	static int LoadingThreadProcStub(void *theArg);
 
-	// Cursor thread methods
-
-	/// @brief TBA
-	void CursorThreadProc();
-	/// @brief stub for cursor thread
-	static int CursorThreadProcStub(void *theArg);
-	/// @brief TBA
-	void StartCursorThread();
-
 	/// @brief TBA
 	void WaitForLoadingThread();
 	/// @brief TBA
@@ -750,9 +783,10 @@ class AppBase : public ButtonListener, public DialogListener
 	/// @param theFileName 
 	/// @param theVariant 
 	/// @param isNew 
+	/// @param loadImage if false, a new entry gets an empty image for the caller to fill in
 	/// @return SharedImageRef
 	virtual SharedImageRef GetSharedImage(const std::string &theFileName, const std::string &theVariant = "",
-										  bool *isNew = NULL);
+										  bool *isNew = NULL, bool loadImage = true);
 
 	/// @brief sets taskbar icon
 	/// @param theFileName 
@@ -1100,11 +1134,19 @@ class AppBase : public ButtonListener, public DialogListener
 
 	// File access methods
 
+	/// @brief folder for files this app can rebuild if they go missing, kept under its registry key
+	/// @return the folder, ending in a slash
+	std::string GetCacheFolder();
 	/// @brief writes buffer to file
 	/// @param theFileName 
 	/// @param theBuffer 
 	/// @return true on success
 	bool WriteBufferToFile(const std::string &theFileName, const Buffer *theBuffer);
+	/// @brief writes buffer to a temp file and renames it over theFileName, so readers never see it half written
+	/// @param theFileName 
+	/// @param theBuffer 
+	/// @return true on success
+	bool WriteBufferToFileAtomic(const std::string &theFileName, const Buffer *theBuffer);
 	/// @brief reads buffer from file
 	/// @param theFileName 
 	/// @param theBuffer 
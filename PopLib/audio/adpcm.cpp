@@ -0,0 +1,118 @@
+#include "adpcm.hpp"
+
+using namespace PopLib;
+
+static const int gIMAIndexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static const int gIMAStepTable[89] = {
+	7,	   8,	  9,	 10,	11,	   12,	  13,	 14,	16,	   17,	  19,	 21,	23,	   25,	  28,
+	31,	   34,	  37,	 41,	45,	   50,	  55,	 60,	66,	   73,	  80,	 88,	97,	   107,	  118,
+	130,   143,	  157,	 173,	190,   209,	  230,	 253,	279,   307,	  337,	 371,	408,   449,	  494,
+	544,   598,	  658,	 724,	796,   876,	  963,	 1060,	1166,  1282,  1411,	 1552,	1707,  1878,  2066,
+	2272,  2499,  2749,	 3024,	3327,  3660,  4026,	 4428,	4871,  5358,  5894,	 6484,	7132,  7845,  8630,
+	9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+struct IMAState
+{
+	int mPredictor;
+	int mIndex;
+};
+
+static inline int16_t IMADecodeNibble(IMAState &theState, int theNibble)
+{
+	int aStep = gIMAStepTable[theState.mIndex];
+
+	int aDiff = aStep >> 3;
+	if (theNibble & 4)
+		aDiff += aStep;
+	if (theNibble & 2)
+		aDiff += aStep >> 1;
+	if (theNibble & 1)
+		aDiff += aStep >> 2;
+
+	if (theNibble & 8)
+		theState.mPredictor -= aDiff;
+	else
+		theState.mPredictor += aDiff;
+
+	theState.mPredictor = std::clamp(theState.mPredictor, -32768, 32767);
+	theState.mIndex = std::clamp(theState.mIndex + gIMAIndexTable[theNibble], 0, 88);
+
+	return (int16_t)theState.mPredictor;
+}
+
+// Picks the nibble that gets the decoder closest to theSample, then steps the state the same way the
+// decoder will so the two never drift apart
+static inline int IMAEncodeSample(IMAState &theState, int theSample)
+{
+	int aStep = gIMAStepTable[theState.mIndex];
+	int aDiff = theSample - theState.mPredictor;
+
+	int aNibble = 0;
+	if (aDiff < 0)
+	{
+		aNibble = 8;
+		aDiff = -aDiff;
+	}
+
+	if (aDiff >= aStep)
+	{
+		aNibble |= 4;
+		aDiff -= aStep;
+	}
+	if (aDiff >= (aStep >> 1))
+	{
+		aNibble |= 2;
+		aDiff -= aStep >> 1;
+	}
+	if (aDiff >= (aStep >> 2))
+		aNibble |= 1;
+
+	IMADecodeNibble(theState, aNibble);
+	return aNibble;
+}
+
+int PopLib::GetIMAADPCMSize(int theNumFrames, int theChannels)
+{
+	return (theNumFrames * theChannels + 1) / 2;
+}
+
+bool PopLib::EncodeIMAADPCM(const int16_t *theSamples, int theNumFrames, int theChannels,
+							std::vector<uint8_t> &theData)
+{
+	if ((theChannels != 1) && (theChannels != 2))
+		return false;
+
+	theData.assign(GetIMAADPCMSize(theNumFrames, theChannels), 0);
+
+	IMAState aStates[2] = {{0, 0}, {0, 0}};
+	int aNumSamples = theNumFrames * theChannels;
+	for (int i = 0; i < aNumSamples; i++)
+	{
+		int aNibble = IMAEncodeSample(aStates[i % theChannels], theSamples[i]);
+		theData[i >> 1] |= (uint8_t)(aNibble << ((i & 1) * 4));
+	}
+
+	return true;
+}
+
+void PopLib::DecodeIMAADPCM(const uint8_t *theData, int theNumFrames, int theChannels, int16_t *theSamples)
+{
+	IMAState aStates[2] = {{0, 0}, {0, 0}};
+	int aNumSamples = theNumFrames * theChannels;
+
+	if (theChannels == 2)
+	{
+		for (int i = 0; i < theNumFrames; i++)
+		{
+			uint8_t aByte = theData[i];
+			theSamples[i * 2] = IMADecodeNibble(aStates[0], aByte & 0x0F);
+			theSamples[i * 2 + 1] = IMADecodeNibble(aStates[1], aByte >> 4);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < aNumSamples; i++)
+			theSamples[i] = IMADecodeNibble(aStates[0], (theData[i >> 1] >> ((i & 1) * 4)) & 0x0F);
+	}
+}
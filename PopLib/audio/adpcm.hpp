@@ -0,0 +1,21 @@
+#ifndef __ADPCM_HPP__
+#define __ADPCM_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+
+namespace PopLib
+{
+
+// IMA-ADPCM, 4 bits per sample.  Mono packs two samples per byte, low nibble first, and stereo packs
+// one frame per byte with the left channel in the low nibble.  There are no block headers, a sound is
+// always decoded from the start.
+int GetIMAADPCMSize(int theNumFrames, int theChannels);
+bool EncodeIMAADPCM(const int16_t *theSamples, int theNumFrames, int theChannels, std::vector<uint8_t> &theData);
+void DecodeIMAADPCM(const uint8_t *theData, int theNumFrames, int theChannels, int16_t *theSamples);
+
+} // namespace PopLib
+
+#endif
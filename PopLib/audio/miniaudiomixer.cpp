@@ -0,0 +1,723 @@
+#include "miniaudiomixer.hpp"
+#include <SDL3/SDL.h>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define MIXER_SSE2
+#endif
+
+using namespace PopLib;
+
+#define MIXER_RAMP_FRAMES 64
+
+enum MixerCommandType
+{
+	MixerCommand_PlaySound,
+	MixerCommand_PlayStream,
+	MixerCommand_Stop,
+	MixerCommand_SetGain,
+	MixerCommand_SetPitch,
+	MixerCommand_SetPaused,
+	MixerCommand_Fade,
+	MixerCommand_SetBusGain
+};
+
+void PopLib::GetMixerGains(double theVolume, int thePan, float *theGainL, float *theGainR)
+{
+	thePan = std::clamp(thePan, -10000, 10000);
+
+	*theGainL = (float)theVolume;
+	*theGainR = (float)theVolume;
+	if (thePan < 0)
+		*theGainR *= (float)std::pow(10.0, thePan / 2000.0);
+	else if (thePan > 0)
+		*theGainL *= (float)std::pow(10.0, -thePan / 2000.0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+MixerStream::MixerStream(int theNumFrames)
+{
+	mNumFrames = 1;
+	while ((int)mNumFrames < theNumFrames)
+		mNumFrames <<= 1;
+
+	mBuffer.resize((size_t)mNumFrames * 2);
+	mReadPos = 0;
+	mWritePos = 0;
+	mEnded = false;
+}
+
+int MixerStream::GetQueuedFrames()
+{
+	return (int)(mWritePos.load(std::memory_order_acquire) - mReadPos.load(std::memory_order_acquire));
+}
+
+int MixerStream::GetWriteRegion(float **theFrames)
+{
+	uint32_t aWritePos = mWritePos.load(std::memory_order_relaxed);
+	uint32_t aFree = mNumFrames - (aWritePos - mReadPos.load(std::memory_order_acquire));
+	uint32_t anOffset = aWritePos & (mNumFrames - 1);
+
+	*theFrames = &mBuffer[(size_t)anOffset * 2];
+	return (int)std::min(aFree, mNumFrames - anOffset);
+}
+
+void MixerStream::CommitWrite(int theNumFrames)
+{
+	mWritePos.store(mWritePos.load(std::memory_order_relaxed) + theNumFrames, std::memory_order_release);
+}
+
+int MixerStream::GetReadRegion(const float **theFrames)
+{
+	uint32_t aReadPos = mReadPos.load(std::memory_order_relaxed);
+	uint32_t aQueued = mWritePos.load(std::memory_order_acquire) - aReadPos;
+	uint32_t anOffset = aReadPos & (mNumFrames - 1);
+
+	*theFrames = &mBuffer[(size_t)anOffset * 2];
+	return (int)std::min(aQueued, mNumFrames - anOffset);
+}
+
+void MixerStream::CommitRead(int theNumFrames)
+{
+	mReadPos.store(mReadPos.load(std::memory_order_relaxed) + theNumFrames, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+MiniaudioMixer::MiniaudioMixer(MixerDevice theDevice, int theSampleRate)
+{
+	mHasContext = false;
+	mHasDevice = false;
+	mSampleRate = (theSampleRate > 0) ? theSampleRate : 44100;
+
+	mCommandHead = 0;
+	mCommandTail = 0;
+	mNextTicket = 1;
+
+	memset(mVoices, 0, sizeof(mVoices));
+	for (int i = 0; i < MIXER_MAX_VOICES; i++)
+	{
+		mFinishedTickets[i] = 0;
+		mVoiceSources[i] = nullptr;
+	}
+	for (int i = 0; i < Num_MixerBuses; i++)
+		mBusGains[i] = 1.0f;
+
+	mActiveVoices = 0;
+	mFramesMixed = 0;
+	mMixTicks = 0;
+	mDroppedCommands = 0;
+	mLoadStartTicks = SDL_GetPerformanceCounter();
+	mLoadStartMixTicks = 0;
+	mLoad = 0;
+
+	if (theDevice == MixerDevice_None)
+		return;
+
+	if (theDevice == MixerDevice_Null)
+	{
+		ma_backend aBackend = ma_backend_null;
+		if (ma_context_init(&aBackend, 1, nullptr, &mContext) != MA_SUCCESS)
+		{
+			SDL_Log("Failed to initialize miniaudio's null backend!\n");
+			return;
+		}
+
+		mHasContext = true;
+	}
+
+	ma_device_config aConfig = ma_device_config_init(ma_device_type_playback);
+	aConfig.playback.format = ma_format_f32;
+	aConfig.playback.channels = 2;
+	aConfig.sampleRate = theSampleRate; // 0 takes the device's own
+	aConfig.dataCallback = DataCallback;
+	aConfig.pUserData = this;
+
+	if (ma_device_init(mHasContext ? &mContext : nullptr, &aConfig, &mDevice) != MA_SUCCESS)
+	{
+		SDL_Log("Failed to open miniaudio device!\n");
+		return;
+	}
+
+	mSampleRate = mDevice.sampleRate;
+	mHasDevice = true;
+
+	if (ma_device_start(&mDevice) != MA_SUCCESS)
+	{
+		SDL_Log("Failed to start miniaudio device!\n");
+		ma_device_uninit(&mDevice);
+		mHasDevice = false;
+	}
+}
+
+MiniaudioMixer::~MiniaudioMixer()
+{
+	if (mHasDevice)
+		ma_device_uninit(&mDevice);
+	if (mHasContext)
+		ma_context_uninit(&mContext);
+
+	// With the device gone nothing is reading any more
+	for (Garbage &aGarbage : mGarbage)
+	{
+		delete aGarbage.mSound;
+		delete aGarbage.mStream;
+	}
+}
+
+bool MiniaudioMixer::IsRunning()
+{
+	return mHasDevice;
+}
+
+int MiniaudioMixer::GetSampleRate()
+{
+	return mSampleRate;
+}
+
+void MiniaudioMixer::DataCallback(ma_device *theDevice, void *theOutput, const void *theInput,
+								  ma_uint32 theNumFrames)
+{
+	((MiniaudioMixer *)theDevice->pUserData)->Mix((float *)theOutput, (int)theNumFrames);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool MiniaudioMixer::PushCommand(MixerCommand &theCommand)
+{
+	// If the mixer isn't keeping up (or isn't running at all) it's better to lose a command than to stall,
+	// but only the ones that adjust a voice get dropped early.  Losing a stop would leave a voice on.
+	bool isStartOrStop = (theCommand.mType == MixerCommand_PlaySound) || (theCommand.mType == MixerCommand_PlayStream) ||
+						 (theCommand.mType == MixerCommand_Stop) ||
+						 ((theCommand.mType == MixerCommand_Fade) && theCommand.mStopAtFadeEnd);
+	uint32_t aLimit = isStartOrStop ? MIXER_MAX_COMMANDS : (MIXER_MAX_COMMANDS - MIXER_RESERVED_COMMANDS);
+
+	uint32_t aHead = mCommandHead.load(std::memory_order_relaxed);
+	if (aHead - mCommandTail.load(std::memory_order_acquire) >= aLimit)
+	{
+		mDroppedCommands++;
+		return false;
+	}
+
+	mCommands[aHead % MIXER_MAX_COMMANDS] = theCommand;
+	mCommandHead.store(aHead + 1, std::memory_order_release);
+	return true;
+}
+
+uint32_t MiniaudioMixer::PlaySound(int theVoice, const MixerSound *theSound, bool looping, float theGainL,
+								   float theGainR, double thePitch, int theBus)
+{
+	MixerCommand aCommand = {};
+	aCommand.mType = MixerCommand_PlaySound;
+	aCommand.mVoice = theVoice;
+	aCommand.mTicket = mNextTicket++;
+	aCommand.mSound = theSound;
+	aCommand.mLooping = looping;
+	aCommand.mGainL = theGainL;
+	aCommand.mGainR = theGainR;
+	aCommand.mPitch = thePitch;
+	aCommand.mFade = 1.0f;
+	aCommand.mBus = theBus;
+
+	return PushCommand(aCommand) ? aCommand.mTicket : 0;
+}
+
+uint32_t MiniaudioMixer::PlayStream(int theVoice, MixerStream *theStream, float theFade, int theBus)
+{
+	MixerCommand aCommand = {};
+	aCommand.mType = MixerCommand_PlayStream;
+	aCommand.mVoice = theVoice;
+	aCommand.mTicket = mNextTicket++;
+	aCommand.mStream = theStream;
+	aCommand.mGainL = 1.0f;
+	aCommand.mGainR = 1.0f;
+	aCommand.mPitch = 1.0;
+	aCommand.mFade = theFade;
+	aCommand.mBus = theBus;
+
+	return PushCommand(aCommand) ? aCommand.mTicket : 0;
+}
+
+void MiniaudioMixer::StopVoice(int theVoice)
+{
+	MixerCommand aCommand = {};
+	aCommand.mType = MixerCommand_Stop;
+	aCommand.mVoice = theVoice;
+	PushCommand(aCommand);
+}
+
+void MiniaudioMixer::SetVoiceGain(int theVoice, float theGainL, float theGainR)
+{
+	MixerCommand aCommand = {};
+	aCommand.mType = MixerCommand_SetGain;
+	aCommand.mVoice = theVoice;
+	aCommand.mGainL = theGainL;
+	aCommand.mGainR = theGainR;
+	PushCommand(aCommand);
+}
+
+void MiniaudioMixer::SetVoicePitch(int theVoice, double thePitch)
+{
+	MixerCommand aCommand = {};
+	aCommand.mType = MixerCommand_SetPitch;
+	aCommand.mVoice = theVoice;
+	aCommand.mPitch = thePitch;
+	PushCommand(aCommand);
+}
+
+void MiniaudioMixer::SetVoicePaused(int theVoice, bool isPaused)
+{
+	MixerCommand aCommand = {};
+	aCommand.mType = MixerCommand_SetPaused;
+	aCommand.mVoice = theVoice;
+	aCommand.mLooping = isPaused;
+	PushCommand(aCommand);
+}
+
+void MiniaudioMixer::FadeVoice(int theVoice, float theFade, int theNumFrames, bool stopAtEnd)
+{
+	MixerCommand aCommand = {};
+	aCommand.mType = MixerCommand_Fade;
+	aCommand.mVoice = theVoice;
+	aCommand.mFade = theFade;
+	aCommand.mFadeFrames = theNumFrames;
+	aCommand.mStopAtFadeEnd = stopAtEnd;
+	PushCommand(aCommand);
+}
+
+void MiniaudioMixer::SetBusGain(int theBus, float theGain)
+{
+	MixerCommand aCommand = {};
+	aCommand.mType = MixerCommand_SetBusGain;
+	aCommand.mBus = theBus;
+	aCommand.mGainL = theGain;
+	PushCommand(aCommand);
+}
+
+bool MiniaudioMixer::IsVoicePlaying(int theVoice, uint32_t theTicket)
+{
+	if (theTicket == 0)
+		return false;
+
+	return (int32_t)(theTicket - mFinishedTickets[theVoice].load(std::memory_order_acquire)) > 0;
+}
+
+void MiniaudioMixer::DeleteWhenUnused(MixerSound *theSound)
+{
+	mGarbage.push_back({theSound, nullptr, mCommandHead.load(std::memory_order_relaxed)});
+}
+
+void MiniaudioMixer::DeleteWhenUnused(MixerStream *theStream)
+{
+	mGarbage.push_back({nullptr, theStream, mCommandHead.load(std::memory_order_relaxed)});
+}
+
+void MiniaudioMixer::CollectGarbage()
+{
+	// Whoever hands something over has already queued the stops for the voices using it, so once the
+	// mixer has read past those nothing new starts on it.  A voice is still checked in case its stop
+	// didn't fit in the queue.  Without a device nobody reads, and the destructor cleans up.
+	uint32_t aTail = mCommandTail.load(std::memory_order_acquire);
+	for (size_t i = 0; i < mGarbage.size();)
+	{
+		bool isUnused = (int32_t)(aTail - mGarbage[i].mCommandPos) >= 0;
+		const void *aSource = (mGarbage[i].mSound != nullptr) ? (const void *)mGarbage[i].mSound
+															  : (const void *)mGarbage[i].mStream;
+		for (int aVoice = 0; isUnused && (aVoice < MIXER_MAX_VOICES); aVoice++)
+			isUnused = mVoiceSources[aVoice].load(std::memory_order_acquire) != aSource;
+
+		if (isUnused)
+		{
+			delete mGarbage[i].mSound;
+			delete mGarbage[i].mStream;
+			mGarbage[i] = mGarbage.back();
+			mGarbage.pop_back();
+		}
+		else
+			i++;
+	}
+}
+
+MixerStats MiniaudioMixer::GetStats()
+{
+	uint64_t aNow = SDL_GetPerformanceCounter();
+	uint64_t aFrequency = SDL_GetPerformanceFrequency();
+	uint64_t aMixTicks = mMixTicks.load(std::memory_order_relaxed);
+	if (aNow - mLoadStartTicks >= aFrequency)
+	{
+		mLoad = (double)(aMixTicks - mLoadStartMixTicks) / (aNow - mLoadStartTicks);
+		mLoadStartTicks = aNow;
+		mLoadStartMixTicks = aMixTicks;
+	}
+
+	MixerStats aStats;
+	aStats.mActiveVoices = mActiveVoices.load(std::memory_order_relaxed);
+	aStats.mFramesMixed = mFramesMixed.load(std::memory_order_relaxed);
+	aStats.mMixTime = aMixTicks * 1000.0 / aFrequency;
+	aStats.mLoad = mLoad;
+	aStats.mDroppedCommands = mDroppedCommands.load(std::memory_order_relaxed);
+	return aStats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MiniaudioMixer::ProcessCommands()
+{
+	uint32_t aTail = mCommandTail.load(std::memory_order_relaxed);
+	uint32_t aHead = mCommandHead.load(std::memory_order_acquire);
+
+	for (; aTail != aHead; aTail++)
+	{
+		const MixerCommand &aCommand = mCommands[aTail % MIXER_MAX_COMMANDS];
+		if (aCommand.mType == MixerCommand_SetBusGain)
+		{
+			mBusGains[aCommand.mBus] = aCommand.mGainL;
+			continue;
+		}
+
+		MixerVoice &aVoice = mVoices[aCommand.mVoice];
+		switch (aCommand.mType)
+		{
+		case MixerCommand_PlaySound:
+		case MixerCommand_PlayStream:
+			if ((aVoice.mSound != nullptr) || (aVoice.mStream != nullptr))
+				FinishVoice(aVoice, aCommand.mVoice);
+
+			aVoice.mSound = aCommand.mSound;
+			aVoice.mStream = aCommand.mStream;
+			aVoice.mTicket = aCommand.mTicket;
+			aVoice.mBus = aCommand.mBus;
+			aVoice.mPosition = 0;
+			aVoice.mPitch = aCommand.mPitch;
+			aVoice.mLooping = aCommand.mLooping;
+			aVoice.mPaused = false;
+			aVoice.mGainL = aCommand.mGainL;
+			aVoice.mGainR = aCommand.mGainR;
+			aVoice.mRampFramesLeft = 0;
+			aVoice.mFade = aCommand.mFade;
+			aVoice.mFadeFramesLeft = 0;
+			aVoice.mStopAtFadeEnd = false;
+			mVoiceSources[aCommand.mVoice].store((aCommand.mSound != nullptr) ? (const void *)aCommand.mSound
+																			 : (const void *)aCommand.mStream,
+												 std::memory_order_release);
+			mActiveVoices++;
+			break;
+
+		case MixerCommand_Stop:
+			if ((aVoice.mSound != nullptr) || (aVoice.mStream != nullptr))
+				FinishVoice(aVoice, aCommand.mVoice);
+			break;
+
+		case MixerCommand_SetGain:
+			aVoice.mGainStepL = (aCommand.mGainL - aVoice.mGainL) / MIXER_RAMP_FRAMES;
+			aVoice.mGainStepR = (aCommand.mGainR - aVoice.mGainR) / MIXER_RAMP_FRAMES;
+			aVoice.mRampFramesLeft = MIXER_RAMP_FRAMES;
+			break;
+
+		case MixerCommand_SetPitch:
+			aVoice.mPitch = aCommand.mPitch;
+			break;
+
+		case MixerCommand_SetPaused:
+			aVoice.mPaused = aCommand.mLooping;
+			break;
+
+		case MixerCommand_Fade:
+			if (aCommand.mFadeFrames <= 0)
+			{
+				aVoice.mFade = aCommand.mFade;
+				aVoice.mFadeFramesLeft = 0;
+				if (aCommand.mStopAtFadeEnd && ((aVoice.mSound != nullptr) || (aVoice.mStream != nullptr)))
+					FinishVoice(aVoice, aCommand.mVoice);
+			}
+			else
+			{
+				aVoice.mFadeStep = (aCommand.mFade - aVoice.mFade) / aCommand.mFadeFrames;
+				aVoice.mFadeFramesLeft = aCommand.mFadeFrames;
+				aVoice.mStopAtFadeEnd = aCommand.mStopAtFadeEnd;
+			}
+			break;
+		}
+	}
+
+	mCommandTail.store(aTail, std::memory_order_release);
+}
+
+void MiniaudioMixer::FinishVoice(MixerVoice &theVoice, int theIndex)
+{
+	theVoice.mSound = nullptr;
+	theVoice.mStream = nullptr;
+	mVoiceSources[theIndex].store(nullptr, std::memory_order_release);
+	mActiveVoices--;
+	mFinishedTickets[theIndex].store(theVoice.mTicket, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+static void MixInt16Mono(const int16_t *theSrc, int theNumFrames, float theGainL, float theGainR, float *theDest)
+{
+	int i = 0;
+#ifdef MIXER_SSE2
+	__m128 aGain = _mm_setr_ps(theGainL, theGainR, theGainL, theGainR);
+	for (; i + 4 <= theNumFrames; i += 4)
+	{
+		// Sign extends four samples to 32 bits, then doubles each of them up into a left/right pair
+		__m128i aSamples = _mm_loadl_epi64((const __m128i *)(theSrc + i));
+		__m128i aWide = _mm_srai_epi32(_mm_unpacklo_epi16(aSamples, aSamples), 16);
+		__m128 aLo = _mm_cvtepi32_ps(_mm_unpacklo_epi32(aWide, aWide));
+		__m128 aHi = _mm_cvtepi32_ps(_mm_unpackhi_epi32(aWide, aWide));
+
+		float *aDest = theDest + i * 2;
+		_mm_storeu_ps(aDest, _mm_add_ps(_mm_loadu_ps(aDest), _mm_mul_ps(aLo, aGain)));
+		_mm_storeu_ps(aDest + 4, _mm_add_ps(_mm_loadu_ps(aDest + 4), _mm_mul_ps(aHi, aGain)));
+	}
+#endif
+	for (; i < theNumFrames; i++)
+	{
+		theDest[i * 2] += theSrc[i] * theGainL;
+		theDest[i * 2 + 1] += theSrc[i] * theGainR;
+	}
+}
+
+static void MixInt16Stereo(const int16_t *theSrc, int theNumFrames, float theGainL, float theGainR,
+						   float *theDest)
+{
+	int i = 0;
+#ifdef MIXER_SSE2
+	__m128 aGain = _mm_setr_ps(theGainL, theGainR, theGainL, theGainR);
+	for (; i + 4 <= theNumFrames; i += 4)
+	{
+		__m128i aSamples = _mm_loadu_si128((const __m128i *)(theSrc + i * 2));
+		__m128 aLo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(aSamples, aSamples), 16));
+		__m128 aHi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(aSamples, aSamples), 16));
+
+		float *aDest = theDest + i * 2;
+		_mm_storeu_ps(aDest, _mm_add_ps(_mm_loadu_ps(aDest), _mm_mul_ps(aLo, aGain)));
+		_mm_storeu_ps(aDest + 4, _mm_add_ps(_mm_loadu_ps(aDest + 4), _mm_mul_ps(aHi, aGain)));
+	}
+#endif
+	for (; i < theNumFrames; i++)
+	{
+		theDest[i * 2] += theSrc[i * 2] * theGainL;
+		theDest[i * 2 + 1] += theSrc[i * 2 + 1] * theGainR;
+	}
+}
+
+static void MixFloatStereo(const float *theSrc, int theNumFrames, float theGainL, float theGainR, float *theDest)
+{
+	int i = 0;
+#ifdef MIXER_SSE2
+	__m128 aGain = _mm_setr_ps(theGainL, theGainR, theGainL, theGainR);
+	for (; i + 2 <= theNumFrames; i += 2)
+	{
+		float *aDest = theDest + i * 2;
+		_mm_storeu_ps(aDest, _mm_add_ps(_mm_loadu_ps(aDest), _mm_mul_ps(_mm_loadu_ps(theSrc + i * 2), aGain)));
+	}
+#endif
+	for (; i < theNumFrames; i++)
+	{
+		theDest[i * 2] += theSrc[i * 2] * theGainL;
+		theDest[i * 2 + 1] += theSrc[i * 2 + 1] * theGainR;
+	}
+}
+
+static void ClampOutput(float *theOutput, int theNumSamples)
+{
+	int i = 0;
+#ifdef MIXER_SSE2
+	__m128 aMin = _mm_set1_ps(-1.0f);
+	__m128 aMax = _mm_set1_ps(1.0f);
+	for (; i + 4 <= theNumSamples; i += 4)
+		_mm_storeu_ps(theOutput + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(theOutput + i), aMin), aMax));
+#endif
+	for (; i < theNumSamples; i++)
+		theOutput[i] = std::clamp(theOutput[i], -1.0f, 1.0f);
+}
+
+// Steps the gain ramp and the fade by one frame.  Returns false when a fade that stops the voice is done.
+static inline bool StepVoiceGains(MixerVoice &theVoice)
+{
+	if (theVoice.mRampFramesLeft > 0)
+	{
+		theVoice.mGainL += theVoice.mGainStepL;
+		theVoice.mGainR += theVoice.mGainStepR;
+		theVoice.mRampFramesLeft--;
+	}
+
+	if (theVoice.mFadeFramesLeft > 0)
+	{
+		theVoice.mFade += theVoice.mFadeStep;
+		if (--theVoice.mFadeFramesLeft == 0)
+		{
+			theVoice.mFade = std::max(0.0f, theVoice.mFade);
+			if (theVoice.mStopAtFadeEnd)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// Returns false once the voice has finished
+bool MiniaudioMixer::MixSound(MixerVoice &theVoice, float *theOutput, int theNumFrames)
+{
+	const MixerSound *aSound = theVoice.mSound;
+	const int16_t *aSamples = aSound->mSamples.data();
+	int aChannels = aSound->mChannels;
+	int aNumFrames = aSound->mNumFrames;
+	float aBusGain = mBusGains[theVoice.mBus] / 32768.0f;
+	double aStep = theVoice.mPitch * aSound->mSampleRate / mSampleRate;
+
+	int aFrame = 0;
+	while (aFrame < theNumFrames)
+	{
+		int aPos = (int)theVoice.mPosition;
+		bool isSteady = (theVoice.mRampFramesLeft == 0) && (theVoice.mFadeFramesLeft == 0);
+
+		if (isSteady && (aStep == 1.0) && (theVoice.mPosition == aPos))
+		{
+			int aCount = std::min(theNumFrames - aFrame, aNumFrames - aPos);
+			float aGainL = theVoice.mGainL * theVoice.mFade * aBusGain;
+			float aGainR = theVoice.mGainR * theVoice.mFade * aBusGain;
+			if (aChannels == 1)
+				MixInt16Mono(aSamples + aPos, aCount, aGainL, aGainR, theOutput + aFrame * 2);
+			else
+				MixInt16Stereo(aSamples + aPos * 2, aCount, aGainL, aGainR, theOutput + aFrame * 2);
+
+			aFrame += aCount;
+			theVoice.mPosition += aCount;
+		}
+		else
+		{
+			// Linear interpolation between neighbouring frames, with the gains stepped every frame
+			for (; aFrame < theNumFrames; aFrame++)
+			{
+				aPos = (int)theVoice.mPosition;
+				if (aPos >= aNumFrames)
+					break;
+
+				int aNextPos = aPos + 1;
+				if (aNextPos >= aNumFrames)
+					aNextPos = theVoice.mLooping ? 0 : aPos;
+
+				float aFrac = (float)(theVoice.mPosition - aPos);
+				float aLeft, aRight;
+				if (aChannels == 1)
+				{
+					aLeft = aSamples[aPos] + (aSamples[aNextPos] - aSamples[aPos]) * aFrac;
+					aRight = aLeft;
+				}
+				else
+				{
+					aLeft = aSamples[aPos * 2] + (aSamples[aNextPos * 2] - aSamples[aPos * 2]) * aFrac;
+					aRight = aSamples[aPos * 2 + 1] + (aSamples[aNextPos * 2 + 1] - aSamples[aPos * 2 + 1]) * aFrac;
+				}
+
+				float aGain = theVoice.mFade * aBusGain;
+				theOutput[aFrame * 2] += aLeft * theVoice.mGainL * aGain;
+				theOutput[aFrame * 2 + 1] += aRight * theVoice.mGainR * aGain;
+				theVoice.mPosition += aStep;
+
+				if (!StepVoiceGains(theVoice))
+					return false;
+
+				// Drops back to the fast path once things have settled
+				if ((aStep == 1.0) && (theVoice.mRampFramesLeft == 0) && (theVoice.mFadeFramesLeft == 0) &&
+					(theVoice.mPosition == (int)theVoice.mPosition))
+				{
+					aFrame++;
+					break;
+				}
+			}
+		}
+
+		if (theVoice.mPosition >= aNumFrames)
+		{
+			if (!theVoice.mLooping)
+				return false;
+
+			theVoice.mPosition = std::fmod(theVoice.mPosition, (double)aNumFrames);
+		}
+	}
+
+	return true;
+}
+
+bool MiniaudioMixer::MixStream(MixerVoice &theVoice, float *theOutput, int theNumFrames)
+{
+	MixerStream *aStream = theVoice.mStream;
+	float aBusGain = mBusGains[theVoice.mBus];
+
+	int aFrame = 0;
+	while (aFrame < theNumFrames)
+	{
+		const float *aSrc;
+		int aCount = std::min(aStream->GetReadRegion(&aSrc), theNumFrames - aFrame);
+		if (aCount == 0)
+		{
+			// Whatever's feeding us fell behind, so this block has a gap in it rather than a stall
+			if (aStream->mEnded.load(std::memory_order_acquire) && (aStream->GetQueuedFrames() == 0))
+				return false;
+			break;
+		}
+
+		if ((theVoice.mRampFramesLeft == 0) && (theVoice.mFadeFramesLeft == 0))
+		{
+			MixFloatStereo(aSrc, aCount, theVoice.mGainL * theVoice.mFade * aBusGain,
+						   theVoice.mGainR * theVoice.mFade * aBusGain, theOutput + aFrame * 2);
+		}
+		else
+		{
+			for (int i = 0; i < aCount; i++)
+			{
+				float aGain = theVoice.mFade * aBusGain;
+				theOutput[(aFrame + i) * 2] += aSrc[i * 2] * theVoice.mGainL * aGain;
+				theOutput[(aFrame + i) * 2 + 1] += aSrc[i * 2 + 1] * theVoice.mGainR * aGain;
+
+				if (!StepVoiceGains(theVoice))
+				{
+					aStream->CommitRead(i + 1);
+					return false;
+				}
+			}
+		}
+
+		aStream->CommitRead(aCount);
+		aFrame += aCount;
+	}
+
+	return true;
+}
+
+void MiniaudioMixer::MixVoice(MixerVoice &theVoice, int theIndex, float *theOutput, int theNumFrames)
+{
+	if (theVoice.mPaused)
+		return;
+
+	bool isPlaying = (theVoice.mSound != nullptr) ? MixSound(theVoice, theOutput, theNumFrames)
+												  : MixStream(theVoice, theOutput, theNumFrames);
+	if (!isPlaying)
+		FinishVoice(theVoice, theIndex);
+}
+
+void MiniaudioMixer::Mix(float *theOutput, int theNumFrames)
+{
+	uint64_t aStartTicks = SDL_GetPerformanceCounter();
+
+	ProcessCommands();
+
+	memset(theOutput, 0, sizeof(float) * 2 * theNumFrames);
+	for (int i = 0; i < MIXER_MAX_VOICES; i++)
+	{
+		MixerVoice &aVoice = mVoices[i];
+		if ((aVoice.mSound != nullptr) || (aVoice.mStream != nullptr))
+			MixVoice(aVoice, i, theOutput, theNumFrames);
+	}
+
+	ClampOutput(theOutput, theNumFrames * 2);
+
+	mFramesMixed.fetch_add(theNumFrames, std::memory_order_relaxed);
+	mMixTicks.fetch_add(SDL_GetPerformanceCounter() - aStartTicks, std::memory_order_relaxed);
+}
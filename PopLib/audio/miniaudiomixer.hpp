@@ -0,0 +1,200 @@
+#ifndef __MINIAUDIOMIXER_HPP__
+#define __MINIAUDIOMIXER_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+#include "soundmanager.hpp"
+#include <atomic>
+#include <miniaudio.h>
+
+namespace PopLib
+{
+
+#define MIXER_MAX_MUSIC_VOICES 8
+#define MIXER_MAX_VOICES (MAX_CHANNELS + MIXER_MAX_MUSIC_VOICES) // sound channels first, then music
+#define MIXER_MAX_COMMANDS 4096
+#define MIXER_RESERVED_COMMANDS 512 // the end of the queue is kept for the commands that start and stop voices
+
+enum MixerDevice
+{
+	MixerDevice_Default, // the system's output
+	MixerDevice_Null,	 // miniaudio's null backend, runs on a timer without any audio hardware
+	MixerDevice_None	 // no device at all, the owner calls Mix itself
+};
+
+enum MixerBus
+{
+	MixerBus_Sound,
+	MixerBus_Music,
+	Num_MixerBuses
+};
+
+// A whole sound in memory, 16 bit interleaved mono or stereo at any rate
+struct MixerSound
+{
+	std::vector<int16_t> mSamples;
+	int mNumFrames;
+	int mChannels;
+	int mSampleRate;
+};
+
+// Stereo float frames at the mixer's rate.  One thread writes, the mixer reads.
+class MixerStream
+{
+  protected:
+	std::vector<float> mBuffer;
+	uint32_t mNumFrames; // power of two
+	std::atomic<uint32_t> mReadPos;
+	std::atomic<uint32_t> mWritePos;
+
+  public:
+	std::atomic<bool> mEnded; // nothing more is coming, the voice finishes once it's drained
+
+  public:
+	MixerStream(int theNumFrames);
+
+	int GetQueuedFrames();
+	int GetWriteRegion(float **theFrames); // contiguous free frames, write them and then CommitWrite
+	void CommitWrite(int theNumFrames);
+	int GetReadRegion(const float **theFrames);
+	void CommitRead(int theNumFrames);
+};
+
+struct MixerCommand
+{
+	int mType;
+	int mVoice;
+	uint32_t mTicket;
+	const MixerSound *mSound;
+	MixerStream *mStream;
+	bool mLooping;
+	float mGainL;
+	float mGainR;
+	double mPitch;
+	float mFade;
+	int mFadeFrames;
+	bool mStopAtFadeEnd;
+	int mBus;
+};
+
+struct MixerVoice
+{
+	const MixerSound *mSound;
+	MixerStream *mStream;
+	uint32_t mTicket;
+	int mBus;
+	double mPosition; // in source frames
+	double mPitch;
+	bool mLooping;
+	bool mPaused;
+
+	float mGainL;
+	float mGainR;
+	float mGainStepL;
+	float mGainStepR;
+	int mRampFramesLeft; // gain changes are spread over a few frames so they don't click
+
+	float mFade; // on top of the gain, stepped every frame until mFadeFramesLeft runs out
+	float mFadeStep;
+	int mFadeFramesLeft;
+	bool mStopAtFadeEnd;
+};
+
+struct MixerStats
+{
+	int mActiveVoices;
+	uint64_t mFramesMixed;
+	double mMixTime; // ms spent in Mix, all told
+	double mLoad;	 // share of the real time budget the last second's mixing took
+	int mDroppedCommands;
+};
+
+// Mixes every voice of a single miniaudio device into float stereo.  Everything but Mix is for the game
+// thread only, and it talks to the mixing thread through a lock free command queue: each Play hands
+// back a ticket, and the voice is playing until the mixer marks that ticket finished.  Sounds and
+// streams a voice might still be reading are handed to DeleteWhenUnused rather than deleted, and
+// they're only freed once the mixer has read every command before that and no voice is on them.
+class MiniaudioMixer
+{
+  protected:
+	ma_context mContext;
+	ma_device mDevice;
+	bool mHasContext;
+	bool mHasDevice;
+	int mSampleRate;
+
+	MixerCommand mCommands[MIXER_MAX_COMMANDS];
+	std::atomic<uint32_t> mCommandHead; // next to be written, game thread
+	std::atomic<uint32_t> mCommandTail; // next to be read, mixing thread
+	uint32_t mNextTicket;
+
+	MixerVoice mVoices[MIXER_MAX_VOICES];
+	std::atomic<uint32_t> mFinishedTickets[MIXER_MAX_VOICES];
+	std::atomic<const void *> mVoiceSources[MIXER_MAX_VOICES]; // the sound or stream each voice is reading
+	float mBusGains[Num_MixerBuses];
+
+	struct Garbage
+	{
+		MixerSound *mSound;
+		MixerStream *mStream;
+		uint32_t mCommandPos; // freed once the mixer has read this far
+	};
+	std::vector<Garbage> mGarbage;
+
+	std::atomic<int> mActiveVoices;
+	std::atomic<uint64_t> mFramesMixed;
+	std::atomic<uint64_t> mMixTicks;
+	std::atomic<int> mDroppedCommands;
+	uint64_t mLoadStartTicks;
+	uint64_t mLoadStartMixTicks;
+	double mLoad;
+
+  protected:
+	static void DataCallback(ma_device *theDevice, void *theOutput, const void *theInput, ma_uint32 theNumFrames);
+
+	bool PushCommand(MixerCommand &theCommand);
+	void ProcessCommands();
+	void FinishVoice(MixerVoice &theVoice, int theIndex);
+	void MixVoice(MixerVoice &theVoice, int theIndex, float *theOutput, int theNumFrames);
+	bool MixSound(MixerVoice &theVoice, float *theOutput, int theNumFrames);
+	bool MixStream(MixerVoice &theVoice, float *theOutput, int theNumFrames);
+
+  public:
+	MiniaudioMixer(MixerDevice theDevice = MixerDevice_Default, int theSampleRate = 0);
+	virtual ~MiniaudioMixer();
+
+	bool IsRunning();
+	int GetSampleRate();
+
+	// Adds every voice into theOutput, which is interleaved stereo.  The device's thread calls this, or
+	// whoever made a MixerDevice_None mixer.
+	void Mix(float *theOutput, int theNumFrames);
+
+	uint32_t PlaySound(int theVoice, const MixerSound *theSound, bool looping, float theGainL, float theGainR,
+					   double thePitch, int theBus = MixerBus_Sound);
+	uint32_t PlayStream(int theVoice, MixerStream *theStream, float theFade, int theBus = MixerBus_Music);
+	void StopVoice(int theVoice);
+	void SetVoiceGain(int theVoice, float theGainL, float theGainR);
+	void SetVoicePitch(int theVoice, double thePitch);
+	void SetVoicePaused(int theVoice, bool isPaused);
+	void FadeVoice(int theVoice, float theFade, int theNumFrames, bool stopAtEnd); // 0 frames sets it right away
+	void SetBusGain(int theBus, float theGain);
+
+	bool IsVoicePlaying(int theVoice, uint32_t theTicket);
+
+	void DeleteWhenUnused(MixerSound *theSound);
+	void DeleteWhenUnused(MixerStream *theStream);
+	void CollectGarbage();
+
+	MixerStats GetStats();
+};
+
+// Linear gains for a SoundInstance style volume and pan, the pan in hundredths of a dB with negative
+// turning the right side down
+void GetMixerGains(double theVolume, int thePan, float *theGainL, float *theGainR);
+
+} // namespace PopLib
+
+#endif
@@ -0,0 +1,403 @@
+#include "miniaudiomusicinterface.hpp"
+#include <SDL3/SDL.h>
+
+using namespace PopLib;
+
+static ma_result MusicReadProc(ma_decoder *theDecoder, void *theBuffer, size_t theBytesToRead, size_t *theBytesRead)
+{
+	size_t aBytesRead = p_fread(theBuffer, 1, theBytesToRead, (PFILE *)theDecoder->pUserData);
+	if (theBytesRead != nullptr)
+		*theBytesRead = aBytesRead;
+
+	return ((aBytesRead == 0) && (theBytesToRead > 0)) ? MA_AT_END : MA_SUCCESS;
+}
+
+static ma_result MusicSeekProc(ma_decoder *theDecoder, ma_int64 theOffset, ma_seek_origin theOrigin)
+{
+	int aWhence = SEEK_SET;
+	if (theOrigin == ma_seek_origin_current)
+		aWhence = SEEK_CUR;
+	else if (theOrigin == ma_seek_origin_end)
+		aWhence = SEEK_END;
+
+	return (p_fseek((PFILE *)theDecoder->pUserData, (long)theOffset, aWhence) == 0) ? MA_SUCCESS : MA_ERROR;
+}
+
+MiniaudioMusicInfo::MiniaudioMusicInfo()
+{
+	mFile = nullptr;
+	mStream = nullptr;
+	mVoice = -1;
+	mTicket = 0;
+	mLooping = false;
+	mPaused = false;
+	mVolume = 0.0;
+	mVolumeCap = 1.0;
+	mFadeVolume = 0.0;
+	mFadeStartTick = 0;
+	mFadeTime = 0.0;
+	mStopOnFade = false;
+}
+
+double MiniaudioMusicInfo::GetVolume()
+{
+	if (mFadeTime <= 0.0)
+		return mVolume;
+
+	double aFraction = std::min(1.0, (SDL_GetTicks() - mFadeStartTick) / mFadeTime);
+	return mVolume + (mFadeVolume - mVolume) * aFraction;
+}
+
+MiniaudioMusicInterface::MiniaudioMusicInterface(std::shared_ptr<MiniaudioMixer> theMixer)
+{
+	mMixer = theMixer;
+	mStreamFrames = mMixer->GetSampleRate() * MUSIC_STREAM_SECONDS;
+	mMaxFillFrames = mMixer->GetSampleRate() / 4; // several times what a frame plays, so it still catches up
+	mFadeStepTime = 10.0;
+}
+
+MiniaudioMusicInterface::~MiniaudioMusicInterface()
+{
+	UnloadAllMusic();
+}
+
+bool MiniaudioMusicInterface::LoadMusic(int theSongId, const std::string &theFileName)
+{
+	PFILE *aFP = p_fopen(theFileName.c_str(), "rb");
+	if (!aFP)
+		return false;
+
+	MiniaudioMusicInfo *aMusicInfo = new MiniaudioMusicInfo();
+	aMusicInfo->mFile = aFP;
+
+	ma_decoder_config aConfig = ma_decoder_config_init(ma_format_f32, 2, mMixer->GetSampleRate());
+	if (ma_decoder_init(MusicReadProc, MusicSeekProc, aFP, &aConfig, &aMusicInfo->mDecoder) != MA_SUCCESS)
+	{
+		p_fclose(aFP);
+		delete aMusicInfo;
+		return false;
+	}
+
+	UnloadMusic(theSongId);
+	mMusicMap.insert(MiniaudioMusicMap::value_type(theSongId, aMusicInfo));
+
+	return true;
+}
+
+int MiniaudioMusicInterface::FindFreeVoice()
+{
+	for (int aVoice = MAX_CHANNELS; aVoice < MIXER_MAX_VOICES; aVoice++)
+	{
+		bool inUse = false;
+		for (MiniaudioMusicMap::iterator anItr = mMusicMap.begin(); anItr != mMusicMap.end(); ++anItr)
+		{
+			if (anItr->second->mVoice == aVoice)
+			{
+				inUse = true;
+				break;
+			}
+		}
+
+		if (!inUse)
+			return aVoice;
+	}
+
+	return -1;
+}
+
+void MiniaudioMusicInterface::StopStream(MiniaudioMusicInfo *theMusicInfo)
+{
+	if (theMusicInfo->mVoice != -1)
+		mMixer->StopVoice(theMusicInfo->mVoice);
+
+	if (theMusicInfo->mStream != nullptr)
+		mMixer->DeleteWhenUnused(theMusicInfo->mStream);
+
+	theMusicInfo->mStream = nullptr;
+	theMusicInfo->mVoice = -1;
+	theMusicInfo->mTicket = 0;
+	theMusicInfo->mPaused = false;
+}
+
+void MiniaudioMusicInterface::FillStream(MiniaudioMusicInfo *theMusicInfo)
+{
+	MixerStream *aStream = theMusicInfo->mStream;
+	bool justLooped = false;
+	int aFramesLeft = mMaxFillFrames;
+
+	while (!aStream->mEnded && (aFramesLeft > 0))
+	{
+		float *aFrames;
+		int aFreeFrames = std::min(aStream->GetWriteRegion(&aFrames), aFramesLeft);
+		if (aFreeFrames == 0)
+			break;
+
+		ma_uint64 aFramesRead = 0;
+		ma_decoder_read_pcm_frames(&theMusicInfo->mDecoder, aFrames, aFreeFrames, &aFramesRead);
+		aStream->CommitWrite((int)aFramesRead);
+		aFramesLeft -= (int)aFramesRead;
+
+		if ((int)aFramesRead == aFreeFrames)
+		{
+			justLooped = false;
+			continue;
+		}
+
+		// At the end of the song.  Coming straight back here after a loop means there's nothing to play.
+		if (theMusicInfo->mLooping && !justLooped &&
+			(ma_decoder_seek_to_pcm_frame(&theMusicInfo->mDecoder, 0) == MA_SUCCESS))
+			justLooped = (aFramesRead == 0);
+		else
+			aStream->mEnded = true;
+	}
+}
+
+void MiniaudioMusicInterface::StartStream(MiniaudioMusicInfo *theMusicInfo, uint64_t theFrame, double theVolume)
+{
+	StopStream(theMusicInfo);
+
+	int aVoice = FindFreeVoice();
+	if (aVoice == -1)
+		return;
+
+	if (ma_decoder_seek_to_pcm_frame(&theMusicInfo->mDecoder, theFrame) != MA_SUCCESS)
+		ma_decoder_seek_to_pcm_frame(&theMusicInfo->mDecoder, 0);
+
+	theMusicInfo->mStream = new MixerStream(mStreamFrames);
+	theMusicInfo->mVoice = aVoice;
+	theMusicInfo->mVolume = theVolume;
+	theMusicInfo->mFadeTime = 0.0;
+	FillStream(theMusicInfo);
+
+	theMusicInfo->mTicket = mMixer->PlayStream(aVoice, theMusicInfo->mStream, (float)theVolume);
+}
+
+void MiniaudioMusicInterface::StartFade(MiniaudioMusicInfo *theMusicInfo, double theVolume, double theSpeed,
+										bool stopSong)
+{
+	theMusicInfo->mVolume = theMusicInfo->GetVolume();
+	theMusicInfo->mFadeVolume = theVolume;
+	theMusicInfo->mFadeStartTick = SDL_GetTicks();
+	theMusicInfo->mFadeTime =
+		(theSpeed > 0.0) ? std::abs(theVolume - theMusicInfo->mVolume) / theSpeed * mFadeStepTime : 0.0;
+	theMusicInfo->mStopOnFade = stopSong;
+
+	if (theMusicInfo->mTicket != 0)
+	{
+		int aNumFrames = (int)(theMusicInfo->mFadeTime * mMixer->GetSampleRate() / 1000.0);
+		mMixer->FadeVoice(theMusicInfo->mVoice, (float)theVolume, aNumFrames, stopSong && (theVolume <= 0.0));
+	}
+}
+
+void MiniaudioMusicInterface::PlayMusic(int theSongId, int theOffset, bool noLoop)
+{
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if (anItr != mMusicMap.end())
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		aMusicInfo->mLooping = !noLoop;
+		aMusicInfo->mStopOnFade = noLoop;
+		StartStream(aMusicInfo, (theOffset > 0) ? theOffset / 4 : 0, aMusicInfo->mVolumeCap);
+	}
+}
+
+void MiniaudioMusicInterface::StopMusic(int theSongId)
+{
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if (anItr != mMusicMap.end())
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		aMusicInfo->mVolume = 0.0;
+		aMusicInfo->mFadeTime = 0.0;
+		StopStream(aMusicInfo);
+	}
+}
+
+void MiniaudioMusicInterface::StopAllMusic()
+{
+	for (MiniaudioMusicMap::iterator anItr = mMusicMap.begin(); anItr != mMusicMap.end(); ++anItr)
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		aMusicInfo->mVolume = 0.0;
+		aMusicInfo->mFadeTime = 0.0;
+		StopStream(aMusicInfo);
+	}
+}
+
+void MiniaudioMusicInterface::UnloadMusic(int theSongId)
+{
+	StopMusic(theSongId);
+
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if (anItr != mMusicMap.end())
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		ma_decoder_uninit(&aMusicInfo->mDecoder);
+		p_fclose(aMusicInfo->mFile);
+		delete aMusicInfo;
+
+		mMusicMap.erase(anItr);
+	}
+}
+
+void MiniaudioMusicInterface::UnloadAllMusic()
+{
+	StopAllMusic();
+	for (MiniaudioMusicMap::iterator anItr = mMusicMap.begin(); anItr != mMusicMap.end(); ++anItr)
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		ma_decoder_uninit(&aMusicInfo->mDecoder);
+		p_fclose(aMusicInfo->mFile);
+		delete aMusicInfo;
+	}
+	mMusicMap.clear();
+}
+
+void MiniaudioMusicInterface::PauseMusic(int theSongId)
+{
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if ((anItr != mMusicMap.end()) && (anItr->second->mTicket != 0))
+	{
+		anItr->second->mPaused = true;
+		mMixer->SetVoicePaused(anItr->second->mVoice, true);
+	}
+}
+
+void MiniaudioMusicInterface::PauseAllMusic()
+{
+	for (MiniaudioMusicMap::iterator anItr = mMusicMap.begin(); anItr != mMusicMap.end(); ++anItr)
+	{
+		if (IsPlaying(anItr->first))
+			PauseMusic(anItr->first);
+	}
+}
+
+void MiniaudioMusicInterface::ResumeAllMusic()
+{
+	for (MiniaudioMusicMap::iterator anItr = mMusicMap.begin(); anItr != mMusicMap.end(); ++anItr)
+	{
+		if (anItr->second->mPaused)
+			ResumeMusic(anItr->first);
+	}
+}
+
+void MiniaudioMusicInterface::ResumeMusic(int theSongId)
+{
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if ((anItr != mMusicMap.end()) && (anItr->second->mTicket != 0))
+	{
+		anItr->second->mPaused = false;
+		mMixer->SetVoicePaused(anItr->second->mVoice, false);
+	}
+}
+
+void MiniaudioMusicInterface::FadeIn(int theSongId, int theOffset, double theSpeed, bool noLoop)
+{
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if (anItr != mMusicMap.end())
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		aMusicInfo->mLooping = !noLoop;
+
+		StartStream(aMusicInfo, (theOffset > 0) ? theOffset / 4 : 0, aMusicInfo->GetVolume());
+		StartFade(aMusicInfo, aMusicInfo->mVolumeCap, theSpeed, noLoop);
+	}
+}
+
+void MiniaudioMusicInterface::FadeOut(int theSongId, bool stopSong, double theSpeed)
+{
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if (anItr != mMusicMap.end())
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		if (aMusicInfo->GetVolume() != 0.0)
+			StartFade(aMusicInfo, 0.0, theSpeed, stopSong);
+		else
+			aMusicInfo->mStopOnFade = stopSong;
+	}
+}
+
+void MiniaudioMusicInterface::FadeOutAll(bool stopSong, double theSpeed)
+{
+	for (MiniaudioMusicMap::iterator anItr = mMusicMap.begin(); anItr != mMusicMap.end(); ++anItr)
+		StartFade(anItr->second, 0.0, theSpeed, stopSong);
+}
+
+void MiniaudioMusicInterface::SetVolume(double theVolume)
+{
+	mMixer->SetBusGain(MixerBus_Music, (float)theVolume);
+}
+
+void MiniaudioMusicInterface::SetSongVolume(int theSongId, double theVolume)
+{
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if (anItr != mMusicMap.end())
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		aMusicInfo->mVolume = theVolume;
+		aMusicInfo->mFadeTime = 0.0;
+		if (aMusicInfo->mTicket != 0)
+			mMixer->FadeVoice(aMusicInfo->mVoice, (float)theVolume, 0, false);
+	}
+}
+
+void MiniaudioMusicInterface::SetSongMaxVolume(int theSongId, double theMaxVolume)
+{
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if (anItr != mMusicMap.end())
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		aMusicInfo->mVolumeCap = theMaxVolume;
+		if (aMusicInfo->GetVolume() > theMaxVolume)
+			SetSongVolume(theSongId, theMaxVolume);
+	}
+}
+
+bool MiniaudioMusicInterface::IsPlaying(int theSongId)
+{
+	MiniaudioMusicMap::iterator anItr = mMusicMap.find(theSongId);
+	if (anItr != mMusicMap.end())
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+		return !aMusicInfo->mPaused && mMixer->IsVoicePlaying(aMusicInfo->mVoice, aMusicInfo->mTicket);
+	}
+
+	return false;
+}
+
+void MiniaudioMusicInterface::SetMusicAmplify(int theSongId, double theAmp)
+{
+}
+
+void MiniaudioMusicInterface::Update()
+{
+	for (MiniaudioMusicMap::iterator anItr = mMusicMap.begin(); anItr != mMusicMap.end(); ++anItr)
+	{
+		MiniaudioMusicInfo *aMusicInfo = anItr->second;
+
+		if ((aMusicInfo->mFadeTime > 0.0) && (SDL_GetTicks() - aMusicInfo->mFadeStartTick >= aMusicInfo->mFadeTime))
+		{
+			aMusicInfo->mVolume = aMusicInfo->mFadeVolume;
+			aMusicInfo->mFadeTime = 0.0;
+		}
+
+		if (aMusicInfo->mTicket == 0)
+			continue;
+
+		// Ran out, was faded out or got pushed off its voice
+		if (!mMixer->IsVoicePlaying(aMusicInfo->mVoice, aMusicInfo->mTicket))
+		{
+			if (aMusicInfo->mFadeTime > 0.0)
+			{
+				aMusicInfo->mVolume = aMusicInfo->mFadeVolume;
+				aMusicInfo->mFadeTime = 0.0;
+			}
+
+			StopStream(aMusicInfo);
+		}
+		else
+			FillStream(aMusicInfo);
+	}
+
+	mMixer->CollectGarbage();
+}
@@ -0,0 +1,191 @@
+#ifndef __MINIAUDIOMUSICINTERFACE_HPP__
+#define __MINIAUDIOMUSICINTERFACE_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "musicinterface.hpp"
+#include "miniaudiomixer.hpp"
+#include "paklib/pakinterface.hpp"
+#include <memory>
+
+namespace PopLib
+{
+
+// Longest main thread stall music plays through.  The loading thread is a job, so this covers things
+// like a synchronous resource group load or a hot reload, not a whole loading screen.
+#define MUSIC_STREAM_SECONDS 4
+
+/**
+ * @brief miniaudio music info
+ *
+ * a song decoded straight out of its PFILE while it plays
+ */
+class MiniaudioMusicInfo
+{
+  public:
+	/// @brief the open file, read from by mDecoder
+	PFILE *mFile;
+	/// @brief decodes to float stereo at the mixer's rate
+	ma_decoder mDecoder;
+	/// @brief what the mixer reads from, NULL while stopped
+	MixerStream *mStream;
+	/// @brief mixer voice, -1 while stopped
+	int mVoice;
+	/// @brief ticket of the last play on mVoice
+	uint32_t mTicket;
+	/// @brief true if going back to the start at the end
+	bool mLooping;
+	/// @brief true if paused
+	bool mPaused;
+	/// @brief volume before a fade, or the whole time if there's none
+	double mVolume;
+	/// @brief maximum volume
+	double mVolumeCap;
+	/// @brief volume the fade goes to
+	double mFadeVolume;
+	/// @brief ticks the fade started at
+	uint64_t mFadeStartTick;
+	/// @brief how long the fade takes, 0 if there's none
+	double mFadeTime;
+	/// @brief true if going to stop on fade
+	bool mStopOnFade;
+
+  public:
+	/// @brief constructor
+	MiniaudioMusicInfo();
+	/// @brief destructor
+	virtual ~MiniaudioMusicInfo() = default;
+
+	/// @brief volume right now, partway through a fade as the mixer has it
+	/// @return volume
+	double GetVolume();
+};
+
+/// @brief list
+typedef std::map<int, MiniaudioMusicInfo *> MiniaudioMusicMap;
+
+/**
+ * @brief miniaudio music interface
+ *
+ * parents MusicInterface, plays through the MiniaudioSoundManager's mixer.  Songs are streamed from
+ * their files, Update tops up what the mixer has to read, and fades run in the mixer frame by frame.
+ * Decoding happens on the main thread, so a song keeps playing through a main thread stall only as
+ * long as its stream lasts: MUSIC_STREAM_SECONDS when it's full.  Every Update decodes at most
+ * mMaxFillFrames, which keeps a big stream from costing a big hitch when a song starts.
+ */
+class MiniaudioMusicInterface : public MusicInterface
+{
+  protected:
+	/// @brief starts theMusicInfo over from theFrame
+	/// @param theMusicInfo
+	/// @param theFrame
+	/// @param theVolume volume it starts at
+	void StartStream(MiniaudioMusicInfo *theMusicInfo, uint64_t theFrame, double theVolume);
+	/// @brief stops theMusicInfo and hands its stream back to the mixer
+	/// @param theMusicInfo
+	void StopStream(MiniaudioMusicInfo *theMusicInfo);
+	/// @brief decodes as much as the stream has room for, up to mMaxFillFrames
+	/// @param theMusicInfo
+	void FillStream(MiniaudioMusicInfo *theMusicInfo);
+	/// @brief fades theMusicInfo to theVolume at theSpeed per mFadeStepTime
+	/// @param theMusicInfo
+	/// @param theVolume
+	/// @param theSpeed
+	/// @param stopSong
+	void StartFade(MiniaudioMusicInfo *theMusicInfo, double theVolume, double theSpeed, bool stopSong);
+	/// @brief finds a music voice nothing is playing on
+	/// @return voice, -1 if none
+	int FindFreeVoice();
+
+  public:
+	/// @brief mixer, shared with the sound manager
+	std::shared_ptr<MiniaudioMixer> mMixer;
+	/// @brief list
+	MiniaudioMusicMap mMusicMap;
+	/// @brief frames of decoded music kept ahead of the mixer, MUSIC_STREAM_SECONDS worth
+	int mStreamFrames;
+	/// @brief most frames one FillStream decodes
+	int mMaxFillFrames;
+	/// @brief ms that one step of a fade speed stands for, fades used to step once per Update
+	double mFadeStepTime;
+
+  public:
+	/// @brief constructor
+	/// @param theMixer
+	MiniaudioMusicInterface(std::shared_ptr<MiniaudioMixer> theMixer);
+	/// @brief destructor
+	virtual ~MiniaudioMusicInterface();
+
+	/// @brief loads music by id
+	/// @param theSongId
+	/// @param theFileName
+	/// @return true if success
+	virtual bool LoadMusic(int theSongId, const std::string &theFileName);
+	/// @brief plays music by id
+	/// @param theSongId
+	/// @param theOffset in bytes of 16 bit stereo, as BASS took it
+	/// @param noLoop
+	virtual void PlayMusic(int theSongId, int theOffset = 0, bool noLoop = false);
+	/// @brief stops music by id
+	/// @param theSongId
+	virtual void StopMusic(int theSongId);
+	/// @brief stops all music
+	virtual void StopAllMusic();
+	/// @brief unloads music by id
+	/// @param theSongId
+	virtual void UnloadMusic(int theSongId);
+	/// @brief unloads all music
+	virtual void UnloadAllMusic();
+	/// @brief pause all music
+	virtual void PauseAllMusic();
+	/// @brief resume all music
+	virtual void ResumeAllMusic();
+	/// @brief pauses music by id
+	/// @param theSongId
+	virtual void PauseMusic(int theSongId);
+	/// @brief resumes music by id
+	/// @param theSongId
+	virtual void ResumeMusic(int theSongId);
+	/// @brief fades in music by id
+	/// @param theSongId
+	/// @param theOffset
+	/// @param theSpeed
+	/// @param noLoop
+	virtual void FadeIn(int theSongId, int theOffset = -1, double theSpeed = 0.002, bool noLoop = false);
+	/// @brief fades out music by id
+	/// @param theSongId
+	/// @param stopSong
+	/// @param theSpeed
+	virtual void FadeOut(int theSongId, bool stopSong = true, double theSpeed = 0.004);
+	/// @brief fades out all music
+	/// @param stopSong
+	/// @param theSpeed
+	virtual void FadeOutAll(bool stopSong = true, double theSpeed = 0.004);
+	/// @brief sets song volume by id
+	/// @param theSongId
+	/// @param theVolume
+	virtual void SetSongVolume(int theSongId, double theVolume);
+	/// @brief sets song maximum volume by id
+	/// @param theSongId
+	/// @param theMaxVolume
+	virtual void SetSongMaxVolume(int theSongId, double theMaxVolume);
+	/// @brief is song by id playing?
+	/// @param theSongId
+	/// @return true if yes
+	virtual bool IsPlaying(int theSongId);
+
+	/// @brief sets global volume
+	/// @param theVolume
+	virtual void SetVolume(double theVolume);
+	/// @brief does nothing, there are no MODs to amplify
+	/// @param theSongId
+	/// @param theAmp
+	virtual void SetMusicAmplify(int theSongId, double theAmp);
+	/// @brief music update, keeps the streams fed
+	virtual void Update();
+};
+
+} // namespace PopLib
+
+#endif
@@ -0,0 +1,125 @@
+#include "miniaudiosoundinstance.hpp"
+#include "miniaudiosoundmanager.hpp"
+#include <cmath>
+
+using namespace PopLib;
+
+MiniaudioSoundInstance::MiniaudioSoundInstance(MiniaudioSoundManager *theSoundManager, const MixerSound *theSound,
+											   int theVoice)
+{
+	mSoundManagerP = theSoundManager;
+	mSound = theSound;
+	mVoice = theVoice;
+	mTicket = 0;
+	mReleased = false;
+	mAutoRelease = false;
+	mHasPlayed = false;
+
+	mBaseVolume = 1.0;
+	mBasePan = 0;
+
+	mVolume = 1.0;
+	mPan = 0;
+
+	mPitch = 1.0;
+}
+
+MiniaudioSoundInstance::~MiniaudioSoundInstance()
+{
+	if (IsPlaying())
+		mSoundManagerP->mMixer->StopVoice(mVoice);
+}
+
+void MiniaudioSoundInstance::RehupVolume()
+{
+	if (!IsPlaying())
+		return;
+
+	float aGainL, aGainR;
+	GetMixerGains(mVolume * mBaseVolume, mBasePan + mPan, &aGainL, &aGainR);
+	mSoundManagerP->mMixer->SetVoiceGain(mVoice, aGainL, aGainR);
+}
+
+void MiniaudioSoundInstance::Release()
+{
+	Stop();
+	mReleased = true;
+}
+
+void MiniaudioSoundInstance::SetBaseVolume(double theBaseVolume)
+{
+	mBaseVolume = theBaseVolume;
+	RehupVolume();
+}
+
+void MiniaudioSoundInstance::SetBasePan(int theBasePan)
+{
+	mBasePan = theBasePan;
+	RehupVolume();
+}
+
+void MiniaudioSoundInstance::SetVolume(double theVolume)
+{
+	mVolume = theVolume;
+	RehupVolume();
+}
+
+void MiniaudioSoundInstance::SetPan(int thePosition)
+{
+	mPan = thePosition;
+	RehupVolume();
+}
+
+void MiniaudioSoundInstance::AdjustPitch(double theNumSteps)
+{
+	// 1.059463..... is the twelfth root of 2, which is the how many semitones per steps.
+	mPitch = std::pow(1.0594630943592952645618252949463, theNumSteps);
+	if (IsPlaying())
+		mSoundManagerP->mMixer->SetVoicePitch(mVoice, mPitch);
+}
+
+bool MiniaudioSoundInstance::Play(bool looping, bool autoRelease)
+{
+	if (mSound == NULL)
+		return false;
+
+	Stop();
+
+	mHasPlayed = true;
+	mAutoRelease = autoRelease;
+
+	float aGainL, aGainR;
+	GetMixerGains(mVolume * mBaseVolume, mBasePan + mPan, &aGainL, &aGainR);
+	mTicket = mSoundManagerP->mMixer->PlaySound(mVoice, mSound, looping, aGainL, aGainR, mPitch);
+	return mTicket != 0;
+}
+
+void MiniaudioSoundInstance::Stop()
+{
+	if (IsPlaying())
+		mSoundManagerP->mMixer->StopVoice(mVoice);
+
+	mTicket = 0;
+	mAutoRelease = false;
+}
+
+bool MiniaudioSoundInstance::IsPlaying()
+{
+	if (!mHasPlayed)
+		return false;
+
+	return mSoundManagerP->mMixer->IsVoicePlaying(mVoice, mTicket);
+}
+
+bool MiniaudioSoundInstance::IsReleased()
+{
+	if ((!mReleased) && (mAutoRelease) && (mHasPlayed) && (!IsPlaying()))
+		Release();
+
+	return mReleased;
+}
+
+double MiniaudioSoundInstance::GetVolume()
+{
+	return mVolume;
+}
@@ -0,0 +1,65 @@
+#ifndef __MINIAUDIOSOUNDINSTANCE_HPP__
+#define __MINIAUDIOSOUNDINSTANCE_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "soundinstance.hpp"
+
+namespace PopLib
+{
+class MiniaudioSoundManager;
+struct MixerSound;
+
+/**
+ * @brief miniaudio sound instance
+ *
+ * parents SoundInstance, plays on the mixer voice of the channel it was given
+ */
+class MiniaudioSoundInstance : public SoundInstance
+{
+	friend class MiniaudioSoundManager;
+
+  protected:
+	MiniaudioSoundManager *mSoundManagerP;
+	const MixerSound *mSound;
+	int mVoice;
+	uint32_t mTicket;
+	bool mAutoRelease;
+	bool mHasPlayed;
+	bool mReleased;
+
+	int mBasePan;
+	double mBaseVolume;
+
+	int mPan;
+	double mVolume;
+
+	double mPitch;
+
+  protected:
+	void RehupVolume();
+
+  public:
+	MiniaudioSoundInstance(MiniaudioSoundManager *theSoundManager, const MixerSound *theSound, int theVoice);
+	~MiniaudioSoundInstance();
+
+	virtual void Release();
+
+	virtual void SetBaseVolume(double theBaseVolume);
+	virtual void SetBasePan(int theBasePan);
+
+	virtual void SetVolume(double theVolume);
+	virtual void SetPan(int thePosition);
+	virtual void AdjustPitch(double theNumSteps);
+
+	virtual bool Play(bool looping, bool autoRelease);
+	virtual void Stop();
+	virtual bool IsPlaying();
+	virtual bool IsReleased();
+	virtual double GetVolume();
+};
+
+} // namespace PopLib
+
+#endif
@@ -0,0 +1,312 @@
+#include "miniaudiosoundmanager.hpp"
+#include "miniaudiosoundinstance.hpp"
+#include "common.hpp"
+#include "sounddecoder.hpp"
+
+#include <SDL3/SDL.h>
+
+using namespace PopLib;
+
+MiniaudioSoundManager::MiniaudioSoundManager(MixerDevice theDevice)
+{
+	mMixer = std::make_shared<MiniaudioMixer>(theDevice);
+
+	int i;
+
+	for (i = 0; i < MAX_SOURCE_SOUNDS; i++)
+	{
+		mSourceSounds[i] = NULL;
+		mBaseVolumes[i] = 1;
+		mBasePans[i] = 0;
+	}
+
+	for (i = 0; i < MAX_CHANNELS; i++)
+		mPlayingSounds[i] = NULL;
+
+	mMasterVolume = 1.0;
+	mLastReleaseTick = 0;
+}
+
+MiniaudioSoundManager::~MiniaudioSoundManager()
+{
+	ReleaseChannels();
+	ReleaseSounds();
+}
+
+bool MiniaudioSoundManager::Initialized()
+{
+	return mMixer->IsRunning();
+}
+
+int MiniaudioSoundManager::FindFreeChannel()
+{
+	uint32_t aTick = SDL_GetTicks();
+	if (aTick - mLastReleaseTick > 1000)
+	{
+		ReleaseFreeChannels();
+		mMixer->CollectGarbage();
+		mLastReleaseTick = aTick;
+	}
+
+	for (int i = 0; i < MAX_CHANNELS; i++)
+	{
+		if (!mPlayingSounds[i])
+			return i;
+
+		if (mPlayingSounds[i]->IsReleased())
+		{
+			delete mPlayingSounds[i];
+			mPlayingSounds[i] = NULL;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void MiniaudioSoundManager::ReleaseFreeChannels()
+{
+	for (int i = 0; i < MAX_CHANNELS; i++)
+		if (mPlayingSounds[i] != NULL && mPlayingSounds[i]->IsReleased())
+		{
+			delete mPlayingSounds[i];
+			mPlayingSounds[i] = NULL;
+		}
+}
+
+bool MiniaudioSoundManager::LoadSound(unsigned int theSfxID, const std::string &theFilename)
+{
+	if ((theSfxID < 0) || (theSfxID >= MAX_SOURCE_SOUNDS))
+		return false;
+
+	ReleaseSound(theSfxID);
+
+	mSourceFileNames[theSfxID] = theFilename;
+
+	DecodedSoundData aData;
+	if (!DecodeSoundFile(theFilename, aData))
+		return false;
+
+	return SetSoundData(theSfxID, aData.mSamples.data(), aData.mNumFrames, aData.mChannels, aData.mSampleRate);
+}
+
+int MiniaudioSoundManager::LoadSound(const std::string &theFilename)
+{
+	int i;
+	for (i = 0; i < MAX_SOURCE_SOUNDS; i++)
+		if (mSourceFileNames[i] == theFilename)
+			return i;
+
+	for (i = MAX_SOURCE_SOUNDS - 1; i >= 0; i--)
+	{
+		if (mSourceSounds[i] == NULL)
+		{
+			if (!LoadSound(i, theFilename))
+				return -1;
+			else
+				return i;
+		}
+	}
+
+	return -1;
+}
+
+bool MiniaudioSoundManager::LoadOGGSound(unsigned int theSfxID, const std::string &theFilename)
+{
+	DecodedSoundData aData;
+	if (!DecodeOGGSound(theFilename, aData))
+		return false;
+
+	return SetSoundData(theSfxID, aData.mSamples.data(), aData.mNumFrames, aData.mChannels, aData.mSampleRate);
+}
+
+bool MiniaudioSoundManager::LoadAUSound(unsigned int theSfxID, const std::string &theFilename)
+{
+	DecodedSoundData aData;
+	if (!DecodeAUSound(theFilename, aData))
+		return false;
+
+	return SetSoundData(theSfxID, aData.mSamples.data(), aData.mNumFrames, aData.mChannels, aData.mSampleRate);
+}
+
+bool MiniaudioSoundManager::SetSoundData(unsigned int theSfxID, const int16_t *theSamples, int theNumFrames,
+										 int theChannels, int theSampleRate)
+{
+	if (((theChannels != 1) && (theChannels != 2)) || (theNumFrames <= 0) || (theSampleRate <= 0))
+		return false;
+
+	MixerSound *aSound = new MixerSound();
+	aSound->mSamples.assign(theSamples, theSamples + (size_t)theNumFrames * theChannels);
+	aSound->mNumFrames = theNumFrames;
+	aSound->mChannels = theChannels;
+	aSound->mSampleRate = theSampleRate;
+
+	mSourceSounds[theSfxID] = aSound;
+	return true;
+}
+
+void MiniaudioSoundManager::ReleaseSound(unsigned int theSfxID)
+{
+	if (mSourceSounds[theSfxID])
+	{
+		// The instances stop their voices as they go, and the mixer lets go of the samples after that
+		ForceReleaseSources(mSourceSounds[theSfxID]);
+		mMixer->DeleteWhenUnused(mSourceSounds[theSfxID]);
+		mSourceSounds[theSfxID] = NULL;
+		mSourceFileNames[theSfxID] = "";
+	}
+}
+
+bool MiniaudioSoundManager::ReloadSound(unsigned int theSfxID, const std::string &theFilename)
+{
+	if ((theSfxID >= MAX_SOURCE_SOUNDS) || (mSourceSounds[theSfxID] == NULL))
+		return false;
+
+	DecodedSoundData aData;
+	if (!DecodeSoundFile(theFilename, aData))
+		return false;
+
+	MixerSound *anOldSound = mSourceSounds[theSfxID];
+	if (!SetSoundData(theSfxID, aData.mSamples.data(), aData.mNumFrames, aData.mChannels, aData.mSampleRate))
+		return false;
+
+	for (int i = 0; i < MAX_CHANNELS; i++)
+	{
+		if (mPlayingSounds[i] != NULL && mPlayingSounds[i]->mSound == anOldSound)
+		{
+			bool isAutoRelease = mPlayingSounds[i]->mAutoRelease;
+			mPlayingSounds[i]->Stop();
+			mPlayingSounds[i]->mAutoRelease = isAutoRelease;
+			mPlayingSounds[i]->mSound = mSourceSounds[theSfxID];
+		}
+	}
+
+	mMixer->DeleteWhenUnused(anOldSound);
+	return true;
+}
+
+void MiniaudioSoundManager::ForceReleaseSources(const MixerSound *theSound)
+{
+	for (int i = 0; i < MAX_CHANNELS; i++)
+	{
+		if (mPlayingSounds[i] != NULL && mPlayingSounds[i]->mSound == theSound)
+		{
+			delete mPlayingSounds[i];
+			mPlayingSounds[i] = NULL;
+		}
+	}
+}
+
+void MiniaudioSoundManager::StopAllSounds()
+{
+	for (int i = 0; i < MAX_CHANNELS; i++)
+		if (mPlayingSounds[i] != NULL)
+		{
+			bool isAutoRelease = mPlayingSounds[i]->mAutoRelease;
+			mPlayingSounds[i]->Stop();
+			mPlayingSounds[i]->mAutoRelease = isAutoRelease;
+		}
+}
+
+int MiniaudioSoundManager::GetFreeSoundId()
+{
+	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
+	{
+		if (mSourceSounds[i] == NULL)
+			return i;
+	}
+
+	return -1;
+}
+
+int MiniaudioSoundManager::GetNumSounds()
+{
+	int aCount = 0;
+	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
+	{
+		if (mSourceSounds[i] != NULL)
+			aCount++;
+	}
+
+	return aCount;
+}
+
+void MiniaudioSoundManager::SetVolume(double theVolume)
+{
+	mMasterVolume = theVolume;
+	mMixer->SetBusGain(MixerBus_Sound, (float)theVolume);
+}
+
+bool MiniaudioSoundManager::SetBaseVolume(unsigned int theSfxID, double theBaseVolume)
+{
+	if ((theSfxID < 0) || (theSfxID >= MAX_SOURCE_SOUNDS))
+		return false;
+
+	mBaseVolumes[theSfxID] = theBaseVolume;
+	return true;
+}
+
+bool MiniaudioSoundManager::SetBasePan(unsigned int theSfxID, int theBasePan)
+{
+	if ((theSfxID < 0) || (theSfxID >= MAX_SOURCE_SOUNDS))
+		return false;
+
+	mBasePans[theSfxID] = theBasePan;
+	return true;
+}
+
+SoundInstance *MiniaudioSoundManager::GetSoundInstance(unsigned int theSfxID)
+{
+	if (theSfxID >= MAX_SOURCE_SOUNDS)
+		return NULL;
+
+	if (mSourceSounds[theSfxID] == NULL)
+		return NULL;
+
+	int aFreeChannel = FindFreeChannel();
+	if (aFreeChannel < 0)
+		return NULL;
+
+	mPlayingSounds[aFreeChannel] = new MiniaudioSoundInstance(this, mSourceSounds[theSfxID], aFreeChannel);
+
+	mPlayingSounds[aFreeChannel]->SetBasePan(mBasePans[theSfxID]);
+	mPlayingSounds[aFreeChannel]->SetBaseVolume(mBaseVolumes[theSfxID]);
+
+	return mPlayingSounds[aFreeChannel];
+}
+
+void MiniaudioSoundManager::ReleaseSounds()
+{
+	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
+		ReleaseSound(i);
+
+	mMixer->CollectGarbage();
+}
+
+void MiniaudioSoundManager::ReleaseChannels()
+{
+	for (int i = 0; i < MAX_CHANNELS; i++)
+		if (mPlayingSounds[i] != NULL)
+		{
+			delete mPlayingSounds[i];
+			mPlayingSounds[i] = NULL;
+		}
+}
+
+double MiniaudioSoundManager::GetMasterVolume()
+{
+	return mMasterVolume;
+}
+
+void MiniaudioSoundManager::SetMasterVolume(double theVolume)
+{
+	SetVolume(theVolume);
+}
+
+void MiniaudioSoundManager::Flush()
+{
+}
+
+void MiniaudioSoundManager::SetCooperativeWindow(bool isWindowed)
+{
+}
@@ -0,0 +1,75 @@
+#ifndef __MINIAUDIOSOUNDMANAGER_HPP__
+#define __MINIAUDIOSOUNDMANAGER_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "soundmanager.hpp"
+#include "miniaudiomixer.hpp"
+#include <memory>
+
+namespace PopLib
+{
+class MiniaudioSoundInstance;
+
+// Sound effects decoded to 16 bit PCM once at load and mixed by a MiniaudioMixer, which the
+// MiniaudioMusicInterface shares so the whole game goes out through one device.  Channel i plays on
+// mixer voice i.
+class MiniaudioSoundManager : public SoundManager
+{
+	friend class MiniaudioSoundInstance;
+
+  public:
+	std::shared_ptr<MiniaudioMixer> mMixer;
+	MixerSound *mSourceSounds[MAX_SOURCE_SOUNDS];
+	std::string mSourceFileNames[MAX_SOURCE_SOUNDS];
+	double mBaseVolumes[MAX_SOURCE_SOUNDS];
+	int mBasePans[MAX_SOURCE_SOUNDS];
+	MiniaudioSoundInstance *mPlayingSounds[MAX_CHANNELS];
+	double mMasterVolume;
+	uint32_t mLastReleaseTick;
+
+  protected:
+	bool SetSoundData(unsigned int theSfxID, const int16_t *theSamples, int theNumFrames, int theChannels,
+					  int theSampleRate);
+	void ForceReleaseSources(const MixerSound *theSound);
+
+  public:
+	int FindFreeChannel();
+	void ReleaseFreeChannels();
+
+	MiniaudioSoundManager(MixerDevice theDevice = MixerDevice_Default);
+	virtual ~MiniaudioSoundManager();
+
+	virtual bool Initialized();
+
+	virtual bool LoadSound(unsigned int theSfxID, const std::string &theFilename);
+	virtual int LoadSound(const std::string &theFilename);
+	virtual bool LoadOGGSound(unsigned int theSfxID, const std::string &theFilename);
+	virtual bool LoadAUSound(unsigned int theSfxID, const std::string &theFilename);
+	virtual void ReleaseSound(unsigned int theSfxID);
+	virtual bool ReloadSound(unsigned int theSfxID, const std::string &theFilename);
+
+	virtual void SetVolume(double theVolume);
+	virtual bool SetBaseVolume(unsigned int theSfxID, double theBaseVolume);
+	virtual bool SetBasePan(unsigned int theSfxID, int theBasePan);
+
+	virtual SoundInstance *GetSoundInstance(unsigned int theSfxID);
+
+	virtual void ReleaseSounds();
+	virtual void ReleaseChannels();
+
+	virtual double GetMasterVolume();
+	virtual void SetMasterVolume(double theVolume);
+
+	virtual void Flush();
+
+	virtual void SetCooperativeWindow(bool isWindowed);
+	virtual void StopAllSounds();
+	virtual int GetFreeSoundId();
+	virtual int GetNumSounds();
+};
+
+} // namespace PopLib
+
+#endif
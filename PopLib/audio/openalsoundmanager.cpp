@@ -2,14 +2,10 @@
 #include "openalsoundinstance.hpp"
 #include "paklib/pakinterface.hpp"
 #include "common.hpp"
-#include "aureader.hpp"
-
-// Vorbis
-#include "vorbis/codec.h"
-#include "vorbis/vorbisfile.h"
+#include "sounddecoder.hpp"
+#include "adpcm.hpp"
 
 #include <cmath>
-#include <miniaudio.h>
 #include <SDL3/SDL.h>
 
 #if defined(_MSC_VER)
@@ -35,6 +31,13 @@ ALCcontext *mALContext = NULL;
 OpenALSoundManager::OpenALSoundManager()
 {
 	mALDeviceD = NULL;
+	mCompressSounds = false;
+	mDecodedCacheLimit = 16 * 1024 * 1024;
+	memset(&mStorageStats, 0, sizeof(mStorageStats));
+
+	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
+		mCompressedSounds[i] = NULL;
+
 	mALDevice = alcOpenDevice(NULL); // Default device
 	if (!mALDevice)
 	{
@@ -151,60 +154,11 @@ bool OpenALSoundManager::LoadSound(unsigned int theSfxID, const std::string &the
 
 	mSourceFileNames[theSfxID] = theFilename;
 
-	if (LoadOGGSound(theSfxID, theFilename + ".ogg")) // do the ogg first
-		return true;
-
-	std::vector<std::string> aFileExtensions = {".mp3", ".flac", ".wav"};
-
-	for (std::string aExt : aFileExtensions)
-	{
-		PFILE *fp = p_fopen((theFilename + aExt).c_str(), "rb");
-		if (!fp)
-			continue;
-
-		p_fseek(fp, 0, SEEK_END);
-		size_t fileSize = p_ftell(fp);
-		p_fseek(fp, 0, SEEK_SET);
-		uint8_t *data = new uint8_t[fileSize];
-		p_fread(data, 1, fileSize, fp);
-		p_fclose(fp);
-
-		mSourceDataSizes[theSfxID] = fileSize;
-
-		ma_decoder decoder;
-		ma_result result = ma_decoder_init_memory(data, fileSize, NULL, &decoder);
-		if (result != MA_SUCCESS)
-		{
-			delete[] data;
-			continue;
-		}
-
-		const size_t bufferSize = 1024 * 1024;
-		std::vector<float> pcmData(bufferSize);
-
-		ma_result decoder_result = ma_decoder_read_pcm_frames(&decoder, pcmData.data(), pcmData.size(), NULL);
-		if (decoder_result != MA_SUCCESS)
-		{
-			delete[] data;
-			ma_decoder_uninit(&decoder);
-			continue;
-		}
-
-		ALuint buffer;
-		alGenBuffers(1, &buffer);
-		alBufferData(buffer, AL_FORMAT_STEREO16, pcmData.data(), pcmData.size(), decoder.outputSampleRate);
-
-		mSourceSounds[theSfxID] = buffer;
-
-		delete[] data;
-		ma_decoder_uninit(&decoder);
-		return true;
-	}
-
-	if (LoadAUSound(theSfxID, theFilename + ".au"))
-		return true;
+	DecodedSoundData aData;
+	if (!DecodeSoundFile(theFilename, aData))
+		return false;
 
-	return false;
+	return SetSoundData(theSfxID, aData.mSamples.data(), aData.mNumFrames, aData.mChannels, aData.mSampleRate);
 }
 
 int OpenALSoundManager::LoadSound(const std::string &theFilename)
@@ -216,7 +170,7 @@ int OpenALSoundManager::LoadSound(const std::string &theFilename)
 
 	for (i = MAX_SOURCE_SOUNDS - 1; i >= 0; i--)
 	{
-		if (!mSourceSounds[i])
+		if (!IsSoundLoaded(i))
 		{
 			if (!LoadSound(i, theFilename))
 				return -1;
@@ -228,126 +182,181 @@ int OpenALSoundManager::LoadSound(const std::string &theFilename)
 	return -1;
 }
 
-static int p_fseek64_wrap(PFILE *f, ogg_int64_t off, int whence)
+bool OpenALSoundManager::LoadOGGSound(unsigned int theSfxID, const std::string &theFilename)
 {
-	if (!f)
-		return -1;
-	
-	return p_fseek(f, (long)off, whence);
+	DecodedSoundData aData;
+	if (!DecodeOGGSound(theFilename, aData))
+		return false;
+
+	return SetSoundData(theSfxID, aData.mSamples.data(), aData.mNumFrames, aData.mChannels, aData.mSampleRate);
 }
 
-int ov_pak_open(PFILE *f, OggVorbis_File *vf, char *initial, long ibytes)
+bool OpenALSoundManager::LoadAUSound(unsigned int theSfxID, const std::string &theFilename)
 {
-	ov_callbacks callbacks = {(size_t(*)(void *, size_t, size_t, void *))p_fread,
-							  (int (*)(void *, ogg_int64_t, int))p_fseek64_wrap, (int (*)(void *))p_fclose,
-							  (long (*)(void *))p_ftell};
+	DecodedSoundData aData;
+	if (!DecodeAUSound(theFilename, aData))
+		return false;
 
-	return ov_open_callbacks((void *)f, vf, initial, ibytes, callbacks);
+	return SetSoundData(theSfxID, aData.mSamples.data(), aData.mNumFrames, aData.mChannels, aData.mSampleRate);
 }
 
-bool OpenALSoundManager::LoadOGGSound(unsigned int theSfxID, const std::string &theFilename)
+bool OpenALSoundManager::SetSoundData(unsigned int theSfxID, const int16_t *theSamples, int theNumFrames,
+									  int theChannels, int theSampleRate)
 {
-	OggVorbis_File vf;
-	int current_section;
-
-	PFILE *aFile = p_fopen(theFilename.c_str(), "rb");
-	if (!aFile)
+	if (((theChannels != 1) && (theChannels != 2)) || (theNumFrames <= 0))
 		return false;
 
-	if (ov_pak_open(aFile, &vf, NULL, 0) < 0)
+	int64_t aPCMBytes = (int64_t)theNumFrames * theChannels * sizeof(int16_t);
+
+	if (mCompressSounds)
 	{
-		p_fclose(aFile);
-		return false;
+		CompressedSound *aSound = new CompressedSound();
+		aSound->mNumFrames = theNumFrames;
+		aSound->mChannels = theChannels;
+		aSound->mSampleRate = theSampleRate;
+		EncodeIMAADPCM(theSamples, theNumFrames, theChannels, aSound->mData);
+
+		mCompressedSounds[theSfxID] = aSound;
+		mSourceDataSizes[theSfxID] = (ulong)aSound->mData.size();
+
+		mStorageStats.mNumCompressed++;
+		mStorageStats.mCompressedBytes += aSound->mData.size();
+		mStorageStats.mPCMBytes += aPCMBytes;
+		return true;
 	}
 
-	vorbis_info *anInfo = ov_info(&vf, -1);
+	ALuint aBuffer;
+	alGenBuffers(1, &aBuffer);
+	alBufferData(aBuffer, (theChannels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16, theSamples, (ALsizei)aPCMBytes,
+				 theSampleRate);
 
-	ALenum format;
-	if (anInfo->channels == 1)
-		format = AL_FORMAT_MONO16;
-	else if (anInfo->channels == 2)
-		format = AL_FORMAT_STEREO16;
-	else
-	{
-		ov_clear(&vf);
-		p_fclose(aFile);
-		return false;
-	}
-	// get total size
-	int aLenBytes = static_cast<int>(ov_pcm_total(&vf, -1) * anInfo->channels * 2);
+	mSourceSounds[theSfxID] = aBuffer;
+	mSourceDataSizes[theSfxID] = (ulong)aPCMBytes;
+	return true;
+}
 
-	char *aBuf = new char[aLenBytes]; // temp buffer
+bool OpenALSoundManager::IsSoundLoaded(unsigned int theSfxID)
+{
+	return (mSourceSounds[theSfxID] != 0) || (mCompressedSounds[theSfxID] != NULL);
+}
 
-	char *aPtr = aBuf;
-	int aNumBytes = aLenBytes;
-	while (aNumBytes > 0)
+ALuint OpenALSoundManager::GetDecodedBuffer(unsigned int theSfxID)
+{
+	for (DecodedSoundList::iterator anItr = mDecodedSounds.begin(); anItr != mDecodedSounds.end(); ++anItr)
 	{
-		long ret = ov_read(&vf, aPtr, aNumBytes,
-						   /* little‑endian: */ 0,
-						   /* 2 bytes/sample: */ 2,
-						   /* signed PCM:   */ 1, &current_section);
-
-		if (ret == 0)
-			break;
-		else if (ret < 0)
+		if (anItr->mSfxID == theSfxID)
 		{
-			// this means something is wrong
-			delete[] aBuf;
-			ov_clear(&vf);
-			return false;
-		}
-		else
-		{
-			aPtr += ret;
-			aNumBytes -= ret;
+			mDecodedSounds.splice(mDecodedSounds.begin(), mDecodedSounds, anItr);
+			mStorageStats.mCacheHits++;
+			return anItr->mBuffer;
 		}
 	}
-	ALuint aBuffer;
-	alGenBuffers(1, &aBuffer);
-	alBufferData(aBuffer, format, aBuf, aLenBytes, anInfo->rate);
 
-	mSourceSounds[theSfxID] = aBuffer;
+	CompressedSound *aSound = mCompressedSounds[theSfxID];
+	uint64_t aStartTicks = SDL_GetPerformanceCounter();
 
-	delete[] aBuf;
-	ov_clear(&vf);
+	mDecodeBuffer.resize((size_t)aSound->mNumFrames * aSound->mChannels);
+	DecodeIMAADPCM(aSound->mData.data(), aSound->mNumFrames, aSound->mChannels, mDecodeBuffer.data());
 
-	return true;
-}
+	DecodedSound aDecodedSound;
+	aDecodedSound.mSfxID = theSfxID;
+	aDecodedSound.mBytes = (int64_t)mDecodeBuffer.size() * sizeof(int16_t);
+	if (mFreeBuffers.empty())
+		alGenBuffers(1, &aDecodedSound.mBuffer);
+	else
+	{
+		aDecodedSound.mBuffer = mFreeBuffers.back();
+		mFreeBuffers.pop_back();
+	}
 
-bool OpenALSoundManager::LoadAUSound(unsigned int theSfxID, const std::string &theFilename)
-{
-	PFILE *fp = p_fopen(theFilename.c_str(), "rb");
-	if (!fp)
-		return false;
+	alBufferData(aDecodedSound.mBuffer, (aSound->mChannels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16,
+				 mDecodeBuffer.data(), (ALsizei)aDecodedSound.mBytes, aSound->mSampleRate);
+
+	mStorageStats.mDecodes++;
+	mStorageStats.mDecodedBytes += aDecodedSound.mBytes;
+	mStorageStats.mDecodeTime +=
+		(SDL_GetPerformanceCounter() - aStartTicks) * 1000.0 / SDL_GetPerformanceFrequency();
 
-	p_fseek(fp, 0, SEEK_END);
-	size_t fileSize = p_ftell(fp);
-	p_fseek(fp, 0, SEEK_SET);
-	uint8_t *data = new uint8_t[fileSize];
-	p_fread(data, 1, fileSize, fp);
-	p_fclose(fp);
+	mDecodedSounds.push_front(aDecodedSound);
+	TrimDecodedSounds();
+
+	return aDecodedSound.mBuffer;
+}
 
-	AuFile aAUFile;
-	if (!LoadAU(data, fileSize, aAUFile))
+bool OpenALSoundManager::IsBufferInUse(ALuint theBuffer)
+{
+	bool inUse = false;
+	for (int i = 0; i < MAX_CHANNELS; i++)
 	{
-		delete[] data;
-		return false;
+		if ((mPlayingSounds[i] == NULL) || (mPlayingSounds[i]->mSourceSoundBuffer != theBuffer))
+			continue;
+
+		// A released instance still has the buffer attached to its source until it's deleted
+		if (mPlayingSounds[i]->IsReleased())
+		{
+			delete mPlayingSounds[i];
+			mPlayingSounds[i] = NULL;
+		}
+		else
+			inUse = true;
 	}
 
-	mSourceDataSizes[theSfxID] = aAUFile.mSamples.size();
+	return inUse;
+}
+
+void OpenALSoundManager::TrimDecodedSounds()
+{
+	// The front one was just decoded for someone, and buffers still attached to an instance have to
+	// wait for it to be released, so the cache can run over the limit for a while
+	DecodedSoundList::iterator anItr = mDecodedSounds.end();
+	while ((mStorageStats.mDecodedBytes > mDecodedCacheLimit) && (anItr != mDecodedSounds.begin()))
+	{
+		--anItr;
+		if ((anItr == mDecodedSounds.begin()) || IsBufferInUse(anItr->mBuffer))
+			continue;
 
-	ALenum format = (aAUFile.mChannels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16);
+		// Filling it with a single frame frees the PCM but keeps the buffer name for the next decode
+		static const int16_t aSilence[2] = {0, 0};
+		alBufferData(anItr->mBuffer, AL_FORMAT_MONO16, aSilence, sizeof(int16_t), 22050);
+		mFreeBuffers.push_back(anItr->mBuffer);
 
-	ALuint buffer;
-	alGenBuffers(1, &buffer);
-	alBufferData(buffer, format, aAUFile.mSamples.data(), aAUFile.mSamples.size() * sizeof(int16_t),
-				 aAUFile.mSampleRate);
+		mStorageStats.mDecodedBytes -= anItr->mBytes;
+		anItr = mDecodedSounds.erase(anItr);
+	}
+}
 
-	mSourceSounds[theSfxID] = buffer;
+void OpenALSoundManager::ReleaseDecodedSound(unsigned int theSfxID)
+{
+	for (DecodedSoundList::iterator anItr = mDecodedSounds.begin(); anItr != mDecodedSounds.end(); ++anItr)
+	{
+		if (anItr->mSfxID == theSfxID)
+		{
+			ForceReleaseSources(anItr->mBuffer);
+			alDeleteBuffers(1, &anItr->mBuffer);
+			mStorageStats.mDecodedBytes -= anItr->mBytes;
+			mDecodedSounds.erase(anItr);
+			return;
+		}
+	}
+}
 
-	delete[] data;
+SoundStorageStats OpenALSoundManager::GetStorageStats()
+{
+	return mStorageStats;
+}
 
-	return true;
+void OpenALSoundManager::DumpStorageStats(std::string &theDestStr)
+{
+	const SoundStorageStats &aStats = mStorageStats;
+	int aNumPlays = aStats.mDecodes + aStats.mCacheHits;
+
+	theDestStr = StrFormat("Compressed sounds: %d, %.1f MB (%.1f MB as PCM)\n", aStats.mNumCompressed,
+						   aStats.mCompressedBytes / (1024.0 * 1024.0), aStats.mPCMBytes / (1024.0 * 1024.0));
+	theDestStr += StrFormat("Decoded cache: %d sounds, %.1f/%.1f MB\n", (int)mDecodedSounds.size(),
+							aStats.mDecodedBytes / (1024.0 * 1024.0), mDecodedCacheLimit / (1024.0 * 1024.0));
+	theDestStr += StrFormat("Plays: %d, %d decoded (%d%% hit), %.2f ms per decode\n", aNumPlays, aStats.mDecodes,
+							(aNumPlays > 0) ? (aStats.mCacheHits * 100 / aNumPlays) : 0,
+							(aStats.mDecodes > 0) ? (aStats.mDecodeTime / aStats.mDecodes) : 0.0);
 }
 
 void OpenALSoundManager::ReleaseSound(unsigned int theSfxID)
@@ -360,6 +369,74 @@ void OpenALSoundManager::ReleaseSound(unsigned int theSfxID)
 		mSourceSounds[theSfxID] = NULL;
 		mSourceFileNames[theSfxID] = "";
 	}
+
+	if (mCompressedSounds[theSfxID])
+	{
+		ReleaseDecodedSound(theSfxID);
+
+		mStorageStats.mNumCompressed--;
+		mStorageStats.mCompressedBytes -= mCompressedSounds[theSfxID]->mData.size();
+		mStorageStats.mPCMBytes -= (int64_t)mCompressedSounds[theSfxID]->mNumFrames *
+								   mCompressedSounds[theSfxID]->mChannels * sizeof(int16_t);
+
+		delete mCompressedSounds[theSfxID];
+		mCompressedSounds[theSfxID] = NULL;
+		mSourceFileNames[theSfxID] = "";
+	}
+}
+
+bool OpenALSoundManager::ReloadSound(unsigned int theSfxID, const std::string &theFilename)
+{
+	if ((theSfxID >= MAX_SOURCE_SOUNDS) || (!IsSoundLoaded(theSfxID)))
+		return false;
+
+	DecodedSoundData aData;
+	if (!DecodeSoundFile(theFilename, aData))
+		return false;
+
+	ALuint anOldBuffer = mSourceSounds[theSfxID];
+	for (DecodedSoundList::iterator anItr = mDecodedSounds.begin(); anItr != mDecodedSounds.end(); ++anItr)
+	{
+		if ((anOldBuffer == 0) && (anItr->mSfxID == theSfxID))
+			anOldBuffer = anItr->mBuffer;
+	}
+
+	// Detached from the old buffer first, so ReleaseSound doesn't take them down with it
+	std::vector<OpenALSoundInstance *> anInstances;
+	for (int i = 0; (anOldBuffer != 0) && (i < MAX_CHANNELS); i++)
+	{
+		OpenALSoundInstance *anInstance = mPlayingSounds[i];
+		if ((anInstance == NULL) || (anInstance->mSourceSoundBuffer != anOldBuffer))
+			continue;
+
+		bool isAutoRelease = anInstance->mAutoRelease;
+		anInstance->Stop();
+		anInstance->mAutoRelease = isAutoRelease;
+
+		alSourcei(anInstance->mSoundSource, AL_BUFFER, 0);
+		anInstance->mSourceSoundBuffer = 0;
+		anInstances.push_back(anInstance);
+	}
+
+	ReleaseSound(theSfxID);
+	mSourceFileNames[theSfxID] = theFilename;
+	if (!SetSoundData(theSfxID, aData.mSamples.data(), aData.mNumFrames, aData.mChannels, aData.mSampleRate))
+		return false;
+
+	if (anInstances.empty())
+		return true;
+
+	ALuint aBuffer = mSourceSounds[theSfxID];
+	if (aBuffer == 0)
+		aBuffer = GetDecodedBuffer(theSfxID);
+
+	for (OpenALSoundInstance *anInstance : anInstances)
+	{
+		anInstance->mSourceSoundBuffer = aBuffer;
+		alSourcei(anInstance->mSoundSource, AL_BUFFER, aBuffer);
+	}
+
+	return true;
 }
 
 void OpenALSoundManager::StopAllSounds()
@@ -377,7 +454,7 @@ int OpenALSoundManager::GetFreeSoundId()
 {
 	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
 	{
-		if (!mSourceSounds[i])
+		if (!IsSoundLoaded(i))
 			return i;
 	}
 
@@ -389,7 +466,7 @@ int OpenALSoundManager::GetNumSounds()
 	int aCount = 0;
 	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
 	{
-		if (mSourceSounds[i])
+		if (IsSoundLoaded(i))
 			aCount++;
 	}
 
@@ -437,17 +514,21 @@ bool OpenALSoundManager::SetBasePan(unsigned int theSfxID, int theBasePan)
 
 SoundInstance *OpenALSoundManager::GetSoundInstance(unsigned int theSfxID)
 {
-	if (theSfxID > MAX_SOURCE_SOUNDS)
+	if (theSfxID >= MAX_SOURCE_SOUNDS)
 		return NULL;
 
 	int aFreeChannel = FindFreeChannel();
 	if (aFreeChannel < 0)
 		return NULL;
 
-	if (!mSourceSounds[theSfxID])
+	if (!IsSoundLoaded(theSfxID))
 		return NULL;
 
-	mPlayingSounds[aFreeChannel] = new OpenALSoundInstance(this, mSourceSounds[theSfxID]);
+	ALuint aBuffer = mSourceSounds[theSfxID];
+	if (!aBuffer)
+		aBuffer = GetDecodedBuffer(theSfxID);
+
+	mPlayingSounds[aFreeChannel] = new OpenALSoundInstance(this, aBuffer);
 
 	mPlayingSounds[aFreeChannel]->SetBasePan(mBasePans[theSfxID]);
 	mPlayingSounds[aFreeChannel]->SetBaseVolume(mBaseVolumes[theSfxID]);
@@ -458,11 +539,20 @@ SoundInstance *OpenALSoundManager::GetSoundInstance(unsigned int theSfxID)
 void OpenALSoundManager::ReleaseSounds()
 {
 	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
+	{
 		if (mSourceSounds[i])
 		{
 			alDeleteBuffers(1, &mSourceSounds[i]);
 			mSourceSounds[i] = NULL;
 		}
+
+		if (mCompressedSounds[i])
+			ReleaseSound(i);
+	}
+
+	if (!mFreeBuffers.empty())
+		alDeleteBuffers((ALsizei)mFreeBuffers.size(), mFreeBuffers.data());
+	mFreeBuffers.clear();
 }
 
 void OpenALSoundManager::ReleaseChannels()
@@ -15,6 +15,17 @@ namespace PopLib
 {
 class OpenALSoundInstance;
 
+struct SoundStorageStats
+{
+	int mNumCompressed;
+	int64_t mCompressedBytes; // ADPCM held in memory
+	int64_t mPCMBytes;		  // what the same sounds would take as 16 bit PCM
+	int64_t mDecodedBytes;	  // PCM in the decoded cache right now
+	int mDecodes;
+	int mCacheHits;
+	double mDecodeTime; // ms spent decoding in GetSoundInstance, all told
+};
+
 class OpenALSoundManager : public SoundManager
 {
 	friend class OpenALSoundInstance;
@@ -33,6 +44,44 @@ class OpenALSoundManager : public SoundManager
 	// hack
 	ALCdevice *mALDeviceD;
 
+	// With mCompressSounds set, sounds are kept as IMA-ADPCM and only decoded into an OpenAL buffer when
+	// an instance is asked for.  The decoded buffers stay around as a cache of the most recently played
+	// sounds, up to mDecodedCacheLimit bytes, and the ones pushed out are emptied and reused.
+	bool mCompressSounds;
+	int64_t mDecodedCacheLimit;
+
+  protected:
+	struct CompressedSound
+	{
+		std::vector<uint8_t> mData;
+		int mNumFrames;
+		int mChannels;
+		int mSampleRate;
+	};
+
+	struct DecodedSound
+	{
+		unsigned int mSfxID;
+		ALuint mBuffer;
+		int64_t mBytes;
+	};
+	typedef std::list<DecodedSound> DecodedSoundList;
+
+	CompressedSound *mCompressedSounds[MAX_SOURCE_SOUNDS];
+	DecodedSoundList mDecodedSounds; // most recently played first
+	std::vector<ALuint> mFreeBuffers;
+	std::vector<int16_t> mDecodeBuffer;
+	SoundStorageStats mStorageStats;
+
+	bool SetSoundData(unsigned int theSfxID, const int16_t *theSamples, int theNumFrames, int theChannels,
+					  int theSampleRate);
+	bool IsSoundLoaded(unsigned int theSfxID);
+	ALuint GetDecodedBuffer(unsigned int theSfxID);
+	bool IsBufferInUse(ALuint theBuffer);
+	void TrimDecodedSounds();
+	void ReleaseDecodedSound(unsigned int theSfxID);
+
+  public:
 	int FindFreeChannel();
 	int VolumeToDB(double theVolume);
 	void ReleaseFreeChannels();
@@ -47,6 +96,7 @@ class OpenALSoundManager : public SoundManager
 	virtual bool LoadOGGSound(unsigned int theSfxID, const std::string &theFilename);
 	virtual bool LoadAUSound(unsigned int theSfxID, const std::string &theFilename);
 	virtual void ReleaseSound(unsigned int theSfxID);
+	virtual bool ReloadSound(unsigned int theSfxID, const std::string &theFilename);
 
 	virtual void SetVolume(double theVolume);
 	virtual bool SetBaseVolume(unsigned int theSfxID, double theBaseVolume);
@@ -67,6 +117,9 @@ class OpenALSoundManager : public SoundManager
 	virtual int GetFreeSoundId();
 	virtual int GetNumSounds();
 	virtual void ForceReleaseSources(ALuint theBuffer);
+
+	SoundStorageStats GetStorageStats();
+	void DumpStorageStats(std::string &theDestStr);
 };
 
 } // namespace PopLib
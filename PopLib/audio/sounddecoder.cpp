@@ -0,0 +1,165 @@
+#include "sounddecoder.hpp"
+#include "paklib/pakinterface.hpp"
+#include "aureader.hpp"
+
+// Vorbis
+#include "vorbis/codec.h"
+#include "vorbis/vorbisfile.h"
+
+#include <miniaudio.h>
+
+using namespace PopLib;
+
+static int p_fseek64_wrap(PFILE *f, ogg_int64_t off, int whence)
+{
+	if (!f)
+		return -1;
+
+	return p_fseek(f, (long)off, whence);
+}
+
+static int ov_pak_open(PFILE *f, OggVorbis_File *vf, char *initial, long ibytes)
+{
+	ov_callbacks callbacks = {(size_t(*)(void *, size_t, size_t, void *))p_fread,
+							  (int (*)(void *, ogg_int64_t, int))p_fseek64_wrap, (int (*)(void *))p_fclose,
+							  (long (*)(void *))p_ftell};
+
+	return ov_open_callbacks((void *)f, vf, initial, ibytes, callbacks);
+}
+
+static bool ReadPakFile(const std::string &theFilename, std::vector<uint8_t> &theData)
+{
+	PFILE *fp = p_fopen(theFilename.c_str(), "rb");
+	if (!fp)
+		return false;
+
+	p_fseek(fp, 0, SEEK_END);
+	size_t fileSize = p_ftell(fp);
+	p_fseek(fp, 0, SEEK_SET);
+	theData.resize(fileSize);
+	p_fread(theData.data(), 1, fileSize, fp);
+	p_fclose(fp);
+	return true;
+}
+
+static bool IsUsableSound(const DecodedSoundData &theData)
+{
+	return ((theData.mChannels == 1) || (theData.mChannels == 2)) && (theData.mNumFrames > 0) &&
+		   (theData.mSampleRate > 0);
+}
+
+bool PopLib::DecodeSoundFile(const std::string &theFilename, DecodedSoundData &theData)
+{
+	if (DecodeOGGSound(theFilename + ".ogg", theData)) // do the ogg first
+		return true;
+
+	static const char *aFileExtensions[] = {".mp3", ".flac", ".wav"};
+	for (const char *anExt : aFileExtensions)
+	{
+		if (DecodeMiniaudioSound(theFilename + anExt, theData))
+			return true;
+	}
+
+	return DecodeAUSound(theFilename + ".au", theData);
+}
+
+bool PopLib::DecodeOGGSound(const std::string &theFilename, DecodedSoundData &theData)
+{
+	OggVorbis_File vf;
+	int current_section;
+
+	PFILE *aFile = p_fopen(theFilename.c_str(), "rb");
+	if (!aFile)
+		return false;
+
+	if (ov_pak_open(aFile, &vf, NULL, 0) < 0)
+	{
+		p_fclose(aFile);
+		return false;
+	}
+
+	vorbis_info *anInfo = ov_info(&vf, -1);
+	if ((anInfo->channels != 1) && (anInfo->channels != 2))
+	{
+		ov_clear(&vf);
+		return false;
+	}
+
+	theData.mSamples.resize((size_t)ov_pcm_total(&vf, -1) * anInfo->channels);
+	char *aPtr = (char *)theData.mSamples.data();
+	int aNumBytes = (int)(theData.mSamples.size() * sizeof(int16_t));
+	while (aNumBytes > 0)
+	{
+		long ret = ov_read(&vf, aPtr, aNumBytes,
+						   /* little‑endian: */ 0,
+						   /* 2 bytes/sample: */ 2,
+						   /* signed PCM:   */ 1, &current_section);
+		if (ret == 0)
+			break;
+		else if (ret < 0)
+		{
+			ov_clear(&vf);
+			return false;
+		}
+
+		aPtr += ret;
+		aNumBytes -= ret;
+	}
+
+	theData.mNumFrames = (int)((aPtr - (char *)theData.mSamples.data()) / (anInfo->channels * 2));
+	theData.mChannels = anInfo->channels;
+	theData.mSampleRate = anInfo->rate;
+	theData.mSamples.resize((size_t)theData.mNumFrames * theData.mChannels);
+
+	ov_clear(&vf);
+	return IsUsableSound(theData);
+}
+
+bool PopLib::DecodeAUSound(const std::string &theFilename, DecodedSoundData &theData)
+{
+	std::vector<uint8_t> aFileData;
+	if (!ReadPakFile(theFilename, aFileData))
+		return false;
+
+	AuFile aAUFile;
+	if (!LoadAU(aFileData.data(), aFileData.size(), aAUFile) || (aAUFile.mChannels == 0))
+		return false;
+
+	theData.mNumFrames = (int)(aAUFile.mSamples.size() / aAUFile.mChannels);
+	theData.mChannels = aAUFile.mChannels;
+	theData.mSampleRate = aAUFile.mSampleRate;
+	theData.mSamples.swap(aAUFile.mSamples);
+	return IsUsableSound(theData);
+}
+
+bool PopLib::DecodeMiniaudioSound(const std::string &theFilename, DecodedSoundData &theData)
+{
+	std::vector<uint8_t> aFileData;
+	if (!ReadPakFile(theFilename, aFileData))
+		return false;
+
+	ma_decoder_config aConfig = ma_decoder_config_init(ma_format_s16, 0, 0);
+	ma_decoder decoder;
+	if (ma_decoder_init_memory(aFileData.data(), aFileData.size(), &aConfig, &decoder) != MA_SUCCESS)
+		return false;
+
+	theData.mSamples.clear();
+	int16_t aChunk[4096];
+	ma_uint64 aChunkFrames = 4096 / decoder.outputChannels;
+	while (true)
+	{
+		ma_uint64 aFramesRead = 0;
+		ma_decoder_read_pcm_frames(&decoder, aChunk, aChunkFrames, &aFramesRead);
+		if (aFramesRead == 0)
+			break;
+
+		theData.mSamples.insert(theData.mSamples.end(), aChunk, aChunk + aFramesRead * decoder.outputChannels);
+	}
+
+	theData.mNumFrames = (int)(theData.mSamples.size() / decoder.outputChannels);
+	theData.mChannels = decoder.outputChannels;
+	theData.mSampleRate = decoder.outputSampleRate;
+
+	ma_decoder_uninit(&decoder);
+	return IsUsableSound(theData);
+}
@@ -0,0 +1,29 @@
+#ifndef __SOUNDDECODER_HPP__
+#define __SOUNDDECODER_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+
+namespace PopLib
+{
+
+// A whole sound file decoded to 16 bit interleaved PCM, mono or stereo.  The sound managers decode
+// through these and then store the samples their own way in SetSoundData.
+struct DecodedSoundData
+{
+	std::vector<int16_t> mSamples;
+	int mNumFrames;
+	int mChannels;
+	int mSampleRate;
+};
+
+bool DecodeSoundFile(const std::string &theFilename, DecodedSoundData &theData); // tries .ogg, .mp3, .flac, .wav, .au
+bool DecodeOGGSound(const std::string &theFilename, DecodedSoundData &theData);
+bool DecodeAUSound(const std::string &theFilename, DecodedSoundData &theData);
+bool DecodeMiniaudioSound(const std::string &theFilename, DecodedSoundData &theData); // anything miniaudio reads
+
+} // namespace PopLib
+
+#endif
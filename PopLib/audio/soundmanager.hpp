@@ -24,6 +24,9 @@ class SoundManager
 	virtual bool LoadSound(unsigned int theSfxID, const std::string &theFilename) = 0;
 	virtual int LoadSound(const std::string &theFilename) = 0;
 	virtual void ReleaseSound(unsigned int theSfxID) = 0;
+	// Leaves the old data in place unless the file decodes.  Instances of the old data are stopped, not
+	// released, and play the new data from then on.
+	virtual bool ReloadSound(unsigned int theSfxID, const std::string &theFilename) = 0;
 
 	virtual void SetVolume(double theVolume) = 0;
 	virtual bool SetBaseVolume(unsigned int theSfxID, double theBaseVolume) = 0;
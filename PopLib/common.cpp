@@ -847,6 +847,37 @@ std::string PopLib::XMLDecodeString(const std::string &theString)
 					c = ' ';
 				else if (anEntName == "cr")
 					c = '\n';
+				else if ((anEntName.length() > 1) && (anEntName[0] == '#'))
+				{
+					// Character references, stored as UTF-8
+					ulong aCode = (anEntName[1] == 'x' || anEntName[1] == 'X')
+									  ? strtoul(anEntName.c_str() + 2, NULL, 16)
+									  : strtoul(anEntName.c_str() + 1, NULL, 10);
+					// NUL, surrogates and anything past Unicode's range aren't characters, drop them
+					if ((aCode == 0) || (aCode > 0x10FFFF) || ((aCode >= 0xD800) && (aCode <= 0xDFFF)))
+						continue;
+					else if (aCode < 0x80)
+						aNewString += (char)aCode;
+					else if (aCode < 0x800)
+					{
+						aNewString += (char)(0xC0 | (aCode >> 6));
+						aNewString += (char)(0x80 | (aCode & 0x3F));
+					}
+					else if (aCode < 0x10000)
+					{
+						aNewString += (char)(0xE0 | (aCode >> 12));
+						aNewString += (char)(0x80 | ((aCode >> 6) & 0x3F));
+						aNewString += (char)(0x80 | (aCode & 0x3F));
+					}
+					else
+					{
+						aNewString += (char)(0xF0 | ((aCode >> 18) & 0x07));
+						aNewString += (char)(0x80 | ((aCode >> 12) & 0x3F));
+						aNewString += (char)(0x80 | ((aCode >> 6) & 0x3F));
+						aNewString += (char)(0x80 | (aCode & 0x3F));
+					}
+					continue;
+				}
 			}
 		}
 
@@ -56,13 +56,18 @@ int Font::StringWidth(const PopString &theString)
 	return 0;
 }
 
-int Font::CharWidth(PopChar theChar)
+uint32_t Font::GetNextChar(const PopString &theString, ulong &thePos)
 {
-	PopString aString(1, theChar);
+	return (uchar)theString[thePos++];
+}
+
+int Font::CharWidth(uint32_t theChar)
+{
+	PopString aString(1, (PopChar)theChar);
 	return StringWidth(aString);
 }
 
-int Font::CharWidthKern(PopChar theChar, PopChar thePrevChar)
+int Font::CharWidthKern(uint32_t theChar, uint32_t thePrevChar)
 {
 	return CharWidth(theChar);
 }
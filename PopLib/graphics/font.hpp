@@ -33,8 +33,12 @@ class Font
 	virtual int GetLineSpacingOffset();
 	virtual int GetLineSpacing();
 	virtual int StringWidth(const PopString &theString);
-	virtual int CharWidth(PopChar theChar);
-	virtual int CharWidthKern(PopChar theChar, PopChar thePrevChar);
+
+	// Reads the char at thePos the way StringWidth does and moves past it.  The widths below take what it
+	// returns, so measuring a string char by char adds up to its StringWidth.
+	virtual uint32_t GetNextChar(const PopString &theString, ulong &thePos);
+	virtual int CharWidth(uint32_t theChar);
+	virtual int CharWidthKern(uint32_t theChar, uint32_t thePrevChar);
 
 	virtual void DrawString(Graphics *g, int theX, int theY, const PopString &theString, const Color &theColor,
 							const Rect &theClipRect);
@@ -1222,8 +1222,9 @@ int Graphics::WriteWordWrapped(const Rect &theRect, const PopString &theLine, in
 	ulong aCurPos = 0;
 	int aLineStartPos = 0;
 	int aCurWidth = 0;
-	PopChar aCurChar = 0;
-	PopChar aPrevChar = 0;
+	ulong aNextPos = 0;
+	uint32_t aCurChar = 0;
+	uint32_t aPrevChar = 0;
 	int aSpacePos = -1;
 	int aMaxWidth = 0;
 	int anIndentX = 0;
@@ -1236,13 +1237,17 @@ int Graphics::WriteWordWrapped(const Rect &theRect, const PopString &theLine, in
 
 	while (aCurPos < theLine.length())
 	{
-		aCurChar = theLine[aCurPos];
+		aNextPos = aCurPos;
+		aCurChar = aFont->GetNextChar(theLine, aNextPos);
 		if (aCurChar == '^' && mWriteColoredString) // Handle special color modifier
 		{
 			if (aCurPos + 1 < theLine.length())
 			{
 				if (theLine[aCurPos + 1] == '^')
+				{
 					aCurPos++; // literal '^' -> just skip the extra '^'
+					aNextPos++;
+				}
 				else
 				{
 					aCurPos += 8;
@@ -1298,7 +1303,7 @@ int Graphics::WriteWordWrapped(const Rect &theRect, const PopString &theLine, in
 			else
 			{
 				if ((int)aCurPos < aLineStartPos + 1)
-					aCurPos++; // ensure at least one character gets written
+					aCurPos = aNextPos; // ensure at least one character gets written
 
 				aWrittenWidth = WriteWordWrappedHelper(this, theLine, theRect.mX + anIndentX, theRect.mY + aYOffset,
 													   theRect.mWidth, theJustification, true, aLineStartPos,
@@ -1324,7 +1329,7 @@ int Graphics::WriteWordWrapped(const Rect &theRect, const PopString &theLine, in
 			aYOffset += theLineSpacing;
 		}
 		else
-			aCurPos++;
+			aCurPos = aNextPos;
 	}
 
 	if (aLineStartPos < (int)theLine.length()) // write the last piece
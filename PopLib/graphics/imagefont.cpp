@@ -5,6 +5,10 @@
 #include "memoryimage.hpp"
 #include "sdlimage.hpp"
 #include "misc/autocrit.hpp"
+#include "misc/buffer.hpp"
+#include "paklib/pakinterface.hpp"
+
+#include <zlib.h>
 
 using namespace PopLib;
 
@@ -76,13 +80,230 @@ DataElement *ListDataElement::Duplicate()
 
 ///
 
-CharData::CharData()
+// Returns the length of the UTF-8 sequence at theData, or 0 if it isn't a valid one
+static int DecodeUTF8Char(const uchar *theData, ulong theLength, uint32_t *theChar)
+{
+	uchar aLead = theData[0];
+	int aLength;
+	uint32_t aChar;
+	uint32_t aMinChar;
+
+	if (aLead < 0x80)
+	{
+		*theChar = aLead;
+		return 1;
+	}
+	else if ((aLead & 0xE0) == 0xC0)
+	{
+		aLength = 2;
+		aChar = aLead & 0x1F;
+		aMinChar = 0x80;
+	}
+	else if ((aLead & 0xF0) == 0xE0)
+	{
+		aLength = 3;
+		aChar = aLead & 0x0F;
+		aMinChar = 0x800;
+	}
+	else if ((aLead & 0xF8) == 0xF0)
+	{
+		aLength = 4;
+		aChar = aLead & 0x07;
+		aMinChar = 0x10000;
+	}
+	else
+		return 0;
+
+	if ((ulong)aLength > theLength)
+		return 0;
+
+	for (int i = 1; i < aLength; i++)
+	{
+		if ((theData[i] & 0xC0) != 0x80)
+			return 0;
+		aChar = (aChar << 6) | (theData[i] & 0x3F);
+	}
+
+	if ((aChar < aMinChar) || (aChar > 0x10FFFF))
+		return 0;
+
+	*theChar = aChar;
+	return aLength;
+}
+
+// Descriptor char lists hold one byte per char, or UTF-8 for chars past the 8-bit range
+static bool GetDescChars(const std::string &theString, uint32_t *theChars, int theCount)
+{
+	if ((int)theString.length() == theCount)
+	{
+		for (int i = 0; i < theCount; i++)
+			theChars[i] = (uchar)theString[i];
+		return true;
+	}
+
+	const uchar *aData = (const uchar *)theString.data();
+	ulong aPos = 0;
+	for (int i = 0; i < theCount; i++)
+	{
+		if (aPos >= theString.length())
+			return false;
+
+		int aLength = DecodeUTF8Char(aData + aPos, theString.length() - aPos, &theChars[i]);
+		if (aLength == 0)
+			return false;
+		aPos += aLength;
+	}
+
+	return aPos == theString.length();
+}
+
+// Finds or adds the glyph for a descriptor char, 0 if theString isn't a single char
+static int GetDescGlyph(FontLayer *theLayer, const std::string &theString)
+{
+	uint32_t aChar;
+	if (!GetDescChars(theString, &aChar, 1))
+		return 0;
+
+	if (aChar >= 256)
+		theLayer->mFontData->mHasWideChars = true;
+	return theLayer->mGlyphs.AddGlyph(aChar);
+}
+
+static bool CompareKerningPair(const GlyphTable::KerningPair &thePair, uint32_t theNextChar)
 {
-	mWidth = 0;
-	mOrder = 0;
+	return thePair.mNextChar < theNextChar;
+}
 
+GlyphTable::GlyphTable()
+{
+	Clear();
+}
+
+void GlyphTable::Clear()
+{
 	for (ulong i = 0; i < 256; i++)
-		mKerningOffsets[i] = 0;
+	{
+		mGlyphIndex[i] = 0;
+		mKerningRow[i] = 0;
+		mKerningColumn[i] = 0;
+	}
+	mWideGlyphIndex.clear();
+
+	mChars.assign(1, 0);
+	mImageRects.assign(1, Rect());
+	mOffsets.assign(1, Point());
+	mWidths.assign(1, 0);
+	mOrders.assign(1, 0);
+	mKerningStart.assign(2, 0);
+	mKerningPairs.clear();
+
+	mNumKerningColumns = 1;
+	mKerningMatrix.assign(1, 0);
+	mHasWideKerning = false;
+}
+
+int GlyphTable::AddGlyph(uint32_t theChar)
+{
+	int aGlyph = GetGlyph(theChar);
+	if (aGlyph != 0)
+		return aGlyph;
+
+	aGlyph = (int)mChars.size();
+	if (aGlyph > 0xFFFF)
+		return 0;
+
+	mChars.push_back(theChar);
+	mImageRects.push_back(Rect());
+	mOffsets.push_back(Point());
+	mWidths.push_back(0);
+	mOrders.push_back(0);
+	mKerningStart.push_back(mKerningStart.back());
+
+	if (theChar < 256)
+		mGlyphIndex[theChar] = (uint16_t)aGlyph;
+	else
+		mWideGlyphIndex[theChar] = (uint16_t)aGlyph;
+
+	return aGlyph;
+}
+
+int GlyphTable::AddKerningCell(uint32_t theChar, uint32_t theNextChar)
+{
+	if (mKerningRow[theChar] == 0)
+	{
+		mKerningRow[theChar] = (uint16_t)(mKerningMatrix.size() / mNumKerningColumns);
+		mKerningMatrix.resize(mKerningMatrix.size() + mNumKerningColumns, 0);
+	}
+
+	if (mKerningColumn[theNextChar] == 0)
+	{
+		int aNumRows = (int)(mKerningMatrix.size() / mNumKerningColumns);
+		std::vector<short> aMatrix(aNumRows * (mNumKerningColumns + 1), 0);
+		for (int aRow = 0; aRow < aNumRows; aRow++)
+			std::copy(mKerningMatrix.begin() + aRow * mNumKerningColumns,
+					  mKerningMatrix.begin() + (aRow + 1) * mNumKerningColumns,
+					  aMatrix.begin() + aRow * (mNumKerningColumns + 1));
+
+		mKerningMatrix.swap(aMatrix);
+		mKerningColumn[theNextChar] = (uint16_t)mNumKerningColumns++;
+	}
+
+	return mKerningRow[theChar] * mNumKerningColumns + mKerningColumn[theNextChar];
+}
+
+int GlyphTable::GetWideKerning(uint32_t theChar, uint32_t theNextChar) const
+{
+	int aGlyph = GetGlyph(theChar);
+	std::vector<KerningPair>::const_iterator aBegin = mKerningPairs.begin() + mKerningStart[aGlyph];
+	std::vector<KerningPair>::const_iterator anEnd = mKerningPairs.begin() + mKerningStart[aGlyph + 1];
+	std::vector<KerningPair>::const_iterator anItr = std::lower_bound(aBegin, anEnd, theNextChar, CompareKerningPair);
+
+	if ((anItr != anEnd) && (anItr->mNextChar == theNextChar))
+		return anItr->mOffset;
+	return 0;
+}
+
+void GlyphTable::SetKerning(uint32_t theChar, uint32_t theNextChar, int theOffset)
+{
+	int aGlyph = AddGlyph(theChar);
+	if (aGlyph == 0)
+		return;
+
+	std::vector<KerningPair>::iterator aBegin = mKerningPairs.begin() + mKerningStart[aGlyph];
+	std::vector<KerningPair>::iterator anEnd = mKerningPairs.begin() + mKerningStart[aGlyph + 1];
+	std::vector<KerningPair>::iterator anItr = std::lower_bound(aBegin, anEnd, theNextChar, CompareKerningPair);
+
+	if ((anItr != anEnd) && (anItr->mNextChar == theNextChar))
+		anItr->mOffset = theOffset;
+	else
+	{
+		KerningPair aPair;
+		aPair.mNextChar = theNextChar;
+		aPair.mOffset = theOffset;
+		mKerningPairs.insert(anItr, aPair);
+
+		for (ulong i = aGlyph + 1; i < mKerningStart.size(); i++)
+			mKerningStart[i]++;
+	}
+
+	if ((theChar < 256) && (theNextChar < 256))
+		mKerningMatrix[AddKerningCell(theChar, theNextChar)] = (short)theOffset;
+	else
+		mHasWideKerning = true;
+}
+
+int GlyphTable::GetMemSize() const
+{
+	int aSize = sizeof(GlyphTable);
+	aSize += (int)(mChars.size() * (sizeof(uint32_t) + sizeof(Rect) + sizeof(Point) + sizeof(int) * 2));
+	aSize += (int)(mKerningStart.size() * sizeof(uint32_t));
+	aSize += (int)(mKerningPairs.size() * sizeof(KerningPair));
+	aSize += (int)(mKerningMatrix.size() * sizeof(short));
+
+	// Roughly one node per entry plus the bucket array
+	aSize += (int)(mWideGlyphIndex.size() * (sizeof(std::pair<const uint32_t, uint16_t>) + sizeof(void *) * 2));
+	aSize += (int)(mWideGlyphIndex.bucket_count() * sizeof(void *));
+	return aSize;
 }
 
 FontLayer::FontLayer(FontData *theFontData)
@@ -105,18 +326,20 @@ FontLayer::FontLayer(FontData *theFontData)
 
 FontLayer::FontLayer(const FontLayer &theFontLayer)
 	: mFontData(theFontLayer.mFontData), mRequiredTags(theFontLayer.mRequiredTags),
-	  mExcludedTags(theFontLayer.mExcludedTags), mImage(theFontLayer.mImage), mDrawMode(theFontLayer.mDrawMode),
+	  mExcludedTags(theFontLayer.mExcludedTags), mImage(theFontLayer.mImage),
+	  mImageFileName(theFontLayer.mImageFileName), mDrawMode(theFontLayer.mDrawMode),
 	  mOffset(theFontLayer.mOffset), mSpacing(theFontLayer.mSpacing), mMinPointSize(theFontLayer.mMinPointSize),
 	  mMaxPointSize(theFontLayer.mMaxPointSize), mPointSize(theFontLayer.mPointSize), mAscent(theFontLayer.mAscent),
 	  mAscentPadding(theFontLayer.mAscentPadding), mHeight(theFontLayer.mHeight),
 	  mDefaultHeight(theFontLayer.mDefaultHeight), mColorMult(theFontLayer.mColorMult),
 	  mColorAdd(theFontLayer.mColorAdd), mLineSpacingOffset(theFontLayer.mLineSpacingOffset),
-	  mBaseOrder(theFontLayer.mBaseOrder)
+	  mBaseOrder(theFontLayer.mBaseOrder), mGlyphs(theFontLayer.mGlyphs)
 {
-	ulong i;
+}
 
-	for (i = 0; i < 256; i++)
-		mCharData[i] = theFontLayer.mCharData[i];
+int FontLayer::GetMemSize() const
+{
+	return (int)(sizeof(FontLayer) - sizeof(GlyphTable)) + mGlyphs.GetMemSize();
 }
 
 FontData::FontData()
@@ -126,6 +349,7 @@ FontData::FontData()
 	mApp = nullptr;
 	mRefCount = 0;
 	mDefaultPointSize = 0;
+	mHasWideChars = false;
 
 	for (ulong i = 0; i < 256; i++)
 		mCharMap[i] = (uchar)i;
@@ -549,6 +773,7 @@ bool FontData::HandleCommand(const ListDataElement &theParams)
 					if (isNew)
 						anImage->Palletize();
 					aLayer->mImage = anImage;
+					aLayer->mImageFileName = aFileName;
 				}
 				else
 				{
@@ -714,9 +939,10 @@ bool FontData::HandleCommand(const ListDataElement &theParams)
 				{
 					for (ulong i = 0; i < aCharsVector.size(); i++)
 					{
-						if (aCharsVector[i].length() == 1)
+						int aGlyph = GetDescGlyph(aLayer, aCharsVector[i]);
+						if (aGlyph != 0)
 						{
-							aLayer->mCharData[(uchar)aCharsVector[i][0]].mWidth = aCharWidthsVector[i];
+							aLayer->mGlyphs.mWidths[aGlyph] = aCharWidthsVector[i];
 						}
 						else
 							invalidParamFormat = true;
@@ -777,9 +1003,9 @@ bool FontData::HandleCommand(const ListDataElement &theParams)
 						for (ulong i = 0; i < aCharsVector.size(); i++)
 						{
 							IntVector aRectElement;
+							int aGlyph = GetDescGlyph(aLayer, aCharsVector[i]);
 
-							if ((aCharsVector[i].length() == 1) &&
-								(DataToIntVector(aRectList.mElementVector[i], &aRectElement)) &&
+							if ((aGlyph != 0) && (DataToIntVector(aRectList.mElementVector[i], &aRectElement)) &&
 								(aRectElement.size() == 4))
 
 							{
@@ -792,20 +1018,18 @@ bool FontData::HandleCommand(const ListDataElement &theParams)
 									return false;
 								}
 
-								aLayer->mCharData[(uchar)aCharsVector[i][0]].mImageRect = aRect;
-								;
+								aLayer->mGlyphs.mImageRects[aGlyph] = aRect;
 							}
 							else
 								invalidParamFormat = true;
 						}
 
 						aLayer->mDefaultHeight = 0;
-						for (int aCharNum = 0; aCharNum < 256; aCharNum++)
-							if (aLayer->mCharData[aCharNum].mImageRect.mHeight +
-									aLayer->mCharData[aCharNum].mOffset.mY >
+						for (int aGlyph = 0; aGlyph < aLayer->mGlyphs.GetNumGlyphs(); aGlyph++)
+							if (aLayer->mGlyphs.mImageRects[aGlyph].mHeight + aLayer->mGlyphs.mOffsets[aGlyph].mY >
 								aLayer->mDefaultHeight)
-								aLayer->mDefaultHeight = aLayer->mCharData[aCharNum].mImageRect.mHeight +
-														 aLayer->mCharData[aCharNum].mOffset.mY;
+								aLayer->mDefaultHeight =
+									aLayer->mGlyphs.mImageRects[aGlyph].mHeight + aLayer->mGlyphs.mOffsets[aGlyph].mY;
 					}
 					else
 					{
@@ -839,12 +1063,12 @@ bool FontData::HandleCommand(const ListDataElement &theParams)
 					for (ulong i = 0; i < aCharsVector.size(); i++)
 					{
 						IntVector aRectElement;
+						int aGlyph = GetDescGlyph(aLayer, aCharsVector[i]);
 
-						if ((aCharsVector[i].length() == 1) &&
-							(DataToIntVector(aRectList.mElementVector[i], &aRectElement)) && (aRectElement.size() == 2))
+						if ((aGlyph != 0) && (DataToIntVector(aRectList.mElementVector[i], &aRectElement)) &&
+							(aRectElement.size() == 2))
 						{
-							aLayer->mCharData[(uchar)aCharsVector[i][0]].mOffset =
-								Point(aRectElement[0], aRectElement[1]);
+							aLayer->mGlyphs.mOffsets[aGlyph] = Point(aRectElement[0], aRectElement[1]);
 						}
 						else
 							invalidParamFormat = true;
@@ -875,10 +1099,13 @@ bool FontData::HandleCommand(const ListDataElement &theParams)
 				{
 					for (ulong i = 0; i < aPairsVector.size(); i++)
 					{
-						if (aPairsVector[i].length() == 2)
+						uint32_t aPair[2];
+
+						if (GetDescChars(aPairsVector[i], aPair, 2))
 						{
-							aLayer->mCharData[(uchar)aPairsVector[i][0]].mKerningOffsets[(uchar)aPairsVector[i][1]] =
-								anOffsetsVector[i];
+							if (aPair[0] >= 256)
+								mHasWideChars = true;
+							aLayer->mGlyphs.SetKerning(aPair[0], aPair[1], anOffsetsVector[i]);
 						}
 						else
 							invalidParamFormat = true;
@@ -930,9 +1157,10 @@ bool FontData::HandleCommand(const ListDataElement &theParams)
 				{
 					for (ulong i = 0; i < aCharsVector.size(); i++)
 					{
-						if (aCharsVector[i].length() == 1)
+						int aGlyph = GetDescGlyph(aLayer, aCharsVector[i]);
+						if (aGlyph != 0)
 						{
-							aLayer->mCharData[(uchar)aCharsVector[i][0]].mOrder = aCharOrdersVector[i];
+							aLayer->mGlyphs.mOrders[aGlyph] = aCharOrdersVector[i];
 						}
 						else
 							invalidParamFormat = true;
@@ -988,6 +1216,355 @@ bool FontData::HandleCommand(const ListDataElement &theParams)
 	return true;
 }
 
+static bool GetFontSourceStamp(const std::string &theFileName, ulong &theSize, ulong &theCRC)
+{
+	PFILE *aFP = p_fopen(theFileName.c_str(), "rb");
+	if (aFP == nullptr)
+		return false;
+
+	p_fseek(aFP, 0, SEEK_END);
+	long aSize = p_ftell(aFP);
+	p_fseek(aFP, 0, SEEK_SET);
+
+	std::vector<uchar> aData(std::max(aSize, 0L));
+	bool aResult = (aSize > 0) && (p_fread(aData.data(), 1, aSize, aFP) == (size_t)aSize);
+	p_fclose(aFP);
+
+	theSize = (ulong)aSize;
+	theCRC = aResult ? crc32(0, aData.data(), (uInt)aSize) : 0;
+	return aResult;
+}
+
+static void WriteDataElement(Buffer &theBuffer, DataElement *theElement)
+{
+	theBuffer.WriteBoolean(theElement->mIsList);
+	if (theElement->mIsList)
+	{
+		ListDataElement *aList = (ListDataElement *)theElement;
+		theBuffer.WriteLong((long)aList->mElementVector.size());
+		for (ulong i = 0; i < aList->mElementVector.size(); i++)
+			WriteDataElement(theBuffer, aList->mElementVector[i]);
+	}
+	else
+		theBuffer.WriteString(((SingleDataElement *)theElement)->mString);
+}
+
+static DataElement *ReadDataElement(const Buffer &theBuffer, int theDepth)
+{
+	if (theBuffer.ReadBoolean())
+	{
+		ListDataElement *aList = new ListDataElement();
+		long aCount = theBuffer.ReadLong();
+		if ((aCount < 0) || (theDepth > 32))
+		{
+			delete aList;
+			return nullptr;
+		}
+
+		for (long i = 0; i < aCount; i++)
+		{
+			DataElement *anElement = ReadDataElement(theBuffer, theDepth + 1);
+			if (anElement == nullptr)
+			{
+				delete aList;
+				return nullptr;
+			}
+			aList->mElementVector.push_back(anElement);
+		}
+		return aList;
+	}
+
+	return new SingleDataElement(theBuffer.ReadString());
+}
+
+static void WriteColor(Buffer &theBuffer, const Color &theColor)
+{
+	theBuffer.WriteLong(theColor.mRed);
+	theBuffer.WriteLong(theColor.mGreen);
+	theBuffer.WriteLong(theColor.mBlue);
+	theBuffer.WriteLong(theColor.mAlpha);
+}
+
+static Color ReadColor(const Buffer &theBuffer)
+{
+	Color aColor;
+	aColor.mRed = theBuffer.ReadLong();
+	aColor.mGreen = theBuffer.ReadLong();
+	aColor.mBlue = theBuffer.ReadLong();
+	aColor.mAlpha = theBuffer.ReadLong();
+	return aColor;
+}
+
+static void WriteStringVector(Buffer &theBuffer, const StringVector &theVector)
+{
+	theBuffer.WriteLong((long)theVector.size());
+	for (ulong i = 0; i < theVector.size(); i++)
+		theBuffer.WriteString(theVector[i]);
+}
+
+static bool ReadStringVector(const Buffer &theBuffer, StringVector &theVector)
+{
+	long aCount = theBuffer.ReadLong();
+	if ((aCount < 0) || (aCount > 0xFFFF))
+		return false;
+
+	theVector.resize(aCount);
+	for (long i = 0; i < aCount; i++)
+		theVector[i] = theBuffer.ReadString();
+	return true;
+}
+
+std::string FontData::GetCacheFileName()
+{
+	// FNV-1a
+	uint64_t aHash = 0xCBF29CE484222325ULL;
+	for (ulong i = 0; i < mSourceFile.length(); i++)
+	{
+		aHash ^= (uchar)toupper(mSourceFile[i]);
+		aHash *= 0x100000001B3ULL;
+	}
+
+	return gAppBase->GetCacheFolder() + StrFormat("fonts/%016llx.fnt", (unsigned long long)aHash);
+}
+
+void FontData::ClearData()
+{
+	for (DataElementMap::iterator anItr = mDefineMap.begin(); anItr != mDefineMap.end(); ++anItr)
+		delete anItr->second;
+	mDefineMap.clear();
+
+	mFontLayerMap.clear();
+	mFontLayerList.clear();
+	mDefaultPointSize = 0;
+	mHasWideChars = false;
+
+	for (ulong i = 0; i < 256; i++)
+		mCharMap[i] = (uchar)i;
+}
+
+bool FontData::SaveCache(const std::string &theCacheFileName, ulong theSourceSize, ulong theSourceCRC)
+{
+	Buffer aData;
+	aData.WriteString(mSourceFile);
+	aData.WriteLong(mDefaultPointSize);
+	aData.WriteBytes(mCharMap, 256);
+
+	aData.WriteLong((long)mDefineMap.size());
+	for (DataElementMap::iterator anItr = mDefineMap.begin(); anItr != mDefineMap.end(); ++anItr)
+	{
+		aData.WriteString(anItr->first);
+		WriteDataElement(aData, anItr->second);
+	}
+
+	aData.WriteLong((long)mFontLayerList.size());
+	for (FontLayerList::iterator aLayerItr = mFontLayerList.begin(); aLayerItr != mFontLayerList.end(); ++aLayerItr)
+	{
+		FontLayer *aLayer = &*aLayerItr;
+
+		std::string aLayerName;
+		for (FontLayerMap::iterator anItr = mFontLayerMap.begin(); anItr != mFontLayerMap.end(); ++anItr)
+		{
+			if (anItr->second == aLayer)
+				aLayerName = anItr->first;
+		}
+
+		aData.WriteString(aLayerName);
+		WriteStringVector(aData, aLayer->mRequiredTags);
+		WriteStringVector(aData, aLayer->mExcludedTags);
+
+		// The image size goes in too, char rects were only checked against the image they were parsed with
+		aData.WriteString(aLayer->mImageFileName);
+		aData.WriteLong(((Image *)aLayer->mImage != nullptr) ? aLayer->mImage->GetWidth() : -1);
+		aData.WriteLong(((Image *)aLayer->mImage != nullptr) ? aLayer->mImage->GetHeight() : -1);
+
+		WriteColor(aData, aLayer->mColorMult);
+		WriteColor(aData, aLayer->mColorAdd);
+		aData.WriteLong(aLayer->mDrawMode);
+		aData.WriteLong(aLayer->mOffset.mX);
+		aData.WriteLong(aLayer->mOffset.mY);
+		aData.WriteLong(aLayer->mSpacing);
+		aData.WriteLong(aLayer->mMinPointSize);
+		aData.WriteLong(aLayer->mMaxPointSize);
+		aData.WriteLong(aLayer->mPointSize);
+		aData.WriteLong(aLayer->mAscent);
+		aData.WriteLong(aLayer->mAscentPadding);
+		aData.WriteLong(aLayer->mHeight);
+		aData.WriteLong(aLayer->mDefaultHeight);
+		aData.WriteLong(aLayer->mLineSpacingOffset);
+		aData.WriteLong(aLayer->mBaseOrder);
+
+		// Glyph 0 is the empty glyph and isn't written, each glyph's pairs are already sorted
+		const GlyphTable &aGlyphs = aLayer->mGlyphs;
+		aData.WriteLong(aGlyphs.GetNumGlyphs() - 1);
+		for (int aGlyph = 1; aGlyph < aGlyphs.GetNumGlyphs(); aGlyph++)
+		{
+			aData.WriteLong(aGlyphs.mChars[aGlyph]);
+			aData.WriteLong(aGlyphs.mImageRects[aGlyph].mX);
+			aData.WriteLong(aGlyphs.mImageRects[aGlyph].mY);
+			aData.WriteLong(aGlyphs.mImageRects[aGlyph].mWidth);
+			aData.WriteLong(aGlyphs.mImageRects[aGlyph].mHeight);
+			aData.WriteLong(aGlyphs.mOffsets[aGlyph].mX);
+			aData.WriteLong(aGlyphs.mOffsets[aGlyph].mY);
+			aData.WriteLong(aGlyphs.mWidths[aGlyph]);
+			aData.WriteLong(aGlyphs.mOrders[aGlyph]);
+
+			aData.WriteLong(aGlyphs.mKerningStart[aGlyph + 1] - aGlyphs.mKerningStart[aGlyph]);
+			for (uint32_t i = aGlyphs.mKerningStart[aGlyph]; i < aGlyphs.mKerningStart[aGlyph + 1]; i++)
+			{
+				aData.WriteLong(aGlyphs.mKerningPairs[i].mNextChar);
+				aData.WriteLong(aGlyphs.mKerningPairs[i].mOffset);
+			}
+		}
+	}
+
+	Buffer aFile;
+	aFile.WriteBytes((const uchar *)"PFNT", 4);
+	aFile.WriteLong(FONTCACHE_VERSION);
+	aFile.WriteLong(theSourceSize);
+	aFile.WriteLong(theSourceCRC);
+	aFile.WriteLong(aData.GetDataLen());
+	aFile.WriteLong(crc32(0, aData.GetDataPtr(), aData.GetDataLen()));
+	aFile.WriteBytes(aData.GetDataPtr(), aData.GetDataLen());
+
+	return mApp->WriteBufferToFileAtomic(theCacheFileName, &aFile);
+}
+
+bool FontData::LoadCache(const std::string &theCacheFileName, ulong theSourceSize, ulong theSourceCRC)
+{
+	Buffer aFile;
+	if ((!mApp->ReadBufferFromFile(theCacheFileName, &aFile)) || (aFile.GetDataLen() < 24))
+		return false;
+
+	const uchar *aHeader = aFile.GetDataPtr();
+	if (memcmp(aHeader, "PFNT", 4) != 0)
+		return false;
+
+	uchar aMagic[4];
+	aFile.ReadBytes(aMagic, 4);
+	if (((ulong)aFile.ReadLong() != FONTCACHE_VERSION) || ((ulong)aFile.ReadLong() != theSourceSize) ||
+		((ulong)aFile.ReadLong() != theSourceCRC))
+		return false;
+
+	long aDataLen = aFile.ReadLong();
+	ulong aDataCRC = (ulong)aFile.ReadLong();
+	if ((aDataLen != aFile.GetDataLen() - 24) || (aDataCRC != crc32(0, aHeader + 24, aDataLen)))
+		return false;
+
+	// Everything past here was written by SaveCache and checksummed, but keep the counts sane anyway
+	const Buffer &aData = aFile;
+	bool aResult = true;
+
+	if (aData.ReadString() != mSourceFile)
+		return false;
+
+	mDefaultPointSize = aData.ReadLong();
+	aData.ReadBytes(mCharMap, 256);
+
+	long aNumDefines = aData.ReadLong();
+	for (long i = 0; (i < aNumDefines) && (aResult); i++)
+	{
+		std::string aName = aData.ReadString();
+		DataElement *anElement = ReadDataElement(aData, 0);
+		if (anElement != nullptr)
+			mDefineMap.insert(DataElementMap::value_type(aName, anElement));
+		else
+			aResult = false;
+	}
+
+	long aNumLayers = aResult ? aData.ReadLong() : 0;
+	for (long aLayerNum = 0; (aLayerNum < aNumLayers) && (aResult); aLayerNum++)
+	{
+		mFontLayerList.push_back(FontLayer(this));
+		FontLayer *aLayer = &mFontLayerList.back();
+
+		std::string aLayerName = aData.ReadString();
+		if (!aLayerName.empty())
+			mFontLayerMap.insert(FontLayerMap::value_type(aLayerName, aLayer));
+
+		aResult = ReadStringVector(aData, aLayer->mRequiredTags) && ReadStringVector(aData, aLayer->mExcludedTags);
+
+		aLayer->mImageFileName = aData.ReadString();
+		long anImageWidth = aData.ReadLong();
+		long anImageHeight = aData.ReadLong();
+		if ((aResult) && (!aLayer->mImageFileName.empty()))
+		{
+			bool isNew;
+			SharedImageRef anImage = mApp->GetSharedImage(aLayer->mImageFileName, "", &isNew);
+			if (((Image *)anImage == nullptr) || (anImage->GetWidth() != anImageWidth) ||
+				(anImage->GetHeight() != anImageHeight))
+				aResult = false;
+			else
+			{
+				if (isNew)
+					anImage->Palletize();
+				aLayer->mImage = anImage;
+			}
+		}
+
+		aLayer->mColorMult = ReadColor(aData);
+		aLayer->mColorAdd = ReadColor(aData);
+		aLayer->mDrawMode = aData.ReadLong();
+		aLayer->mOffset.mX = aData.ReadLong();
+		aLayer->mOffset.mY = aData.ReadLong();
+		aLayer->mSpacing = aData.ReadLong();
+		aLayer->mMinPointSize = aData.ReadLong();
+		aLayer->mMaxPointSize = aData.ReadLong();
+		aLayer->mPointSize = aData.ReadLong();
+		aLayer->mAscent = aData.ReadLong();
+		aLayer->mAscentPadding = aData.ReadLong();
+		aLayer->mHeight = aData.ReadLong();
+		aLayer->mDefaultHeight = aData.ReadLong();
+		aLayer->mLineSpacingOffset = aData.ReadLong();
+		aLayer->mBaseOrder = aData.ReadLong();
+
+		GlyphTable &aGlyphs = aLayer->mGlyphs;
+		long aNumGlyphs = aData.ReadLong();
+		if ((aNumGlyphs < 0) || (aNumGlyphs > 0xFFFF))
+			aResult = false;
+
+		for (long i = 0; (i < aNumGlyphs) && (aResult); i++)
+		{
+			uint32_t aChar = aData.ReadLong();
+			int aGlyph = aGlyphs.AddGlyph(aChar);
+			if (aGlyph != i + 1)
+			{
+				aResult = false;
+				break;
+			}
+
+			if (aChar >= 256)
+				mHasWideChars = true;
+
+			aGlyphs.mImageRects[aGlyph].mX = aData.ReadLong();
+			aGlyphs.mImageRects[aGlyph].mY = aData.ReadLong();
+			aGlyphs.mImageRects[aGlyph].mWidth = aData.ReadLong();
+			aGlyphs.mImageRects[aGlyph].mHeight = aData.ReadLong();
+			aGlyphs.mOffsets[aGlyph].mX = aData.ReadLong();
+			aGlyphs.mOffsets[aGlyph].mY = aData.ReadLong();
+			aGlyphs.mWidths[aGlyph] = aData.ReadLong();
+			aGlyphs.mOrders[aGlyph] = aData.ReadLong();
+
+			long aNumPairs = aData.ReadLong();
+			if ((aNumPairs < 0) || (aNumPairs > 0x10000))
+				aResult = false;
+
+			for (long j = 0; (j < aNumPairs) && (aResult); j++)
+			{
+				uint32_t aNextChar = aData.ReadLong();
+				aGlyphs.SetKerning(aChar, aNextChar, (int)aData.ReadLong());
+			}
+		}
+	}
+
+	if ((!aResult) || (!aData.AtEnd()))
+	{
+		ClearData();
+		return false;
+	}
+
+	return true;
+}
+
 bool FontData::Load(AppBase *thePopLibApp, const std::string &theFontDescFileName)
 {
 	if (mInitialized)
@@ -1002,12 +1579,37 @@ bool FontData::Load(AppBase *thePopLibApp, const std::string &theFontDescFileNam
 
 	mSourceFile = theFontDescFileName;
 
+	ulong aSourceSize = 0;
+	ulong aSourceCRC = 0;
+	bool useCache = mApp->mFontCacheEnabled && GetFontSourceStamp(theFontDescFileName, aSourceSize, aSourceCRC);
+
+	std::string aCacheFileName;
+	if (useCache)
+	{
+		aCacheFileName = GetCacheFileName();
+		if (LoadCache(aCacheFileName, aSourceSize, aSourceCRC))
+		{
+			mInitialized = true;
+			return true;
+		}
+	}
+
 	mInitialized = LoadDescriptor(theFontDescFileName);
-	;
+
+	if ((mInitialized) && (useCache))
+		SaveCache(aCacheFileName, aSourceSize, aSourceCRC);
 
 	return !hasErrors;
 }
 
+int FontData::GetMemSize()
+{
+	int aSize = sizeof(FontData);
+	for (FontLayerList::iterator anItr = mFontLayerList.begin(); anItr != mFontLayerList.end(); ++anItr)
+		aSize += anItr->GetMemSize();
+	return aSize;
+}
+
 bool FontData::LoadLegacy(Image *theFontImage, const std::string &theFontDescFileName)
 {
 	if (mInitialized)
@@ -1033,7 +1635,8 @@ bool FontData::LoadLegacy(Image *theFontImage, const std::string &theFontDescFil
 	mSourceFile = theFontDescFileName;
 
 	int aSpaceWidth = 0;
-	fscanf(aStream, "%d%d", &aFontLayer->mCharData[' '].mWidth, &aFontLayer->mAscent);
+	fscanf(aStream, "%d%d", &aSpaceWidth, &aFontLayer->mAscent);
+	aFontLayer->mGlyphs.mWidths[aFontLayer->mGlyphs.AddGlyph(' ')] = aSpaceWidth;
 
 	while (!feof(aStream))
 	{
@@ -1047,20 +1650,22 @@ bool FontData::LoadLegacy(Image *theFontImage, const std::string &theFontDescFil
 		if (aChar == 0)
 			break;
 
-		aFontLayer->mCharData[(uchar)aChar].mImageRect = Rect(aCharPos, 0, aWidth, aFontLayer->mImage->GetHeight());
-		aFontLayer->mCharData[(uchar)aChar].mWidth = aWidth;
+		int aGlyph = aFontLayer->mGlyphs.AddGlyph((uchar)aChar);
+		aFontLayer->mGlyphs.mImageRects[aGlyph] = Rect(aCharPos, 0, aWidth, aFontLayer->mImage->GetHeight());
+		aFontLayer->mGlyphs.mWidths[aGlyph] = aWidth;
 
 		aCharPos += aWidth;
 	}
 
 	char c;
+	GlyphTable &aGlyphs = aFontLayer->mGlyphs;
 
 	for (c = 'A'; c <= 'Z'; c++)
-		if ((aFontLayer->mCharData[c].mWidth == 0) && (aFontLayer->mCharData[c - 'A' + 'a'].mWidth != 0))
+		if ((aGlyphs.mWidths[aGlyphs.GetGlyph(c)] == 0) && (aGlyphs.mWidths[aGlyphs.GetGlyph(c - 'A' + 'a')] != 0))
 			mCharMap[c] = c - 'A' + 'a';
 
 	for (c = 'a'; c <= 'z'; c++)
-		if ((aFontLayer->mCharData[c].mWidth == 0) && (aFontLayer->mCharData[c - 'a' + 'A'].mWidth != 0))
+		if ((aGlyphs.mWidths[aGlyphs.GetGlyph(c)] == 0) && (aGlyphs.mWidths[aGlyphs.GetGlyph(c - 'a' + 'A')] != 0))
 			mCharMap[c] = c - 'a' + 'A';
 
 	mInitialized = true;
@@ -1079,13 +1684,10 @@ ActiveFontLayer::ActiveFontLayer()
 
 ActiveFontLayer::ActiveFontLayer(const ActiveFontLayer &theActiveFontLayer)
 	: mBaseFontLayer(theActiveFontLayer.mBaseFontLayer), mScaledImage(theActiveFontLayer.mScaledImage),
-	  mOwnsImage(theActiveFontLayer.mOwnsImage)
+	  mOwnsImage(theActiveFontLayer.mOwnsImage), mScaledGlyphRects(theActiveFontLayer.mScaledGlyphRects)
 {
 	if (mOwnsImage)
 		mScaledImage = mBaseFontLayer->mFontData->mApp->CopyImage(mScaledImage);
-
-	for (int aCharNum = 0; aCharNum < 256; aCharNum++)
-		mScaledCharImageRects[aCharNum] = theActiveFontLayer.mScaledCharImageRects[aCharNum];
 }
 
 ActiveFontLayer::~ActiveFontLayer()
@@ -1155,9 +1757,12 @@ PopChar ImageFont::GetMappedChar(char value)
 	return mFontData->mCharMap[value];
 }
 
-CharData *FontLayer::GetCharData(PopChar value)
+int ImageFont::GetMemSize()
 {
-	return &mCharData[value];
+	int aSize = sizeof(ImageFont) + mFontData->GetMemSize();
+	for (ActiveFontLayerList::iterator anItr = mActiveLayerList.begin(); anItr != mActiveLayerList.end(); ++anItr)
+		aSize += (int)(sizeof(ActiveFontLayer) + anItr->mScaledGlyphRects.size() * sizeof(Rect));
+	return aSize;
 }
 
 ImageFont::~ImageFont()
@@ -1232,8 +1837,7 @@ void ImageFont::GenerateActiveFontLayers()
 
 					// Use the specified point size
 
-					for (int aCharNum = 0; aCharNum < 256; aCharNum++)
-						anActiveFontLayer->mScaledCharImageRects[aCharNum] = aFontLayer->mCharData[aCharNum].mImageRect;
+					anActiveFontLayer->mScaledGlyphRects = aFontLayer->mGlyphs.mImageRects;
 				}
 				else
 				{
@@ -1244,21 +1848,23 @@ void ImageFont::GenerateActiveFontLayers()
 					}
 
 					// Resize font elements
-					int aCharNum;
+					int aGlyph;
+					int aNumGlyphs = aFontLayer->mGlyphs.GetNumGlyphs();
+					anActiveFontLayer->mScaledGlyphRects.resize(aNumGlyphs);
 
 					MemoryImage *aMemoryImage = new MemoryImage(mFontData->mApp);
 
 					int aCurX = 0;
 					int aMaxHeight = 0;
 
-					for (aCharNum = 0; aCharNum < 256; aCharNum++)
+					for (aGlyph = 0; aGlyph < aNumGlyphs; aGlyph++)
 					{
-						Rect *anOrigRect = &aFontLayer->mCharData[aCharNum].mImageRect;
+						Rect *anOrigRect = &aFontLayer->mGlyphs.mImageRects[aGlyph];
 
 						Rect aScaledRect(aCurX, 0, (int)((anOrigRect->mWidth * aPointSize) / aLayerPointSize),
 										 (int)((anOrigRect->mHeight * aPointSize) / aLayerPointSize));
 
-						anActiveFontLayer->mScaledCharImageRects[aCharNum] = aScaledRect;
+						anActiveFontLayer->mScaledGlyphRects[aGlyph] = aScaledRect;
 
 						if (aScaledRect.mHeight > aMaxHeight)
 							aMaxHeight = aScaledRect.mHeight;
@@ -1275,11 +1881,11 @@ void ImageFont::GenerateActiveFontLayers()
 
 					Graphics g(aMemoryImage);
 
-					for (aCharNum = 0; aCharNum < 256; aCharNum++)
+					for (aGlyph = 0; aGlyph < aNumGlyphs; aGlyph++)
 					{
 						if ((Image *)aFontLayer->mImage != nullptr)
-							g.DrawImage(aFontLayer->mImage, anActiveFontLayer->mScaledCharImageRects[aCharNum],
-										aFontLayer->mCharData[aCharNum].mImageRect);
+							g.DrawImage(aFontLayer->mImage, anActiveFontLayer->mScaledGlyphRects[aGlyph],
+										aFontLayer->mGlyphs.mImageRects[aGlyph]);
 					}
 
 					if (mForceScaledImagesWhite)
@@ -1327,35 +1933,61 @@ void ImageFont::GenerateActiveFontLayers()
 	}
 }
 
+uint32_t ImageFont::GetNextChar(const PopString &theString, ulong &thePos)
+{
+	uchar aByte = (uchar)theString[thePos++];
+
+	// Fonts with nothing past 255 keep reading strings a byte at a time, so 8-bit text still works
+	if ((aByte < 0x80) || (!mFontData->mHasWideChars))
+		return aByte;
+
+	uint32_t aChar;
+	int aLength = DecodeUTF8Char((const uchar *)theString.data() + thePos - 1, theString.length() - thePos + 1, &aChar);
+	if (aLength == 0)
+		return aByte;
+
+	thePos += aLength - 1;
+	return aChar;
+}
+
 int ImageFont::StringWidth(const PopString &theString)
 {
+	Prepare();
+
 	int aWidth = 0;
-	char aPrevChar = 0;
-	for (int i = 0; i < (int)theString.length(); i++)
+	uint32_t aPrevChar = 0;
+	ulong aPos = 0;
+	while (aPos < theString.length())
 	{
-		char aChar = theString[i];
-		aWidth += CharWidthKern(aChar, aPrevChar);
+		uint32_t aChar = MapChar(GetNextChar(theString, aPos));
+		aWidth += GlyphWidthKern(aChar, aPrevChar);
 		aPrevChar = aChar;
 	}
 
 	return aWidth;
 }
 
-int ImageFont::CharWidthKern(char theChar, char thePrevChar)
+int ImageFont::CharWidthKern(uint32_t theChar, uint32_t thePrevChar)
 {
 	Prepare();
 
+	uint32_t aPrevChar = 0;
+	if (thePrevChar != 0)
+		aPrevChar = MapChar(thePrevChar);
+
+	return GlyphWidthKern(MapChar(theChar), aPrevChar);
+}
+
+int ImageFont::GlyphWidthKern(uint32_t theChar, uint32_t thePrevChar)
+{
 	int aMaxXPos = 0;
 	double aPointSize = mPointSize * mScale;
 
-	theChar = mFontData->mCharMap[(uchar)theChar];
-	if (thePrevChar != 0)
-		thePrevChar = mFontData->mCharMap[(uchar)thePrevChar];
-
 	ActiveFontLayerList::iterator anItr = mActiveLayerList.begin();
 	while (anItr != mActiveLayerList.end())
 	{
 		ActiveFontLayer *anActiveFontLayer = &*anItr;
+		const GlyphTable &aGlyphs = anActiveFontLayer->mBaseFontLayer->mGlyphs;
 
 		int aLayerXPos = 0;
 
@@ -1363,35 +1995,22 @@ int ImageFont::CharWidthKern(char theChar, char thePrevChar)
 		int aSpacing;
 
 		int aLayerPointSize = anActiveFontLayer->mBaseFontLayer->mPointSize;
+		int aWidth = aGlyphs.mWidths[aGlyphs.GetGlyph(theChar)];
+
+		int aKerning = 0;
+		if (thePrevChar != 0)
+			aKerning = anActiveFontLayer->mBaseFontLayer->mSpacing +
+					   aGlyphs.GetKerning(thePrevChar, theChar);
 
 		if (aLayerPointSize == 0)
 		{
-			aCharWidth = anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)theChar].mWidth * mScale;
-
-			if (thePrevChar != 0)
-			{
-				aSpacing =
-					(anActiveFontLayer->mBaseFontLayer->mSpacing +
-					 anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)thePrevChar].mKerningOffsets[(uchar)theChar]) *
-					mScale;
-			}
-			else
-				aSpacing = 0;
+			aCharWidth = aWidth * mScale;
+			aSpacing = aKerning * mScale;
 		}
 		else
 		{
-			aCharWidth =
-				(anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)theChar].mWidth * aPointSize / aLayerPointSize);
-
-			if (thePrevChar != 0)
-			{
-				aSpacing =
-					(anActiveFontLayer->mBaseFontLayer->mSpacing +
-					 anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)thePrevChar].mKerningOffsets[(uchar)theChar]) *
-					aPointSize / aLayerPointSize;
-			}
-			else
-				aSpacing = 0;
+			aCharWidth = (aWidth * aPointSize / aLayerPointSize);
+			aSpacing = aKerning * aPointSize / aLayerPointSize;
 		}
 
 		aLayerXPos += aCharWidth + aSpacing;
@@ -1405,7 +2024,7 @@ int ImageFont::CharWidthKern(char theChar, char thePrevChar)
 	return aMaxXPos;
 }
 
-int ImageFont::CharWidth(char theChar)
+int ImageFont::CharWidth(uint32_t theChar)
 {
 	return CharWidthKern(theChar, 0);
 }
@@ -1452,13 +2071,20 @@ void ImageFont::DrawStringEx(Graphics *g, int theX, int theY, const PopString &t
 	int aCurXPos = theX;
 	int aCurPoolIdx = 0;
 
-	for (ulong aCharNum = 0; aCharNum < theString.length(); aCharNum++)
+	ulong aPos = 0;
+	ulong aNextPos = 0;
+	uint32_t aNextChar = 0;
+	if (!theString.empty())
+		aNextChar = MapChar(GetNextChar(theString, aNextPos));
+
+	while (aPos < theString.length())
 	{
-		char aChar = mFontData->mCharMap[(uchar)theString[aCharNum]];
+		uint32_t aChar = aNextChar;
+		aPos = aNextPos;
 
-		char aNextChar = 0;
-		if (aCharNum < theString.length() - 1)
-			aNextChar = mFontData->mCharMap[(uchar)theString[aCharNum + 1]];
+		aNextChar = 0;
+		if (aNextPos < theString.length())
+			aNextChar = MapChar(GetNextChar(theString, aNextPos));
 
 		int aMaxXPos = aCurXPos;
 
@@ -1466,6 +2092,8 @@ void ImageFont::DrawStringEx(Graphics *g, int theX, int theY, const PopString &t
 		while (anItr != mActiveLayerList.end())
 		{
 			ActiveFontLayer *anActiveFontLayer = &*anItr;
+			const GlyphTable &aGlyphs = anActiveFontLayer->mBaseFontLayer->mGlyphs;
+			int aGlyph = aGlyphs.GetGlyph(aChar);
 
 			int aLayerXPos = aCurXPos;
 
@@ -1482,38 +2110,33 @@ void ImageFont::DrawStringEx(Graphics *g, int theX, int theY, const PopString &t
 
 			if (aScale == 1.0)
 			{
-				anImageX = aLayerXPos + anActiveFontLayer->mBaseFontLayer->mOffset.mX +
-						   anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)aChar].mOffset.mX;
+				anImageX =
+					aLayerXPos + anActiveFontLayer->mBaseFontLayer->mOffset.mX + aGlyphs.mOffsets[aGlyph].mX;
 				anImageY =
 					theY - (anActiveFontLayer->mBaseFontLayer->mAscent - anActiveFontLayer->mBaseFontLayer->mOffset.mY -
-							anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)aChar].mOffset.mY);
-				aCharWidth = anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)aChar].mWidth;
+							aGlyphs.mOffsets[aGlyph].mY);
+				aCharWidth = aGlyphs.mWidths[aGlyph];
 
 				if (aNextChar != 0)
 				{
-					aSpacing =
-						anActiveFontLayer->mBaseFontLayer->mSpacing +
-						anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)aChar].mKerningOffsets[(uchar)aNextChar];
+					aSpacing = anActiveFontLayer->mBaseFontLayer->mSpacing + aGlyphs.GetKerning(aChar, aNextChar);
 				}
 				else
 					aSpacing = 0;
 			}
 			else
 			{
-				anImageX = aLayerXPos + (int)((anActiveFontLayer->mBaseFontLayer->mOffset.mX +
-											   anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)aChar].mOffset.mX) *
-											  aScale);
+				anImageX = aLayerXPos +
+						   (int)((anActiveFontLayer->mBaseFontLayer->mOffset.mX + aGlyphs.mOffsets[aGlyph].mX) * aScale);
 				anImageY = theY - (int)((anActiveFontLayer->mBaseFontLayer->mAscent -
-										 anActiveFontLayer->mBaseFontLayer->mOffset.mY -
-										 anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)aChar].mOffset.mY) *
+										 anActiveFontLayer->mBaseFontLayer->mOffset.mY - aGlyphs.mOffsets[aGlyph].mY) *
 										aScale);
-				aCharWidth = (anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)aChar].mWidth * aScale);
+				aCharWidth = (aGlyphs.mWidths[aGlyph] * aScale);
 
 				if (aNextChar != 0)
 				{
 					aSpacing = (int)((anActiveFontLayer->mBaseFontLayer->mSpacing +
-									  anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)aChar]
-										  .mKerningOffsets[(uchar)aNextChar]) *
+									  aGlyphs.GetKerning(aChar, aNextChar)) *
 									 aScale);
 				}
 				else
@@ -1534,8 +2157,7 @@ void ImageFont::DrawStringEx(Graphics *g, int theX, int theY, const PopString &t
 									anActiveFontLayer->mBaseFontLayer->mColorAdd.mAlpha,
 								255);
 
-			int anOrder = anActiveFontLayer->mBaseFontLayer->mBaseOrder +
-						  anActiveFontLayer->mBaseFontLayer->mCharData[(uchar)aChar].mOrder;
+			int anOrder = anActiveFontLayer->mBaseFontLayer->mBaseOrder + aGlyphs.mOrders[aGlyph];
 
 			if (aCurPoolIdx >= POOL_SIZE)
 				break;
@@ -1546,10 +2168,11 @@ void ImageFont::DrawStringEx(Graphics *g, int theX, int theY, const PopString &t
 			aRenderCommand->mColor = aColor;
 			aRenderCommand->mDest[0] = anImageX;
 			aRenderCommand->mDest[1] = anImageY;
-			aRenderCommand->mSrc[0] = anActiveFontLayer->mScaledCharImageRects[(uchar)aChar].mX;
-			aRenderCommand->mSrc[1] = anActiveFontLayer->mScaledCharImageRects[(uchar)aChar].mY;
-			aRenderCommand->mSrc[2] = anActiveFontLayer->mScaledCharImageRects[(uchar)aChar].mWidth;
-			aRenderCommand->mSrc[3] = anActiveFontLayer->mScaledCharImageRects[(uchar)aChar].mHeight;
+			const Rect &aSrcRect = anActiveFontLayer->mScaledGlyphRects[aGlyph];
+			aRenderCommand->mSrc[0] = aSrcRect.mX;
+			aRenderCommand->mSrc[1] = aSrcRect.mY;
+			aRenderCommand->mSrc[2] = aSrcRect.mWidth;
+			aRenderCommand->mSrc[3] = aSrcRect.mHeight;
 			aRenderCommand->mMode = anActiveFontLayer->mBaseFontLayer->mDrawMode;
 			aRenderCommand->mNext = nullptr;
 
@@ -1575,12 +2198,11 @@ void ImageFont::DrawStringEx(Graphics *g, int theX, int theY, const PopString &t
 			g->SetColor(aColor);
 			if (anActiveFontLayer->mScaledImage != nullptr)
 				g->DrawImage(anActiveFontLayer->mScaledImage, anImageX, anImageY,
-			anActiveFontLayer->mScaledCharImageRects[aChar]); g->SetColor(anOrigColor); g->SetDrawMode(anOldDrawMode);*/
+			anActiveFontLayer->mScaledGlyphRects[aGlyph]); g->SetColor(anOrigColor); g->SetDrawMode(anOldDrawMode);*/
 
 			if (theDrawnAreas != nullptr)
 			{
-				Rect aDestRect = Rect(anImageX, anImageY, anActiveFontLayer->mScaledCharImageRects[(uchar)aChar].mWidth,
-									  anActiveFontLayer->mScaledCharImageRects[(uchar)aChar].mHeight);
+				Rect aDestRect = Rect(anImageX, anImageY, aSrcRect.mWidth, aSrcRect.mHeight);
 
 				theDrawnAreas->push_back(aDestRect);
 
@@ -8,23 +8,81 @@
 #include "readwrite/descparser.hpp"
 #include "sharedimage.hpp"
 
+#include <unordered_map>
+
 namespace PopLib
 {
 
 class AppBase;
 class Image;
 
-class CharData
+// Glyph metrics for one layer, kept as parallel arrays indexed by glyph.  Glyph 0 is the empty glyph
+// every char without data maps to.  Chars up to 255 are found through a flat table, anything above
+// through a hash map.  Each glyph's kerning is its own run of mKerningPairs sorted by next char, and
+// pairs of 8-bit chars are mirrored into a matrix with a row per char that starts a pair and a column
+// per char that ends one, so the common lookup is three loads.
+class GlyphTable
 {
   public:
-	Rect mImageRect;
-	Point mOffset;
-	char mKerningOffsets[256];
-	int mWidth;
-	int mOrder;
+	struct KerningPair
+	{
+		uint32_t mNextChar;
+		int mOffset;
+	};
+
+  public:
+	uint16_t mGlyphIndex[256];
+	std::unordered_map<uint32_t, uint16_t> mWideGlyphIndex;
+
+	std::vector<uint32_t> mChars;
+	std::vector<Rect> mImageRects;
+	std::vector<Point> mOffsets;
+	std::vector<int> mWidths;
+	std::vector<int> mOrders;
+	std::vector<uint32_t> mKerningStart; // one more entry than there are glyphs
+	std::vector<KerningPair> mKerningPairs;
+
+	uint16_t mKerningRow[256]; // row and column 0 are all zeros
+	uint16_t mKerningColumn[256];
+	int mNumKerningColumns;
+	std::vector<short> mKerningMatrix;
+	bool mHasWideKerning;
+
+  protected:
+	int AddKerningCell(uint32_t theChar, uint32_t theNextChar);
+	int GetWideKerning(uint32_t theChar, uint32_t theNextChar) const;
 
   public:
-	CharData();
+	GlyphTable();
+
+	void Clear();
+	int AddGlyph(uint32_t theChar);
+	void SetKerning(uint32_t theChar, uint32_t theNextChar, int theOffset);
+	int GetMemSize() const;
+
+	int GetNumGlyphs() const
+	{
+		return (int)mChars.size();
+	}
+
+	int GetGlyph(uint32_t theChar) const
+	{
+		if (theChar < 256)
+			return mGlyphIndex[theChar];
+
+		std::unordered_map<uint32_t, uint16_t>::const_iterator anItr = mWideGlyphIndex.find(theChar);
+		return (anItr != mWideGlyphIndex.end()) ? anItr->second : 0;
+	}
+
+	int GetKerning(uint32_t theChar, uint32_t theNextChar) const
+	{
+		if ((theChar < 256) && (theNextChar < 256))
+			return mKerningMatrix[mKerningRow[theChar] * mNumKerningColumns + mKerningColumn[theNextChar]];
+
+		if (!mHasWideKerning)
+			return 0;
+		return GetWideKerning(theChar, theNextChar);
+	}
 };
 
 class FontData;
@@ -35,10 +93,11 @@ class FontLayer
 	FontData *mFontData;
 	StringVector mRequiredTags;
 	StringVector mExcludedTags;
-	CharData mCharData[256];
+	GlyphTable mGlyphs;
 	Color mColorMult;
 	Color mColorAdd;
 	SharedImageRef mImage;
+	std::string mImageFileName; // as resolved by LayerSetImage, for the descriptor cache
 	int mDrawMode;
 	Point mOffset;
 	int mSpacing;
@@ -55,13 +114,15 @@ class FontLayer
   public:
 	FontLayer(FontData *theFontData);
 	FontLayer(const FontLayer &theFontLayer);
-	CharData *GetCharData(PopChar value);
+	int GetMemSize() const;
 };
 
 typedef std::list<FontLayer> FontLayerList;
 typedef std::map<std::string, FontLayer *> FontLayerMap;
 typedef std::list<Rect> RectList;
 
+const ulong FONTCACHE_VERSION = 2;
+
 class FontData : public DescParser
 {
   public:
@@ -71,6 +132,7 @@ class FontData : public DescParser
 
 	int mDefaultPointSize;
 	uchar mCharMap[256];
+	bool mHasWideChars; // some layer has glyphs above 255, so strings are read as UTF-8
 	FontLayerList mFontLayerList;
 	FontLayerMap mFontLayerMap;
 
@@ -84,6 +146,13 @@ class FontData : public DescParser
 	bool DataToLayer(DataElement *theSource, FontLayer **theFontLayer);
 	virtual bool HandleCommand(const ListDataElement &theParams);
 
+	// The fully resolved descriptor (layers, char data, kerning and defines) is kept under
+	// cache/fonts and reused for as long as the descriptor's size and CRC still match
+	std::string GetCacheFileName();
+	bool LoadCache(const std::string &theCacheFileName, ulong theSourceSize, ulong theSourceCRC);
+	bool SaveCache(const std::string &theCacheFileName, ulong theSourceSize, ulong theSourceCRC);
+	void ClearData();
+
   public:
 	FontData();
 	virtual ~FontData();
@@ -93,6 +162,8 @@ class FontData : public DescParser
 
 	bool Load(AppBase *thePopLibApp, const std::string &theFontDescFileName);
 	bool LoadLegacy(Image *theFontImage, const std::string &theFontDescFileName);
+
+	int GetMemSize();
 };
 
 class ActiveFontLayer
@@ -102,7 +173,7 @@ class ActiveFontLayer
 
 	Image *mScaledImage;
 	bool mOwnsImage;
-	Rect mScaledCharImageRects[256];
+	std::vector<Rect> mScaledGlyphRects; // indexed like mBaseFontLayer->mGlyphs
 
   public:
 	ActiveFontLayer();
@@ -137,6 +208,10 @@ class ImageFont : public Font
 	double mScale;
 	bool mForceScaledImagesWhite;
 
+  protected:
+	uint32_t MapChar(uint32_t theChar) { return (theChar < 256) ? mFontData->mCharMap[theChar] : theChar; }
+	int GlyphWidthKern(uint32_t theChar, uint32_t thePrevChar);
+
   public:
 	virtual void GenerateActiveFontLayers();
 	virtual void DrawStringEx(Graphics *g, int theX, int theY, const PopString &theString, const Color &theColor,
@@ -152,8 +227,9 @@ class ImageFont : public Font
 	ImageFont(Image *theFontImage, const std::string &theFontDescFileName);
 	// ImageFont(const ImageFont& theImageFont, Image* theImage);
 
-	virtual int CharWidth(char theChar);
-	virtual int CharWidthKern(char theChar, char thePrevChar);
+	virtual uint32_t GetNextChar(const PopString &theString, ulong &thePos);
+	virtual int CharWidth(uint32_t theChar);
+	virtual int CharWidthKern(uint32_t theChar, uint32_t thePrevChar);
 	virtual int StringWidth(const PopString &theString);
 	virtual void DrawString(Graphics *g, int theX, int theY, const PopString &theString, const Color &theColor,
 							const Rect &theClipRect);
@@ -170,6 +246,7 @@ class ImageFont : public Font
 	virtual std::string GetDefine(const std::string &theName);
 
 	PopChar GetMappedChar(char value);
+	int GetMemSize();
 
 	virtual void Prepare();
 };
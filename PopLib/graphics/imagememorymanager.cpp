@@ -0,0 +1,237 @@
+#include "imagememorymanager.hpp"
+#include "memoryimage.hpp"
+#include "sdlinterface.hpp"
+#include "appbase.hpp"
+#include "imagelib/imagelib.hpp"
+#include "misc/autocrit.hpp"
+
+#include <algorithm>
+
+using namespace PopLib;
+
+ImageMemoryManager::ImageMemoryManager()
+{
+	mBudget = 0;
+	mSweepInterval = 500;
+	mLastSweepTime = 0;
+	mSweepCount = 0;
+
+	mCPUMemory = 0;
+	mTextureMemory = 0;
+	mNumImages = 0;
+	mNumEvictedImages = 0;
+
+	mEvictCount = 0;
+	mReloadCount = 0;
+}
+
+ImageMemoryManager::~ImageMemoryManager()
+{
+}
+
+int ImageMemoryManager::GetCPUMemSize(MemoryImage *theImage)
+{
+	int aNumPixels = theImage->mWidth * theImage->mHeight;
+	int aSize = 0;
+
+	if (theImage->mBits != nullptr)
+		aSize += aNumPixels * 4;
+	if (theImage->mColorIndices != nullptr)
+		aSize += aNumPixels;
+	if (theImage->mColorTable != nullptr)
+		aSize += 256 * 4;
+	if (theImage->mNativeAlphaData != nullptr)
+		aSize += aNumPixels * 4;
+	if (theImage->mRLAlphaData != nullptr)
+		aSize += aNumPixels;
+	if (theImage->mRLAdditiveData != nullptr)
+		aSize += aNumPixels;
+
+	return aSize;
+}
+
+int ImageMemoryManager::GetTextureMemSize(MemoryImage *theImage)
+{
+	if (theImage->mD3DData == nullptr)
+		return 0;
+
+	return ((SDLTextureData *)theImage->mD3DData)->GetMemSize();
+}
+
+void ImageMemoryManager::SetBudget(int64_t theBudget)
+{
+	mBudget = theBudget;
+	Update(true);
+}
+
+void ImageMemoryManager::SetReloadable(MemoryImage *theImage, bool isReloadable)
+{
+	AutoCrit anAutoCrit(mCritSect);
+
+	// Program generated images ("!name") have nothing on disk to come back from
+	if ((theImage->mFilePath.empty()) || (theImage->mFilePath[0] == '!'))
+		isReloadable = false;
+
+	Entry &anEntry = mEntries[theImage];
+	anEntry.mLastDrawnSweep = mSweepCount;
+	anEntry.mLoadedBitsChangedCount = theImage->mBitsChangedCount;
+	anEntry.mReloadable = isReloadable;
+	anEntry.mEvicted = false;
+}
+
+void ImageMemoryManager::RemoveImage(MemoryImage *theImage)
+{
+	AutoCrit anAutoCrit(mCritSect);
+	mEntries.erase(theImage);
+}
+
+void ImageMemoryManager::EvictImage(MemoryImage *theImage)
+{
+	delete[] theImage->mBits;
+	theImage->mBits = nullptr;
+
+	delete[] theImage->mColorIndices;
+	theImage->mColorIndices = nullptr;
+
+	delete[] theImage->mColorTable;
+	theImage->mColorTable = nullptr;
+
+	delete[] theImage->mNativeAlphaData;
+	theImage->mNativeAlphaData = nullptr;
+
+	delete[] theImage->mRLAlphaData;
+	theImage->mRLAlphaData = nullptr;
+
+	delete[] theImage->mRLAdditiveData;
+	theImage->mRLAdditiveData = nullptr;
+
+	theImage->Delete3DBuffers();
+	mEvictCount++;
+}
+
+bool ImageMemoryManager::ReloadImage(MemoryImage *theImage)
+{
+	std::string aFilePath;
+
+	{
+		AutoCrit anAutoCrit(mCritSect);
+
+		EntryMap::iterator anItr = mEntries.find(theImage);
+		if ((anItr == mEntries.end()) || (!anItr->second.mEvicted))
+			return false;
+
+		aFilePath = theImage->mFilePath;
+	}
+
+	// Decode outside of the lock, this can take a while for large images
+	ImageLib::Image *aLoadedImage = ImageLib::GetImage(aFilePath, true);
+	if ((aLoadedImage == nullptr) || (aLoadedImage->mWidth != theImage->mWidth) ||
+		(aLoadedImage->mHeight != theImage->mHeight))
+	{
+		delete aLoadedImage;
+		return false;
+	}
+
+	theImage->TakeBits(aLoadedImage->mBits, aLoadedImage->mWidth, aLoadedImage->mHeight);
+	aLoadedImage->mBits = nullptr;
+	delete aLoadedImage;
+
+	AutoCrit anAutoCrit(mCritSect);
+
+	EntryMap::iterator anItr = mEntries.find(theImage);
+	if (anItr != mEntries.end())
+	{
+		anItr->second.mEvicted = false;
+		anItr->second.mLoadedBitsChangedCount = theImage->mBitsChangedCount;
+		anItr->second.mLastDrawnSweep = mSweepCount;
+	}
+
+	mReloadCount++;
+	return true;
+}
+
+void ImageMemoryManager::Update(bool force)
+{
+	uint64_t aNow = SDL_GetTicks();
+	if ((!force) && (aNow - mLastSweepTime < mSweepInterval))
+		return;
+
+	mLastSweepTime = aNow;
+	mSweepCount++;
+
+	typedef std::pair<uint32_t, MemoryImage *> Candidate;
+	std::vector<Candidate> aCandidates;
+
+	AutoCrit anImageCrit(gAppBase->mSDLInterface->mCritSect);
+	AutoCrit anAutoCrit(mCritSect);
+
+	mCPUMemory = 0;
+	mTextureMemory = 0;
+	mNumImages = 0;
+	mNumEvictedImages = 0;
+
+	MemoryImageSet &anImageSet = gAppBase->mMemoryImageSet;
+	for (MemoryImageSet::iterator anItr = anImageSet.begin(); anItr != anImageSet.end(); ++anItr)
+	{
+		MemoryImage *anImage = *anItr;
+
+		int aCPUSize = GetCPUMemSize(anImage);
+		int aTextureSize = GetTextureMemSize(anImage);
+
+		mCPUMemory += aCPUSize;
+		mTextureMemory += aTextureSize;
+		mNumImages++;
+
+		EntryMap::iterator anEntryItr = mEntries.find(anImage);
+		if (anEntryItr == mEntries.end())
+		{
+			anImage->mDrawn = false;
+			continue;
+		}
+
+		Entry &anEntry = anEntryItr->second;
+		if (anImage->mDrawn)
+		{
+			anEntry.mLastDrawnSweep = mSweepCount;
+			anImage->mDrawn = false;
+		}
+
+		if (anEntry.mEvicted)
+		{
+			mNumEvictedImages++;
+			continue;
+		}
+
+		// Anything drawn into since it was loaded can't be brought back from the file
+		if ((!anEntry.mReloadable) || (anEntry.mLoadedBitsChangedCount != anImage->mBitsChangedCount) ||
+			(anImage->mIsVolatile) || (anEntry.mLastDrawnSweep == mSweepCount) || (aCPUSize + aTextureSize == 0))
+			continue;
+
+		if ((anImage->mD3DData != nullptr) && (((SDLTextureData *)anImage->mD3DData)->mIsRenderTarget))
+			continue;
+
+		aCandidates.push_back(Candidate(anEntry.mLastDrawnSweep, anImage));
+	}
+
+	if ((mBudget <= 0) || (mCPUMemory + mTextureMemory <= mBudget))
+		return;
+
+	std::sort(aCandidates.begin(), aCandidates.end());
+
+	int64_t aTotal = mCPUMemory + mTextureMemory;
+	for (int i = 0; (i < (int)aCandidates.size()) && (aTotal > mBudget); i++)
+	{
+		MemoryImage *anImage = aCandidates[i].second;
+
+		int aCPUSize = GetCPUMemSize(anImage);
+		int aTextureSize = GetTextureMemSize(anImage);
+
+		EvictImage(anImage);
+		mEntries[anImage].mEvicted = true;
+
+		aTotal -= aCPUSize + aTextureSize;
+		mCPUMemory -= aCPUSize;
+		mTextureMemory -= aTextureSize;
+		mNumEvictedImages++;
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef __IMAGEMEMORYMANAGER_HPP__
+#define __IMAGEMEMORYMANAGER_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+#include "misc/critsect.hpp"
+
+#include <unordered_map>
+
+namespace PopLib
+{
+
+class MemoryImage;
+
+// Keeps count of the CPU and texture memory held by every MemoryImage, and when a budget is set,
+// evicts the least recently drawn images that can be loaded again from their mFilePath.  Evicted
+// images keep their size and flags, and are reloaded the next time something asks for their bits.
+class ImageMemoryManager
+{
+  public:
+	struct Entry
+	{
+		uint32_t mLastDrawnSweep;
+		int mLoadedBitsChangedCount; // the bits are untouched since loading while this still matches
+		bool mReloadable;
+		bool mEvicted;
+	};
+
+	typedef std::unordered_map<MemoryImage *, Entry> EntryMap;
+
+  public:
+	CritSect mCritSect;
+	EntryMap mEntries;
+
+	int64_t mBudget;		 // bytes of CPU + texture memory, 0 for no limit
+	uint32_t mSweepInterval; // ms between accounting passes
+	uint64_t mLastSweepTime;
+	uint32_t mSweepCount;
+
+	// Totals from the last sweep
+	int64_t mCPUMemory;
+	int64_t mTextureMemory;
+	int mNumImages;
+	int mNumEvictedImages;
+
+	int mEvictCount;
+	int mReloadCount;
+
+  protected:
+	void EvictImage(MemoryImage *theImage);
+
+  public:
+	ImageMemoryManager();
+	virtual ~ImageMemoryManager();
+
+	static int GetCPUMemSize(MemoryImage *theImage);
+	static int GetTextureMemSize(MemoryImage *theImage);
+
+	void SetBudget(int64_t theBudget);
+	void SetReloadable(MemoryImage *theImage, bool isReloadable);
+	void RemoveImage(MemoryImage *theImage);
+	bool ReloadImage(MemoryImage *theImage);
+
+	void Update(bool force = false);
+};
+
+} // namespace PopLib
+
+#endif // __IMAGEMEMORYMANAGER_HPP__
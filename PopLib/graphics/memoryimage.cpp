@@ -1086,6 +1086,10 @@ void MemoryImage::PurgeBits()
 		//  and therefore the actual purging
 		if (mD3DData == nullptr)
 			return;
+
+		// GetBits couldn't get them back out of the texture
+		if (!mApp->mSDLInterface->CanRecoverBits(this))
+			return;
 	}
 	else
 	{
@@ -1182,6 +1186,30 @@ void MemoryImage::SetBits(ulong *theBits, int theWidth, int theHeight, bool comm
 	}
 }
 
+// Like SetBits, but takes ownership of theBits instead of copying them.  theBits has to come from
+//  new[] with room for theWidth * theHeight + 1 ulongs.
+void MemoryImage::TakeBits(ulong *theBits, int theWidth, int theHeight, bool commitBits)
+{
+	if (theBits != mBits)
+	{
+		delete[] mColorIndices;
+		mColorIndices = nullptr;
+
+		delete[] mColorTable;
+		mColorTable = nullptr;
+
+		delete[] mBits;
+		mBits = theBits;
+		mWidth = theWidth;
+		mHeight = theHeight;
+		mBits[mWidth * mHeight] = MEMORYCHECK_ID;
+
+		BitsChanged();
+		if (commitBits)
+			CommitBits();
+	}
+}
+
 void MemoryImage::Create(int theWidth, int theHeight)
 {
 	delete[] mBits;
@@ -1199,6 +1227,11 @@ void MemoryImage::Create(int theWidth, int theHeight)
 
 ulong *MemoryImage::GetBits()
 {
+	// Evicted by the ImageMemoryManager, so bring it back from the file.  Only the manager knows, as the
+	// texture data may well have been recreated already by the time anything asks for the bits.
+	if ((mBits == nullptr) && (mColorTable == nullptr) && (mApp->mImageMemoryManager.ReloadImage(this)))
+		return mBits;
+
 	if (mBits == nullptr)
 	{
 		int aSize = mWidth * mHeight;
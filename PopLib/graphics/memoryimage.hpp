@@ -100,6 +100,7 @@ class MemoryImage : public Image
 
 	virtual void Clear();
 	virtual void SetBits(ulong *theBits, int theWidth, int theHeight, bool commitBits = true);
+	virtual void TakeBits(ulong *theBits, int theWidth, int theHeight, bool commitBits = true);
 	virtual void Create(int theWidth, int theHeight);
 	virtual ulong *GetBits();
 
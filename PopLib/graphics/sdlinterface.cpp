@@ -28,15 +28,16 @@ SDLInterface::SDLInterface(AppBase *theApp)
 	mPresentationRect = Rect(0, 0, mWidth, mHeight);
 	mScreenImage = nullptr;
 	mHasInitiated = false;
-	mCursorX = 0;
-	mCursorY = 0;
 	mIs3D = false;
 	mMillisecondsPerFrame = 0;
-	mNextCursorX = 0;
-	mNextCursorY = 0;
+	mLowPrecisionTextures = false;
+	mSupportsA4R4G4B4 = false;
+	mSupportsR5G6B5 = false;
 	mRefreshRate = 0;
 	mRenderer = nullptr;
 	mScreenTexture = nullptr;
+	mRenderTarget = nullptr;
+	mRenderTargetImage = nullptr;
 	mWindow = nullptr;
 }
 
@@ -174,6 +175,21 @@ bool SDLInterface::InitSDLRenderer()
 								 nullptr);
 		return false;
 	}
+	mRenderTarget = mScreenTexture;
+	mRenderTargetImage = nullptr;
+
+	// SDL will quietly convert unsupported formats back up to 32 bits, which would defeat the point
+	mSupportsA4R4G4B4 = false;
+	mSupportsR5G6B5 = false;
+	const SDL_PixelFormat *aFormats = (const SDL_PixelFormat *)SDL_GetPointerProperty(
+		SDL_GetRendererProperties(mRenderer), SDL_PROP_RENDERER_TEXTURE_FORMATS_POINTER, nullptr);
+	for (; (aFormats != nullptr) && (*aFormats != SDL_PIXELFORMAT_UNKNOWN); ++aFormats)
+	{
+		if (*aFormats == SDL_PIXELFORMAT_ARGB4444)
+			mSupportsA4R4G4B4 = true;
+		else if (*aFormats == SDL_PIXELFORMAT_RGB565)
+			mSupportsR5G6B5 = true;
+	}
 
 	const SDL_DisplayMode *aMode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(mWindow));
 	mRefreshRate = aMode->refresh_rate;
@@ -237,17 +253,6 @@ void SDLInterface::SetVideoOnlyDraw(bool videoOnly)
 	mScreenImage->SetImageMode(false, false);
 }
 
-/// <summary>
-/// Set the next cursor position
-/// </summary>
-/// <param name="theCursorX"></param>
-/// <param name="theCursorY"></param>
-void SDLInterface::SetCursorPos(int theCursorX, int theCursorY)
-{
-	mNextCursorX = theCursorX;
-	mNextCursorY = theCursorY;
-}
-
 /// <summary>
 /// Set the cursor image to a Image* or nullptr to hide the cursor
 /// </summary>
@@ -342,7 +347,11 @@ bool SDLInterface::CreateImageTexture(MemoryImage *theImage)
 
 	if (theImage->mD3DData == nullptr)
 	{
-		theImage->mD3DData = new SDLTextureData(mRenderer);
+		// An image the ImageMemoryManager evicted gets its bits back before there's a texture to upload them to
+		if ((theImage->mBits == nullptr) && (theImage->mColorTable == nullptr))
+			mApp->mImageMemoryManager.ReloadImage(theImage);
+
+		theImage->mD3DData = new SDLTextureData(this);
 
 		// The actual purging was deferred
 		wantPurge = theImage->mPurgeBits;
@@ -360,11 +369,85 @@ bool SDLInterface::CreateImageTexture(MemoryImage *theImage)
 	return true;
 }
 
-bool SDLInterface::RecoverBits(MemoryImage *theImage)
+/// <summary>
+/// Gives theImage a GPU render target texture instead of a static one, so it can be drawn into with SetRenderTarget
+/// </summary>
+/// <param name="theImage"></param>
+/// <returns></returns>
+bool SDLInterface::CreateRenderTarget(MemoryImage *theImage)
+{
+	if (theImage->mD3DData == nullptr)
+	{
+		theImage->mD3DData = new SDLTextureData(this);
+
+		AutoCrit aCrit(mCritSect); // Make images thread safe
+		mImageSet.insert(theImage);
+	}
+
+	SDLTextureData *aData = static_cast<SDLTextureData *>(theImage->mD3DData);
+	aData->mIsRenderTarget = true;
+	aData->CheckCreateTextures(theImage);
+
+	return aData->mTexture != nullptr;
+}
+
+/// <summary>
+/// Redirects all drawing to theImage's render target, or back to the screen when theImage is nullptr
+/// </summary>
+/// <param name="theImage"></param>
+/// <param name="clear">clear the target to transparent black first</param>
+void SDLInterface::SetRenderTarget(MemoryImage *theImage, bool clear)
+{
+	SDLTextureData *aData = theImage != nullptr ? static_cast<SDLTextureData *>(theImage->mD3DData) : nullptr;
+	if (aData != nullptr && aData->mIsRenderTarget && aData->mTexture != nullptr)
+	{
+		mRenderTarget = aData->mTexture;
+		mRenderTargetImage = theImage;
+	}
+	else
+	{
+		mRenderTarget = mScreenTexture;
+		mRenderTargetImage = nullptr;
+	}
+
+	if (clear)
+	{
+		SDL_SetRenderTarget(mRenderer, mRenderTarget);
+		SDL_SetRenderDrawBlendMode(mRenderer, SDL_BLENDMODE_NONE);
+		SDL_SetRenderDrawColor(mRenderer, 0, 0, 0, 0);
+		SDL_RenderClear(mRenderer);
+		SDL_SetRenderDrawBlendMode(mRenderer, ChooseBlendMode(Graphics::DRAWMODE_NORMAL));
+		SDL_SetRenderTarget(mRenderer, nullptr);
+	}
+}
+
+/// <summary>
+/// The image drawing is currently going to, nullptr when it's the screen
+/// </summary>
+/// <returns></returns>
+MemoryImage *SDLInterface::GetRenderTarget()
+{
+	return mRenderTargetImage;
+}
+
+/// <summary>
+/// False for the reduced texture formats, which can't give back the original bits
+/// </summary>
+/// <param name="theImage"></param>
+/// <returns></returns>
+bool SDLInterface::CanRecoverBits(MemoryImage *theImage)
 {
 	if (theImage->mD3DData == nullptr)
 		return false;
 
+	return ((SDLTextureData *)theImage->mD3DData)->mPixelFormat == SDL_PIXELFORMAT_ARGB8888;
+}
+
+bool SDLInterface::RecoverBits(MemoryImage *theImage)
+{
+	if (!CanRecoverBits(theImage))
+		return false;
+
 	SDLTextureData *aData = (SDLTextureData *)theImage->mD3DData;
 	if (aData->mBitsChangedCount != theImage->mBitsChangedCount) // bits have changed since texture was created
 		return false;
@@ -401,13 +484,51 @@ SDL_BlendMode SDLInterface::ChooseBlendMode(int theBlendMode)
 	return theSDLBlendMode;
 }
 
-SDLTextureData::SDLTextureData(SDL_Renderer *theRenderer)
+// Render targets are drawn into with normal blending from transparent black, which leaves their colour
+// already multiplied by alpha, so drawing them out again mustn't multiply it a second time
+SDL_BlendMode SDLInterface::ChooseBlendMode(SDLTextureData *theData, int theBlendMode)
+{
+	if ((theData == nullptr) || (!theData->mIsRenderTarget))
+		return ChooseBlendMode(theBlendMode);
+
+	if (theBlendMode == Graphics::DRAWMODE_ADDITIVE)
+		return SDL_BLENDMODE_ADD_PREMULTIPLIED;
+
+	return SDL_BLENDMODE_BLEND_PREMULTIPLIED;
+}
+
+SDL_PixelFormat SDLInterface::ChooseTextureFormat(MemoryImage *theImage)
+{
+	if ((theImage->mImageFlags & SDLImageFlag_UseA8R8G8B8) || (theImage->mIsVolatile))
+		return SDL_PIXELFORMAT_ARGB8888;
+
+	bool wantA4R4G4B4 = (theImage->mImageFlags & SDLImageFlag_UseA4R4G4B4) != 0;
+	if ((!wantA4R4G4B4) && (!mLowPrecisionTextures))
+		return SDL_PIXELFORMAT_ARGB8888;
+
+	theImage->CommitBits();
+
+	if ((!theImage->mHasAlpha) && (!theImage->mHasTrans) && (mSupportsR5G6B5))
+		return SDL_PIXELFORMAT_RGB565;
+
+	// Alpha gradients band badly in 4 bits, so only do it when the resource asks for it
+	if ((wantA4R4G4B4) && (mSupportsA4R4G4B4))
+		return SDL_PIXELFORMAT_ARGB4444;
+
+	return SDL_PIXELFORMAT_ARGB8888;
+}
+
+SDLTextureData::SDLTextureData(SDLInterface *theInterface)
 {
 	mWidth = 0;
 	mHeight = 0;
 	mBitsChangedCount = 0;
-	mRenderer = theRenderer;
+	mTexMemSize = 0;
+	mInterface = theInterface;
+	mRenderer = theInterface->mRenderer;
 	mTexture = nullptr;
+	mPixelFormat = SDL_PIXELFORMAT_ARGB8888;
+	mIsRenderTarget = false;
 }
 
 SDLTextureData::~SDLTextureData()
@@ -419,6 +540,70 @@ void SDLTextureData::ReleaseTextures()
 {
 	if (mTexture != nullptr)
 		SDL_DestroyTexture(mTexture);
+	mTexture = nullptr;
+	mTexMemSize = 0;
+}
+
+void SDLTextureData::CreateRenderTargetTexture(MemoryImage *theImage)
+{
+	ReleaseTextures();
+
+	mPixelFormat = SDL_PIXELFORMAT_ARGB8888;
+	mTexture = SDL_CreateTexture(mRenderer, mPixelFormat, SDL_TEXTUREACCESS_TARGET, theImage->mWidth,
+								 theImage->mHeight);
+	if (mTexture)
+	{
+		SDL_SetTextureScaleMode(mTexture, SDL_SCALEMODE_NEAREST);
+		mTexMemSize = SDL_BYTESPERPIXEL(mPixelFormat) * theImage->mWidth * theImage->mHeight;
+	}
+	else
+		SDL_Log("Failed to create render target texture: %s", SDL_GetError());
+
+	// the contents live only on the GPU, so there are never any bits to upload
+	mWidth = theImage->mWidth;
+	mHeight = theImage->mHeight;
+	mBitsChangedCount = theImage->mBitsChangedCount;
+}
+
+void SDLTextureData::UploadBits(MemoryImage *theImage)
+{
+	int aWidth = theImage->GetWidth();
+	int aHeight = theImage->GetHeight();
+
+	const ulong *aBits;
+	std::vector<ulong> anExpandedBits;
+	if ((theImage->mBits == nullptr) && (theImage->mColorTable != nullptr))
+	{
+		// Expand into a scratch buffer so the image gets to keep its 8-bit copy
+		int aSize = aWidth * aHeight;
+		anExpandedBits.resize(aSize);
+		for (int i = 0; i < aSize; i++)
+			anExpandedBits[i] = theImage->mColorTable[theImage->mColorIndices[i]];
+		aBits = anExpandedBits.data();
+	}
+	else
+		aBits = theImage->GetBits();
+
+	if (aBits == nullptr)
+	{
+		SDL_Log("Error: Image bits are nullptr, cannot update texture.");
+		return;
+	}
+
+	if (mPixelFormat == SDL_PIXELFORMAT_ARGB8888)
+	{
+		SDL_UpdateTexture(mTexture, nullptr, aBits, aWidth * SDL_BYTESPERPIXEL(SDL_PIXELFORMAT_ARGB8888));
+		return;
+	}
+
+	int aPitch = aWidth * SDL_BYTESPERPIXEL(mPixelFormat);
+	std::vector<uchar> aConvertedBits(aPitch * aHeight);
+	if (SDL_ConvertPixels(aWidth, aHeight, SDL_PIXELFORMAT_ARGB8888, aBits,
+						  aWidth * SDL_BYTESPERPIXEL(SDL_PIXELFORMAT_ARGB8888), mPixelFormat, aConvertedBits.data(),
+						  aPitch))
+		SDL_UpdateTexture(mTexture, nullptr, aConvertedBits.data(), aPitch);
+	else
+		SDL_Log("Failed to convert texture bits: %s", SDL_GetError());
 }
 
 void SDLTextureData::CreateTextures(MemoryImage *theImage)
@@ -428,8 +613,11 @@ void SDLTextureData::CreateTextures(MemoryImage *theImage)
 
 	bool createTexture = false;
 
-	// only recreate the texture if the dimensions or image data have changed
-	if (mWidth != theImage->mWidth || mHeight != theImage->mHeight || mBitsChangedCount != theImage->mBitsChangedCount)
+	SDL_PixelFormat aPixelFormat = mInterface->ChooseTextureFormat(theImage);
+
+	// only recreate the texture if the dimensions, format or image data have changed
+	if (mWidth != theImage->mWidth || mHeight != theImage->mHeight ||
+		mBitsChangedCount != theImage->mBitsChangedCount || mPixelFormat != aPixelFormat)
 	{
 		ReleaseTextures();
 		createTexture = true;
@@ -440,7 +628,8 @@ void SDLTextureData::CreateTextures(MemoryImage *theImage)
 
 	if (createTexture)
 	{
-		mTexture = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, aWidth, aHeight);
+		mPixelFormat = aPixelFormat;
+		mTexture = SDL_CreateTexture(mRenderer, mPixelFormat, SDL_TEXTUREACCESS_STATIC, aWidth, aHeight);
 
 		if (mTexture)
 		{
@@ -450,15 +639,8 @@ void SDLTextureData::CreateTextures(MemoryImage *theImage)
 												  ? SDL_SCALEMODE_NEAREST
 												  : SDL_SCALEMODE_LINEAR);
 
-			void *bits = theImage->GetBits();
-			if (bits)
-			{
-				SDL_UpdateTexture(mTexture, nullptr, bits, aWidth * SDL_BYTESPERPIXEL(SDL_PIXELFORMAT_ARGB8888));
-			}
-			else
-			{
-				SDL_Log("Error: Image bits are nullptr, cannot update texture.");
-			}
+			mTexMemSize = SDL_BYTESPERPIXEL(mPixelFormat) * aWidth * aHeight;
+			UploadBits(theImage);
 		}
 		else
 		{
@@ -467,15 +649,7 @@ void SDLTextureData::CreateTextures(MemoryImage *theImage)
 	}
 	else if (mBitsChangedCount != theImage->mBitsChangedCount)
 	{
-		void *bits = theImage->GetBits();
-		if (bits)
-		{
-			SDL_UpdateTexture(mTexture, nullptr, bits, aWidth * SDL_BYTESPERPIXEL(SDL_PIXELFORMAT_ARGB8888));
-		}
-		else
-		{
-			SDL_Log("Error: Image bits are nullptr, cannot update texture.");
-		}
+		UploadBits(theImage);
 	}
 
 	mWidth = theImage->mWidth;
@@ -485,6 +659,13 @@ void SDLTextureData::CreateTextures(MemoryImage *theImage)
 
 void SDLTextureData::CheckCreateTextures(MemoryImage *theImage)
 {
+	if (mIsRenderTarget)
+	{
+		if (mTexture == nullptr || mWidth != theImage->mWidth || mHeight != theImage->mHeight)
+			CreateRenderTargetTexture(theImage);
+		return;
+	}
+
 	if (mTexture != nullptr)
 	{
 		if (mWidth != theImage->mWidth || mHeight != theImage->mHeight ||
@@ -497,11 +678,7 @@ void SDLTextureData::CheckCreateTextures(MemoryImage *theImage)
 
 int SDLTextureData::GetMemSize()
 {
-	int aSize = 0;
-
-	aSize = (SDL_BYTESPERPIXEL(SDL_PIXELFORMAT_ARGB8888) / 8) * mWidth * mHeight;
-
-	return aSize;
+	return mTexMemSize;
 }
 
 /////////////////////////////////////////////////////////////////
@@ -518,11 +695,11 @@ void SDLInterface::Blt(Image *theImage, int theX, int theY, const Rect &theSrcRe
 	SDLTextureData *texData = static_cast<SDLTextureData *>(memImg->mD3DData);
 	SDL_Texture *texture = texData->mTexture;
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_SetTextureColorMod(texture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
 	SDL_SetTextureAlphaMod(texture, theColor.GetAlpha());
-	SDL_SetTextureBlendMode(texture, ChooseBlendMode(theDrawMode));
+	SDL_SetTextureBlendMode(texture, ChooseBlendMode(texData, theDrawMode));
 
 	SDL_FRect srcF = {(float)theSrcRect.mX, (float)theSrcRect.mY, (float)theSrcRect.mWidth, (float)theSrcRect.mHeight};
 	SDL_FRect dstF = {(float)theX, (float)theY, (float)theSrcRect.mWidth, (float)theSrcRect.mHeight};
@@ -544,7 +721,7 @@ void SDLInterface::BltClipF(Image *theImage, float theX, float theY, const Rect
 
 	SDLTextureData *aData = (SDLTextureData *)aSrcMemoryImage->mD3DData;
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_Texture *aTexture = aData->mTexture;
 	SDL_SetTextureColorMod(aTexture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
@@ -561,7 +738,7 @@ void SDLInterface::BltClipF(Image *theImage, float theX, float theY, const Rect
 
 	SDL_FRect srcRect = {theSrcRect.mX, theSrcRect.mY, theSrcRect.mWidth, theSrcRect.mHeight};
 
-	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(theDrawMode));
+	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(aData, theDrawMode));
 	SDL_RenderTexture(mRenderer, aTexture, &srcRect, &destRect);
 	SDL_SetRenderClipRect(mRenderer, nullptr);
 	SDL_SetRenderTarget(mRenderer, nullptr);
@@ -577,7 +754,7 @@ void SDLInterface::BltMirror(Image *theImage, float theX, float theY, const Rect
 
 	SDLTextureData *aData = (SDLTextureData *)aSrcMemoryImage->mD3DData;
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_Texture *aTexture = aData->mTexture;
 	SDL_SetTextureColorMod(aTexture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
@@ -586,7 +763,7 @@ void SDLInterface::BltMirror(Image *theImage, float theX, float theY, const Rect
 	SDL_FRect destRect = {theX, theY, theSrcRect.mWidth, theSrcRect.mHeight};
 	SDL_FRect srcRect = {theSrcRect.mX, theSrcRect.mY, theSrcRect.mWidth, theSrcRect.mHeight};
 
-	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(theDrawMode));
+	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(aData, theDrawMode));
 
 	SDL_RenderTextureRotated(mRenderer, aTexture, &srcRect, &destRect, 0, nullptr, SDL_FLIP_HORIZONTAL);
 	SDL_SetRenderTarget(mRenderer, nullptr);
@@ -602,7 +779,7 @@ void SDLInterface::StretchBlt(Image *theImage, const Rect &theDestRect, const Re
 	SDLTextureData *aData = static_cast<SDLTextureData *>(aSrcMemoryImage->mD3DData);
 	SDL_Texture *aTexture = aData->mTexture;
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 	SDL_SetTextureColorMod(aTexture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
 	SDL_SetTextureAlphaMod(aTexture, theColor.GetAlpha());
 	SDL_SetTextureScaleMode(aTexture, fastStretch ? SDL_SCALEMODE_NEAREST : SDL_SCALEMODE_LINEAR);
@@ -620,7 +797,7 @@ void SDLInterface::StretchBlt(Image *theImage, const Rect &theDestRect, const Re
 	SDL_FRect srcRect = {(float)theSrcRect.mX, (float)theSrcRect.mY, (float)theSrcRect.mWidth,
 						 (float)theSrcRect.mHeight};
 
-	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(theDrawMode));
+	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(aData, theDrawMode));
 	SDL_RenderTextureRotated(mRenderer, aTexture, &srcRect, &destRect, 0.0, nullptr,
 							 mirror ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE);
 	SDL_SetRenderClipRect(mRenderer, nullptr);
@@ -640,7 +817,7 @@ void SDLInterface::BltRotated(Image *theImage, float theX, float theY, const Rec
 	if (!aTexture)
 		return;
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_SetTextureColorMod(aTexture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
 	SDL_SetTextureAlphaMod(aTexture, theColor.GetAlpha());
@@ -658,7 +835,7 @@ void SDLInterface::BltRotated(Image *theImage, float theX, float theY, const Rec
 
 	SDL_FPoint rotationCenter = {theRotCenterX, theRotCenterY};
 
-	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(theDrawMode));
+	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(aData, theDrawMode));
 	SDL_RenderTextureRotated(mRenderer, aTexture, &srcRect, &destRect, theRot, &rotationCenter, SDL_FLIP_NONE);
 	SDL_SetRenderClipRect(mRenderer, nullptr);
 	SDL_SetRenderTarget(mRenderer, nullptr);
@@ -678,7 +855,7 @@ void SDLInterface::BltTransformed(Image *theImage, const Rect *theClipRect, cons
 		return;
 
 	SDL_Texture *aTexture = aData->mTexture;
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_SetTextureColorMod(aTexture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
 	SDL_SetTextureAlphaMod(aTexture, theColor.GetAlpha());
@@ -690,7 +867,7 @@ void SDLInterface::BltTransformed(Image *theImage, const Rect *theClipRect, cons
 		SDL_SetRenderClipRect(mRenderer, &clipRect);
 	}
 
-	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(theDrawMode));
+	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(aData, theDrawMode));
 
 	float halfWidth = theSrcRect.mWidth * 0.5f;
 	float halfHeight = theSrcRect.mHeight * 0.5f;
@@ -732,7 +909,7 @@ void SDLInterface::DrawLine(double theStartX, double theStartY, double theEndX,
 	if (!mRenderer)
 		return;
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_SetRenderDrawBlendMode(mRenderer, ChooseBlendMode(theDrawMode));
 	SDL_SetRenderDrawColor(mRenderer, theColor.mRed, theColor.mGreen, theColor.mBlue, theColor.mAlpha);
@@ -748,7 +925,7 @@ void SDLInterface::FillRect(const Rect &theRect, const Color &theColor, int theD
 	if (!mRenderer)
 		return;
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_FRect theSDLRect = {theRect.mX, theRect.mY, theRect.mWidth, theRect.mHeight};
 
@@ -764,7 +941,7 @@ void SDLInterface::FillRect(const Rect &theRect, const Color &theColor, int theD
 void SDLInterface::DrawTriangle(const TriVertex &p1, const TriVertex &p2, const TriVertex &p3, const Color &theColor,
 								int theDrawMode)
 {
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_FColor aColor = {theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue(), theColor.GetAlpha()};
 
@@ -788,12 +965,12 @@ void SDLInterface::DrawTriangleTex(const TriVertex &p1, const TriVertex &p2, con
 
 	SDLTextureData *aData = (SDLTextureData *)aSrcMemoryImage->mD3DData;
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_Texture *aTexture = aData->mTexture;
 	SDL_SetTextureColorMod(aTexture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
 	SDL_SetTextureAlphaMod(aTexture, theColor.GetAlpha());
-	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(theDrawMode));
+	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(aData, theDrawMode));
 
 	SDL_FColor aColor = {theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue(), theColor.GetAlpha()};
 
@@ -817,12 +994,12 @@ void SDLInterface::DrawTrianglesTex(const TriVertex theVertices[][3], int theNum
 
 	SDLTextureData *aData = (SDLTextureData *)aSrcMemoryImage->mD3DData;
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_Texture *aTexture = aData->mTexture;
 	SDL_SetTextureColorMod(aTexture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
 	SDL_SetTextureAlphaMod(aTexture, theColor.GetAlpha());
-	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(theDrawMode));
+	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(aData, theDrawMode));
 
 	for (int aTriangleNum = 0; aTriangleNum < theNumTriangles; aTriangleNum++)
 	{
@@ -893,8 +1070,8 @@ void SDLInterface::DrawTrianglesTexStrip(const TriVertex theVertices[], int theN
 		colors.push_back(color);
 	}
 
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
-	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(theDrawMode));
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
+	SDL_SetTextureBlendMode(aTexture, ChooseBlendMode(aData, theDrawMode));
 	SDL_SetTextureColorMod(aTexture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
 	SDL_SetTextureAlphaMod(aTexture, theColor.GetAlpha());
 
@@ -935,7 +1112,7 @@ void SDLInterface::FillPoly(const Point theVertices[], int theNumVertices, const
 void SDLInterface::BltTexture(SDL_Texture *theTexture, const SDL_FRect &theSrcRect, const SDL_FRect &theDestRect,
 				const Color &theColor, int theDrawMode)
 {
-	SDL_SetRenderTarget(mRenderer, mScreenTexture);
+	SDL_SetRenderTarget(mRenderer, mRenderTarget);
 
 	SDL_SetTextureColorMod(theTexture, theColor.GetRed(), theColor.GetGreen(), theColor.GetBlue());
 	SDL_SetTextureAlphaMod(theTexture, theColor.GetAlpha());
@@ -21,6 +21,7 @@ class AppBase;
 class SDLImage;
 class Matrix3;
 class TriVertex;
+class SDLInterface;
 
 typedef std::set<SDLImage *> SDLImageSet;
 typedef std::set<MemoryImage *> ImageSet;
@@ -29,8 +30,8 @@ typedef std::list<Matrix3> TransformStack;
 enum SDLImageFlags
 {
 	SDLImageFlag_NearestFiltering = 0x0001, // Uses nearest filtering for the texture
-											// 0x0002
-											// 0x0004
+	SDLImageFlag_UseA4R4G4B4 = 0x0002,		// 16 bit texture (R5G6B5 if the image is opaque)
+	SDLImageFlag_UseA8R8G8B8 = 0x0004,		// Always 32 bit, even with mLowPrecisionTextures
 											// 0x0008
 };
 
@@ -40,17 +41,23 @@ struct SDLTextureData
 {
   public:
 	SDL_Texture *mTexture;
+	SDL_PixelFormat mPixelFormat;
 	int mWidth;
 	int mHeight;
 	int mBitsChangedCount;
+	int mTexMemSize;
+	SDLInterface *mInterface;
 	SDL_Renderer *mRenderer;
+	bool mIsRenderTarget;
 
-	SDLTextureData(SDL_Renderer *theRenderer);
+	SDLTextureData(SDLInterface *theInterface);
 	~SDLTextureData();
 
 	void ReleaseTextures();
 
+	void UploadBits(MemoryImage *theImage);
 	void CreateTextures(MemoryImage *theImage);
+	void CreateRenderTargetTexture(MemoryImage *theImage);
 	void CheckCreateTextures(MemoryImage *theImage);
 
 	int GetMemSize();
@@ -89,10 +96,9 @@ class SDLInterface : public NativeDisplay
 	Image *mCursorImage;
 	SDLImage *mScreenImage;
 
-	int mNextCursorX;
-	int mNextCursorY;
-	int mCursorX;
-	int mCursorY;
+	bool mLowPrecisionTextures; // opaque images get R5G6B5 textures unless flagged a8r8g8b8
+	bool mSupportsA4R4G4B4;
+	bool mSupportsR5G6B5;
 
 	ImageSet mImageSet;
 	SDLImageSet mSDLImageSet;
@@ -102,11 +108,14 @@ class SDLInterface : public NativeDisplay
 	SDL_Renderer *mRenderer;
 	SDL_Window *mWindow;
 	SDL_Texture *mScreenTexture;
+	SDL_Texture *mRenderTarget; // where the draw funcs render to, normally mScreenTexture
+	MemoryImage *mRenderTargetImage; // the image mRenderTarget belongs to, nullptr for the screen
 
   public:
 	void AddSDLImage(SDLImage *theSDLImage);
 	void RemoveSDLImage(SDLImage *theSDLImage);
 	void Remove3DData(MemoryImage *theImage); // for 3d texture cleanup
+	SDL_PixelFormat ChooseTextureFormat(MemoryImage *theImage);
 
   public:
 	SDLInterface(AppBase *theApp);
@@ -123,8 +132,6 @@ class SDLInterface : public NativeDisplay
 	bool Redraw(Rect *theClipRect);
 	void SetVideoOnlyDraw(bool videoOnly);
 
-	void SetCursorPos(int theCursorX, int theCursorY);
-
 	bool SetCursorImage(Image *theImage);
 	bool UpdateWindowIcon(Image *theImage);
 
@@ -140,9 +147,14 @@ class SDLInterface : public NativeDisplay
 	bool PreDraw();
 
 	bool CreateImageTexture(MemoryImage *theImage);
+	bool CreateRenderTarget(MemoryImage *theImage);
+	void SetRenderTarget(MemoryImage *theImage = nullptr, bool clear = false);
+	MemoryImage *GetRenderTarget();
+	bool CanRecoverBits(MemoryImage *theImage);
 	bool RecoverBits(MemoryImage *theImage);
 
 	SDL_BlendMode ChooseBlendMode(int theBlendMode);
+	SDL_BlendMode ChooseBlendMode(SDLTextureData *theData, int theBlendMode);
 
 	// Draw Funcs
 	void Blt(Image *theImage, int theX, int theY, const Rect &theSrcRect, const Color &theColor, int theDrawMode,
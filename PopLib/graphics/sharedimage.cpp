@@ -1,13 +1,166 @@
 #include "sharedimage.hpp"
 #include "sdlimage.hpp"
 #include "appbase.hpp"
+#include "misc/autocrit.hpp"
+#include "debug/debug.hpp"
+
+#include <ctype.h>
 
 using namespace PopLib;
 
+size_t StringHashNoCase::operator()(const std::string &theString) const
+{
+	size_t aHash = 2166136261U;
+	for (size_t i = 0; i < theString.length(); i++)
+		aHash = (aHash ^ (size_t)toupper((uchar)theString[i])) * 16777619U;
+	return aHash;
+}
+
+bool StringEqualNoCase::operator()(const std::string &s1, const std::string &s2) const
+{
+	if (s1.length() != s2.length())
+		return false;
+
+	for (size_t i = 0; i < s1.length(); i++)
+	{
+		if (toupper((uchar)s1[i]) != toupper((uchar)s2[i]))
+			return false;
+	}
+	return true;
+}
+
 SharedImage::SharedImage()
 {
 	mImage = nullptr;
 	mRefCount = 0;
+	mKey = SharedImageKey(nullptr, nullptr);
+	mShard = nullptr;
+	mNextUnused = nullptr;
+	mUnused = false;
+}
+
+static const std::string *InternName(SharedImageShard::InternMap &theSet, const std::string &theName)
+{
+	SharedImageShard::InternMap::iterator anItr = theSet.find(theName);
+	if (anItr == theSet.end())
+		anItr = theSet.emplace(StringToUpper(theName), 0).first;
+	return &anItr->first;
+}
+
+static void ReleaseName(SharedImageShard::InternMap &theSet, const std::string *theName)
+{
+	SharedImageShard::InternMap::iterator anItr = theSet.find(*theName);
+	if ((anItr != theSet.end()) && (--anItr->second <= 0))
+		theSet.erase(anItr);
+}
+
+SharedImageRef SharedImageMap::Find(const std::string &theFileName, const std::string &theVariant, bool *isNew)
+{
+	SharedImageShard &aShard = mShards[StringHashNoCase()(theFileName) % NUM_SHARDS];
+
+	AutoCrit anAutoCrit(aShard.mCritSect);
+
+	SharedImageKey aKey(InternName(aShard.mNames, theFileName), InternName(aShard.mNames, theVariant));
+	std::pair<SharedImageShard::ImageMap::iterator, bool> aResultPair = aShard.mImages.try_emplace(aKey);
+
+	SharedImage *aSharedImage = &aResultPair.first->second;
+	if (aResultPair.second)
+	{
+		aSharedImage->mKey = aKey;
+		aSharedImage->mShard = &aShard;
+		aShard.mNames.find(*aKey.first)->second++;
+		aShard.mNames.find(*aKey.second)->second++;
+	}
+
+	if (isNew != nullptr)
+		*isNew = aResultPair.second;
+
+	// Has to be taken under the lock, or Cleanup could delete it out from under us
+	return SharedImageRef(aSharedImage);
+}
+
+void SharedImageMap::Release(SharedImage *theSharedImage)
+{
+	SharedImageShard *aShard = theSharedImage->mShard;
+
+	AutoCrit anAutoCrit(aShard->mCritSect);
+	if ((--theSharedImage->mRefCount == 0) && (!theSharedImage->mUnused))
+	{
+		theSharedImage->mUnused = true;
+		theSharedImage->mNextUnused = aShard->mUnusedHead;
+		aShard->mUnusedHead = theSharedImage;
+	}
+}
+
+void SharedImageMap::Cleanup()
+{
+	std::vector<SDLImage *> aDeadImages;
+
+	for (int i = 0; i < NUM_SHARDS; i++)
+	{
+		SharedImageShard &aShard = mShards[i];
+
+		AutoCrit anAutoCrit(aShard.mCritSect);
+
+		SharedImage *aSharedImage = aShard.mUnusedHead;
+		aShard.mUnusedHead = nullptr;
+
+		while (aSharedImage != nullptr)
+		{
+			SharedImage *aNext = aSharedImage->mNextUnused;
+			aSharedImage->mNextUnused = nullptr;
+			aSharedImage->mUnused = false;
+
+			// It may have been picked up again since it was queued
+			if (aSharedImage->mRefCount == 0)
+			{
+				SharedImageKey aKey = aSharedImage->mKey;
+				aDeadImages.push_back(aSharedImage->mImage);
+				aShard.mImages.erase(aKey);
+				ReleaseName(aShard.mNames, aKey.first);
+				ReleaseName(aShard.mNames, aKey.second);
+			}
+
+			aSharedImage = aNext;
+		}
+	}
+
+	// Image destruction takes the display's lock, so keep it outside of ours
+	for (int i = 0; i < (int)aDeadImages.size(); i++)
+		delete aDeadImages[i];
+}
+
+void SharedImageMap::Clear()
+{
+	for (int i = 0; i < NUM_SHARDS; i++)
+	{
+		SharedImageShard &aShard = mShards[i];
+
+		AutoCrit anAutoCrit(aShard.mCritSect);
+
+		SharedImageShard::ImageMap::iterator anItr = aShard.mImages.begin();
+		while (anItr != aShard.mImages.end())
+		{
+			DBG_ASSERTE(anItr->second.mRefCount == 0);
+			delete anItr->second.mImage;
+			++anItr;
+		}
+
+		aShard.mImages.clear();
+		aShard.mNames.clear();
+		aShard.mUnusedHead = nullptr;
+	}
+}
+
+int SharedImageMap::GetSize()
+{
+	int aSize = 0;
+	for (int i = 0; i < NUM_SHARDS; i++)
+	{
+		AutoCrit anAutoCrit(mShards[i].mCritSect);
+		aSize += (int)mShards[i].mImages.size();
+	}
+	return aSize;
 }
 
 SharedImageRef::SharedImageRef(const SharedImageRef &theSharedImageRef)
@@ -48,8 +201,8 @@ void SharedImageRef::Release()
 	mUnsharedImage = nullptr;
 	if (mSharedImage != nullptr)
 	{
-		if (--mSharedImage->mRefCount == 0)
-			gAppBase->mCleanupSharedImages = true;
+		gAppBase->mSharedImageMap.Release(mSharedImage);
+		gAppBase->mCleanupSharedImages = true;
 	}
 	mSharedImage = nullptr;
 }
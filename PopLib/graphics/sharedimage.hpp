@@ -5,6 +5,10 @@
 #endif
 
 #include "common.hpp"
+#include "misc/critsect.hpp"
+
+#include <atomic>
+#include <unordered_map>
 
 namespace PopLib
 {
@@ -12,17 +16,82 @@ namespace PopLib
 class Image;
 class SDLImage;
 class MemoryImage;
+class SharedImageRef;
+struct SharedImageShard;
+
+struct StringHashNoCase
+{
+	size_t operator()(const std::string &theString) const;
+};
+
+struct StringEqualNoCase
+{
+	bool operator()(const std::string &s1, const std::string &s2) const;
+};
+
+// Interned, upper-cased file name and variant
+typedef std::pair<const std::string *, const std::string *> SharedImageKey;
 
 class SharedImage
 {
   public:
 	SDLImage *mImage;
-	int mRefCount;
+	std::atomic<int> mRefCount;
+
+	SharedImageKey mKey;
+	SharedImageShard *mShard;
+	SharedImage *mNextUnused; // next in mShard's list of images that have dropped to 0 refs
+	bool mUnused;
 
 	SharedImage();
 };
 
-typedef std::map<std::pair<std::string, std::string>, SharedImage> SharedImageMap;
+struct SharedImageShard
+{
+	struct KeyHash
+	{
+		size_t operator()(const SharedImageKey &theKey) const
+		{
+			return std::hash<const void *>()(theKey.first) * 31 + std::hash<const void *>()(theKey.second);
+		}
+	};
+
+	// Name -> how many images in the shard have it in their key, so it can go when the last one does
+	typedef std::unordered_map<std::string, int, StringHashNoCase, StringEqualNoCase> InternMap;
+	typedef std::unordered_map<SharedImageKey, SharedImage, KeyHash> ImageMap;
+
+	CritSect mCritSect;
+	InternMap mNames;
+	ImageMap mImages;
+	SharedImage *mUnusedHead;
+
+	SharedImageShard()
+	{
+		mUnusedHead = nullptr;
+	}
+};
+
+// Shared images are spread over a number of shards by file name, each with its own lock, so the
+// loading thread and the main thread rarely wait on each other.  Lookups hash the name without
+// case folding it into a new string, and images whose ref count drops to 0 are queued so cleanup
+// only has to look at those.
+class SharedImageMap
+{
+  public:
+	enum
+	{
+		NUM_SHARDS = 16
+	};
+
+	SharedImageShard mShards[NUM_SHARDS];
+
+  public:
+	SharedImageRef Find(const std::string &theFileName, const std::string &theVariant, bool *isNew);
+	void Release(SharedImage *theSharedImage);
+	void Cleanup();
+	void Clear();
+	int GetSize();
+};
 
 class SharedImageRef
 {
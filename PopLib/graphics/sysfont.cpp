@@ -167,10 +167,11 @@ ImageFont *SysFont::CreateImageFont()
 	for (i=0; i<256; i++)
 	{
 		char aChar = i;
+		int aGlyph = aFontLayer->mGlyphs.AddGlyph((uchar) aChar);
 
-		aFontLayer->mCharData[(uchar) aChar].mImageRect =
-	Rect(aChar*anImageCharWidth,0,anImageCharWidth,anImage->mHeight); aFontLayer->mCharData[(uchar) aChar].mWidth =
-	CharWidth(aChar); aFontLayer->mCharData[(uchar) aChar].mOffset = Point(-anImageXOff,-anImageYOff);
+		aFontLayer->mGlyphs.mImageRects[aGlyph] = Rect(aChar*anImageCharWidth,0,anImageCharWidth,anImage->mHeight);
+		aFontLayer->mGlyphs.mWidths[aGlyph] = CharWidth(aChar);
+		aFontLayer->mGlyphs.mOffsets[aGlyph] = Point(-anImageXOff,-anImageYOff);
 	}
 
 	aFont->GenerateActiveFontLayers();
@@ -189,6 +190,29 @@ int SysFont::StringWidth(const PopString &theString)
 	return w;
 }
 
+// SDL_ttf always reads strings as UTF-8
+uint32_t SysFont::GetNextChar(const PopString &theString, ulong &thePos)
+{
+	const char *aPos = theString.c_str() + thePos;
+	size_t aLength = theString.length() - thePos;
+	uint32_t aChar = SDL_StepUTF8(&aPos, &aLength);
+	thePos = (ulong)(aPos - theString.c_str());
+	return aChar;
+}
+
+// Glyph advance plus kerning, so summing these over a string lines up with StringWidth
+int SysFont::CharWidthKern(uint32_t theChar, uint32_t thePrevChar)
+{
+	int anAdvance = 0;
+	TTF_GetGlyphMetrics(mTTFFont, theChar, nullptr, nullptr, nullptr, nullptr, &anAdvance);
+
+	int aKerning = 0;
+	if (thePrevChar != 0)
+		TTF_GetGlyphKerning(mTTFFont, thePrevChar, theChar, &aKerning);
+
+	return anAdvance + aKerning;
+}
+
 void SysFont::DrawString(Graphics *g, int theX, int theY, const PopString &theString, const Color &theColor,
 						 const Rect &theClipRect)
 {
@@ -39,6 +39,8 @@ class SysFont : public Font
 
 	ImageFont *CreateImageFont();
 	virtual int StringWidth(const PopString &theString);
+	virtual uint32_t GetNextChar(const PopString &theString, ulong &thePos);
+	virtual int CharWidthKern(uint32_t theChar, uint32_t thePrevChar);
 	virtual void DrawString(Graphics *g, int theX, int theY, const PopString &theString, const Color &theColor,
 							const Rect &theClipRect);
 
@@ -7,6 +7,17 @@
 #include <cmath>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define IMAGELIB_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGELIB_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define IMAGELIB_NEON
+#endif
+
 using namespace ImageLib;
 
 Image::Image()
@@ -19,7 +30,7 @@ Image::Image()
 
 Image::~Image()
 {
-	delete mBits;
+	delete[] mBits;
 }
 
 int Image::GetWidth()
@@ -37,6 +48,119 @@ ulong *Image::GetBits()
 	return mBits;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Pixel kernels
+
+void ImageLib::ConvertRGBAToARGB(const uchar *theSrc, ulong *theDest, int theCount)
+{
+	int i = 0;
+
+	// Read as little endian words the pixels are 0xAABBGGRR, so it's just R and B trading places
+#if defined(IMAGELIB_AVX2)
+	const __m256i aMaskAG = _mm256_set1_epi32((int)0xFF00FF00);
+	const __m256i aMaskLow = _mm256_set1_epi32(0x000000FF);
+	for (; i + 8 <= theCount; i += 8)
+	{
+		__m256i aPixels = _mm256_loadu_si256((const __m256i *)(theSrc + i * 4));
+		__m256i aRed = _mm256_slli_epi32(_mm256_and_si256(aPixels, aMaskLow), 16);
+		__m256i aBlue = _mm256_and_si256(_mm256_srli_epi32(aPixels, 16), aMaskLow);
+		aPixels = _mm256_or_si256(_mm256_and_si256(aPixels, aMaskAG), _mm256_or_si256(aRed, aBlue));
+		_mm256_storeu_si256((__m256i *)(theDest + i), aPixels);
+	}
+#elif defined(IMAGELIB_SSE2)
+	const __m128i aMaskAG = _mm_set1_epi32((int)0xFF00FF00);
+	const __m128i aMaskLow = _mm_set1_epi32(0x000000FF);
+	for (; i + 4 <= theCount; i += 4)
+	{
+		__m128i aPixels = _mm_loadu_si128((const __m128i *)(theSrc + i * 4));
+		__m128i aRed = _mm_slli_epi32(_mm_and_si128(aPixels, aMaskLow), 16);
+		__m128i aBlue = _mm_and_si128(_mm_srli_epi32(aPixels, 16), aMaskLow);
+		aPixels = _mm_or_si128(_mm_and_si128(aPixels, aMaskAG), _mm_or_si128(aRed, aBlue));
+		_mm_storeu_si128((__m128i *)(theDest + i), aPixels);
+	}
+#elif defined(IMAGELIB_NEON)
+	for (; i + 16 <= theCount; i += 16)
+	{
+		uint8x16x4_t aPixels = vld4q_u8(theSrc + i * 4);
+		uint8x16_t aRed = aPixels.val[0];
+		aPixels.val[0] = aPixels.val[2];
+		aPixels.val[2] = aRed;
+		vst4q_u8((uint8_t *)(theDest + i), aPixels);
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		const uchar *aPixel = theSrc + i * 4;
+		theDest[i] = (aPixel[3] << 24) | (aPixel[0] << 16) | (aPixel[1] << 8) | aPixel[2];
+	}
+}
+
+void ImageLib::ComposeAlpha(ulong *theBits, const ulong *theAlphaBits, int theCount)
+{
+	int i = 0;
+
+#if defined(IMAGELIB_AVX2)
+	const __m256i aMaskRGB = _mm256_set1_epi32(0x00FFFFFF);
+	for (; i + 8 <= theCount; i += 8)
+	{
+		__m256i aPixels = _mm256_loadu_si256((const __m256i *)(theBits + i));
+		__m256i anAlpha = _mm256_slli_epi32(_mm256_loadu_si256((const __m256i *)(theAlphaBits + i)), 24);
+		_mm256_storeu_si256((__m256i *)(theBits + i), _mm256_or_si256(_mm256_and_si256(aPixels, aMaskRGB), anAlpha));
+	}
+#elif defined(IMAGELIB_SSE2)
+	const __m128i aMaskRGB = _mm_set1_epi32(0x00FFFFFF);
+	for (; i + 4 <= theCount; i += 4)
+	{
+		__m128i aPixels = _mm_loadu_si128((const __m128i *)(theBits + i));
+		__m128i anAlpha = _mm_slli_epi32(_mm_loadu_si128((const __m128i *)(theAlphaBits + i)), 24);
+		_mm_storeu_si128((__m128i *)(theBits + i), _mm_or_si128(_mm_and_si128(aPixels, aMaskRGB), anAlpha));
+	}
+#elif defined(IMAGELIB_NEON)
+	const uint32x4_t aMaskRGB = vdupq_n_u32(0x00FFFFFF);
+	for (; i + 4 <= theCount; i += 4)
+	{
+		uint32x4_t aPixels = vld1q_u32(theBits + i);
+		uint32x4_t anAlpha = vshlq_n_u32(vld1q_u32(theAlphaBits + i), 24);
+		vst1q_u32(theBits + i, vorrq_u32(vandq_u32(aPixels, aMaskRGB), anAlpha));
+	}
+#endif
+
+	for (; i < theCount; i++)
+		theBits[i] = (theBits[i] & 0x00FFFFFF) | ((theAlphaBits[i] & 0xFF) << 24);
+}
+
+void ImageLib::AlphaToColor(ulong *theBits, ulong theColor, int theCount)
+{
+	int i = 0;
+
+#if defined(IMAGELIB_AVX2)
+	const __m256i aColor = _mm256_set1_epi32((int)theColor);
+	for (; i + 8 <= theCount; i += 8)
+	{
+		__m256i anAlpha = _mm256_slli_epi32(_mm256_loadu_si256((const __m256i *)(theBits + i)), 24);
+		_mm256_storeu_si256((__m256i *)(theBits + i), _mm256_or_si256(aColor, anAlpha));
+	}
+#elif defined(IMAGELIB_SSE2)
+	const __m128i aColor = _mm_set1_epi32((int)theColor);
+	for (; i + 4 <= theCount; i += 4)
+	{
+		__m128i anAlpha = _mm_slli_epi32(_mm_loadu_si128((const __m128i *)(theBits + i)), 24);
+		_mm_storeu_si128((__m128i *)(theBits + i), _mm_or_si128(aColor, anAlpha));
+	}
+#elif defined(IMAGELIB_NEON)
+	const uint32x4_t aColor = vdupq_n_u32(theColor);
+	for (; i + 4 <= theCount; i += 4)
+	{
+		uint32x4_t anAlpha = vshlq_n_u32(vld1q_u32(theBits + i), 24);
+		vst1q_u32(theBits + i, vorrq_u32(aColor, anAlpha));
+	}
+#endif
+
+	for (; i < theCount; i++)
+		theBits[i] = theColor | ((theBits[i] & 0xFF) << 24);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // PNG Pak Support
 
@@ -47,28 +171,29 @@ Image *GetImageSTB(const std::string &theFileName)
 	if ((fp = p_fopen(theFileName.c_str(), "rb")) == nullptr)
 		return nullptr;
 
-	p_fseek(fp, 0, SEEK_END);
-	size_t fileSize = p_ftell(fp);
-	p_fseek(fp, 0, SEEK_SET);
-	std::vector<uint8_t> data(fileSize);
-	p_fread(data.data(), 1, fileSize, fp);
-	p_fclose(fp);
-
 	int width, height, num_channels;
-	unsigned char *stb_image = stbi_load_from_memory(data.data(), fileSize, &width, &height, &num_channels, NULL);
+	unsigned char *stb_image;
 
-	ulong *aBits = new ulong[width * height];
-	for (int i = 0; i < width * height; ++i)
+	// Always ask for 4 channels so gray and gray+alpha images expand properly too
+	if (fp->mRecord != nullptr)
 	{
-		unsigned char *pixel = &stb_image[i * num_channels];
+		// The pak is already sitting in memory, so decode it right from there
+		PakRecord *aRecord = fp->mRecord;
+		stb_image = stbi_load_from_memory(aRecord->mCollection->data() + aRecord->mStartPos, (int)aRecord->mSize,
+										  &width, &height, &num_channels, 4);
+	}
+	else
+		stb_image = stbi_load_from_file(fp->mFP, &width, &height, &num_channels, 4);
 
-		unsigned char r = pixel[0];
-		unsigned char g = pixel[1];
-		unsigned char b = pixel[2];
-		unsigned char a = (num_channels == 4) ? pixel[3] : 0xFF;
+	p_fclose(fp);
 
-		aBits[i] = (a << 24) | (r << 16) | (g << 8) | b;
-	}
+	if (stb_image == nullptr)
+		return nullptr;
+
+	ulong *aBits = new ulong[width * height + 1];
+	ConvertRGBAToARGB(stb_image, aBits, width * height);
+
+	stbi_image_free(stb_image);
 
 	Image *anImage = new Image();
 	anImage->mWidth = width;
@@ -76,8 +201,6 @@ Image *GetImageSTB(const std::string &theFileName)
 	anImage->mBits = aBits;
 	anImage->mNumChannels = num_channels;
 
-	delete stb_image;
-
 	return anImage;
 }
 
@@ -406,7 +529,7 @@ Image *GetGIFImage(const std::string &theFileName)
 		pass = 0;
 		top_stack = pixel_stack;
 
-		ulong *aBits = new ulong[width * height];
+		ulong *aBits = new ulong[width * height + 1];
 
 		unsigned char *c = nullptr;
 
@@ -661,9 +784,58 @@ bool ImageLib::WriteImageRaw(const std::string &theFileName, const std::string &
 	return true;
 }
 
-int ImageLib::gAlphaComposeColor = 0xFFFFFF;
+thread_local int ImageLib::gAlphaComposeColor = 0xFFFFFF;
 bool ImageLib::gAutoLoadAlpha = true;
 
+// Checks the file index first so missing extensions and alpha images don't each cost a failed open
+static bool FindImageFile(const std::string &theFileName, std::string &theRealName)
+{
+	if (gPakInterface == nullptr)
+	{
+		theRealName = theFileName;
+		return true;
+	}
+
+	return gPakInterface->FindFile(theFileName, &theRealName);
+}
+
+// Every file GetImage might read for theFilename, whether it exists or not
+void ImageLib::GetImageFileNames(const std::string &theFilename, bool lookForAlphaImage,
+								 std::vector<std::string> &theFileNames)
+{
+	if (!gAutoLoadAlpha)
+		lookForAlphaImage = false;
+
+	int aLastDotPos = theFilename.rfind('.');
+	int aLastSlashPos = std::max((int)theFilename.rfind('\\'), (int)theFilename.rfind('/'));
+
+	std::string anExt;
+	std::string aFilename;
+
+	if (aLastDotPos > aLastSlashPos)
+	{
+		anExt = theFilename.substr(aLastDotPos, theFilename.length() - aLastDotPos);
+		aFilename = theFilename.substr(0, aLastDotPos);
+	}
+	else
+		aFilename = theFilename;
+
+	static const char *anExts[] = {".tga", ".jpg", ".png", ".gif"};
+	for (int i = 0; i < 4; i++)
+	{
+		if ((anExt.length() == 0) || (stricmp(anExt.c_str(), anExts[i]) == 0))
+			theFileNames.push_back(aFilename + anExts[i]);
+	}
+
+	if (lookForAlphaImage)
+	{
+		GetImageFileNames(theFilename.substr(0, aLastSlashPos + 1) + "_" +
+							  theFilename.substr(aLastSlashPos + 1, theFilename.length() - aLastSlashPos - 1),
+						  false, theFileNames);
+		GetImageFileNames(theFilename + "_", false, theFileNames);
+	}
+}
+
 Image *ImageLib::GetImage(const std::string &theFilename, bool lookForAlphaImage)
 {
 	if (!gAutoLoadAlpha)
@@ -684,18 +856,23 @@ Image *ImageLib::GetImage(const std::string &theFilename, bool lookForAlphaImage
 		aFilename = theFilename;
 
 	Image *anImage = nullptr;
+	std::string aRealName;
 
-	if ((anImage == nullptr) && ((stricmp(anExt.c_str(), ".tga") == 0) || (anExt.length() == 0)))
-		anImage = GetImageSTB(aFilename + ".tga");
+	if ((anImage == nullptr) && ((stricmp(anExt.c_str(), ".tga") == 0) || (anExt.length() == 0)) &&
+		FindImageFile(aFilename + ".tga", aRealName))
+		anImage = GetImageSTB(aRealName);
 
-	if ((anImage == nullptr) && ((stricmp(anExt.c_str(), ".jpg") == 0) || (anExt.length() == 0)))
-		anImage = GetImageSTB(aFilename + ".jpg");
+	if ((anImage == nullptr) && ((stricmp(anExt.c_str(), ".jpg") == 0) || (anExt.length() == 0)) &&
+		FindImageFile(aFilename + ".jpg", aRealName))
+		anImage = GetImageSTB(aRealName);
 
-	if ((anImage == nullptr) && ((stricmp(anExt.c_str(), ".png") == 0) || (anExt.length() == 0)))
-		anImage = GetImageSTB(aFilename + ".png");
+	if ((anImage == nullptr) && ((stricmp(anExt.c_str(), ".png") == 0) || (anExt.length() == 0)) &&
+		FindImageFile(aFilename + ".png", aRealName))
+		anImage = GetImageSTB(aRealName);
 
-	if ((anImage == nullptr) && ((stricmp(anExt.c_str(), ".gif") == 0) || (anExt.length() == 0)))
-		anImage = GetGIFImage(aFilename + ".gif");
+	if ((anImage == nullptr) && ((stricmp(anExt.c_str(), ".gif") == 0) || (anExt.length() == 0)) &&
+		FindImageFile(aFilename + ".gif", aRealName))
+		anImage = GetGIFImage(aRealName);
 
 	// Check for alpha images
 	Image *anAlphaImage = nullptr;
@@ -717,47 +894,14 @@ Image *ImageLib::GetImage(const std::string &theFilename, bool lookForAlphaImage
 		if (anImage != nullptr)
 		{
 			if ((anImage->mWidth == anAlphaImage->mWidth) && (anImage->mHeight == anAlphaImage->mHeight))
-			{
-				ulong *aBits1 = anImage->mBits;
-				ulong *aBits2 = anAlphaImage->mBits;
-				int aSize = anImage->mWidth * anImage->mHeight;
-
-				for (int i = 0; i < aSize; i++)
-				{
-					*aBits1 = (*aBits1 & 0x00FFFFFF) | ((*aBits2 & 0xFF) << 24);
-					++aBits1;
-					++aBits2;
-				}
-			}
+				ComposeAlpha(anImage->mBits, anAlphaImage->mBits, anImage->mWidth * anImage->mHeight);
 
 			delete anAlphaImage;
 		}
-		else if (gAlphaComposeColor == 0xFFFFFF)
-		{
-			anImage = anAlphaImage;
-
-			ulong *aBits1 = anImage->mBits;
-
-			int aSize = anImage->mWidth * anImage->mHeight;
-			for (int i = 0; i < aSize; i++)
-			{
-				*aBits1 = (0x00FFFFFF) | ((*aBits1 & 0xFF) << 24);
-				++aBits1;
-			}
-		}
 		else
 		{
-			const int aColor = gAlphaComposeColor;
 			anImage = anAlphaImage;
-
-			ulong *aBits1 = anImage->mBits;
-
-			int aSize = anImage->mWidth * anImage->mHeight;
-			for (int i = 0; i < aSize; i++)
-			{
-				*aBits1 = aColor | ((*aBits1 & 0xFF) << 24);
-				++aBits1;
-			}
+			AlphaToColor(anImage->mBits, gAlphaComposeColor, anImage->mWidth * anImage->mHeight);
 		}
 	}
 
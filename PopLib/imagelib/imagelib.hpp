@@ -6,6 +6,7 @@
 
 #include "common.hpp"
 #include <string>
+#include <vector>
 
 namespace ImageLib
 {
@@ -15,7 +16,7 @@ class Image
   public:
 	int mWidth;
 	int mHeight;
-	ulong *mBits;
+	ulong *mBits; // new[]'d with one spare ulong past the end, so MemoryImage::TakeBits can adopt it
 	int mNumChannels;
 
   public:
@@ -30,10 +31,16 @@ class Image
 bool WriteImage(const std::string &theFileName, const std::string &theExtension, Image *theImage);
 bool WriteImageRaw(const std::string &theFileName, const std::string &theExtension, unsigned char *theData,
 				   int theWidth, int theHeight);
-extern int gAlphaComposeColor;
+extern thread_local int gAlphaComposeColor; // per thread so images can be decoded on several at once
 extern bool gAutoLoadAlpha;
 
+// Pixel kernels, vectorized where the target allows it
+void ConvertRGBAToARGB(const uchar *theSrc, ulong *theDest, int theCount);
+void ComposeAlpha(ulong *theBits, const ulong *theAlphaBits, int theCount);
+void AlphaToColor(ulong *theBits, ulong theColor, int theCount);
+
 Image *GetImage(const std::string &theFileName, bool lookForAlphaImage = true);
+void GetImageFileNames(const std::string &theFileName, bool lookForAlphaImage, std::vector<std::string> &theFileNames);
 
 } // namespace ImageLib
 
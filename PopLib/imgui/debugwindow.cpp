@@ -1,5 +1,9 @@
 #include "imguimanager.hpp"
 #include "appbase.hpp"
+#include "misc/jobsystem.hpp"
+#include "resources/resourcemanager.hpp"
+#include "audio/openalsoundmanager.hpp"
+#include "audio/miniaudiosoundmanager.hpp"
 
 using namespace PopLib;
 
@@ -49,6 +53,52 @@ static struct RegisterDebugWindow
 			}
 
 			ImGui::Text("FPS: %.2f", fps);
+			ImGui::Text("Input latency: %.2f ms", gAppBase->mCursorInputLatencyNS / 1000000.0);
+
+			// job workers, refreshed once a second by JobSystem::UpdateStats
+			JobSystem *aJobSystem = gAppBase->mJobSystem;
+			if ((aJobSystem != nullptr) && ImGui::CollapsingHeader("Job Workers"))
+			{
+				for (int i = 0; i < aJobSystem->GetNumWorkers(); i++)
+				{
+					const JobWorker *aWorker = aJobSystem->GetWorker(i);
+					char anOverlay[64];
+					snprintf(anOverlay, sizeof(anOverlay), "%d: %.0f%%, %d jobs/s", i, aWorker->mUtilization * 100.0f,
+							 aWorker->mJobsPerSecond);
+					ImGui::ProgressBar(aWorker->mUtilization, ImVec2(-1, 0), anOverlay);
+				}
+			}
+
+			ResourceManager *aResourceManager = gAppBase->mResourceManager;
+			if ((aResourceManager != nullptr) && ImGui::CollapsingHeader("Resource Prefetch"))
+			{
+				std::string aStats;
+				aResourceManager->DumpPrefetchStats(aStats);
+				ImGui::TextUnformatted(aStats.c_str());
+			}
+
+			OpenALSoundManager *aSoundManager = dynamic_cast<OpenALSoundManager *>(gAppBase->mSoundManager);
+			if ((aSoundManager != nullptr) && (aSoundManager->mCompressSounds) &&
+				ImGui::CollapsingHeader("Sound Storage"))
+			{
+				std::string aStats;
+				aSoundManager->DumpStorageStats(aStats);
+				ImGui::TextUnformatted(aStats.c_str());
+			}
+
+			MiniaudioSoundManager *aMiniaudioSoundManager =
+				dynamic_cast<MiniaudioSoundManager *>(gAppBase->mSoundManager);
+			if ((aMiniaudioSoundManager != nullptr) && ImGui::CollapsingHeader("Audio Mixer"))
+			{
+				MixerStats aStats = aMiniaudioSoundManager->mMixer->GetStats();
+				ImGui::Text("Voices: %d", aStats.mActiveVoices);
+				ImGui::Text("Sample rate: %d", aMiniaudioSoundManager->mMixer->GetSampleRate());
+				ImGui::Text("Dropped commands: %d", aStats.mDroppedCommands);
+
+				char anOverlay[64];
+				snprintf(anOverlay, sizeof(anOverlay), "%.1f%% of real time", aStats.mLoad * 100.0);
+				ImGui::ProgressBar((float)aStats.mLoad, ImVec2(-1, 0), anOverlay);
+			}
 
 			// quit button
 			const float padding = 10.0f;
@@ -0,0 +1,306 @@
+#ifndef __ASYNC_HPP__
+#define __ASYNC_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+#include <atomic>
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+namespace PopLib
+{
+
+// Shared between an Async handle and whatever resolves it.  Everything but mCancelled is only
+// touched on the main thread, background work should just check mCancelled and skip what it can.
+class AsyncStateBase : public std::enable_shared_from_this<AsyncStateBase>
+{
+  public:
+	struct Continuation
+	{
+		std::coroutine_handle<> mHandle;
+		AsyncStateBase *mOwner; // state of the awaiting coroutine if it's an Async one, else NULL
+	};
+
+	bool mDone;
+	std::atomic<bool> mCancelled;
+	std::vector<Continuation> mContinuations;
+	std::vector<std::function<void()>> mCallbacks;
+	std::shared_ptr<AsyncStateBase> mAwaiting;				 // what our coroutine is suspended on
+	std::vector<std::shared_ptr<AsyncStateBase>> mChildren; // cancelled along with us, see WhenAll
+
+  public:
+	AsyncStateBase() : mDone(false), mCancelled(false)
+	{
+	}
+
+	virtual ~AsyncStateBase()
+	{
+	}
+
+	void Resolve()
+	{
+		if (mDone)
+			return;
+
+		std::shared_ptr<AsyncStateBase> aSelf = shared_from_this();
+		mDone = true;
+		mAwaiting.reset();
+		mChildren.clear();
+
+		std::vector<std::function<void()>> aCallbacks;
+		aCallbacks.swap(mCallbacks);
+		std::vector<Continuation> aContinuations;
+		aContinuations.swap(mContinuations);
+
+		for (std::function<void()> &aCallback : aCallbacks)
+			aCallback();
+
+		// A cancelled coroutine is never resumed again, its frame just gets thrown away here
+		for (Continuation &aContinuation : aContinuations)
+		{
+			if ((aContinuation.mOwner != NULL) && aContinuation.mOwner->mCancelled)
+				aContinuation.mHandle.destroy();
+			else
+			{
+				if (aContinuation.mOwner != NULL)
+					aContinuation.mOwner->mAwaiting.reset();
+				aContinuation.mHandle.resume();
+			}
+		}
+	}
+
+	void Cancel()
+	{
+		if (mDone)
+			return;
+
+		std::shared_ptr<AsyncStateBase> aSelf = shared_from_this();
+		mCancelled = true;
+
+		std::shared_ptr<AsyncStateBase> anAwaiting;
+		anAwaiting.swap(mAwaiting);
+		std::vector<std::shared_ptr<AsyncStateBase>> aChildren;
+		aChildren.swap(mChildren);
+
+		if (anAwaiting != NULL)
+			anAwaiting->Cancel();
+		for (std::shared_ptr<AsyncStateBase> &aChild : aChildren)
+			aChild->Cancel();
+
+		Resolve();
+	}
+
+	void AddCallback(const std::function<void()> &theCallback)
+	{
+		if (mDone)
+			theCallback();
+		else
+			mCallbacks.push_back(theCallback);
+	}
+};
+
+template <typename T> class AsyncState : public AsyncStateBase
+{
+  public:
+	T mResult{};
+
+  public:
+	void SetResult(T theResult)
+	{
+		if (mDone)
+			return;
+
+		mResult = std::move(theResult);
+		Resolve();
+	}
+};
+
+template <> class AsyncState<void> : public AsyncStateBase
+{
+  public:
+	void SetResult()
+	{
+		Resolve();
+	}
+};
+
+template <typename T> class Async;
+
+class AsyncPromiseBase
+{
+  public:
+	AsyncStateBase *mAsyncState;
+
+  public:
+	std::suspend_never initial_suspend() noexcept
+	{
+		return {};
+	}
+	std::suspend_never final_suspend() noexcept
+	{
+		return {};
+	}
+	void unhandled_exception()
+	{
+		throw;
+	}
+};
+
+template <typename T> class AsyncPromise : public AsyncPromiseBase
+{
+  public:
+	std::shared_ptr<AsyncState<T>> mState;
+
+  public:
+	AsyncPromise() : mState(std::make_shared<AsyncState<T>>())
+	{
+		mAsyncState = mState.get();
+	}
+
+	Async<T> get_return_object()
+	{
+		return Async<T>(mState);
+	}
+
+	void return_value(T theValue)
+	{
+		mState->SetResult(std::move(theValue));
+	}
+};
+
+template <> class AsyncPromise<void> : public AsyncPromiseBase
+{
+  public:
+	std::shared_ptr<AsyncState<void>> mState;
+
+  public:
+	AsyncPromise() : mState(std::make_shared<AsyncState<void>>())
+	{
+		mAsyncState = mState.get();
+	}
+
+	Async<void> get_return_object();
+
+	void return_void()
+	{
+		mState->SetResult();
+	}
+};
+
+// Result of something that finishes later on the main thread, either an asset load or a coroutine
+// returning Async<T>.  co_await it from another Async coroutine, or poll IsDone / use Then from
+// ordinary code.  Coroutines start running as soon as they're called and don't need to be awaited.
+// Cancel resolves it straight away with an empty result, and a coroutine that gets cancelled is
+// destroyed the next time it would have been resumed.
+template <typename T> class Async
+{
+  public:
+	typedef AsyncPromise<T> promise_type;
+
+	std::shared_ptr<AsyncState<T>> mState;
+
+  public:
+	Async()
+	{
+	}
+
+	Async(const std::shared_ptr<AsyncState<T>> &theState) : mState(theState)
+	{
+	}
+
+	bool IsDone() const
+	{
+		return mState->mDone;
+	}
+
+	bool IsCancelled() const
+	{
+		return mState->mCancelled;
+	}
+
+	void Cancel()
+	{
+		mState->Cancel();
+	}
+
+	void Then(const std::function<void()> &theCallback)
+	{
+		mState->AddCallback(theCallback);
+	}
+
+	template <typename U = T> const U &GetResult() const
+	{
+		return mState->mResult;
+	}
+
+	bool await_ready() const
+	{
+		return mState->mDone;
+	}
+
+	template <typename P> void await_suspend(std::coroutine_handle<P> theHandle)
+	{
+		AsyncStateBase *anOwner = NULL;
+		if constexpr (std::is_base_of_v<AsyncPromiseBase, P>)
+		{
+			anOwner = theHandle.promise().mAsyncState;
+			anOwner->mAwaiting = mState;
+		}
+
+		mState->mContinuations.push_back({theHandle, anOwner});
+	}
+
+	T await_resume() const
+	{
+		if constexpr (!std::is_void_v<T>)
+			return mState->mResult;
+	}
+};
+
+inline Async<void> AsyncPromise<void>::get_return_object()
+{
+	return Async<void>(mState);
+}
+
+// Resolves once every one of theAsyncs has, with their results in the same order.  Cancelling it
+// cancels them all.
+template <typename T> Async<std::vector<T>> WhenAll(const std::vector<Async<T>> &theAsyncs)
+{
+	std::shared_ptr<AsyncState<std::vector<T>>> aState = std::make_shared<AsyncState<std::vector<T>>>();
+	if (theAsyncs.empty())
+	{
+		aState->Resolve();
+		return Async<std::vector<T>>(aState);
+	}
+
+	aState->mResult.resize(theAsyncs.size());
+	std::shared_ptr<size_t> aNumLeft = std::make_shared<size_t>(theAsyncs.size());
+	std::weak_ptr<AsyncState<std::vector<T>>> aWeakState = aState;
+
+	for (const Async<T> &anAsync : theAsyncs)
+		aState->mChildren.push_back(anAsync.mState);
+
+	for (size_t i = 0; i < theAsyncs.size(); i++)
+	{
+		AsyncState<T> *aChild = theAsyncs[i].mState.get();
+		aChild->AddCallback([aWeakState, aNumLeft, aChild, i]() {
+			std::shared_ptr<AsyncState<std::vector<T>>> aParent = aWeakState.lock();
+			if ((aParent == NULL) || aParent->mDone)
+				return;
+
+			aParent->mResult[i] = aChild->mResult;
+			if (--*aNumLeft == 0)
+				aParent->Resolve();
+		});
+	}
+
+	return Async<std::vector<T>>(aState);
+}
+
+} // namespace PopLib
+
+#endif
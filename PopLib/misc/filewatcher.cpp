@@ -0,0 +1,147 @@
+#include "filewatcher.hpp"
+#include <filesystem>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace PopLib;
+
+FileWatcher::FileWatcher() : mNotifyFd(-1), mThread(nullptr), mStopped(false), mSettleTime(100)
+{
+#ifdef __linux__
+	mNotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (mNotifyFd >= 0)
+		mThread = SDL_CreateThread(ThreadProcStub, "FileWatcher", this);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+	mStopped = true;
+	if (mThread != nullptr)
+		SDL_WaitThread(mThread, nullptr);
+
+#ifdef __linux__
+	// Closing the descriptor drops all of its watches along with it
+	if (mNotifyFd >= 0)
+		close(mNotifyFd);
+#endif
+}
+
+bool FileWatcher::IsActive()
+{
+	return mThread != nullptr;
+}
+
+std::string FileWatcher::GetWatchPath(const std::string &theFileName)
+{
+	std::error_code anError;
+	std::filesystem::path aPath = std::filesystem::absolute(std::filesystem::path(theFileName), anError);
+	if (anError)
+		aPath = std::filesystem::path(theFileName);
+
+	return aPath.lexically_normal().generic_string();
+}
+
+bool FileWatcher::WatchFile(const std::string &theFileName)
+{
+	if (!IsActive())
+		return false;
+
+	std::string aPath = GetWatchPath(theFileName);
+	size_t aSlashPos = aPath.rfind('/');
+	if (aSlashPos == std::string::npos)
+		return false;
+
+	std::string aDir = aPath.substr(0, std::max((size_t)1, aSlashPos));
+
+	std::lock_guard<std::mutex> aLock(mMutex);
+	if (mWatchedDirSet.find(aDir) == mWatchedDirSet.end())
+	{
+#ifdef __linux__
+		int aWatch = inotify_add_watch(mNotifyFd, aDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (aWatch < 0)
+			return false;
+
+		mWatchedDirs[aWatch] = aDir;
+#endif
+		mWatchedDirSet.insert(aDir);
+	}
+
+	mWatchedFiles.insert(aPath);
+	return true;
+}
+
+bool FileWatcher::IsWatching(const std::string &theFileName)
+{
+	std::lock_guard<std::mutex> aLock(mMutex);
+	return mWatchedFiles.find(GetWatchPath(theFileName)) != mWatchedFiles.end();
+}
+
+void FileWatcher::GetChangedFiles(std::vector<std::string> &theFileNames)
+{
+	uint64_t aNow = SDL_GetTicks();
+
+	std::lock_guard<std::mutex> aLock(mMutex);
+	for (auto anItr = mPendingFiles.begin(); anItr != mPendingFiles.end();)
+	{
+		if (aNow - anItr->second >= (uint64_t)mSettleTime)
+		{
+			theFileNames.push_back(anItr->first);
+			anItr = mPendingFiles.erase(anItr);
+		}
+		else
+			++anItr;
+	}
+}
+
+int FileWatcher::ThreadProcStub(void *theArg)
+{
+	((FileWatcher *)theArg)->ThreadProc();
+	return 0;
+}
+
+void FileWatcher::ThreadProc()
+{
+#ifdef __linux__
+	alignas(struct inotify_event) char aBuffer[4096];
+
+	while (!mStopped)
+	{
+		// Wakes up now and then to see whether we're being shut down
+		pollfd aPollFd = {mNotifyFd, POLLIN, 0};
+		if (poll(&aPollFd, 1, 100) <= 0)
+			continue;
+
+		ssize_t aLength = read(mNotifyFd, aBuffer, sizeof(aBuffer));
+		if (aLength <= 0)
+			continue;
+
+		uint64_t aNow = SDL_GetTicks();
+
+		std::lock_guard<std::mutex> aLock(mMutex);
+		for (char *aPtr = aBuffer; aPtr < aBuffer + aLength;)
+		{
+			const struct inotify_event *anEvent = (const struct inotify_event *)aPtr;
+			aPtr += sizeof(struct inotify_event) + anEvent->len;
+
+			if (anEvent->len == 0)
+				continue;
+
+			auto aDirItr = mWatchedDirs.find(anEvent->wd);
+			if (aDirItr == mWatchedDirs.end())
+				continue;
+
+			std::string aPath = aDirItr->second;
+			if (aPath.back() != '/')
+				aPath += '/';
+			aPath += anEvent->name;
+			if (mWatchedFiles.find(aPath) != mWatchedFiles.end())
+				mPendingFiles[aPath] = aNow;
+		}
+	}
+#endif
+}
@@ -0,0 +1,59 @@
+#ifndef __FILEWATCHER_HPP__
+#define __FILEWATCHER_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace PopLib
+{
+
+// Tells you which of the files you asked about have been written to.  The containing directories are
+// watched with inotify from a thread of its own, so editors that save through a temp file and a rename
+// are picked up too.  A file only shows up in GetChangedFiles once it has been left alone for
+// mSettleTime ms, which keeps a save that arrives in several writes down to one change.  Does nothing
+// on platforms other than Linux, IsActive tells you.
+class FileWatcher
+{
+  protected:
+	int mNotifyFd;
+	SDL_Thread *mThread;
+	std::atomic<bool> mStopped;
+
+	std::mutex mMutex;
+	std::unordered_map<int, std::string> mWatchedDirs;		 // inotify watch descriptor to directory
+	std::unordered_set<std::string> mWatchedDirSet;
+	std::unordered_set<std::string> mWatchedFiles;
+	std::unordered_map<std::string, uint64_t> mPendingFiles; // to the ticks of their last change
+
+  protected:
+	static int ThreadProcStub(void *theArg);
+	void ThreadProc();
+
+  public:
+	int mSettleTime;
+
+  public:
+	FileWatcher();
+	virtual ~FileWatcher();
+
+	bool IsActive();
+
+	// The files don't have to exist yet, only their directory does
+	bool WatchFile(const std::string &theFileName);
+	bool IsWatching(const std::string &theFileName);
+	void GetChangedFiles(std::vector<std::string> &theFileNames);
+
+	// Absolute and with the separators cleaned up, the way GetChangedFiles reports names
+	static std::string GetWatchPath(const std::string &theFileName);
+};
+
+} // namespace PopLib
+
+#endif
@@ -0,0 +1,120 @@
+#include "framepacer.hpp"
+#include <SDL3/SDL.h>
+
+using namespace PopLib;
+
+// The spin time never goes lower than this, since timer slack alone is often a good fraction of it
+static const double FRAMEPACER_MIN_SPIN_TIME = 0.25;
+static const double FRAMEPACER_MAX_SPIN_TIME = 4.0;
+
+FramePacer::FramePacer()
+{
+	mFrequency = SDL_GetPerformanceFrequency();
+	mStartCounter = SDL_GetPerformanceCounter();
+	mSpinTime = 1.0;
+	mMissedDeadlines = 0;
+
+	ResetStats();
+
+	mFrameTimeMean = 0;
+	mFrameTimeStdDev = 0;
+	mFrameTimeMax = 0;
+	mFrameTimeMissed = 0;
+}
+
+double FramePacer::GetTime()
+{
+	uint64_t aCounter = SDL_GetPerformanceCounter() - mStartCounter;
+
+	// Split it up so the multiply can't overflow on a high frequency counter
+	return (double)(aCounter / mFrequency) * 1000.0 + (double)(aCounter % mFrequency) * 1000.0 / mFrequency;
+}
+
+void FramePacer::WaitUntil(double theTime)
+{
+	for (;;)
+	{
+		double aNow = GetTime();
+		double aTimeLeft = theTime - aNow;
+		if (aTimeLeft <= 0)
+			break;
+
+		if (aTimeLeft > mSpinTime)
+		{
+			double aSleepTime = aTimeLeft - mSpinTime;
+			SDL_DelayNS((uint64_t)(aSleepTime * 1000000.0));
+
+			// Cover however late we woke up with spinning next time, and slowly give it back when
+			//  the OS is being punctual
+			double anOversleep = (GetTime() - aNow) - aSleepTime;
+			if (anOversleep > mSpinTime)
+				mSpinTime = std::min(anOversleep, FRAMEPACER_MAX_SPIN_TIME);
+			else
+				mSpinTime = std::max(mSpinTime * 0.95 + anOversleep * 0.05, FRAMEPACER_MIN_SPIN_TIME);
+		}
+		else
+			SDL_CPUPauseInstruction();
+	}
+}
+
+void FramePacer::Wait(double theDuration)
+{
+	WaitUntil(GetTime() + theDuration);
+}
+
+void FramePacer::FramePresented(double theTargetFrameTime)
+{
+	double aNow = GetTime();
+
+	if (mLastPresentTime > 0)
+	{
+		double aFrameTime = aNow - mLastPresentTime;
+
+		mWindowFrames++;
+		mWindowSum += aFrameTime;
+		mWindowSumSq += aFrameTime * aFrameTime;
+		mWindowMax = std::max(mWindowMax, aFrameTime);
+
+		// More than half a frame late means it went out on a later refresh than it should have
+		if ((theTargetFrameTime > 0) && (aFrameTime > theTargetFrameTime * 1.5))
+		{
+			mMissedDeadlines++;
+			mWindowMissedDeadlines++;
+		}
+	}
+
+	mLastPresentTime = aNow;
+
+	if (aNow - mWindowStartTime >= 1000.0)
+	{
+		if (mWindowFrames > 0)
+		{
+			mFrameTimeMean = mWindowSum / mWindowFrames;
+			mFrameTimeStdDev =
+				sqrt(std::max(mWindowSumSq / mWindowFrames - mFrameTimeMean * mFrameTimeMean, 0.0));
+			mFrameTimeMax = mWindowMax;
+			mFrameTimeMissed = mWindowMissedDeadlines;
+		}
+
+		double aLastPresentTime = mLastPresentTime;
+		ResetStats();
+		mLastPresentTime = aLastPresentTime;
+	}
+}
+
+void FramePacer::FrameSkipped()
+{
+	// Nothing was drawn, so the next present isn't late, it just didn't have anything to show
+	mLastPresentTime = 0;
+}
+
+void FramePacer::ResetStats()
+{
+	mLastPresentTime = 0;
+	mWindowStartTime = GetTime();
+	mWindowFrames = 0;
+	mWindowMissedDeadlines = 0;
+	mWindowSum = 0;
+	mWindowSumSq = 0;
+	mWindowMax = 0;
+}
@@ -0,0 +1,53 @@
+#ifndef __FRAMEPACER_HPP__
+#define __FRAMEPACER_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+
+namespace PopLib
+{
+
+// Keeps time off the performance counter instead of SDL_GetTicks, and waits for deadlines by
+// sleeping most of the way there and spinning for the rest.  Also keeps track of how steady the
+// presented frames are.
+class FramePacer
+{
+  public:
+	uint64_t mFrequency;
+	uint64_t mStartCounter;
+	double mSpinTime; // how far out from a deadline we stop sleeping, grows with how late the OS wakes us
+
+	double mLastPresentTime;
+	int mMissedDeadlines;
+
+	// Accumulated over the current one second window
+	double mWindowStartTime;
+	int mWindowFrames;
+	int mWindowMissedDeadlines;
+	double mWindowSum;
+	double mWindowSumSq;
+	double mWindowMax;
+
+	// Results from the last complete window, in milliseconds
+	double mFrameTimeMean;
+	double mFrameTimeStdDev;
+	double mFrameTimeMax;
+	int mFrameTimeMissed;
+
+  public:
+	FramePacer();
+
+	double GetTime(); // milliseconds
+	void WaitUntil(double theTime);
+	void Wait(double theDuration);
+
+	void FramePresented(double theTargetFrameTime);
+	void FrameSkipped();
+	void ResetStats();
+};
+
+} // namespace PopLib
+
+#endif
@@ -0,0 +1,422 @@
+#include "jobsystem.hpp"
+
+using namespace PopLib;
+
+JobSystem *PopLib::gJobSystem = nullptr;
+
+static thread_local JobSystem *gWorkerSystem = nullptr;
+static thread_local int gWorkerIndex = -1;
+
+JobSystem::JobSystem(int theNumWorkers)
+	: mNextWorker(0), mNumQueuedJobs(0), mNumSleeping(0), mStopped(false)
+{
+	if (gJobSystem == nullptr)
+		gJobSystem = this;
+
+	// The loading thread is a job that holds its worker until loading is done, so there's always another
+	if (theNumWorkers <= 0)
+		theNumWorkers = std::max(2, SDL_GetNumLogicalCPUCores() - 1);
+
+	mSleepMutex = SDL_CreateMutex();
+	mMainThreadMutex = SDL_CreateMutex();
+	mLowPriorityMutex = SDL_CreateMutex();
+	mSleepCond = SDL_CreateCondition();
+	mMainThreadId = SDL_GetCurrentThreadID();
+	mStatsStartTicks = SDL_GetPerformanceCounter();
+
+	// All the queues have to be there before any worker goes looking for something to steal
+	for (int i = 0; i < theNumWorkers; i++)
+	{
+		JobWorker *aWorker = new JobWorker();
+		aWorker->mSystem = this;
+		aWorker->mIndex = i;
+		aWorker->mThread = nullptr;
+		aWorker->mMutex = SDL_CreateMutex();
+		aWorker->mBusyTicks = 0;
+		aWorker->mJobsRun = 0;
+		aWorker->mLastBusyTicks = 0;
+		aWorker->mLastJobsRun = 0;
+		aWorker->mUtilization = 0;
+		aWorker->mJobsPerSecond = 0;
+		mWorkers.push_back(aWorker);
+	}
+
+	for (int i = 0; i < theNumWorkers; i++)
+	{
+		char aName[32];
+		snprintf(aName, sizeof(aName), "JobWorker%d", i);
+		mWorkers[i]->mThread = SDL_CreateThread(WorkerThreadProcStub, aName, mWorkers[i]);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	SDL_LockMutex(mSleepMutex);
+	mStopped = true;
+	SDL_BroadcastCondition(mSleepCond);
+	SDL_UnlockMutex(mSleepMutex);
+
+	for (JobWorker *aWorker : mWorkers)
+		SDL_WaitThread(aWorker->mThread, nullptr);
+
+	// Whatever never got to run is dropped
+	for (JobWorker *aWorker : mWorkers)
+	{
+		for (Job *aJob : aWorker->mJobs)
+			delete aJob;
+		SDL_DestroyMutex(aWorker->mMutex);
+		delete aWorker;
+	}
+	mWorkers.clear();
+
+	for (Job *aJob : mMainThreadJobs)
+		delete aJob;
+	mMainThreadJobs.clear();
+
+	for (Job *aJob : mLowPriorityJobs)
+		delete aJob;
+	mLowPriorityJobs.clear();
+
+	SDL_DestroyCondition(mSleepCond);
+	SDL_DestroyMutex(mSleepMutex);
+	SDL_DestroyMutex(mMainThreadMutex);
+	SDL_DestroyMutex(mLowPriorityMutex);
+
+	if (gJobSystem == this)
+		gJobSystem = nullptr;
+}
+
+int JobSystem::WorkerThreadProcStub(void *theArg)
+{
+	JobWorker *aWorker = (JobWorker *)theArg;
+	aWorker->mSystem->WorkerThreadProc(aWorker->mIndex);
+	return 0;
+}
+
+void JobSystem::WorkerThreadProc(int theIndex)
+{
+	gWorkerSystem = this;
+	gWorkerIndex = theIndex;
+
+	JobWorker *aWorker = mWorkers[theIndex];
+	while (!mStopped)
+	{
+		Job *aJob = PopJob(theIndex, true);
+		if (aJob != nullptr)
+		{
+			// Jobs run from inside a Wait are part of the outer job's time
+			uint64_t aStartTicks = SDL_GetPerformanceCounter();
+			Execute(aJob);
+			aWorker->mBusyTicks += SDL_GetPerformanceCounter() - aStartTicks;
+			continue;
+		}
+
+		// Schedule bumps mNumQueuedJobs before it checks mNumSleeping, so one side always sees the other
+		SDL_LockMutex(mSleepMutex);
+		mNumSleeping++;
+		while ((mNumQueuedJobs <= 0) && (!mStopped))
+			SDL_WaitCondition(mSleepCond, mSleepMutex);
+		mNumSleeping--;
+		SDL_UnlockMutex(mSleepMutex);
+	}
+}
+
+void JobSystem::Schedule(Job *theJob)
+{
+	if (theJob->mMainThread)
+	{
+		SDL_LockMutex(mMainThreadMutex);
+		mMainThreadJobs.push_back(theJob);
+		SDL_UnlockMutex(mMainThreadMutex);
+		return;
+	}
+
+	mNumQueuedJobs++;
+
+	if (theJob->mLowPriority)
+	{
+		SDL_LockMutex(mLowPriorityMutex);
+		mLowPriorityJobs.push_back(theJob);
+		SDL_UnlockMutex(mLowPriorityMutex);
+	}
+	else
+	{
+		// Workers keep what they spawn to themselves until someone steals it, everyone else deals round robin
+		int anIndex = gWorkerIndex;
+		if ((gWorkerSystem != this) || (anIndex < 0))
+			anIndex = (mNextWorker++ & 0x7FFFFFFF) % (int)mWorkers.size();
+
+		JobWorker *aWorker = mWorkers[anIndex];
+		SDL_LockMutex(aWorker->mMutex);
+		aWorker->mJobs.push_back(theJob);
+		SDL_UnlockMutex(aWorker->mMutex);
+	}
+
+	if (mNumSleeping > 0)
+	{
+		SDL_LockMutex(mSleepMutex);
+		SDL_SignalCondition(mSleepCond);
+		SDL_UnlockMutex(mSleepMutex);
+	}
+}
+
+void JobSystem::Submit(Job *theJob, JobCounter *theDependency)
+{
+	if (theJob->mCounter != nullptr)
+		theJob->mCounter->mCount++;
+
+	if (theDependency != nullptr)
+	{
+		SDL_LockMutex(theDependency->mMutex);
+		if (!theDependency->IsDone())
+		{
+			theDependency->mWaitingJobs.push_back(theJob);
+			SDL_UnlockMutex(theDependency->mMutex);
+			return;
+		}
+		SDL_UnlockMutex(theDependency->mMutex);
+	}
+
+	Schedule(theJob);
+}
+
+Job *JobSystem::PopJob(int theIndex, bool allowLowPriority)
+{
+	int aNumWorkers = (int)mWorkers.size();
+	if (theIndex >= 0)
+	{
+		JobWorker *aWorker = mWorkers[theIndex];
+		SDL_LockMutex(aWorker->mMutex);
+		if (!aWorker->mJobs.empty())
+		{
+			Job *aJob = aWorker->mJobs.back();
+			aWorker->mJobs.pop_back();
+			SDL_UnlockMutex(aWorker->mMutex);
+			mNumQueuedJobs--;
+			return aJob;
+		}
+		SDL_UnlockMutex(aWorker->mMutex);
+	}
+
+	int aStart = std::max(theIndex, 0);
+	for (int i = 0; i < aNumWorkers; i++)
+	{
+		int aVictim = (aStart + i) % aNumWorkers;
+		if (aVictim == theIndex)
+			continue;
+
+		JobWorker *aWorker = mWorkers[aVictim];
+		SDL_LockMutex(aWorker->mMutex);
+		if (!aWorker->mJobs.empty())
+		{
+			Job *aJob = aWorker->mJobs.front();
+			aWorker->mJobs.pop_front();
+			SDL_UnlockMutex(aWorker->mMutex);
+			mNumQueuedJobs--;
+			return aJob;
+		}
+		SDL_UnlockMutex(aWorker->mMutex);
+	}
+
+	if (allowLowPriority)
+	{
+		SDL_LockMutex(mLowPriorityMutex);
+		if (!mLowPriorityJobs.empty())
+		{
+			Job *aJob = mLowPriorityJobs.front();
+			mLowPriorityJobs.pop_front();
+			SDL_UnlockMutex(mLowPriorityMutex);
+			mNumQueuedJobs--;
+			return aJob;
+		}
+		SDL_UnlockMutex(mLowPriorityMutex);
+	}
+
+	return nullptr;
+}
+
+Job *JobSystem::PopMainThreadJob()
+{
+	Job *aJob = nullptr;
+
+	SDL_LockMutex(mMainThreadMutex);
+	if (!mMainThreadJobs.empty())
+	{
+		aJob = mMainThreadJobs.front();
+		mMainThreadJobs.pop_front();
+	}
+	SDL_UnlockMutex(mMainThreadMutex);
+
+	return aJob;
+}
+
+void JobSystem::Execute(Job *theJob)
+{
+	theJob->mFunction();
+
+	if ((gWorkerSystem == this) && (gWorkerIndex >= 0))
+		mWorkers[gWorkerIndex]->mJobsRun++;
+
+	JobCounter *aCounter = theJob->mCounter;
+	delete theJob;
+
+	if (aCounter == nullptr)
+		return;
+
+	// The count drops under the counter's lock so that Wait can tell when we're done touching it
+	std::vector<Job *> aReleasedJobs;
+	SDL_LockMutex(aCounter->mMutex);
+	if (--aCounter->mCount == 0)
+		aReleasedJobs.swap(aCounter->mWaitingJobs);
+	SDL_UnlockMutex(aCounter->mMutex);
+
+	for (Job *aJob : aReleasedJobs)
+		Schedule(aJob);
+}
+
+bool JobSystem::RunPendingJob()
+{
+	Job *aJob = nullptr;
+	if (IsMainThread())
+		aJob = PopMainThreadJob();
+
+	if (aJob == nullptr)
+		aJob = PopJob(GetCurrentWorker(), false);
+
+	if (aJob == nullptr)
+		return false;
+
+	Execute(aJob);
+	return true;
+}
+
+void JobSystem::Run(const JobFunction &theFunction, JobCounter *theCounter, JobCounter *theDependency)
+{
+	Job *aJob = new Job();
+	aJob->mFunction = theFunction;
+	aJob->mCounter = theCounter;
+	aJob->mMainThread = false;
+	aJob->mLowPriority = false;
+	Submit(aJob, theDependency);
+}
+
+void JobSystem::RunOnMainThread(const JobFunction &theFunction, JobCounter *theCounter, JobCounter *theDependency)
+{
+	Job *aJob = new Job();
+	aJob->mFunction = theFunction;
+	aJob->mCounter = theCounter;
+	aJob->mMainThread = true;
+	aJob->mLowPriority = false;
+	Submit(aJob, theDependency);
+}
+
+void JobSystem::RunLowPriority(const JobFunction &theFunction, JobCounter *theCounter, JobCounter *theDependency)
+{
+	Job *aJob = new Job();
+	aJob->mFunction = theFunction;
+	aJob->mCounter = theCounter;
+	aJob->mMainThread = false;
+	aJob->mLowPriority = true;
+	Submit(aJob, theDependency);
+}
+
+void JobSystem::ParallelFor(int theBegin, int theEnd, const JobRangeFunction &theFunction, int theGrainSize)
+{
+	if (theEnd <= theBegin)
+		return;
+
+	int aCount = theEnd - theBegin;
+	if (theGrainSize <= 0)
+		theGrainSize = std::max(1, aCount / ((GetNumWorkers() + 1) * 4));
+
+	if (aCount <= theGrainSize)
+	{
+		theFunction(theBegin, theEnd);
+		return;
+	}
+
+	// The caller takes the first range itself and then helps out with the rest
+	JobCounter aCounter;
+	int aStart = theBegin + theGrainSize;
+	while (aStart < theEnd)
+	{
+		int anEnd = aStart + std::min(theGrainSize, theEnd - aStart);
+		Run([&theFunction, aStart, anEnd]() { theFunction(aStart, anEnd); }, &aCounter);
+		aStart = anEnd;
+	}
+
+	theFunction(theBegin, theBegin + theGrainSize);
+	Wait(&aCounter);
+}
+
+void JobSystem::Wait(JobCounter *theCounter)
+{
+	while (!theCounter->IsDone())
+	{
+		if (!RunPendingJob())
+			SDL_DelayNS(SDL_NS_PER_US * 50);
+	}
+
+	// The last Execute may still be holding the lock it dropped the count under
+	SDL_LockMutex(theCounter->mMutex);
+	SDL_UnlockMutex(theCounter->mMutex);
+}
+
+void JobSystem::ProcessMainThreadJobs()
+{
+	// Only what's queued now, jobs that queue more main thread work get it run next frame
+	SDL_LockMutex(mMainThreadMutex);
+	size_t aNumJobs = mMainThreadJobs.size();
+	SDL_UnlockMutex(mMainThreadMutex);
+
+	for (size_t i = 0; i < aNumJobs; i++)
+	{
+		Job *aJob = PopMainThreadJob();
+		if (aJob == nullptr)
+			break;
+		Execute(aJob);
+	}
+}
+
+void JobSystem::UpdateStats()
+{
+	uint64_t aTicks = SDL_GetPerformanceCounter();
+	uint64_t aFrequency = SDL_GetPerformanceFrequency();
+	uint64_t anElapsed = aTicks - mStatsStartTicks;
+	if (anElapsed < aFrequency)
+		return;
+
+	for (JobWorker *aWorker : mWorkers)
+	{
+		uint64_t aBusyTicks = aWorker->mBusyTicks;
+		int aJobsRun = aWorker->mJobsRun;
+
+		// Long jobs are only counted once they finish, so a window can come out over 100%
+		aWorker->mUtilization = std::min(1.0f, (float)(aBusyTicks - aWorker->mLastBusyTicks) / anElapsed);
+		aWorker->mJobsPerSecond = (int)((aJobsRun - aWorker->mLastJobsRun) * aFrequency / anElapsed);
+		aWorker->mLastBusyTicks = aBusyTicks;
+		aWorker->mLastJobsRun = aJobsRun;
+	}
+
+	mStatsStartTicks = aTicks;
+}
+
+bool JobSystem::IsMainThread()
+{
+	return SDL_GetCurrentThreadID() == mMainThreadId;
+}
+
+int JobSystem::GetNumWorkers()
+{
+	return (int)mWorkers.size();
+}
+
+int JobSystem::GetCurrentWorker()
+{
+	return (gWorkerSystem == this) ? gWorkerIndex : -1;
+}
+
+const JobWorker *JobSystem::GetWorker(int theIndex)
+{
+	return mWorkers[theIndex];
+}
@@ -0,0 +1,141 @@
+#ifndef __JOBSYSTEM_HPP__
+#define __JOBSYSTEM_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+
+namespace PopLib
+{
+
+typedef std::function<void()> JobFunction;
+typedef std::function<void(int theBegin, int theEnd)> JobRangeFunction;
+
+struct Job;
+class JobSystem;
+
+// Number of jobs still outstanding.  Jobs that were started with a counter bump it and drop it again
+// when they finish, and jobs can be made to wait on a counter before they start.  Only destroy a
+// counter after JobSystem::Wait has returned for it.
+class JobCounter
+{
+  protected:
+	friend class JobSystem;
+
+	std::atomic<int> mCount;
+	SDL_Mutex *mMutex;
+	std::vector<Job *> mWaitingJobs; // jobs held back until mCount reaches zero
+
+  public:
+	JobCounter() : mCount(0)
+	{
+		mMutex = SDL_CreateMutex();
+	}
+
+	~JobCounter()
+	{
+		SDL_DestroyMutex(mMutex);
+	}
+
+	JobCounter(const JobCounter &) = delete;
+	JobCounter &operator=(const JobCounter &) = delete;
+
+	bool IsDone() const
+	{
+		return mCount.load(std::memory_order_acquire) == 0;
+	}
+};
+
+struct Job
+{
+	JobFunction mFunction;
+	JobCounter *mCounter;
+	bool mMainThread;
+	bool mLowPriority;
+};
+
+struct JobWorker
+{
+	JobSystem *mSystem;
+	int mIndex;
+	SDL_Thread *mThread;
+	SDL_Mutex *mMutex;
+	std::deque<Job *> mJobs; // the owner works off the back, thieves take from the front
+
+	std::atomic<uint64_t> mBusyTicks;
+	std::atomic<int> mJobsRun;
+
+	// Main thread only, see JobSystem::UpdateStats
+	uint64_t mLastBusyTicks;
+	int mLastJobsRun;
+	float mUtilization;
+	int mJobsPerSecond;
+};
+
+// Runs jobs on one worker thread per spare core.  Every worker keeps its own queue and steals from
+// the others when it runs dry, the queues are deques behind an SDL_Mutex each rather than lock free.
+// Anything that has to happen on the main thread (SDL rendering, widgets) can be queued with
+// RunOnMainThread, those are picked up once per frame.
+class JobSystem
+{
+  protected:
+	std::vector<JobWorker *> mWorkers;
+	std::atomic<int> mNextWorker;
+	std::atomic<int> mNumQueuedJobs;
+	std::atomic<int> mNumSleeping;
+	std::atomic<bool> mStopped;
+	SDL_Mutex *mSleepMutex;
+	SDL_Condition *mSleepCond;
+	SDL_ThreadID mMainThreadId;
+
+	SDL_Mutex *mMainThreadMutex;
+	std::deque<Job *> mMainThreadJobs;
+
+	// Only picked up by workers with nothing else to do, and never by a thread helping out in Wait
+	SDL_Mutex *mLowPriorityMutex;
+	std::deque<Job *> mLowPriorityJobs;
+
+	uint64_t mStatsStartTicks;
+
+  protected:
+	static int WorkerThreadProcStub(void *theArg);
+	void WorkerThreadProc(int theIndex);
+
+	void Schedule(Job *theJob);
+	void Submit(Job *theJob, JobCounter *theDependency);
+	Job *PopJob(int theIndex, bool allowLowPriority);
+	Job *PopMainThreadJob();
+	void Execute(Job *theJob);
+	bool RunPendingJob();
+
+  public:
+	JobSystem(int theNumWorkers = 0); // 0 keeps one core free for the main thread, but starts at least 2
+	virtual ~JobSystem();
+
+	void Run(const JobFunction &theFunction, JobCounter *theCounter = nullptr, JobCounter *theDependency = nullptr);
+	void RunOnMainThread(const JobFunction &theFunction, JobCounter *theCounter = nullptr,
+						 JobCounter *theDependency = nullptr);
+	void RunLowPriority(const JobFunction &theFunction, JobCounter *theCounter = nullptr,
+						JobCounter *theDependency = nullptr);
+	void ParallelFor(int theBegin, int theEnd, const JobRangeFunction &theFunction, int theGrainSize = 0);
+	void Wait(JobCounter *theCounter);
+
+	void ProcessMainThreadJobs();
+	void UpdateStats();
+
+	bool IsMainThread();
+	int GetNumWorkers();
+	int GetCurrentWorker(); // -1 when not called from a worker
+	const JobWorker *GetWorker(int theIndex);
+};
+
+extern JobSystem *gJobSystem;
+
+} // namespace PopLib
+
+#endif
@@ -0,0 +1,105 @@
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace PopLib;
+
+MappedFile::MappedFile()
+{
+	mData = nullptr;
+	mSize = 0;
+#ifdef _WIN32
+	mFileHandle = INVALID_HANDLE_VALUE;
+	mMappingHandle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string &theFileName, size_t theMinSize)
+{
+	Close();
+
+	// Nothing can map an empty file
+	theMinSize = std::max(theMinSize, (size_t)1);
+
+#ifdef _WIN32
+	HANDLE aFile = CreateFileA(theFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							   FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (aFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER aFileSize;
+	if ((!GetFileSizeEx(aFile, &aFileSize)) || (aFileSize.QuadPart < (LONGLONG)theMinSize))
+	{
+		CloseHandle(aFile);
+		return false;
+	}
+
+	HANDLE aMapping = CreateFileMappingA(aFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void *aView = (aMapping != nullptr) ? MapViewOfFile(aMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (aView == nullptr)
+	{
+		if (aMapping != nullptr)
+			CloseHandle(aMapping);
+		CloseHandle(aFile);
+		return false;
+	}
+
+	mFileHandle = aFile;
+	mMappingHandle = aMapping;
+	mData = (const uchar *)aView;
+	mSize = (size_t)aFileSize.QuadPart;
+#else
+	int aFD = open(theFileName.c_str(), O_RDONLY);
+	if (aFD < 0)
+		return false;
+
+	struct stat aStat;
+	if ((fstat(aFD, &aStat) != 0) || (aStat.st_size < (off_t)theMinSize))
+	{
+		close(aFD);
+		return false;
+	}
+
+	void *aView = mmap(nullptr, aStat.st_size, PROT_READ, MAP_PRIVATE, aFD, 0);
+	close(aFD); // the mapping keeps the file around
+
+	if (aView == MAP_FAILED)
+		return false;
+
+	mData = (const uchar *)aView;
+	mSize = (size_t)aStat.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mData);
+	CloseHandle(mMappingHandle);
+	CloseHandle(mFileHandle);
+	mFileHandle = INVALID_HANDLE_VALUE;
+	mMappingHandle = nullptr;
+#else
+	munmap((void *)mData, mSize);
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+}
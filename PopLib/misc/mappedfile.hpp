@@ -0,0 +1,51 @@
+#ifndef __MAPPEDFILE_HPP__
+#define __MAPPEDFILE_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+
+namespace PopLib
+{
+
+// A loose file mapped read only into memory, for as long as the MappedFile is open
+class MappedFile
+{
+  protected:
+	const uchar *mData;
+	size_t mSize;
+#ifdef _WIN32
+	void *mFileHandle;
+	void *mMappingHandle;
+#endif
+
+  public:
+	MappedFile();
+	virtual ~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool Open(const std::string &theFileName, size_t theMinSize = 1); // fails on files smaller than theMinSize
+	void Close();
+
+	bool IsOpen()
+	{
+		return mData != nullptr;
+	}
+
+	const uchar *GetData()
+	{
+		return mData;
+	}
+
+	size_t GetSize()
+	{
+		return mSize;
+	}
+};
+
+} // namespace PopLib
+
+#endif
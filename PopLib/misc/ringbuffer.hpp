@@ -0,0 +1,98 @@
+#ifndef __RINGBUFFER_HPP__
+#define __RINGBUFFER_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+
+namespace PopLib
+{
+
+// Queue with random access, pushing at the back and popping at the front are both O(1).  Popped
+// slots keep their object and get assigned over on a later push, so strings and vectors in them
+// keep their storage when the buffer is cycled as a log.
+template <typename T> class RingBuffer
+{
+  protected:
+	std::vector<T> mItems; // size is always a power of two, or zero
+	size_t mHead;
+	size_t mSize;
+
+  protected:
+	void Grow()
+	{
+		std::vector<T> anItems(mItems.empty() ? 16 : mItems.size() * 2);
+		for (size_t i = 0; i < mSize; i++)
+			anItems[i] = std::move(mItems[(mHead + i) & (mItems.size() - 1)]);
+
+		mItems.swap(anItems);
+		mHead = 0;
+	}
+
+  public:
+	RingBuffer() : mHead(0), mSize(0)
+	{
+	}
+
+	size_t size() const
+	{
+		return mSize;
+	}
+
+	bool empty() const
+	{
+		return mSize == 0;
+	}
+
+	void clear()
+	{
+		mHead = 0;
+		mSize = 0;
+	}
+
+	T &operator[](size_t theIndex)
+	{
+		return mItems[(mHead + theIndex) & (mItems.size() - 1)];
+	}
+
+	const T &operator[](size_t theIndex) const
+	{
+		return mItems[(mHead + theIndex) & (mItems.size() - 1)];
+	}
+
+	T &front()
+	{
+		return (*this)[0];
+	}
+
+	T &back()
+	{
+		return (*this)[mSize - 1];
+	}
+
+	// Returns the new back slot, which may still hold whatever was popped from it last time round
+	T &push_back()
+	{
+		if (mSize == mItems.size())
+			Grow();
+
+		mSize++;
+		return back();
+	}
+
+	void push_back(const T &theItem)
+	{
+		push_back() = theItem;
+	}
+
+	void pop_front()
+	{
+		mHead = (mHead + 1) & (mItems.size() - 1);
+		mSize--;
+	}
+};
+
+} // namespace PopLib
+
+#endif // __RINGBUFFER_HPP__
@@ -2,90 +2,33 @@
 
 using namespace PopLib;
 
-WorkerThread::WorkerThread(const std::string &name)
-	: mThread(nullptr), mMutex(nullptr), mCond(nullptr), mTask(nullptr), mTaskArg(nullptr), mStopped(false),
-	  mTaskPending(false), mName(name)
+WorkerThread::WorkerThread(const std::string &name) : mName(name)
 {
-	mMutex = SDL_CreateMutex();
-	mCond = SDL_CreateCondition();
-	mThread = SDL_CreateThread(StaticThreadProc, mName.c_str(), this);
 }
 
 WorkerThread::~WorkerThread()
 {
-	SDL_LockMutex(mMutex);
-	mStopped = true;
-	SDL_SignalCondition(mCond);
-	SDL_UnlockMutex(mMutex);
-
-	SDL_WaitThread(mThread, nullptr);
-	SDL_DestroyCondition(mCond);
-	SDL_DestroyMutex(mMutex);
+	WaitForTask();
 }
 
 void WorkerThread::DoTask(void (*task)(void *), void *arg)
 {
-	SDL_LockMutex(mMutex);
-	mTask = task;
-	mTaskArg = arg;
-	mTaskPending = true;
-	SDL_SignalCondition(mCond);
-	SDL_UnlockMutex(mMutex);
-}
-
-void WorkerThread::WaitForTask()
-{
-	SDL_LockMutex(mMutex);
-	while (mTaskPending)
+	if (gJobSystem == nullptr)
 	{
-		SDL_WaitCondition(mCond, mMutex);
+		task(arg);
+		return;
 	}
-	SDL_UnlockMutex(mMutex);
-}
 
-bool WorkerThread::IsProcessingTask()
-{
-	SDL_LockMutex(mMutex);
-	bool processing = mTaskPending;
-	SDL_UnlockMutex(mMutex);
-	return processing;
+	gJobSystem->Run([task, arg]() { task(arg); }, &mCounter);
 }
 
-int WorkerThread::StaticThreadProc(void *data)
+void WorkerThread::WaitForTask()
 {
-	WorkerThread *self = static_cast<WorkerThread *>(data);
-	self->ThreadProc();
-	return 0;
+	if (gJobSystem != nullptr)
+		gJobSystem->Wait(&mCounter);
 }
 
-void WorkerThread::ThreadProc()
+bool WorkerThread::IsProcessingTask()
 {
-	while (true)
-	{
-		SDL_LockMutex(mMutex);
-		while (!mTaskPending && !mStopped)
-		{
-			SDL_WaitCondition(mCond, mMutex);
-		}
-
-		if (mStopped)
-		{
-			SDL_UnlockMutex(mMutex);
-			break;
-		}
-
-		void (*task)(void *) = mTask;
-		void *arg = mTaskArg;
-		mTaskPending = false;
-		SDL_UnlockMutex(mMutex);
-
-		if (task)
-		{
-			task(arg);
-		}
-
-		SDL_LockMutex(mMutex);
-		SDL_SignalCondition(mCond);
-		SDL_UnlockMutex(mMutex);
-	}
-}
\ No newline at end of file
+	return !mCounter.IsDone();
+}
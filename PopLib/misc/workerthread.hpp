@@ -5,10 +5,12 @@
 #endif
 
 #include "common.hpp"
-#include <SDL3/SDL.h>
+#include "jobsystem.hpp"
 
 namespace PopLib
 {
+// Runs its tasks as jobs on gJobSystem instead of owning a thread.  Tasks are run straight away on the
+// calling thread if there's no job system.
 class WorkerThread
 {
   public:
@@ -21,21 +23,8 @@ class WorkerThread
 	std::string mName;
 
   protected:
-	static int StaticThreadProc(void *);
-
-	SDL_Thread *mThread;
-	SDL_Mutex *mMutex;
-	SDL_Condition *mCond;
-
-	void *mSignalEvent;
-	void *mDoneEvent;
-	void (*mTask)(void *);
-	void *mTaskArg;
-	bool mStopped;
-	bool mTaskPending;
-
-	void ThreadProc();
+	JobCounter mCounter;
 };
 } // namespace PopLib
 
-#endif
\ No newline at end of file
+#endif
@@ -150,6 +150,64 @@ bool PakInterface::AddPakFile(const string &fileName)
 	return true;
 }
 
+//////////////////
+// Looks for a file in the paks or on disk without opening it.  Disk lookups ignore case, and
+// theRealName is set to the name the file can actually be opened with.
+bool PakInterface::FindFile(const string &theFileName, string *theRealName)
+{
+	if (mPakRecordMap.find(toupper(theFileName)) != mPakRecordMap.end())
+	{
+		if (theRealName != nullptr)
+			*theRealName = theFileName;
+		return true;
+	}
+
+	size_t aSlashPos = theFileName.find_last_of("\\/");
+	string aDir = (aSlashPos == string::npos) ? string() : theFileName.substr(0, aSlashPos + 1);
+	string aName = (aSlashPos == string::npos) ? theFileName : theFileName.substr(aSlashPos + 1);
+
+	string aDirKey = toupper(aDir);
+	std::replace(aDirKey.begin(), aDirKey.end(), '\\', '/');
+
+	std::lock_guard<std::mutex> aLock(mDirListingsMutex);
+
+	PakDirListingMap::iterator aDirItr = mDirListings.find(aDirKey);
+	if (aDirItr == mDirListings.end())
+	{
+		// A directory that won't open, possibly just because it was asked for in the wrong case, isn't
+		// remembered, or it would hide the directory from a later lookup that spells it right
+		error_code anError;
+		filesystem::directory_iterator anItr(aDir.empty() ? filesystem::path(".") : filesystem::path(aDir), anError);
+		if (anError)
+			return false;
+
+		PakDirListing aListing;
+		aListing.mDir = aDir;
+		for (; !anError && anItr != filesystem::directory_iterator(); anItr.increment(anError))
+		{
+			string aFileName = anItr->path().filename().string();
+			aListing.mFiles[toupper(aFileName)] = aFileName;
+		}
+
+		aDirItr = mDirListings.emplace(aDirKey, std::move(aListing)).first;
+	}
+
+	std::unordered_map<string, string>::iterator aFileItr = aDirItr->second.mFiles.find(toupper(aName));
+	if (aFileItr == aDirItr->second.mFiles.end())
+		return false;
+
+	if (theRealName != nullptr)
+		*theRealName = aDirItr->second.mDir + aFileItr->second;
+	return true;
+}
+
+// Needs to be called after files are added to or removed from the disk behind our back
+void PakInterface::InvalidateFileIndex()
+{
+	std::lock_guard<std::mutex> aLock(mDirListingsMutex);
+	mDirListings.clear();
+}
+
 PFILE *PakInterface::FOpen(const char *fn, const char *mode)
 {
 	string name(fn);
@@ -12,6 +12,8 @@
 #include <cstdio>
 #include <fstream>
 #include <vector> // how is this not included.
+#include <unordered_map>
+#include <mutex>
 
 class PakCollection;
 
@@ -66,6 +68,14 @@ class PakCollection
 
 typedef std::list<PakCollection> PakCollectionList;
 
+// One directory that could be opened, listed by upper-cased file name -> file name as it is on disk
+struct PakDirListing
+{
+	std::string mDir; // spelled the way it was first opened, which the disk accepted
+	std::unordered_map<std::string, std::string> mFiles;
+};
+typedef std::unordered_map<std::string, PakDirListing> PakDirListingMap;
+
 /**
  * @brief file struct that allows to exist both locally and inside a .pak file
  */
@@ -160,11 +170,19 @@ class PakInterface : public PakInterfaceBase
 	PakRecordMap mPakRecordMap;
 	std::string mError;
 
+	// Directories get listed the first time something inside of them is looked for, so probing for
+	// files that aren't there doesn't have to go to the disk every time
+	PakDirListingMap mDirListings;
+	std::mutex mDirListingsMutex;
+
 	PakInterface();
 	~PakInterface();
 
 	virtual bool AddPakFile(const std::string &fileName);
 
+	bool FindFile(const std::string &theFileName, std::string *theRealName = nullptr);
+	void InvalidateFileIndex();
+
 	PFILE *FOpen(const char *fn, const char *mode) override;
 	int FClose(PFILE *pf) override;
 	int FSeek(PFILE *pf, long offset, int whence) override;
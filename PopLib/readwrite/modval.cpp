@@ -1,10 +1,14 @@
 #include "modval.hpp"
 #include "common.hpp"
+#include <SDL3/SDL.h>
 #include <fstream>
+#include <mutex>
+#include <sstream>
 
-struct ModStorage
+using namespace PopLib;
+
+struct PopLib::ModValue
 {
-	bool mChanged;
 	int mInt;
 	double mDouble;
 	std::string mString;
@@ -12,27 +16,27 @@ struct ModStorage
 
 struct ModPointer
 {
-	const char *mStrPtr;
+	ModStorage *mStorage;
 	int mLineNum;
 
-	ModPointer() : mStrPtr(NULL), mLineNum(0)
+	ModPointer() : mStorage(NULL), mLineNum(0)
 	{
 	}
-	ModPointer(const char *theStrPtr, int theLineNum) : mStrPtr(theStrPtr), mLineNum(theLineNum)
+	ModPointer(ModStorage *theStorage, int theLineNum) : mStorage(theStorage), mLineNum(theLineNum)
 	{
 	}
 };
 
-typedef std::map<int, ModPointer> ModStorageMap; // stores counters
+typedef std::multimap<int, ModPointer> ModStorageMap; // by counter, a header's M()s get one from each file
 
 struct FileMod
 {
-	bool mHasMods;
+	bool mReported; // handed out by GetNewModValFiles yet
 	ModStorageMap mMap;
 
-	FileMod(bool hasMods = false)
+	FileMod()
 	{
-		mHasMods = hasMods;
+		mReported = false;
 	}
 };
 
@@ -40,8 +44,9 @@ typedef std::map<std::string, int> StringToIntMap;
 typedef std::map<std::string, FileMod> FileModMap;
 
 static StringToIntMap gStringToIntMap;
-time_t gLastFileTime = 0;
-const char *gSampleString = NULL; // for finding the others
+
+// M() can be hit from any thread, the first time each call site is hit registers it here
+static std::mutex gModMutex;
 
 static FileModMap &GetFileModMap()
 {
@@ -49,26 +54,6 @@ static FileModMap &GetFileModMap()
 	return aMap;
 }
 
-static const char *FindFileInStringTable(const std::string &theSearch, const char *theMem, uint32_t theLength,
-										 const char *theStartPos)
-{
-	const char *aFind = NULL;
-	try
-	{
-		aFind = std::search(theStartPos, theMem + theLength, theSearch.c_str(), theSearch.c_str() + theSearch.length());
-		if (aFind >= theMem + theLength)
-			return NULL;
-		else
-			return aFind;
-	}
-	catch (...)
-	{
-		return NULL;
-	}
-
-	return NULL;
-}
-
 static bool ParseModValString(std::string &theStr, int *theCounter = NULL, int *theLineNum = NULL)
 {
 	int aPos = theStr.length() - 1;
@@ -102,150 +87,50 @@ static bool ParseModValString(std::string &theStr, int *theCounter = NULL, int *
 	return true;
 }
 
-static bool FindModValsInMemoryHelper(const char *theMem, uint32_t theLength)
+ModStorage *PopLib::GetModStorage(const char *theModString)
 {
-	std::string aSearchStr = "POPLIBMODVAL";
-
-	FileModMap &aMap = GetFileModMap();
-
-	bool foundOne = false;
-	const char *aPtr = theMem;
-	while (true)
-	{
-		aPtr = FindFileInStringTable(aSearchStr, theMem, theLength, aPtr);
-		if (!aPtr)
-			break;
-
-		int aCounter, aLineNum;
-		std::string aFileName = aPtr + 10; // skip POPLIBMODVAL
-		if (ParseModValString(aFileName, &aCounter, &aLineNum))
-		{
-
-			FileMod &aFileMod = aMap[aFileName];
-			aFileMod.mMap[aCounter] = ModPointer(aPtr - 5, aLineNum);
-			foundOne = true;
-		}
-		aPtr++;
-	}
-
-	return foundOne;
-}
-
-static void FindModValsInMemory()
-{
-	/*
-	MEMORY_BASIC_INFORMATION mbi;
-	PVOID      pvAddress = 0;
-
-	const char *aMem = NULL;
-	DWORD aMemLength = 0;
-
-	int aFound = 0;
-	int aTotal = 0;
-	memset(&mbi, 0, sizeof(MEMORY_BASIC_INFORMATION));
-	for (; VirtualQuery(pvAddress, &mbi, sizeof(MEMORY_BASIC_INFORMATION)) == sizeof(MEMORY_BASIC_INFORMATION);
-	pvAddress = ((BYTE*)mbi.BaseAddress) + mbi.RegionSize)
-	{
-		const char *anAddress = (const char*)mbi.BaseAddress;
-		if (mbi.State==MEM_COMMIT && mbi.Type==MEM_IMAGE)
-		{
-			aTotal++;
-			if (aMem!=NULL && aMem+aMemLength==anAddress) // compact these two
-			{
-				aMemLength += mbi.RegionSize;
-				continue;
-			}
-
-			if (aMem!=NULL) // do find in old section
-			{
-				if (FindModValsInMemoryHelper(aMem,aMemLength))
-				{
-					aFound++;
-					return;
-				}
-
-				aMem = NULL;
-			}
-
-			aMem = anAddress;
-			aMemLength = mbi.RegionSize;
-		}
-	}
+	ModStorage *aModStorage = new ModStorage;
+	aModStorage->mValue.store(NULL, std::memory_order_relaxed);
 
-	if (aMem!=NULL)
+	std::string aFileName = theModString + 19; // skip POPLIB_POPLIBMODVAL
+	int aCounter, aLineNum;
+	if (ParseModValString(aFileName, &aCounter, &aLineNum))
 	{
-		if (FindModValsInMemoryHelper(aMem,aMemLength))
-			aFound++;
+		std::lock_guard<std::mutex> aLock(gModMutex);
+		GetFileModMap()[aFileName].mMap.insert(ModStorageMap::value_type(aCounter, ModPointer(aModStorage, aLineNum)));
 	}
-	*/
-}
 
-static ModStorage *CreateFileModsHelper(const char *theFileName)
-{
-	ModStorage *aModStorage = new ModStorage;
-	aModStorage->mChanged = false;
-	/*
-	// Change this thinggie
-	DWORD anOldProtect;
-	VirtualProtect((LPVOID) theFileName, 5, PAGE_READWRITE, &anOldProtect);
-	*((char*) theFileName) = 0;
-	*((ModStorage**) (theFileName+1)) = aModStorage;
-	VirtualProtect((LPVOID) theFileName, 5, anOldProtect, &anOldProtect);
-	*/
 	return aModStorage;
 }
 
-static ModStorage *CreateFileMods(const char *theFileName)
-{
-	if (!gSampleString)
-		gSampleString = theFileName;
-
-	std::string aFileName = theFileName + 15; // skip POPLIB_POPLIBMODVAL
-	ParseModValString(aFileName);
-
-	FileModMap &aMap = GetFileModMap();
-	aMap[aFileName].mHasMods = true;
-
-	return CreateFileModsHelper(theFileName);
-}
-
-int PopLib::ModVal(int theAreaNum, const char *theFileName, int theInt)
+int PopLib::ModVal(ModStorage *theStorage, int theInt)
 {
-	if (*theFileName != 0)
-		CreateFileMods(theFileName);
-
-	ModStorage *aModStorage = *(ModStorage **)(theFileName + 1);
-	if (aModStorage->mChanged)
-		return aModStorage->mInt;
+	const ModValue *aValue = theStorage->mValue.load(std::memory_order_acquire);
+	if (aValue != NULL)
+		return aValue->mInt;
 	else
 		return theInt;
 }
 
-double PopLib::ModVal(int theAreaNum, const char *theFileName, double theDouble)
+double PopLib::ModVal(ModStorage *theStorage, double theDouble)
 {
-	if (*theFileName != 0)
-		CreateFileMods(theFileName);
-
-	ModStorage *aModStorage = *(ModStorage **)(theFileName + 1);
-	if (aModStorage->mChanged)
-		return aModStorage->mDouble;
+	const ModValue *aValue = theStorage->mValue.load(std::memory_order_acquire);
+	if (aValue != NULL)
+		return aValue->mDouble;
 	else
 		return theDouble;
 }
 
-float PopLib::ModVal(int theAreaNum, const char *theFileName, float theFloat)
+float PopLib::ModVal(ModStorage *theStorage, float theFloat)
 {
-	return (float)ModVal(theAreaNum, theFileName, (double)theFloat);
+	return (float)ModVal(theStorage, (double)theFloat);
 }
 
-const char *PopLib::ModVal(int theAreaNum, const char *theFileName, const char *theStr)
+const char *PopLib::ModVal(ModStorage *theStorage, const char *theStr)
 {
-	if (*theFileName != 0)
-		CreateFileMods(theFileName);
-
-	ModStorage *aModStorage = *(ModStorage **)(theFileName + 1);
-	if (aModStorage->mChanged)
-		return aModStorage->mString.c_str();
+	const ModValue *aValue = theStorage->mValue.load(std::memory_order_acquire);
+	if (aValue != NULL)
+		return aValue->mString.c_str();
 	else
 		return theStr;
 }
@@ -443,243 +328,318 @@ static bool ModStringToString(const char *theString, std::string &theStrVal)
 	return true;
 }
 
-bool PopLib::ReparseModValues()
+static bool IsModIdentChar(char theChar)
 {
-	/*
-	if (gLastFileTime == 0)
-	{
-		char anEXEName[256];
-		GetModuleFileNameA(NULL, anEXEName, 256);
-		gLastFileTime = GetFileDate(anEXEName);
+	return isalnum((unsigned char)theChar) || (theChar == '_');
+}
 
-		FindModValsInMemory();
+// Area number of the M() or M1()..M9() whose '(' is at thePos, -1 if it's some other parenthesis
+static int GetModAreaNum(const std::string &theText, size_t thePos)
+{
+	if ((thePos >= 1) && (theText[thePos - 1] == 'M') && ((thePos < 2) || !IsModIdentChar(theText[thePos - 2])))
+		return 0;
+
+	if ((thePos >= 2) && (theText[thePos - 1] >= '1') && (theText[thePos - 1] <= '9') &&
+		(theText[thePos - 2] == 'M') && ((thePos < 3) || !IsModIdentChar(theText[thePos - 3])))
+		return theText[thePos - 1] - '0';
+
+	return -1;
+}
+
+struct ModOccurrence
+{
+	int mLineNum;
+	size_t mPos; // of the value, just past the '('
+};
+
+typedef std::vector<ModOccurrence> ModOccurrenceList;
+
+struct ModEntry
+{
+	int mCounter;
+	ModPointer mPointer;
+};
+
+typedef std::vector<ModEntry> ModEntryList;
+
+// Finds every M() in the file in source order, skipping over strings and comments
+static bool ScanModValFile(const std::string &theFileName, std::string &theText, ModOccurrenceList &theOccurrences,
+						   std::string &theError)
+{
+	std::ifstream aStream(theFileName.c_str(), std::ios::in | std::ios::binary);
+	if (!aStream.is_open())
+	{
+		theError = "Unable to open " + theFileName + " for reparsing.";
+		return false;
 	}
 
-	bool hasNewFiles = false;
-	std::string aFileList;
+	std::stringstream aBuffer;
+	aBuffer << aStream.rdbuf();
+	theText = aBuffer.str();
+	const std::string &aText = theText;
 
-	// Process each file one at a time
-	FileModMap &aMap = GetFileModMap();
-	FileModMap::iterator aFileModItr;
-	for (aFileModItr = aMap.begin(); aFileModItr != aMap.end(); ++aFileModItr)
+	int aLineNum = 1;
+	size_t i = 0;
+	while (i < aText.length())
 	{
-		FileMod &aFileMod = aFileModItr->second;
-		if (!aFileMod.mHasMods)
-			continue;
+		char aChar = aText[i];
+		char aNextChar = (i + 1 < aText.length()) ? aText[i + 1] : 0;
 
-		ModStorageMap &aModMap = aFileMod.mMap;
-		std::string aFileName = aFileModItr->first;
+		if (aChar == '\n')
+			aLineNum++;
+		else if ((aChar == '"') || (aChar == '\'')) // Skip strings
+		{
+			for (i++; (i < aText.length()) && (aText[i] != aChar); i++)
+			{
+				if (aText[i] == '\\')
+				{
+					i++;
+					if ((i < aText.length()) && (aText[i] == '\n')) // continuation
+						aLineNum++;
+				}
+				else if (aText[i] == '\n')
+					break;
+			}
 
-		time_t aThisTime = GetFileDate(aFileName);
-		if (aThisTime > gLastFileTime)
+			if ((i >= aText.length()) || (aText[i] != aChar))
+			{
+				theError = StrFormat("ERROR in %s on line %d: Error parsing quotes", theFileName.c_str(), aLineNum);
+				return false;
+			}
+		}
+		else if ((aChar == '/') && (aNextChar == '/')) // Skip C++ comments
 		{
-			gLastFileTime = aThisTime;
-			hasNewFiles = true;
+			for (i += 2; i < aText.length(); i++)
+			{
+				if (aText[i] == '\n')
+				{
+					if (aText[i - 1] != '\\') // line continuation
+						break;
+					aLineNum++;
+				}
+			}
+			continue;
+		}
+		else if ((aChar == '/') && (aNextChar == '*')) // skip C comments
+		{
+			size_t anEnd = aText.find("*/", i + 2);
+			if (anEnd == std::string::npos)
+			{
+				theError = StrFormat("ERROR in %s on line %d: Error parsing c comment", theFileName.c_str(), aLineNum);
+				return false;
+			}
+
+			aLineNum += (int)std::count(aText.begin() + i, aText.begin() + anEnd, '\n');
+			i = anEnd + 1;
+		}
+		else if ((aChar == '(') && (GetModAreaNum(aText, i) != -1))
+		{
+			ModOccurrence anOccurrence;
+			anOccurrence.mLineNum = aLineNum;
+			anOccurrence.mPos = i + 1;
+			theOccurrences.push_back(anOccurrence);
 		}
 
-		if (aFileList.length() > 0)
-			aFileList += "\n  ";
-		aFileList += aFileName;
+		i++;
+	}
 
-		int aLineNum = 1;
-		int aModNum = 0;
-		ModStorageMap::iterator aModMapItr = aModMap.begin();
+	return true;
+}
 
-		std::fstream aStream(aFileName.c_str(), std::ios::in);
+static bool ParseModValue(const char *theValueStr, ModValue &theValue)
+{
+	theValue.mInt = 0;
+	theValue.mDouble = 0.0;
+
+	if (ModStringToInteger(theValueStr, &theValue.mInt))
+	{
+		theValue.mDouble = theValue.mInt;
+		return true;
+	}
+
+	return ModStringToString(theValueStr, theValue.mString) || ModStringToDouble(theValueStr, &theValue.mDouble);
+}
+
+static bool ModEntryFits(const ModEntry &theEntry, int theBase, const ModOccurrenceList &theOccurrences)
+{
+	int anIndex = theEntry.mCounter - theBase;
+	return (anIndex >= 0) && (anIndex < (int)theOccurrences.size()) &&
+		   (theOccurrences[anIndex].mLineNum == theEntry.mPointer.mLineNum);
+}
+
+// Each M() takes the next __COUNTER__, so in one translation unit a file's M()s have counters in source
+// order, gaps and all, and once one entry is pinned to its M() the rest are found by their offset from it.
+// Counters run on across everything a translation unit includes and a header registers from each one,
+// so whenever the base stops fitting a new one is picked from the M()s on that entry's line, taking
+// whichever fits the most entries after it.  theMatches gets the occurrence for each entry, -1 for none.
+static void MatchModEntries(const ModEntryList &theEntries, const ModOccurrenceList &theOccurrences,
+							std::vector<int> &theMatches)
+{
+	theMatches.assign(theEntries.size(), -1);
 
-		if (aStream.is_open())
+	bool hasBase = false;
+	int aBase = 0;
+	for (size_t i = 0; i < theEntries.size(); i++)
+	{
+		if (!hasBase || !ModEntryFits(theEntries[i], aBase, theOccurrences))
 		{
-			while (!aStream.eof())
+			int aBestRun = -1;
+			for (size_t anOccurrence = 0; anOccurrence < theOccurrences.size(); anOccurrence++)
 			{
-				char aString[8192];
-				aStream.getline(aString, 8192);
+				if (theOccurrences[anOccurrence].mLineNum != theEntries[i].mPointer.mLineNum)
+					continue;
+
+				int aCandidateBase = theEntries[i].mCounter - (int)anOccurrence;
+				int aRun = 0;
+				for (size_t j = i + 1; (j < theEntries.size()) && ModEntryFits(theEntries[j], aCandidateBase, theOccurrences);
+					 j++)
+					aRun++;
 
-				int aCharIdx = 0;
-				int aChar = 0;
-				int aLastChar = 0;
-				while (aString[aCharIdx] != 0)
+				if (aRun > aBestRun)
 				{
-					aLastChar = aChar;
-					aChar = aString[aCharIdx];
-
-					if (aChar == '"')  // Skip strings
-					{
-						while (true)
-						{
-							aLastChar = aChar;
-							aChar = aString[++aCharIdx];
-
-							if (aChar=='\\' && aLastChar=='\\') // so we don't interpret \\" as an escaped quote
-								aChar = 0;
-							else if (aChar=='"' && aLastChar!='\\')
-								break;
-							else if (aChar==0)
-							{
-								if (aLastChar=='\\') // continuation
-								{
-									aCharIdx = -1;
-									aChar = 0;
-									aLastChar = 0;
-									aLineNum++;
-
-									aStream.getline(aString, 8192);
-									if (aString[0]!=0 || !aStream.eof()) // got valid new line
-										continue;
-								}
-
-								char aStr[512];
-								sprintf(aStr, "ERROR in %s on line %d: Error parsing quotes", aFileName.c_str(),
-	aLineNum); MessageBoxA(NULL, aStr, "MODVAL ERROR", MB_OK | MB_ICONERROR); return false;
-							}
-						}
-					}
-					else if (aChar=='/') // Skip C++ comments
-					{
-						if (aLastChar=='/')
-						{
-
-							while (true)
-							{
-								aLastChar = aChar;
-								aChar = aString[++aCharIdx];
-								if (aChar==0) // line continuation
-								{
-									if (aLastChar=='\\') // continuation
-									{
-										aCharIdx = -1;
-										aChar = 0;
-										aLastChar = 0;
-										aLineNum++;
-
-										aStream.getline(aString, 8192);
-										if (aString[0]!=0 || !aStream.eof()) // got valid new line
-											continue;
-									}
-									else
-									{
-										aCharIdx--;
-										break;
-									}
-
-									char aStr[512];
-									sprintf(aStr, "ERROR in %s on line %d: Error parsing c++ comment",
-	aFileName.c_str(), aLineNum); MessageBoxA(NULL, aStr, "MODVAL ERROR", MB_OK | MB_ICONERROR); return false;
-								}
-							}
-						}
-					}
-					else if (aChar=='*') // skip C comments
-					{
-						if (aLastChar=='/')
-						{
-							while (true)
-							{
-								aLastChar = aChar;
-								aChar = aString[++aCharIdx];
-								if (aChar=='/' && aLastChar=='*')
-									break;
-								else if (aChar==0) // line continuation
-								{
-									aCharIdx = -1;
-									aChar = 0;
-									aLastChar = 0;
-									aLineNum++;
-
-									aStream.getline(aString, 8192);
-									if (aString[0]!=0 || !aStream.eof()) // got valid new line
-										continue;
-
-									char aStr[512];
-									sprintf(aStr, "ERROR in %s on line %d: Error parsing c comment", aFileName.c_str(),
-	aLineNum); MessageBoxA(NULL, aStr, "MODVAL ERROR", MB_OK | MB_ICONERROR); return false;
-								}
-							}
-						}
-					}
-					else if (aChar == '(')
-					{
-						int theAreaNum = -1;
-						if ((aCharIdx >= 2) && (aString[aCharIdx-1] == 'M') &&
-							(!isalpha((unsigned char) aString[aCharIdx-2])))
-						{
-							theAreaNum = 0;
-						}
-						else if ((aCharIdx >= 3) &&
-							(aString[aCharIdx-1] >= '1') && (aString[aCharIdx-1] <= '9') &&
-							(aString[aCharIdx-2] == 'M') &&
-							(!isalpha((unsigned char) aString[aCharIdx-3])))
-						{
-							theAreaNum = aString[aCharIdx-1] - '0';
-						}
-
-						if (theAreaNum != -1)
-						{
-							while (aModMapItr!=aModMap.end() && aModMapItr->second.mLineNum<aLineNum)
-								++aModMapItr;
-
-							if (aModMapItr!=aModMap.end() && aModMapItr->second.mLineNum==aLineNum)
-							{
-								const char *aPtr = aModMapItr->second.mStrPtr;
-								aModMapItr++;
-
-								int anIntVal = 0;
-								double aDoubleVal = 0.0;
-								std::string aStrVal;
-
-								// Try to parse out a number
-								if ((ModStringToString(aString + aCharIdx + 1, aStrVal)) ||
-									(ModStringToInteger(aString + aCharIdx + 1, &anIntVal)) ||
-									(ModStringToDouble(aString + aCharIdx + 1, &aDoubleVal)))
-								{
-									// We found a mod value!
-
-									if (*aPtr!=0) // have stored something here
-										CreateFileMods(aPtr);
-
-									ModStorage* aModStorage = *(ModStorage**)(aPtr+1);
-									aModStorage->mInt = anIntVal;
-									aModStorage->mDouble = aDoubleVal;
-									aModStorage->mString = aStrVal;
-									aModStorage->mChanged = true;
-								}
-								else
-								{
-									char aStr[512];
-									sprintf(aStr, "ERROR in %s on line %d.  Parsing Error.", aFileName.c_str(),
-	aLineNum); MessageBoxA(NULL, aStr, "MODVAL ERROR", MB_OK | MB_ICONERROR);
-
-									return false;
-								}
-							}
-							else
-							{
-								// Functions can be optimized out
-							}
-						}
-					}
-
-					aCharIdx++;
+					aBestRun = aRun;
+					aBase = aCandidateBase;
 				}
-
-				aLineNum++;
 			}
+
+			hasBase = (aBestRun >= 0);
+			if (!hasBase)
+				continue;
 		}
-		else
+
+		theMatches[i] = theEntries[i].mCounter - aBase;
+	}
+}
+
+static bool DoReparseModValueFile(const std::string &theFileName, std::string &theError)
+{
+	ModEntryList anEntries;
+	{
+		std::lock_guard<std::mutex> aLock(gModMutex);
+
+		FileModMap &aMap = GetFileModMap();
+		FileModMap::iterator anItr = aMap.find(theFileName);
+		if (anItr == aMap.end())
+			return true;
+
+		for (ModStorageMap::iterator aModItr = anItr->second.mMap.begin(); aModItr != anItr->second.mMap.end();
+			 ++aModItr)
 		{
-			MessageBoxA(NULL, (std::string("ERROR: Unable to open ") + aFileName + " for reparsing.").c_str(), "MODVAL
-	ERROR!", MB_OK | MB_ICONERROR); return false;
+			ModEntry anEntry;
+			anEntry.mCounter = aModItr->first;
+			anEntry.mPointer = aModItr->second;
+			anEntries.push_back(anEntry);
 		}
 	}
 
-	if (!hasNewFiles)
+	std::string aText;
+	ModOccurrenceList anOccurrences;
+	if (!ScanModValFile(theFileName, aText, anOccurrences, theError))
+		return false;
+
+	std::vector<int> aMatches;
+	MatchModEntries(anEntries, anOccurrences, aMatches);
+
+	// Everything is parsed before anything is published so an error leaves all of the old values in place
+	std::map<int, ModValue *> aValues;
+	for (int aMatch : aMatches)
 	{
-		if (aFileList.length() == 0)
-			aFileList = "none";
-		MessageBoxA(NULL, (std::string("WARNING: No file changes detected.  Files parsed: \n  ") + aFileList).c_str(),
-	"MODVAL WARNING!", MB_OK | MB_ICONWARNING); return false;
+		if ((aMatch == -1) || (aValues.count(aMatch) != 0))
+			continue;
+
+		ModValue *aValue = new ModValue;
+		if (!ParseModValue(aText.c_str() + anOccurrences[aMatch].mPos, *aValue))
+		{
+			theError = StrFormat("ERROR in %s on line %d.  Parsing Error.", theFileName.c_str(),
+								 anOccurrences[aMatch].mLineNum);
+			delete aValue;
+			for (std::map<int, ModValue *>::iterator anItr = aValues.begin(); anItr != aValues.end(); ++anItr)
+				delete anItr->second;
+			return false;
+		}
+
+		aValues[aMatch] = aValue;
+	}
+
+	// The old values are left to leak, M() may have handed out their strings
+	std::set<ModValue *> aPublished;
+	for (size_t i = 0; i < anEntries.size(); i++)
+	{
+		if (aMatches[i] == -1)
+			continue;
+
+		ModValue *aValue = aValues[aMatches[i]];
+		ModStorage *aModStorage = anEntries[i].mPointer.mStorage;
+		const ModValue *anOldValue = aModStorage->mValue.load(std::memory_order_acquire);
+		if ((anOldValue != NULL) && (anOldValue->mInt == aValue->mInt) && (anOldValue->mDouble == aValue->mDouble) &&
+			(anOldValue->mString == aValue->mString))
+			continue;
+
+		aModStorage->mValue.store(aValue, std::memory_order_release);
+		aPublished.insert(aValue);
+	}
+
+	for (std::map<int, ModValue *>::iterator anItr = aValues.begin(); anItr != aValues.end(); ++anItr)
+	{
+		if (aPublished.count(anItr->second) == 0)
+			delete anItr->second;
 	}
 
 	return true;
-	*/
+}
+
+bool PopLib::ReparseModValueFile(const std::string &theFileName)
+{
+	std::string anError;
+	if (DoReparseModValueFile(theFileName, anError))
+		return true;
+
+	SDL_Log("MODVAL ERROR: %s", anError.c_str());
 	return false;
 }
+
+void PopLib::GetNewModValFiles(std::vector<std::string> &theFileNames)
+{
+	std::lock_guard<std::mutex> aLock(gModMutex);
+
+	FileModMap &aMap = GetFileModMap();
+	for (FileModMap::iterator anItr = aMap.begin(); anItr != aMap.end(); ++anItr)
+	{
+		if (!anItr->second.mReported)
+		{
+			anItr->second.mReported = true;
+			theFileNames.push_back(anItr->first);
+		}
+	}
+}
+
+bool PopLib::ReparseModValues()
+{
+	std::vector<std::string> aFileNames;
+	{
+		std::lock_guard<std::mutex> aLock(gModMutex);
+
+		FileModMap &aMap = GetFileModMap();
+		for (FileModMap::iterator anItr = aMap.begin(); anItr != aMap.end(); ++anItr)
+			aFileNames.push_back(anItr->first);
+	}
+
+	if (aFileNames.empty())
+	{
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_WARNING, "MODVAL WARNING!",
+								 "WARNING: No file changes detected.  Files parsed: \n  none", NULL);
+		return false;
+	}
+
+	for (const std::string &aFileName : aFileNames)
+	{
+		std::string anError;
+		if (!DoReparseModValueFile(aFileName, anError))
+		{
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "MODVAL ERROR", anError.c_str(), NULL);
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -4,7 +4,9 @@
 #pragma once
 #endif
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 /*
  This module allows for dynamic modification of integer and floating-point
@@ -26,10 +28,13 @@
 	executed within a particular source file, its value will not be
 	updated.
 
+	With AppBase::mHotReload set the source files are watched and each one
+	is reparsed on its own as soon as it is saved.
+
  Performance:
 	There a small setup cost the first time each M() value is accessed
-	after program startup and reparsing, but after that there is just the
-	tiny overhead of a function call and a few vector dereferences.
+	after program startup, but after that each call site keeps its own
+	storage in a static, so it's just a guard check and an atomic load.
 
  */
 
@@ -51,7 +56,12 @@ namespace PopLib
 #define MODVAL_STR_COUNTER2(x, y, z) x #y "," #z
 #define MODVAL_STR_COUNTER1(x, y, z) MODVAL_STR_COUNTER2(x, y, z)
 #define MODVAL_STR_COUNTER(x) MODVAL_STR_COUNTER1(x, __COUNTER__, __LINE__)
-#define M(val) ModVal(0, MODVAL_STR_COUNTER("POPLIB_POPLIBMODVAL"__FILE__), (val))
+#define MODVAL_STORAGE(x)                                                                                              \
+	([]() -> PopLib::ModStorage * {                                                                                    \
+		static PopLib::ModStorage *aModStorage = PopLib::GetModStorage(x);                                             \
+		return aModStorage;                                                                                            \
+	}())
+#define M(val) PopLib::ModVal(MODVAL_STORAGE(MODVAL_STR_COUNTER("POPLIB_POPLIBMODVAL" __FILE__)), (val))
 #define M1(val) M(val)
 #define M2(val) M(val)
 #define M3(val) M(val)
@@ -63,11 +73,24 @@ namespace PopLib
 #define M9(val) M(val)
 #endif
 
-int ModVal(int theAreaNum, const char *theFileName, int theInt);
-double ModVal(int theAreaNum, const char *theFileName, double theDouble);
-float ModVal(int theAreaNum, const char *theFileName, float theFloat);
-const char *ModVal(int theAreaNum, const char *theFileName, const char *theStr);
+struct ModValue;
+
+// One per M() call site.  A reparse publishes a whole new value, old ones are never freed since
+// M() may have handed out their strings.
+struct ModStorage
+{
+	std::atomic<const ModValue *> mValue; // NULL until a reparse has given it one
+};
+
+ModStorage *GetModStorage(const char *theModString); // registers a call site, M() calls it once for each
+
+int ModVal(ModStorage *theStorage, int theInt);
+double ModVal(ModStorage *theStorage, double theDouble);
+float ModVal(ModStorage *theStorage, float theFloat);
+const char *ModVal(ModStorage *theStorage, const char *theStr);
 bool ReparseModValues();
+bool ReparseModValueFile(const std::string &theFileName); // just the M()s in this one source file
+void GetNewModValFiles(std::vector<std::string> &theFileNames); // source files with M()s seen since the last call
 void AddModValEnum(const std::string &theEnumName, int theVal);
 
 } // namespace PopLib
@@ -2,20 +2,83 @@
 #include "debug/debug.hpp"
 #include "paklib/pakinterface.hpp"
 
+#include <cstring>
+
 using namespace PopLib;
 
+static inline bool IsXMLWhitespace(char c)
+{
+	return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+static inline bool IsXMLNameEnd(char c)
+{
+	return IsXMLWhitespace(c) || (c == '/') || (c == '>') || (c == '=');
+}
+
+static std::string_view TrimWhitespace(const char *theStart, const char *theEnd)
+{
+	while ((theStart < theEnd) && (IsXMLWhitespace(*theStart)))
+		theStart++;
+	while ((theEnd > theStart) && (IsXMLWhitespace(theEnd[-1])))
+		theEnd--;
+	return std::string_view(theStart, theEnd - theStart);
+}
+
+static std::string DecodeView(std::string_view theView, bool needsDecode)
+{
+	if (!needsDecode)
+		return std::string(theView);
+	return XMLDecodeString(std::string(theView));
+}
+
+std::string XMLAttributeView::GetValue() const
+{
+	return DecodeView(mValue, mNeedsDecode);
+}
+
+XMLNodeView::XMLNodeView()
+{
+	mType = XMLElement::TYPE_NONE;
+	mValueNeedsDecode = false;
+}
+
+const XMLAttributeView *XMLNodeView::FindAttribute(std::string_view theKey) const
+{
+	// Later duplicates win, same as they do in XMLElement::mAttributes
+	for (int i = (int)mAttributes.size() - 1; i >= 0; i--)
+	{
+		if (mAttributes[i].mKey == theKey)
+			return &mAttributes[i];
+	}
+	return nullptr;
+}
+
+bool XMLNodeView::GetAttribute(std::string_view theKey, std::string &theValue) const
+{
+	const XMLAttributeView *anAttribute = FindAttribute(theKey);
+	if (anAttribute == nullptr)
+		return false;
+
+	theValue = anAttribute->GetValue();
+	return true;
+}
+
+std::string XMLNodeView::GetValue() const
+{
+	return DecodeView(mValue, mValueNeedsDecode);
+}
+
 XMLParser::XMLParser()
 {
-	mFile = NULL;
-	mLineNum = 0;
-	mCurrentNode = nullptr;
-	mFirstStart = true;
+	mData = nullptr;
+	mPos = nullptr;
+	mEnd = nullptr;
+	Init();
 }
 
 XMLParser::~XMLParser()
 {
-	if (mFile != NULL)
-		p_fclose(mFile);
 }
 
 void XMLParser::Fail(const PopString &theErrorText)
@@ -26,17 +89,21 @@ void XMLParser::Fail(const PopString &theErrorText)
 
 void XMLParser::Init()
 {
-    mLineNum = 1;
-    mHasFailed  = false;
-    mCurrentNode = nullptr;
-    mSectionStack.clear();
+	mLineNum = 1;
+	mHasFailed = false;
+	mNodeStart = mPos;
+	mLineNumPos = mPos;
+
+	mSectionPath.clear();
+	mSectionLengths.clear();
+	mOpenTags.clear();
+	mHasPendingEnd = false;
+	mPopPending = false;
+	mCustomRootState = 0;
 }
 
 bool XMLParser::AddAttribute(XMLElement *theElement, const PopString &theAttributeKey, const PopString &theAttributeValue)
 {
-    if (theAttributeValue == "SUNFLOWER_HEAD_SING1")
-        int asd = 2;
-
 	std::pair<XMLParamMap::iterator, bool> aRet;
 
 	aRet = theElement->mAttributes.insert(XMLParamMap::value_type(theAttributeKey, theAttributeValue));
@@ -49,237 +116,398 @@ bool XMLParser::AddAttribute(XMLElement *theElement, const PopString &theAttribu
 	return aRet.second;
 }
 
-bool XMLParser::OpenBuffer(const std::string &theBuffer, const std::string &custom_root)
+bool XMLParser::Open(const char *theData, size_t theSize, const std::string &theCustomRoot)
 {
-	mCurrentNode = nullptr;
-	mSectionStack.clear();
-	mEndPending.clear();
-	mHasFailed = false;
+	mData = theData;
+	mPos = theData;
+	mEnd = theData + theSize;
 
+	// UTF-8 BOM
+	if ((theSize >= 3) && ((uchar)theData[0] == 0xEF) && ((uchar)theData[1] == 0xBB) && ((uchar)theData[2] == 0xBF))
+		mPos += 3;
+
+	Init();
+
+	// Wrap everything after the declaration in <custom_root>, for files with more than one top level element
+	mCustomRoot = theCustomRoot;
+	if (!mCustomRoot.empty())
+		mCustomRootState = 1;
 
-    // UTF-8 stuff
-    std::string input = theBuffer;
-    if (input.size() >= 3 &&
-        (unsigned char)input[0] == 0xEF &&
-        (unsigned char)input[1] == 0xBB &&
-        (unsigned char)input[2] == 0xBF)
-    {
-        input = input.substr(3);
-    }
-
-    std::string aNewWrappedBuffer;
-
-    if (custom_root != "")
-    {
-        // get the declaration so we dont add the custom root before it
-        std::string xmlDecl;
-        if (input.find("<?xml") == 0)
-        {
-            size_t declEnd = input.find("?>");
-            if (declEnd != std::string::npos)
-            {
-                declEnd += 2;
-                xmlDecl = input.substr(0, declEnd);
-                input = input.substr(declEnd);  // remove declaration from the main content
-            }
-        }
-
-        // Wrap with custom root
-        aNewWrappedBuffer = xmlDecl + "<" + custom_root + ">" + input + "</" + custom_root + ">";
-    }
-    else
-        aNewWrappedBuffer = input;
-
-    const char* data = aNewWrappedBuffer.c_str();
-    size_t size = aNewWrappedBuffer.size();
-
-    mDocument = new XMLDocument();
-	XMLError err = mDocument->Parse(data, size);
-	if (err != XML_SUCCESS) { 
-		std::string anError = mDocument->ErrorStr();
-		Fail("Parse error: " + anError); 
-		return false;
-	}
 	return true;
 }
 
+bool XMLParser::OpenBuffer(const std::string &theBuffer, const std::string &custom_root)
+{
+	mFileName.clear();
+	mBuffer.assign(theBuffer.begin(), theBuffer.end());
+	return Open(mBuffer.data(), mBuffer.size(), custom_root);
+}
+
 bool XMLParser::OpenFile(const std::string &theFileName, const std::string &custom_root)
 {
-	mFile = p_fopen(theFileName.c_str(), "r");
+	mFileName = theFileName;
+	mBuffer.clear();
 
-	if (mFile == NULL)
+	PFILE *aFile = p_fopen(theFileName.c_str(), "rb");
+	if (aFile == NULL)
 	{
+		mData = mPos = mEnd = nullptr;
+		Init();
 		mLineNum = 0;
 		Fail("Unable to open file " + theFileName);
 		return false;
 	}
 
-	p_fseek(mFile, 0, SEEK_END);
-	long size = p_ftell(mFile);
-	p_fseek(mFile, 0, SEEK_SET);
+	// Pak files are already in memory and stay there, so they can be parsed where they are
+	if (aFile->mRecord != nullptr)
+	{
+		PakRecord *aRecord = aFile->mRecord;
+		p_fclose(aFile);
+		return Open((const char *)aRecord->mCollection->data() + aRecord->mStartPos, aRecord->mSize, custom_root);
+	}
+
+	p_fseek(aFile, 0, SEEK_END);
+	long aSize = p_ftell(aFile);
+	p_fseek(aFile, 0, SEEK_SET);
+
+	if (aSize > 0)
+	{
+		mBuffer.resize(aSize);
+		mBuffer.resize(p_fread(mBuffer.data(), 1, aSize, aFile));
+	}
+	p_fclose(aFile);
 
-	if (size <= 0)
+	if (mBuffer.empty())
 	{
-		p_fclose(mFile);
+		mData = mPos = mEnd = nullptr;
+		Init();
 		Fail("Empty or unreadable file: " + theFileName);
 		return false;
 	}
 
-	std::string content(size, '\0');
-	p_fread(content.data(), size, 1, mFile);
+	return Open(mBuffer.data(), mBuffer.size(), custom_root);
+}
+
+void XMLParser::PushSection(std::string_view theName)
+{
+	mSectionLengths.push_back(mSectionPath.length());
+	if (!mSectionPath.empty())
+		mSectionPath += '/';
+	mSectionPath.append(theName.data(), theName.length());
+	mOpenTags.push_back(theName);
+}
+
+void XMLParser::SkipWhitespace()
+{
+	while ((mPos < mEnd) && (IsXMLWhitespace(*mPos)))
+		mPos++;
+}
+
+bool XMLParser::ParseTag(XMLNodeView &theNode)
+{
+	// mPos is just past the '<'
+	const char *aNameStart = mPos;
+	while ((mPos < mEnd) && (!IsXMLNameEnd(*mPos)))
+		mPos++;
+
+	std::string_view aName(aNameStart, mPos - aNameStart);
+	if (aName.empty())
+	{
+		Fail("Expecting element name");
+		return false;
+	}
+
+	bool isClosed = false;
+	for (;;)
+	{
+		SkipWhitespace();
+		if (mPos >= mEnd)
+		{
+			Fail("Unexpected end of file in <" + std::string(aName) + ">");
+			return false;
+		}
+
+		if (*mPos == '>')
+		{
+			mPos++;
+			break;
+		}
+
+		if (*mPos == '/')
+		{
+			if ((mPos + 1 >= mEnd) || (mPos[1] != '>'))
+			{
+				Fail("Expecting '>' after '/' in <" + std::string(aName) + ">");
+				return false;
+			}
+			mPos += 2;
+			isClosed = true;
+			break;
+		}
+
+		const char *aKeyStart = mPos;
+		while ((mPos < mEnd) && (!IsXMLNameEnd(*mPos)))
+			mPos++;
+		std::string_view aKey(aKeyStart, mPos - aKeyStart);
+
+		SkipWhitespace();
+		if ((aKey.empty()) || (mPos >= mEnd) || (*mPos != '='))
+		{
+			Fail("Expecting '=' after attribute '" + std::string(aKey) + "'");
+			return false;
+		}
+		mPos++;
+		SkipWhitespace();
+
+		if ((mPos >= mEnd) || ((*mPos != '"') && (*mPos != '\'')))
+		{
+			Fail("Expecting quoted value for attribute '" + std::string(aKey) + "'");
+			return false;
+		}
+
+		char aQuote = *mPos++;
+		const char *aValueEnd = (const char *)memchr(mPos, aQuote, mEnd - mPos);
+		if (aValueEnd == nullptr)
+		{
+			Fail("Unterminated value for attribute '" + std::string(aKey) + "'");
+			return false;
+		}
+
+		XMLAttributeView anAttribute;
+		anAttribute.mKey = aKey;
+		anAttribute.mValue = std::string_view(mPos, aValueEnd - mPos);
+		anAttribute.mNeedsDecode = anAttribute.mValue.find('&') != std::string_view::npos;
+		theNode.mAttributes.push_back(anAttribute);
+
+		mPos = aValueEnd + 1;
+	}
+
+	PushSection(aName);
+
+	theNode.mType = XMLElement::TYPE_START;
+	theNode.mValue = aName;
+	theNode.mSection = mSectionPath;
+
+	if (isClosed)
+	{
+		mPendingEnd = aName;
+		mHasPendingEnd = true;
+	}
 
-    OpenBuffer(content, custom_root);
 	return true;
 }
 
+bool XMLParser::NextNode(XMLNodeView &theNode)
+{
+	theNode.mType = XMLElement::TYPE_NONE;
+	theNode.mSection = std::string_view();
+	theNode.mValue = std::string_view();
+	theNode.mValueNeedsDecode = false;
+	theNode.mAttributes.clear();
+
+	if ((mHasFailed) || (mData == nullptr))
+		return false;
+
+	if (mPopPending)
+	{
+		mSectionPath.resize(mSectionLengths.back());
+		mSectionLengths.pop_back();
+		mOpenTags.pop_back();
+		mPopPending = false;
+	}
+
+	if (mHasPendingEnd)
+	{
+		theNode.mType = XMLElement::TYPE_END;
+		theNode.mValue = mPendingEnd;
+		theNode.mSection = mSectionPath;
+		mHasPendingEnd = false;
+		mPopPending = true;
+		return true;
+	}
+
+	for (;;)
+	{
+		if (mCustomRootState == 1)
+		{
+			SkipWhitespace();
+			if ((mEnd - mPos < 2) || (memcmp(mPos, "<?", 2) != 0))
+			{
+				mCustomRootState = 2;
+				PushSection(mCustomRoot);
+				theNode.mType = XMLElement::TYPE_START;
+				theNode.mValue = mCustomRoot;
+				theNode.mSection = mSectionPath;
+				return true;
+			}
+		}
+
+		mNodeStart = mPos;
+
+		const char *aTextEnd = (const char *)memchr(mPos, '<', mEnd - mPos);
+		if (aTextEnd == nullptr)
+			aTextEnd = mEnd;
+
+		std::string_view aText = TrimWhitespace(mPos, aTextEnd);
+		mPos = aTextEnd;
+		if (!aText.empty())
+		{
+			theNode.mType = XMLElement::TYPE_ELEMENT;
+			theNode.mValue = aText;
+			theNode.mValueNeedsDecode = aText.find('&') != std::string_view::npos;
+			theNode.mSection = mSectionPath;
+			return true;
+		}
+
+		if (mPos >= mEnd)
+		{
+			if (mCustomRootState == 2)
+			{
+				mCustomRootState = 3;
+				theNode.mType = XMLElement::TYPE_END;
+				theNode.mValue = mCustomRoot;
+				theNode.mSection = mSectionPath;
+				mPopPending = true;
+				return true;
+			}
+
+			if (!mOpenTags.empty())
+				Fail("Unexpected end of file, expecting </" + std::string(mOpenTags.back()) + ">");
+			return false;
+		}
+
+		mNodeStart = mPos;
+		std::string_view aRest(mPos, mEnd - mPos);
+
+		if (aRest.compare(0, 4, "<!--") == 0)
+		{
+			size_t anEndPos = aRest.find("-->", 4);
+			if (anEndPos == std::string_view::npos)
+			{
+				Fail("Unterminated comment");
+				return false;
+			}
+
+			theNode.mType = XMLElement::TYPE_COMMENT;
+			theNode.mValue = aRest.substr(4, anEndPos - 4);
+			theNode.mSection = mSectionPath;
+			mPos += anEndPos + 3;
+			return true;
+		}
+		else if (aRest.compare(0, 9, "<![CDATA[") == 0)
+		{
+			size_t anEndPos = aRest.find("]]>", 9);
+			if (anEndPos == std::string_view::npos)
+			{
+				Fail("Unterminated CDATA section");
+				return false;
+			}
+
+			mPos += anEndPos + 3;
+			if (anEndPos == 9)
+				continue;
+
+			theNode.mType = XMLElement::TYPE_ELEMENT;
+			theNode.mValue = aRest.substr(9, anEndPos - 9);
+			theNode.mSection = mSectionPath;
+			return true;
+		}
+		else if (aRest.compare(0, 2, "<!") == 0)
+		{
+			// <!DOCTYPE ...>, nothing we use
+			size_t anEndPos = aRest.find('>');
+			if (anEndPos == std::string_view::npos)
+			{
+				Fail("Unterminated declaration");
+				return false;
+			}
+			mPos += anEndPos + 1;
+			continue;
+		}
+		else if (aRest.compare(0, 2, "<?") == 0)
+		{
+			size_t anEndPos = aRest.find("?>", 2);
+			if (anEndPos == std::string_view::npos)
+			{
+				Fail("Unterminated processing instruction");
+				return false;
+			}
+
+			theNode.mType = XMLElement::TYPE_INSTRUCTION;
+			theNode.mValue = TrimWhitespace(mPos + 2, mPos + anEndPos);
+			theNode.mSection = mSectionPath;
+			mPos += anEndPos + 2;
+			return true;
+		}
+		else if (aRest.compare(0, 2, "</") == 0)
+		{
+			size_t anEndPos = aRest.find('>');
+			if (anEndPos == std::string_view::npos)
+			{
+				Fail("Unterminated end tag");
+				return false;
+			}
+
+			std::string_view aName = TrimWhitespace(mPos + 2, mPos + anEndPos);
+			if ((mOpenTags.empty()) || (mOpenTags.back() != aName) || (mCustomRootState == 2 && mOpenTags.size() == 1))
+			{
+				Fail("Unexpected </" + std::string(aName) + ">");
+				return false;
+			}
+
+			theNode.mType = XMLElement::TYPE_END;
+			theNode.mValue = aName;
+			theNode.mSection = mSectionPath;
+			mPos += anEndPos + 1;
+			mPopPending = true;
+			return true;
+		}
+
+		mPos++;
+		if (!ParseTag(theNode))
+		{
+			theNode.mAttributes.clear();
+			return false;
+		}
+		return true;
+	}
+}
+
 bool XMLParser::NextElement(XMLElement *theElement)
 {
+	theElement->mAttributes.clear();
+	theElement->mAttributeIteratorList.clear();
+	theElement->mInstruction.clear();
+	theElement->mValue.clear();
+	theElement->mSection.clear();
 
-    theElement->mAttributes.clear();
-    theElement->mInstruction.clear();
-    theElement->mValue.clear();
-    theElement->mSection.clear();
-
-
-    if (!mEndPending.empty())
-    {
-        theElement->mType = XMLElement::TYPE_END;
-        theElement->mValue = mEndPending.back();
-        theElement->mSection = mSectionStack.back();
-        mEndPending.pop_back();
-        mSectionStack.pop_back();
-        return true;
-    }
-
-	while (!mNodeStack.empty() && mCurrentNode == nullptr)
-    {
-        XMLNode* parent = mNodeStack.back();
-        mNodeStack.pop_back();
-
-        theElement->mType = XMLElement::TYPE_END;
-        theElement->mValue = parent->ToElement()->Name();
-        theElement->mSection = mSectionStack.back();
-        mSectionStack.pop_back();
-
-        if (mSectionStack.empty())
-            return false; //We left the root?
-
-        mCurrentNode = parent->NextSibling();
-        while (mCurrentNode &&
-            !mCurrentNode->ToElement() &&
-            !mCurrentNode->ToComment() &&
-            !mCurrentNode->ToDeclaration())
-        {
-            mCurrentNode = mCurrentNode->NextSibling();
-        }
-		if (mCurrentNode)
-			mLineNum = mCurrentNode->GetLineNum();
-        return true;
-    }
-
-	if (!mCurrentNode && mFirstStart)
-    {
-        mCurrentNode = mDocument->FirstChild();
-        mFirstStart = false;
-    }
-    else if (!mCurrentNode && !mFirstStart)
-    {
-        // No more nodes to process, end of document reached
-        return false;
-    }
-
-    while (mCurrentNode &&
-           !mCurrentNode->ToElement() &&
-           !mCurrentNode->ToComment() &&
-           !mCurrentNode->ToDeclaration())
-    {
-        mCurrentNode = mCurrentNode->NextSibling();
-    }
-
-  	if (!mCurrentNode)
-        return false;
-
-    if (auto com = mCurrentNode->ToComment()) // Comments
-    {
-        theElement->mType = XMLElement::TYPE_COMMENT;
-        theElement->mInstruction = com->Value();
-        mCurrentNode = mCurrentNode->NextSibling();
-        return true;
-    }
-    else if (auto decl = mCurrentNode->ToDeclaration()) // XML declaration / PI
-    {
-        theElement->mType        = XMLElement::TYPE_INSTRUCTION;
-        theElement->mInstruction = decl->Value();
-		mCurrentNode = mCurrentNode->NextSibling();
-        return true;
-    }
-    else if (auto elem = mCurrentNode->ToElement()) // Element start
-    {
-        auto closeType = elem->ClosingType();
-
-        if (closeType == tinyxml2::XMLElement::OPEN)
-        {
-            // Start tag <tag>
-            theElement->mType = XMLElement::TYPE_START;
-            theElement->mValue = elem->Name();
-
-            if (mSectionStack.empty())
-                mSectionStack.push_back(elem->Name());
-            else
-                mSectionStack.push_back(mSectionStack.back() + "/" + elem->Name());
-            theElement->mSection = mSectionStack.back();
-
-            for (auto attr = elem->FirstAttribute(); attr; attr = attr->Next())
-                AddAttribute(theElement, attr->Name(), attr->Value());
-
-            mCurrentNode = elem->FirstChild();
-            mNodeStack.push_back(elem);
-
-            return true;
-        }
-        else if (closeType == tinyxml2::XMLElement::CLOSED)
-        {
-            // Self-closing tag <tag />
-            // Emit START event now
-            theElement->mType = XMLElement::TYPE_START;
-            theElement->mValue = elem->Name();
-
-            if (mSectionStack.empty())
-                mSectionStack.push_back(elem->Name());
-            else
-                mSectionStack.push_back(mSectionStack.back() + "/" + elem->Name());
-            theElement->mSection = mSectionStack.back();
-
-            for (auto attr = elem->FirstAttribute(); attr; attr = attr->Next())
-                AddAttribute(theElement, attr->Name(), attr->Value());
-
-            // Immediately emit the END event for the same element on next call
-            mEndPending.push_back(elem->Name());
-
-            mCurrentNode = mCurrentNode->NextSibling();
-
-            return true;
-        }
-        else if (closeType == tinyxml2::XMLElement::CLOSING)
-        {
-            // This means an end tag node (</tag>) - normally tinyxml2 skips these as separate nodes,
-            // but if you get here, emit END event.
-
-            theElement->mType = XMLElement::TYPE_END;
-            theElement->mValue = elem->Name();
-
-            if (!mSectionStack.empty())
-                mSectionStack.pop_back();
-
-            theElement->mSection = mSectionStack.empty() ? "" : mSectionStack.back();
-
-            mCurrentNode = mCurrentNode->NextSibling();
-
-            return true;
-        }
-    }
-
-	return false;
+	if (!NextNode(mNode))
+		return false;
+
+	GetElement(mNode, theElement);
+	return true;
+}
+
+void XMLParser::GetElement(const XMLNodeView &theNode, XMLElement *theElement)
+{
+	theElement->mAttributes.clear();
+	theElement->mAttributeIteratorList.clear();
+	theElement->mInstruction.clear();
+	theElement->mValue.clear();
+
+	theElement->mType = theNode.mType;
+	theElement->mSection.assign(theNode.mSection.data(), theNode.mSection.length());
+
+	if ((theNode.mType == XMLElement::TYPE_COMMENT) || (theNode.mType == XMLElement::TYPE_INSTRUCTION))
+		theElement->mInstruction.assign(theNode.mValue.data(), theNode.mValue.length());
+	else
+		theElement->mValue = theNode.GetValue();
+
+	for (int i = 0; i < (int)theNode.mAttributes.size(); i++)
+	{
+		const XMLAttributeView &anAttribute = theNode.mAttributes[i];
+		AddAttribute(theElement, PopString(anAttribute.mKey), anAttribute.GetValue());
+	}
 }
 
 bool XMLParser::HasFailed()
@@ -294,10 +522,21 @@ PopString XMLParser::GetErrorText()
 
 int XMLParser::GetCurrentLineNum()
 {
+	// Counted on demand, most files are parsed without ever asking
+	if ((mNodeStart != nullptr) && (mNodeStart > mLineNumPos))
+	{
+		for (const char *aPos = mLineNumPos; aPos < mNodeStart; aPos++)
+		{
+			if (*aPos == '\n')
+				mLineNum++;
+		}
+		mLineNumPos = mNodeStart;
+	}
+
 	return mLineNum;
 }
 
 std::string XMLParser::GetFileName()
 {
 	return mFileName;
-}
\ No newline at end of file
+}
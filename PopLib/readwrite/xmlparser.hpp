@@ -6,10 +6,7 @@
 
 #include "common.hpp"
 #include "debug/perftimer.hpp"
-#include <tinyxml2.h>
-
-using namespace tinyxml2;
-struct PFILE;
+#include <string_view>
 
 namespace PopLib
 {
@@ -48,32 +45,72 @@ class XMLElement
 	XMLParamMapIteratorList mAttributeIteratorList; // stores attribute iterators in their original order
 };
 
+// Attribute of the node last returned by XMLParser::NextNode, pointing straight into the parser's buffer
+struct XMLAttributeView
+{
+	std::string_view mKey;
+	std::string_view mValue; // still has its entities when mNeedsDecode is set
+	bool mNeedsDecode;
+
+	std::string GetValue() const;
+};
+
+typedef std::vector<XMLAttributeView> XMLAttributeViewList;
+
+// Node returned by XMLParser::NextNode.  Nothing is copied out of the file, so the views are only
+// good until the next NextNode call.  Reusing the same node keeps the attribute list's storage.
+class XMLNodeView
+{
+  public:
+	int mType; // XMLElement::TYPE_*
+	std::string_view mSection;
+	std::string_view mValue; // tag name, text, comment or instruction
+	bool mValueNeedsDecode;
+	XMLAttributeViewList mAttributes; // in document order
+
+  public:
+	XMLNodeView();
+
+	const XMLAttributeView *FindAttribute(std::string_view theKey) const;
+	bool GetAttribute(std::string_view theKey, std::string &theValue) const;
+	std::string GetValue() const;
+};
+
 class XMLParser
 {
   protected:
 	std::string mFileName;
 	PopString mErrorText;
 	int mLineNum;
-	PFILE *mFile;
 	bool mHasFailed;
-	bool mFirstChar;
-	bool mByteSwap;
-    XMLDocument* mDocument;
-    XMLNode* mCurrentNode;
-	/// @brief current elements
-	std::vector<PopString> mSectionStack;
-	/// @brief names of elements that await TYPE_END
-	std::vector<PopString> mEndPending;
-	
-	/// @brief the processed children
-	std::vector<PopString> mProcessedChildren;
-	/// @brief stack of parent elements
-	std::vector<XMLNode*> mNodeStack;
-	bool mFirstStart;
+
+	std::vector<char> mBuffer; // loose files and OpenBuffer, pak files are parsed in place
+	const char *mData;
+	const char *mPos;
+	const char *mEnd;
+	const char *mNodeStart;
+	const char *mLineNumPos; // mLineNum is counted up to here
+
+	std::string mSectionPath;
+	std::vector<size_t> mSectionLengths;
+	std::vector<std::string_view> mOpenTags;
+	std::string_view mPendingEnd; // self closing tag still to report the end of
+	bool mHasPendingEnd;
+	bool mPopPending; // the last node was an end, leave its section until the next call
+
+	std::string mCustomRoot;
+	int mCustomRootState;
+
+	XMLNodeView mNode; // for NextElement
 
   protected:
 	void Fail(const PopString &theErrorText);
 	void Init();
+	bool Open(const char *theData, size_t theSize, const std::string &theCustomRoot);
+
+	void PushSection(std::string_view theName);
+	void SkipWhitespace();
+	bool ParseTag(XMLNodeView &theNode);
 
 	bool AddAttribute(XMLElement *theElement, const PopString &aAttributeKey, const PopString &aAttributeValue);
 
@@ -83,7 +120,9 @@ class XMLParser
 
 	bool OpenFile(const std::string &theFilename, const std::string &custom_root = "");
 	bool OpenBuffer(const std::string &theBuffer, const std::string &custom_root = "");
+	bool NextNode(XMLNodeView &theNode);
 	bool NextElement(XMLElement *theElement);
+	void GetElement(const XMLNodeView &theNode, XMLElement *theElement); // copies a node out to keep
 	PopString GetErrorText();
 	int GetCurrentLineNum();
 	std::string GetFileName();
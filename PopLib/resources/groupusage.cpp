@@ -0,0 +1,120 @@
+#include "groupusage.hpp"
+#include "appbase.hpp"
+#include "misc/buffer.hpp"
+
+using namespace PopLib;
+
+// Counts are halved once one of them gets this big, so the ordering keeps up if the game changes
+static const int MAX_TRANSITION_COUNT = 1024;
+
+GroupUsage::GroupUsage()
+{
+	mLoaded = false;
+	mDirty = false;
+}
+
+const std::string &GroupUsage::GetFileName()
+{
+	if (mFileName.empty())
+		mFileName = gAppBase->GetCacheFolder() + "groupusage.dat";
+
+	return mFileName;
+}
+
+void GroupUsage::GroupRequested(const std::string &theGroup)
+{
+	if (!mLoaded)
+		Load();
+
+	if ((!mLastGroup.empty()) && (stricmp(mLastGroup.c_str(), theGroup.c_str()) != 0))
+	{
+		NextGroupMap &aNextGroups = mTransitions[mLastGroup];
+		if (++aNextGroups[theGroup] >= MAX_TRANSITION_COUNT)
+		{
+			for (NextGroupMap::iterator anItr = aNextGroups.begin(); anItr != aNextGroups.end(); ++anItr)
+				anItr->second /= 2;
+		}
+
+		mDirty = true;
+	}
+
+	mLastGroup = theGroup;
+}
+
+std::string GroupUsage::PredictNext(const std::string &theGroup)
+{
+	if (!mLoaded)
+		Load();
+
+	TransitionMap::iterator aTransitionItr = mTransitions.find(theGroup);
+	if (aTransitionItr == mTransitions.end())
+		return "";
+
+	std::string aBestGroup;
+	int aBestCount = 0;
+	for (NextGroupMap::iterator anItr = aTransitionItr->second.begin(); anItr != aTransitionItr->second.end(); ++anItr)
+	{
+		if (anItr->second > aBestCount)
+		{
+			aBestGroup = anItr->first;
+			aBestCount = anItr->second;
+		}
+	}
+
+	return aBestGroup;
+}
+
+bool GroupUsage::Load()
+{
+	mLoaded = true;
+	mTransitions.clear();
+
+	Buffer aFile;
+	if ((!gAppBase->ReadBufferFromFile(GetFileName(), &aFile)) || (aFile.GetDataLen() < 12))
+		return false;
+
+	uchar aMagic[4];
+	aFile.ReadBytes(aMagic, 4);
+	if ((memcmp(aMagic, "PGRP", 4) != 0) || ((ulong)aFile.ReadLong() != GROUPUSAGE_VERSION))
+		return false;
+
+	int aNumGroups = aFile.ReadLong();
+	for (int i = 0; (i < aNumGroups) && (!aFile.AtEnd()); i++)
+	{
+		NextGroupMap &aNextGroups = mTransitions[aFile.ReadString()];
+		int aNumNextGroups = aFile.ReadLong();
+		for (int j = 0; (j < aNumNextGroups) && (!aFile.AtEnd()); j++)
+		{
+			std::string aNextGroup = aFile.ReadString();
+			aNextGroups[aNextGroup] = aFile.ReadLong();
+		}
+	}
+
+	return true;
+}
+
+bool GroupUsage::Save()
+{
+	Buffer aFile;
+	aFile.WriteBytes((const uchar *)"PGRP", 4);
+	aFile.WriteLong(GROUPUSAGE_VERSION);
+	aFile.WriteLong((long)mTransitions.size());
+	for (TransitionMap::iterator aTransitionItr = mTransitions.begin(); aTransitionItr != mTransitions.end();
+		 ++aTransitionItr)
+	{
+		aFile.WriteString(aTransitionItr->first);
+		aFile.WriteLong((long)aTransitionItr->second.size());
+		for (NextGroupMap::iterator anItr = aTransitionItr->second.begin(); anItr != aTransitionItr->second.end();
+			 ++anItr)
+		{
+			aFile.WriteString(anItr->first);
+			aFile.WriteLong(anItr->second);
+		}
+	}
+
+	if (!gAppBase->WriteBufferToFileAtomic(GetFileName(), &aFile))
+		return false;
+
+	mDirty = false;
+	return true;
+}
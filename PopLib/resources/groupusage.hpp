@@ -0,0 +1,43 @@
+#ifndef __GROUPUSAGE_HPP__
+#define __GROUPUSAGE_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+
+namespace PopLib
+{
+
+const uint32_t GROUPUSAGE_VERSION = 1;
+
+// Learns which resource group usually gets loaded after which, over every run of the game, so the
+// ResourceManager can guess what to prefetch.  Kept as a count per pair of groups in a row.
+class GroupUsage
+{
+  public:
+	typedef std::map<std::string, int, StringLessNoCase> NextGroupMap;
+	typedef std::map<std::string, NextGroupMap, StringLessNoCase> TransitionMap;
+
+	TransitionMap mTransitions;
+	std::string mLastGroup;
+	std::string mFileName;
+	bool mLoaded;
+	bool mDirty; // changed since the last Save, which only happens when the ResourceManager goes away
+
+  protected:
+	const std::string &GetFileName();
+
+  public:
+	GroupUsage();
+
+	void GroupRequested(const std::string &theGroup);
+	std::string PredictNext(const std::string &theGroup); // empty if nothing has followed it yet
+
+	bool Load();
+	bool Save();
+};
+
+} // namespace PopLib
+
+#endif
@@ -0,0 +1,272 @@
+#include "imagecache.hpp"
+#include "appbase.hpp"
+#include "graphics/memoryimage.hpp"
+#include "paklib/pakinterface.hpp"
+#include "misc/buffer.hpp"
+#include "misc/mappedfile.hpp"
+
+#include <filesystem>
+#include <zlib.h>
+
+using namespace PopLib;
+
+ImageCache::ImageCache()
+{
+	mEnabled = true;
+	mCompress = false;
+
+	mHits = 0;
+	mMisses = 0;
+	mStores = 0;
+}
+
+ImageCache::~ImageCache()
+{
+}
+
+// Worked out on first use, since the ResourceManager is made before the app has read its registry key
+const std::string &ImageCache::GetCacheDir()
+{
+	std::call_once(mCacheDirOnce, [this]() {
+		if (mCacheDir.empty())
+			mCacheDir = gAppBase->GetCacheFolder() + "images/";
+	});
+
+	return mCacheDir;
+}
+
+// Keys are file paths, which don't care about case, so they're upper-cased before being hashed or compared
+std::string ImageCache::GetCacheFileName(const std::string &theKey)
+{
+	// FNV-1a
+	uint64_t aHash = 0xCBF29CE484222325ULL;
+	for (size_t i = 0; i < theKey.length(); i++)
+	{
+		aHash ^= (uchar)theKey[i];
+		aHash *= 0x100000001B3ULL;
+	}
+
+	return GetCacheDir() + StrFormat("%016llx.img", (unsigned long long)aHash);
+}
+
+void ImageCache::GetSources(const std::vector<std::string> &theSourceFiles, std::vector<ImageCacheSource> &theSources)
+{
+	theSources.resize(theSourceFiles.size());
+
+	for (size_t i = 0; i < theSourceFiles.size(); i++)
+	{
+		ImageCacheSource &aSource = theSources[i];
+		aSource.mSize = IMAGECACHE_MISSING;
+		aSource.mStamp = 0;
+
+		std::string aRealName = theSourceFiles[i];
+		if (gPakInterface != nullptr)
+		{
+			if (!gPakInterface->FindFile(theSourceFiles[i], &aRealName))
+				continue;
+
+			PakRecordMap::iterator aPakItr = gPakInterface->mPakRecordMap.find(StringToUpper(aRealName));
+			if (aPakItr != gPakInterface->mPakRecordMap.end())
+			{
+				// Paks don't keep file times, but the data is already in memory so just checksum it
+				PakRecord &aRecord = aPakItr->second;
+				aSource.mSize = aRecord.mSize;
+				aSource.mStamp = crc32(0, aRecord.mCollection->data() + aRecord.mStartPos, (uInt)aRecord.mSize);
+				continue;
+			}
+		}
+
+		std::error_code anError;
+		uintmax_t aSize = std::filesystem::file_size(aRealName, anError);
+		if (anError)
+			continue;
+
+		std::filesystem::file_time_type aTime = std::filesystem::last_write_time(aRealName, anError);
+		if (anError)
+			continue;
+
+		aSource.mSize = aSize;
+		aSource.mStamp = (uint64_t)aTime.time_since_epoch().count();
+	}
+}
+
+// True if theFile is an entry for theCacheKey whose source files haven't changed since
+bool ImageCache::CheckEntry(MappedFile &theFile, const std::string &theCacheKey,
+							const std::vector<std::string> &theSourceFiles, ImageCacheHeader &theHeader)
+{
+	const uchar *aFileData = theFile.GetData();
+	memcpy(&theHeader, aFileData, sizeof(theHeader));
+
+	size_t aSourcesOffset = sizeof(theHeader) + theHeader.mKeyLength;
+	size_t aSourcesEnd = aSourcesOffset + (size_t)theHeader.mNumSources * sizeof(ImageCacheSource);
+
+	if ((memcmp(theHeader.mMagic, "PIMG", 4) != 0) || (theHeader.mVersion != IMAGECACHE_VERSION) ||
+		(theHeader.mKeyLength != theCacheKey.length()) || (theHeader.mNumSources != theSourceFiles.size()) ||
+		(theHeader.mWidth <= 0) || (theHeader.mHeight <= 0) || (aSourcesEnd > theHeader.mDataOffset) ||
+		((size_t)theHeader.mDataOffset + theHeader.mDataSize > theFile.GetSize()) ||
+		(memcmp(aFileData + sizeof(theHeader), theCacheKey.data(), theCacheKey.length()) != 0))
+		return false;
+
+	std::vector<ImageCacheSource> aStoredSources(theHeader.mNumSources);
+	if (!aStoredSources.empty())
+		memcpy(&aStoredSources[0], aFileData + aSourcesOffset, aStoredSources.size() * sizeof(ImageCacheSource));
+
+	std::vector<ImageCacheSource> aSources;
+	GetSources(theSourceFiles, aSources);
+
+	for (size_t i = 0; i < aSources.size(); i++)
+	{
+		if ((aSources[i].mSize != aStoredSources[i].mSize) || (aSources[i].mStamp != aStoredSources[i].mStamp))
+			return false;
+	}
+
+	return true;
+}
+
+bool ImageCache::Load(const std::string &theKey, const std::vector<std::string> &theSourceFiles, MemoryImage *theImage)
+{
+	if (!mEnabled)
+		return false;
+
+	std::string aCacheKey = StringToUpper(theKey);
+
+	std::string aFileName = GetCacheFileName(aCacheKey);
+	MappedFile aFile;
+	if (!aFile.Open(aFileName, sizeof(ImageCacheHeader)))
+	{
+		mMisses++;
+		return false;
+	}
+
+	ulong *aBits = nullptr;
+	ImageCacheHeader aHeader;
+	bool isValid = CheckEntry(aFile, aCacheKey, theSourceFiles, aHeader);
+
+	if (isValid)
+	{
+		int aNumPixels = aHeader.mWidth * aHeader.mHeight;
+		const uchar *aData = aFile.GetData() + aHeader.mDataOffset;
+		aBits = new ulong[aNumPixels + 1];
+
+		if (aHeader.mFlags & IMAGECACHE_COMPRESSED)
+		{
+			uLongf aDestLen = aNumPixels * sizeof(ulong);
+			isValid = (uncompress((Bytef *)aBits, &aDestLen, aData, aHeader.mDataSize) == Z_OK) &&
+					  (aDestLen == aNumPixels * sizeof(ulong));
+		}
+		else
+		{
+			// One copy out of the page cache, the mapping goes away when the file is closed
+			isValid = (aHeader.mDataSize == aNumPixels * sizeof(ulong));
+			if (isValid)
+				memcpy(aBits, aData, aHeader.mDataSize);
+		}
+	}
+
+	aFile.Close();
+
+	if (!isValid)
+	{
+		delete[] aBits;
+		std::error_code anError;
+		std::filesystem::remove(aFileName, anError);
+
+		mMisses++;
+		return false;
+	}
+
+	theImage->TakeBits(aBits, aHeader.mWidth, aHeader.mHeight, false);
+
+	mHits++;
+	return true;
+}
+
+bool ImageCache::Store(const std::string &theKey, const std::vector<std::string> &theSourceFiles, MemoryImage *theImage)
+{
+	if (!mEnabled)
+		return false;
+
+	ulong *aBits = theImage->GetBits();
+	if ((aBits == nullptr) || (theImage->mWidth <= 0) || (theImage->mHeight <= 0))
+		return false;
+
+	std::string aCacheKey = StringToUpper(theKey);
+
+	std::vector<ImageCacheSource> aSources;
+	GetSources(theSourceFiles, aSources);
+
+	int aNumPixels = theImage->mWidth * theImage->mHeight;
+	const uchar *aData = (const uchar *)aBits;
+	uLong aDataSize = aNumPixels * sizeof(ulong);
+
+	std::vector<uchar> aCompressedData;
+	if (mCompress)
+	{
+		uLongf aCompressedSize = compressBound(aDataSize);
+		aCompressedData.resize(aCompressedSize);
+		if (compress(aCompressedData.data(), &aCompressedSize, aData, aDataSize) != Z_OK)
+			return false;
+
+		aData = aCompressedData.data();
+		aDataSize = aCompressedSize;
+	}
+
+	size_t aHeaderSize = sizeof(ImageCacheHeader) + aCacheKey.length() + aSources.size() * sizeof(ImageCacheSource);
+
+	ImageCacheHeader aHeader;
+	memcpy(aHeader.mMagic, "PIMG", 4);
+	aHeader.mVersion = IMAGECACHE_VERSION;
+	aHeader.mKeyLength = (uint32_t)aCacheKey.length();
+	aHeader.mNumSources = (uint32_t)aSources.size();
+	aHeader.mWidth = theImage->mWidth;
+	aHeader.mHeight = theImage->mHeight;
+	aHeader.mFlags = mCompress ? IMAGECACHE_COMPRESSED : 0;
+	aHeader.mDataSize = (uint32_t)aDataSize;
+	aHeader.mDataOffset = (uint32_t)((aHeaderSize + 15) & ~15);
+	aHeader.mReserved = 0;
+
+	static const uchar aPadding[16] = {0};
+
+	Buffer aFile;
+	aFile.WriteBytes((const uchar *)&aHeader, sizeof(aHeader));
+	aFile.WriteBytes((const uchar *)aCacheKey.data(), (int)aCacheKey.length());
+	if (!aSources.empty())
+		aFile.WriteBytes((const uchar *)&aSources[0], (int)(aSources.size() * sizeof(ImageCacheSource)));
+	aFile.WriteBytes(aPadding, (int)(aHeader.mDataOffset - aHeaderSize));
+	aFile.WriteBytes(aData, (int)aDataSize);
+
+	if (!gAppBase->WriteBufferToFileAtomic(GetCacheFileName(aCacheKey), &aFile))
+		return false;
+
+	mStores++;
+	return true;
+}
+
+// For prefetching, pages a current entry in so the Load that follows doesn't wait on the disk
+bool ImageCache::Touch(const std::string &theKey, const std::vector<std::string> &theSourceFiles)
+{
+	if (!mEnabled)
+		return false;
+
+	std::string aCacheKey = StringToUpper(theKey);
+
+	MappedFile aFile;
+	ImageCacheHeader aHeader;
+	if ((!aFile.Open(GetCacheFileName(aCacheKey), sizeof(ImageCacheHeader))) ||
+		(!CheckEntry(aFile, aCacheKey, theSourceFiles, aHeader)))
+		return false;
+
+	const volatile uchar *aData = aFile.GetData() + aHeader.mDataOffset;
+	uchar aSum = 0;
+	for (size_t i = 0; i < aHeader.mDataSize; i += 4096)
+		aSum += aData[i];
+	(void)aSum;
+
+	return true;
+}
+
+void ImageCache::Clear()
+{
+	std::error_code anError;
+	std::filesystem::remove_all(GetCacheDir(), anError);
+}
@@ -0,0 +1,84 @@
+#ifndef __IMAGECACHE_HPP__
+#define __IMAGECACHE_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace PopLib
+{
+
+class MemoryImage;
+class MappedFile;
+
+const uint32_t IMAGECACHE_VERSION = 1;
+
+enum
+{
+	IMAGECACHE_COMPRESSED = 0x0001
+};
+
+// On disk each entry is this header, the key, one ImageCacheSource per source file and then the
+// ARGB bits starting at mDataOffset, which is 16 byte aligned so the bits can be mapped in as is
+struct ImageCacheHeader
+{
+	char mMagic[4];
+	uint32_t mVersion;
+	uint32_t mKeyLength;
+	uint32_t mNumSources;
+	int32_t mWidth;
+	int32_t mHeight;
+	uint32_t mFlags;
+	uint32_t mDataSize;
+	uint32_t mDataOffset;
+	uint32_t mReserved;
+};
+
+struct ImageCacheSource
+{
+	uint64_t mSize; // IMAGECACHE_MISSING if the file didn't exist
+	uint64_t mStamp;
+};
+
+const uint64_t IMAGECACHE_MISSING = 0xFFFFFFFFFFFFFFFFULL;
+
+// Keeps the final ARGB bits of loaded images (after alpha composition) on disk so later runs can
+// skip decoding.  Entries remember the size and modification time (or CRC, for files in a pak) of
+// every file that went into them, and anything that doesn't match anymore is thrown out and rebuilt.
+class ImageCache
+{
+  public:
+	std::string mCacheDir;
+	std::once_flag mCacheDirOnce;
+	bool mEnabled;
+	bool mCompress;
+
+	// Bumped from the loading thread and prefetch jobs at once
+	std::atomic<int> mHits;
+	std::atomic<int> mMisses;
+	std::atomic<int> mStores;
+
+  protected:
+	const std::string &GetCacheDir();
+	std::string GetCacheFileName(const std::string &theKey);
+	void GetSources(const std::vector<std::string> &theSourceFiles, std::vector<ImageCacheSource> &theSources);
+	bool CheckEntry(MappedFile &theFile, const std::string &theCacheKey, const std::vector<std::string> &theSourceFiles,
+					ImageCacheHeader &theHeader);
+
+  public:
+	ImageCache();
+	virtual ~ImageCache();
+
+	bool Load(const std::string &theKey, const std::vector<std::string> &theSourceFiles, MemoryImage *theImage);
+	bool Store(const std::string &theKey, const std::vector<std::string> &theSourceFiles, MemoryImage *theImage);
+	bool Touch(const std::string &theKey, const std::vector<std::string> &theSourceFiles); // false if not cached
+	void Clear();
+};
+
+} // namespace PopLib
+
+#endif
@@ -7,6 +7,9 @@
 #include "graphics/imagefont.hpp"
 #include "graphics/sysfont.hpp"
 #include "imagelib/imagelib.hpp"
+#include "misc/jobsystem.hpp"
+#include "misc/filewatcher.hpp"
+#include "paklib/pakinterface.hpp"
 
 #include "debug/perftimer.hpp"
 
@@ -50,16 +53,32 @@ ResourceManager::ResourceManager(AppBase *theApp)
 
 	mAllowMissingProgramResources = false;
 	mAllowAlreadyDefinedResources = false;
+	mUseResourceManifest = true;
 	mCurResGroupList = NULL;
+	mFileWatcher = NULL;
+
+	mPrefetchEnabled = true;
+	mPrefetchMemoryLimit = 64 * 1024 * 1024;
+	mPrefetchMemory = 0;
+	memset(&mPrefetchStats, 0, sizeof(mPrefetchStats));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ResourceManager::~ResourceManager()
 {
+	CancelPrefetch();
+
+	if (mGroupUsage.mDirty)
+		mGroupUsage.Save();
+
 	DeleteMap(mImageMap);
 	DeleteMap(mSoundMap);
 	DeleteMap(mFontMap);
+
+	mResHandles.clear();
+	for (int i = 0; i < 3; i++)
+		mResHandleMap[i].clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -119,6 +138,23 @@ void ResourceManager::DeleteExtraImageBuffers(const std::string &theGroup)
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::GetImageMemoryByGroup(GroupMemoryMap &theMap)
+{
+	for (ResMap::iterator anItr = mImageMap.begin(); anItr != mImageMap.end(); ++anItr)
+	{
+		ImageRes *aRes = (ImageRes *)anItr->second;
+		MemoryImage *anImage = (MemoryImage *)aRes->mImage;
+		if (anImage == NULL)
+			continue;
+
+		std::pair<int64_t, int64_t> &aUsage = theMap[aRes->mResGroup];
+		aUsage.first += ImageMemoryManager::GetCPUMemSize(anImage);
+		aUsage.second += ImageMemoryManager::GetTextureMemSize(anImage);
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 std::string ResourceManager::GetErrorText()
@@ -201,6 +237,10 @@ bool ResourceManager::ParseCommonResource(XMLElement &theElement, BaseRes *theRe
 		return Fail("Resource already defined.");
 	}
 
+	theRes->mHandle = (int)mResHandles.size();
+	mResHandles.push_back(theRes);
+	mResHandleMap[theRes->mType][anId] = theRes->mHandle;
+
 	mCurResGroupList->push_back(theRes);
 	return true;
 }
@@ -475,96 +515,56 @@ bool ResourceManager::ParseSetDefaults(XMLElement &theElement)
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::ParseResourceElement(XMLElement &theElement)
+{
+	if (theElement.mValue == "Image")
+		return ParseImageResource(theElement);
+	else if (theElement.mValue == "Sound")
+		return ParseSoundResource(theElement);
+	else if (theElement.mValue == "Font")
+		return ParseFontResource(theElement);
+	else if (theElement.mValue == "PopAnim")
+		return ParsePopAnimResource(theElement);
+	else if (theElement.mValue == "PIEffect")
+		return ParsePIEffectResource(theElement);
+	else if (theElement.mValue == "SetDefaults")
+		return ParseSetDefaults(theElement);
+
+	return Fail("Invalid Section '" + theElement.mValue + "'");
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 bool ResourceManager::ParseResources()
 {
+	// Only the resource tags themselves are copied out of the parser's buffer
+	XMLNodeView aNode;
+	XMLElement aXMLElement;
 	for (;;)
 	{
-		XMLElement aXMLElement;
-		if (!mXMLParser->NextElement(&aXMLElement))
+		if (!mXMLParser->NextNode(aNode))
 			return false;
 
-		if (aXMLElement.mType == XMLElement::TYPE_START)
+		if (aNode.mType == XMLElement::TYPE_START)
 		{
-			if (aXMLElement.mValue == "Image")
-			{
-				if (!ParseImageResource(aXMLElement))
-					return false;
-
-				if (!mXMLParser->NextElement(&aXMLElement))
-					return false;
-
-				if (aXMLElement.mType != XMLElement::TYPE_END)
-					return Fail("Unexpected element found.");
-			}
-			else if (aXMLElement.mValue == "Sound")
-			{
-				if (!ParseSoundResource(aXMLElement))
-					return false;
-
-				if (!mXMLParser->NextElement(&aXMLElement))
-					return false;
-
-				if (aXMLElement.mType != XMLElement::TYPE_END)
-					return Fail("Unexpected element found.");
-			}
-			else if (aXMLElement.mValue == "Font")
-			{
-				if (!ParseFontResource(aXMLElement))
-					return false;
-
-				if (!mXMLParser->NextElement(&aXMLElement))
-					return false;
-
-				if (aXMLElement.mType != XMLElement::TYPE_END)
-					return Fail("Unexpected element found.");
-			}
-			else if (aXMLElement.mValue == "PopAnim")
-			{
-				if (!ParsePopAnimResource(aXMLElement))
-					return false;
-
-				if (!mXMLParser->NextElement(&aXMLElement))
-					return false;
-
-				if (aXMLElement.mType != XMLElement::TYPE_END)
-					return Fail("Unexpected element found.");
-			}
-			else if (aXMLElement.mValue == "PIEffect")
-			{
-				if (!ParsePIEffectResource(aXMLElement))
-					return false;
-
-				if (!mXMLParser->NextElement(&aXMLElement))
-					return false;
-
-				if (aXMLElement.mType != XMLElement::TYPE_END)
-					return Fail("Unexpected element found.");
-			}
-			else if (aXMLElement.mValue == "SetDefaults")
-			{
-				if (!ParseSetDefaults(aXMLElement))
-					return false;
-
-				if (!mXMLParser->NextElement(&aXMLElement))
-					return false;
+			mXMLParser->GetElement(aNode, &aXMLElement);
+			if (!ParseResourceElement(aXMLElement))
+				return false;
 
-				if (aXMLElement.mType != XMLElement::TYPE_END)
-					return Fail("Unexpected element found.");
-			}
-			else
-			{
-				Fail("Invalid Section '" + aXMLElement.mValue + "'");
+			if (!mXMLParser->NextNode(aNode))
 				return false;
-			}
+
+			if (aNode.mType != XMLElement::TYPE_END)
+				return Fail("Unexpected element found.");
 		}
-		else if (aXMLElement.mType == XMLElement::TYPE_ELEMENT)
+		else if (aNode.mType == XMLElement::TYPE_ELEMENT)
 		{
-			Fail("Element Not Expected '" + aXMLElement.mValue + "'");
+			Fail("Element Not Expected '" + aNode.GetValue() + "'");
 			return false;
 		}
-		else if (aXMLElement.mType == XMLElement::TYPE_END)
+		else if (aNode.mType == XMLElement::TYPE_END)
 		{
 			return true;
 		}
@@ -577,17 +577,18 @@ bool ResourceManager::DoParseResources()
 {
 	if (!mXMLParser->HasFailed())
 	{
+		XMLNodeView aNode;
 		for (;;)
 		{
-			XMLElement aXMLElement;
-			if (!mXMLParser->NextElement(&aXMLElement))
+			if (!mXMLParser->NextNode(aNode))
 				break;
 
-			if (aXMLElement.mType == XMLElement::TYPE_START)
+			if (aNode.mType == XMLElement::TYPE_START)
 			{
-				if (aXMLElement.mValue == "Resources")
+				if (aNode.mValue == "Resources")
 				{
-					mCurResGroup = aXMLElement.mAttributes["id"];
+					mCurResGroup.clear();
+					aNode.GetAttribute("id", mCurResGroup);
 					mCurResGroupList = &mResGroupMap[mCurResGroup];
 
 					if (mCurResGroup.empty())
@@ -601,13 +602,13 @@ bool ResourceManager::DoParseResources()
 				}
 				else
 				{
-					Fail("Invalid Section '" + aXMLElement.mValue + "'");
+					Fail("Invalid Section '" + aNode.GetValue() + "'");
 					break;
 				}
 			}
-			else if (aXMLElement.mType == XMLElement::TYPE_ELEMENT)
+			else if (aNode.mType == XMLElement::TYPE_ELEMENT)
 			{
-				Fail("Element Not Expected '" + aXMLElement.mValue + "'");
+				Fail("Element Not Expected '" + aNode.GetValue() + "'");
 				break;
 			}
 		}
@@ -622,23 +623,83 @@ bool ResourceManager::DoParseResources()
 	return !mHasFailed;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::ParseResourcesManifest(ResourceManifest &theManifest)
+{
+	for (uint32_t aGroupIdx = 0; aGroupIdx < theManifest.mHeader->mNumGroups; aGroupIdx++)
+	{
+		const ResManifestGroup &aGroup = theManifest.mGroups[aGroupIdx];
+
+		mCurResGroup = theManifest.GetString(aGroup.mId);
+		mCurResGroupList = &mResGroupMap[mCurResGroup];
+
+		if (mCurResGroup.empty())
+			return Fail("No id specified.");
+
+		uint32_t anEnd = std::min(aGroup.mFirstElement + aGroup.mNumElements, theManifest.mHeader->mNumElements);
+		for (uint32_t anElementIdx = aGroup.mFirstElement; anElementIdx < anEnd; anElementIdx++)
+		{
+			const ResManifestElement &aResElement = theManifest.mElements[anElementIdx];
+
+			XMLElement anElement;
+			anElement.mType = XMLElement::TYPE_START;
+			anElement.mValue = theManifest.GetString(aResElement.mName);
+
+			uint32_t anAttrEnd = std::min(aResElement.mFirstAttribute + aResElement.mNumAttributes,
+										  theManifest.mHeader->mNumAttributes);
+			for (uint32_t anAttrIdx = aResElement.mFirstAttribute; anAttrIdx < anAttrEnd; anAttrIdx++)
+			{
+				const ResManifestAttribute &anAttribute = theManifest.mAttributes[anAttrIdx];
+
+				uint32_t aKeyLength, aValueLength;
+				const char *aKey = theManifest.GetString(anAttribute.mKey, &aKeyLength);
+				const char *aValue = theManifest.GetString(anAttribute.mValue, &aValueLength);
+
+				// Keys were written out of a sorted map, so they can always go on the end
+				XMLParamMap::iterator anItr = anElement.mAttributes.emplace_hint(
+					anElement.mAttributes.end(), PopString(aKey, aKeyLength), PopString(aValue, aValueLength));
+				anElement.mAttributeIteratorList.push_back(anItr);
+			}
+
+			if (!ParseResourceElement(anElement))
+				return false;
+		}
+	}
+
+	return !mHasFailed;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 bool ResourceManager::ParseResourcesFile(const std::string &theFilename)
 {
+	mResourceFiles[FileWatcher::GetWatchPath(theFilename)] = theFilename;
+	if (mFileWatcher != NULL)
+		mFileWatcher->WatchFile(theFilename);
+
+	// A manifest compiled from this exact XML skips the XML parsing entirely
+	if (mUseResourceManifest)
+	{
+		ResourceManifest aManifest;
+		if ((aManifest.Open(ResourceManifest::GetManifestFileName(theFilename))) &&
+			(aManifest.MatchesSource(theFilename)))
+			return ParseResourcesManifest(aManifest);
+	}
+
 	mXMLParser = new XMLParser();
 	if (!mXMLParser->OpenFile(theFilename))
 		Fail("Resource file not found: " + theFilename);
 
-	XMLElement aXMLElement;
+	XMLNodeView aNode;
 	while (!mXMLParser->HasFailed())
 	{
-		if (!mXMLParser->NextElement(&aXMLElement))
+		if (!mXMLParser->NextNode(aNode))
 			Fail(mXMLParser->GetErrorText());
 
-		if (aXMLElement.mType == XMLElement::TYPE_START)
+		if (aNode.mType == XMLElement::TYPE_START)
 		{
-			if (aXMLElement.mValue != "ResourceManifest")
+			if (aNode.mValue != "ResourceManifest")
 				break;
 			else
 				return DoParseResources();
@@ -730,17 +791,7 @@ bool ResourceManager::LoadAlphaImage(ImageRes *theRes, SDLImage *theImage)
 		return Fail(StrFormat("AlphaImage size mismatch between %s and %s", theRes->mPath.c_str(),
 							  theRes->mAlphaImage.c_str()));
 
-	ulong *aBits1 = theImage->mBits;
-
-	ulong *aBits2 = anAlphaImage->mBits;
-	int aSize = theImage->mWidth * theImage->mHeight;
-
-	for (int i = 0; i < aSize; i++)
-	{
-		*aBits1 = (*aBits1 & 0x00FFFFFF) | ((*aBits2 & 0xFF) << 24);
-		++aBits1;
-		++aBits2;
-	}
+	ImageLib::ComposeAlpha(theImage->GetBits(), anAlphaImage->mBits, theImage->mWidth * theImage->mHeight);
 
 	theImage->BitsChanged();
 	return true;
@@ -748,7 +799,22 @@ bool ResourceManager::LoadAlphaImage(ImageRes *theRes, SDLImage *theImage)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-bool ResourceManager::DoLoadImage(ImageRes *theRes)
+void ResourceManager::GetImageCacheKey(ImageRes *theRes, std::string &theKey, std::vector<std::string> &theSourceFiles)
+{
+	theKey = StrFormat("%s|%s|%s|%s|%08X|%d|%d|%d", theRes->mPath.c_str(), theRes->mVariant.c_str(),
+					   theRes->mAlphaImage.c_str(), theRes->mAlphaGridImage.c_str(), theRes->mAlphaColor,
+					   ImageLib::gAutoLoadAlpha ? 1 : 0, theRes->mRows, theRes->mCols);
+
+	ImageLib::GetImageFileNames(theRes->mPath, true, theSourceFiles);
+	if (!theRes->mAlphaImage.empty())
+		ImageLib::GetImageFileNames(theRes->mAlphaImage, true, theSourceFiles);
+	if (!theRes->mAlphaGridImage.empty())
+		ImageLib::GetImageFileNames(theRes->mAlphaGridImage, true, theSourceFiles);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::DoLoadImage(ImageRes *theRes, ImageLib::Image *theDecodedImage)
 {
 	bool lookForAlpha = theRes->mAlphaImage.empty() && theRes->mAlphaGridImage.empty() && theRes->mAutoFindAlpha;
 
@@ -758,15 +824,50 @@ bool ResourceManager::DoLoadImage(ImageRes *theRes)
 	// PERF_END("ResourceManager:GetImage");
 
 	bool isNew;
+	bool useCache = mImageCache.mEnabled && (theRes->mPath.length() > 0) && (theRes->mPath[0] != '!');
+	std::string aCacheKey;
+	std::vector<std::string> aCacheSourceFiles;
+
 	ImageLib::gAlphaComposeColor = theRes->mAlphaColor;
-	SharedImageRef aSharedImageRef = gAppBase->GetSharedImage(theRes->mPath, theRes->mVariant, &isNew);
+	SharedImageRef aSharedImageRef =
+		gAppBase->GetSharedImage(theRes->mPath, theRes->mVariant, &isNew, !useCache && (theDecodedImage == NULL));
 	ImageLib::gAlphaComposeColor = 0xFFFFFF;
 
+	bool fromCache = false;
+	if (useCache && isNew)
+	{
+		GetImageCacheKey(theRes, aCacheKey, aCacheSourceFiles);
+
+		SDLImage *anImage = (SDLImage *)aSharedImageRef;
+		if (mImageCache.Load(aCacheKey, aCacheSourceFiles, anImage))
+		{
+			anImage->mFilePath = theRes->mPath;
+			fromCache = true;
+		}
+		else if (theDecodedImage == NULL)
+		{
+			// Not cached (or out of date), so swap the placeholder for the real thing
+			delete anImage;
+			ImageLib::gAlphaComposeColor = theRes->mAlphaColor;
+			aSharedImageRef.mSharedImage->mImage = gAppBase->GetImage(theRes->mPath, false);
+			ImageLib::gAlphaComposeColor = 0xFFFFFF;
+		}
+	}
+
+	if (isNew && !fromCache && (theDecodedImage != NULL))
+	{
+		// The placeholder just takes the bits
+		SDLImage *anImage = (SDLImage *)aSharedImageRef;
+		anImage->mFilePath = theRes->mPath;
+		anImage->TakeBits(theDecodedImage->mBits, theDecodedImage->mWidth, theDecodedImage->mHeight, false);
+		theDecodedImage->mBits = NULL;
+	}
+
 	SDLImage *aSDLImage = (SDLImage *)aSharedImageRef;
 	if (!aSDLImage)
 		return Fail(StrFormat("Failed to load image: %s", theRes->mPath.c_str()));
 
-	if (isNew)
+	if (isNew && !fromCache)
 	{
 		if (!theRes->mAlphaImage.empty())
 		{
@@ -779,6 +880,9 @@ bool ResourceManager::DoLoadImage(ImageRes *theRes)
 			if (!LoadAlphaGridImage(theRes, aSharedImageRef))
 				return false;
 		}
+
+		if (useCache)
+			mImageCache.Store(aCacheKey, aCacheSourceFiles, aSDLImage);
 	}
 
 	aSDLImage->CommitBits();
@@ -800,32 +904,90 @@ bool ResourceManager::DoLoadImage(ImageRes *theRes)
 		PERF_END("ResourceManager:DDSurface");
 	}
 
-	if (theRes->mPalletize)
+	if ((theRes->mPalletize) && (!aSDLImage->mPurgeBits))
 	{
-		// PERF_BEGIN("ResourceManager:Palletize");
-		// if (aSDLImage->mSurface==NULL)
-		//	aSDLImage->Palletize();
-		// else
-		// aSDLImage->mWantPal = true;
-		// PERF_END("ResourceManager:Palletize");
+		// Only sticks if the image has 256 colors or fewer, otherwise the bits are left alone.  Not worth the
+		// scan for images whose bits are about to be purged.
+		PERF_BEGIN("ResourceManager:Palletize");
+		if (aSDLImage->mD3DData == NULL)
+			aSDLImage->Palletize();
+		else
+			aSDLImage->mWantPal = true;
+		PERF_END("ResourceManager:Palletize");
 	}
 
 	if (theRes->mNearestFilter)
 		aSDLImage->mImageFlags |= SDLImageFlag_NearestFiltering;
 
+	if (theRes->mA4R4G4B4)
+		aSDLImage->mImageFlags |= SDLImageFlag_UseA4R4G4B4;
+
+	if (theRes->mA8R8G8B8)
+		aSDLImage->mImageFlags |= SDLImageFlag_UseA8R8G8B8;
+
 	if (theRes->mAnimInfo.mAnimType != AnimType_None)
 		aSDLImage->mAnimInfo = new AnimInfo(theRes->mAnimInfo);
 
 	aSDLImage->mNumRows = theRes->mRows;
 	aSDLImage->mNumCols = theRes->mCols;
 
+	// Reloading only goes through ImageLib, which knows nothing about the extra alpha sources
+	mApp->mImageMemoryManager.SetReloadable(aSDLImage, theRes->mAlphaImage.empty() &&
+														   theRes->mAlphaGridImage.empty() &&
+														   ((theRes->mAlphaColor & 0xFFFFFF) == 0xFFFFFF));
+
 	if (aSDLImage->mPurgeBits)
 		aSDLImage->PurgeBits();
 
+	if (mFileWatcher != NULL)
+		WatchResource(theRes);
+
 	ResourceLoadedHook(theRes);
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::DoLoadImageWithPrefetch(ImageRes *theRes)
+{
+	PrefetchedImage aPrefetchedImage;
+	{
+		std::unique_lock<std::mutex> aLock(mPrefetchMutex);
+		WaitForPrefetch(aLock, theRes->mId);
+
+		PrefetchedImageMap::iterator anItr = mPrefetchedImages.find(theRes->mId);
+		if (anItr == mPrefetchedImages.end())
+			aPrefetchedImage.mImage = NULL;
+		else
+		{
+			aPrefetchedImage = anItr->second;
+			mPrefetchedImages.erase(anItr);
+			mPrefetchMemory -= (int64_t)aPrefetchedImage.mImage->mWidth * aPrefetchedImage.mImage->mHeight * 4;
+		}
+	}
+
+	if (aPrefetchedImage.mImage == NULL)
+		return DoLoadImage(theRes);
+
+	// A prefetch of a path the resource no longer has is just thrown away
+	std::unique_ptr<ImageLib::Image> aDelPrefetchedImage(aPrefetchedImage.mImage);
+	ImageLib::Image *aDecodedImage = (aPrefetchedImage.mPath == theRes->mPath) ? aPrefetchedImage.mImage : NULL;
+
+	bool aResult = DoLoadImage(theRes, aDecodedImage);
+
+	// DoLoadImage only takes the bits if nothing was shared or cached under that path already
+	std::lock_guard<std::mutex> aLock(mPrefetchMutex);
+	if (aPrefetchedImage.mImage->mBits == NULL)
+	{
+		mPrefetchStats.mImagesUsed++;
+		mPrefetchStats.mStallTimeSaved += aPrefetchedImage.mDecodeTime;
+	}
+	else
+		mPrefetchStats.mImagesDiscarded++;
+
+	return aResult;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 void ResourceManager::DeleteImage(const std::string &theName)
@@ -848,7 +1010,7 @@ SharedImageRef ResourceManager::LoadImage(const std::string &theName)
 	if (aRes->mFromProgram)
 		return NULL;
 
-	if (!DoLoadImage(aRes))
+	if (!DoLoadImageWithPrefetch(aRes))
 		return NULL;
 
 	return aRes->mImage;
@@ -877,6 +1039,9 @@ bool ResourceManager::DoLoadSound(SoundRes *theRes)
 
 	aRes->mSoundId = aSoundId;
 
+	if (mFileWatcher != NULL)
+		WatchResource(theRes);
+
 	ResourceLoadedHook(theRes);
 	return true;
 }
@@ -953,6 +1118,9 @@ bool ResourceManager::DoLoadFont(FontRes *theRes)
 
 	PERF_END("ResourceManager:DoLoadFont");
 
+	if (mFileWatcher != NULL)
+		WatchResource(theRes);
+
 	ResourceLoadedHook(theRes);
 	return true;
 }
@@ -971,7 +1139,7 @@ bool ResourceManager::DoLoadResource(BaseRes *theRes, bool *fromProgram)
 	{
 	case ResType_Image:
 		PERF_BEGIN("ResourceManager::DoLoadResource(ResType_Image)");
-		result = DoLoadImage((ImageRes *)theRes);
+		result = DoLoadImageWithPrefetch((ImageRes *)theRes);
 		PERF_END("ResourceManager::DoLoadResource(ResType_Image)");
 		break;
 	case ResType_Sound:
@@ -1021,144 +1189,810 @@ void ResourceManager::DeleteFont(const std::string &theName)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-bool ResourceManager::LoadNextResource()
+int ResourceManager::LoadSound(const std::string &theName)
 {
-	if (HadError())
-		return false;
+	ResMap::iterator anItr = mSoundMap.find(theName);
+	if (anItr == mSoundMap.end())
+		return -1;
 
-	if (!mCurResGroupList)
-		return false;
+	SoundRes *aRes = (SoundRes *)anItr->second;
+	if (aRes->mSoundId != -1)
+		return aRes->mSoundId;
 
-	while (mCurResGroupListItr != mCurResGroupList->end())
-	{
-		BaseRes *aRes = *mCurResGroupListItr++;
-		if (aRes->mFromProgram)
-			continue;
+	if (aRes->mFromProgram)
+		return -1;
 
-		switch (aRes->mType)
-		{
-		case ResType_Image: {
-			ImageRes *anImageRes = (ImageRes *)aRes;
-			if ((SDLImage *)anImageRes->mImage != NULL)
-				continue;
+	if (!DoLoadSound(aRes))
+		return -1;
 
-			return DoLoadImage(anImageRes);
-		}
+	return aRes->mSoundId;
+}
 
-		case ResType_Sound: {
-			SoundRes *aSoundRes = (SoundRes *)aRes;
-			if (aSoundRes->mSoundId != -1)
-				continue;
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+Async<SharedImageRef> ResourceManager::LoadImageAsync(const std::string &theName)
+{
+	std::shared_ptr<AsyncState<SharedImageRef>> aState = std::make_shared<AsyncState<SharedImageRef>>();
 
-			return DoLoadSound(aSoundRes);
+	ResMap::iterator anItr = mImageMap.find(theName);
+	ImageRes *aRes = (anItr != mImageMap.end()) ? (ImageRes *)anItr->second : NULL;
+	if ((aRes == NULL) || ((SDLImage *)aRes->mImage != NULL) || aRes->mFromProgram || (gJobSystem == NULL))
+	{
+		aState->SetResult(LoadImage(theName));
+		return aState;
+	}
+
+	// Only the file gets decoded off the main thread, or its image cache entry read in if it has a current one.
+	// Everything that touches the shared image map or the resource itself happens back on the main thread in
+	// DoLoadImage, which takes cached images from the cache the same way LoadImage does.
+	std::string aPath = aRes->mPath;
+	int anAlphaColor = aRes->mAlphaColor;
+	bool decode = (aPath.length() > 0) && (aPath[0] != '!');
+
+	std::string aCacheKey;
+	std::vector<std::string> aCacheSourceFiles;
+	if (decode)
+		GetImageCacheKey(aRes, aCacheKey, aCacheSourceFiles);
+
+	gJobSystem->Run([this, aState, theName, aPath, anAlphaColor, decode, aCacheKey, aCacheSourceFiles]() {
+		// A prefetch of the same image gets finished or taken over here, off the main thread
+		ImageLib::Image *aDecodedImage = NULL;
+		if (decode && !aState->mCancelled && !WaitForPrefetchedImage(theName) &&
+			!mImageCache.Touch(aCacheKey, aCacheSourceFiles))
+		{
+			ImageLib::gAlphaComposeColor = anAlphaColor;
+			aDecodedImage = ImageLib::GetImage(aPath, true);
+			ImageLib::gAlphaComposeColor = 0xFFFFFF;
 		}
 
-		case ResType_Font: {
-			FontRes *aFontRes = (FontRes *)aRes;
-			if (aFontRes->mFont != NULL)
-				continue;
+		gJobSystem->RunOnMainThread([this, aState, theName, aPath, aDecodedImage]() {
+			std::unique_ptr<ImageLib::Image> aDelDecodedImage(aDecodedImage);
+			if (aState->mCancelled)
+				return;
 
-			return DoLoadFont(aFontRes);
-		}
-		}
-	}
+			// Same as LoadImage, but the decoded bits go straight to DoLoadImage unless the path has changed
+			// since, so nothing is handed over through the ResourceManager the loading thread also uses
+			ResMap::iterator anItr = mImageMap.find(theName);
+			ImageRes *aRes = (anItr != mImageMap.end()) ? (ImageRes *)anItr->second : NULL;
+			if ((aRes != NULL) && ((SDLImage *)aRes->mImage == NULL) && (!aRes->mFromProgram))
+			{
+				if (aDecodedImage == NULL)
+					DoLoadImageWithPrefetch(aRes);
+				else
+					DoLoadImage(aRes, (aRes->mPath == aPath) ? aDecodedImage : NULL);
+			}
 
-	return false;
-}
+			SharedImageRef anImage;
+			if (aRes != NULL)
+				anImage = aRes->mImage;
+			aState->SetResult(anImage);
+		});
+	});
 
-///////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////
-void ResourceManager::ResourceLoadedHook(BaseRes *theRes)
-{
+	return aState;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void ResourceManager::StartLoadResources(const std::string &theGroup)
+Async<int> ResourceManager::LoadSoundAsync(const std::string &theName)
 {
-	mError = "";
-	mHasFailed = false;
+	std::shared_ptr<AsyncState<int>> aState = std::make_shared<AsyncState<int>>();
+	if (gJobSystem == NULL)
+	{
+		aState->SetResult(LoadSound(theName));
+		return aState;
+	}
 
-	mCurResGroup = theGroup;
-	mCurResGroupList = &mResGroupMap[theGroup];
-	mCurResGroupListItr = mCurResGroupList->begin();
+	gJobSystem->RunOnMainThread([this, aState, theName]() {
+		if (!aState->mCancelled)
+			aState->SetResult(LoadSound(theName));
+	});
+
+	return aState;
 }
 
-//////////////////////////////////////////////////////////////////////////
-//////////////////////////////////////////////////////////////////////////
-void ResourceManager::DumpCurResGroup(std::string &theDestStr)
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+Async<Font *> ResourceManager::LoadFontAsync(const std::string &theName)
 {
-	const ResList *rl = &mResGroupMap.find(mCurResGroup)->second;
-	ResList::const_iterator it = rl->begin();
-	theDestStr =
-		StrFormat("About to dump %d elements from current res group name %s\n", rl->size(), mCurResGroup.c_str());
-
-	ResList::const_iterator rl_end = rl->end();
-	while (it != rl_end)
+	std::shared_ptr<AsyncState<Font *>> aState = std::make_shared<AsyncState<Font *>>();
+	if (gJobSystem == NULL)
 	{
-		BaseRes *br = *it++;
-		std::string prefix = StrFormat("%s: %s\n", br->mId.c_str(), br->mPath.c_str());
-		theDestStr += prefix;
-		if (br->mFromProgram)
-			theDestStr += std::string("     res is from program\n");
-		else if (br->mType == ResType_Image)
-			theDestStr += std::string("     res is an image\n");
-		else if (br->mType == ResType_Sound)
-			theDestStr += std::string("     res is a sound\n");
-		else if (br->mType == ResType_Font)
-			theDestStr += std::string("     res is a font\n");
-
-		if (it == mCurResGroupListItr)
-			theDestStr += std::string("iterator has reached mCurResGroupItr\n");
+		aState->SetResult(LoadFont(theName));
+		return aState;
 	}
 
-	theDestStr += std::string("Done dumping resources\n");
+	gJobSystem->RunOnMainThread([this, aState, theName]() {
+		if (!aState->mCancelled)
+			aState->SetResult(LoadFont(theName));
+	});
+
+	return aState;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-bool ResourceManager::LoadResources(const std::string &theGroup)
+Async<bool> ResourceManager::LoadGroupAsync(std::string theGroup)
 {
-	mError = "";
-	mHasFailed = false;
-	StartLoadResources(theGroup);
-	while (LoadNextResource())
+	std::vector<Async<SharedImageRef>> anImageLoads;
+	std::vector<Async<int>> aSoundLoads;
+	std::vector<Async<Font *>> aFontLoads;
+
+	GroupRequested(theGroup);
+
+	ResList &aList = mResGroupMap[theGroup];
+	for (ResList::iterator anItr = aList.begin(); anItr != aList.end(); ++anItr)
 	{
+		BaseRes *aRes = *anItr;
+		if (aRes->mFromProgram)
+			continue;
+
+		switch (aRes->mType)
+		{
+		case ResType_Image:
+			anImageLoads.push_back(LoadImageAsync(aRes->mId));
+			break;
+		case ResType_Sound:
+			aSoundLoads.push_back(LoadSoundAsync(aRes->mId));
+			break;
+		case ResType_Font:
+			aFontLoads.push_back(LoadFontAsync(aRes->mId));
+			break;
+		}
 	}
 
-	if (!HadError())
+	bool success = true;
+
+	std::vector<SharedImageRef> anImages = co_await WhenAll(anImageLoads);
+	for (SharedImageRef &anImage : anImages)
+		success &= ((SDLImage *)anImage != NULL);
+
+	std::vector<int> aSounds = co_await WhenAll(aSoundLoads);
+	for (int aSoundId : aSounds)
+		success &= (aSoundId != -1);
+
+	std::vector<Font *> aFonts = co_await WhenAll(aFontLoads);
+	for (Font *aFont : aFonts)
+		success &= (aFont != NULL);
+
+	if (success)
 	{
 		mLoadedGroups.insert(theGroup);
-		return true;
+		GroupLoaded(theGroup);
 	}
-	else
-		return false;
+
+	co_return success;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-int ResourceManager::GetNumResources(const std::string &theGroup, ResMap &theMap)
+void ResourceManager::GroupRequested(const std::string &theGroup)
 {
-	if (theGroup.empty())
-		return theMap.size();
+	std::lock_guard<std::mutex> aLock(mPrefetchMutex);
 
-	int aCount = 0;
-	for (ResMap::iterator anItr = theMap.begin(); anItr != theMap.end(); ++anItr)
+	// Right guesses keep whatever is still being prefetched going, each load takes over or waits for its image
+	if (!mPrefetchGroup.empty())
 	{
-		BaseRes *aRes = anItr->second;
-		if (aRes->mResGroup == theGroup && !aRes->mFromProgram)
-			++aCount;
+		if (stricmp(mPrefetchGroup.c_str(), theGroup.c_str()) == 0)
+		{
+			mPrefetchStats.mPredictionHits++;
+			mPrefetchGroup.clear();
+		}
+		else
+			DiscardPrefetch();
 	}
 
-	return aCount;
+	mGroupUsage.GroupRequested(theGroup);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-int ResourceManager::GetNumImages(const std::string &theGroup)
+void ResourceManager::GroupLoaded(const std::string &theGroup)
 {
-	return GetNumResources(theGroup, mImageMap);
-}
+	std::string aNextGroup;
+	{
+		std::lock_guard<std::mutex> aLock(mPrefetchMutex);
+
+		// Anything a right guess prefetched that the group didn't end up taking is of no use now
+		if (mPrefetchGroup.empty())
+			DiscardPrefetch();
+
+		aNextGroup = mGroupUsage.PredictNext(theGroup);
+	}
+
+	if (!aNextGroup.empty())
+		PrefetchGroup(aNextGroup);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::DiscardPrefetch()
+{
+	if (mPrefetchCancelled != NULL)
+		*mPrefetchCancelled = true;
+	mPrefetchCancelled.reset();
+
+	for (PrefetchedImageMap::iterator anItr = mPrefetchedImages.begin(); anItr != mPrefetchedImages.end(); ++anItr)
+	{
+		delete anItr->second.mImage;
+		mPrefetchStats.mImagesDiscarded++;
+	}
+
+	mPrefetchedImages.clear();
+	mPrefetchMemory = 0;
+	mPrefetchGroup.clear();
+
+	// Jobs that were cancelled leave these alone from here on
+	mPrefetchQueued.clear();
+	mPrefetchDecoding.clear();
+	mPrefetchDecoded.notify_all();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::WaitForPrefetch(std::unique_lock<std::mutex> &theLock, const std::string &theId)
+{
+	// A job that hasn't started is left with nothing to do, one that has is waited on so nothing's decoded twice
+	mPrefetchQueued.erase(theId);
+	mPrefetchDecoded.wait(theLock, [this, &theId]() { return mPrefetchDecoding.count(theId) == 0; });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::WaitForPrefetchedImage(const std::string &theId)
+{
+	std::unique_lock<std::mutex> aLock(mPrefetchMutex);
+	WaitForPrefetch(aLock, theId);
+	return mPrefetchedImages.count(theId) != 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::PrefetchImage(const std::shared_ptr<std::atomic<bool>> &theCancelled, const std::string &theId,
+									const std::string &thePath, int theAlphaColor, const std::string &theCacheKey,
+									const std::vector<std::string> &theCacheSourceFiles)
+{
+	{
+		std::lock_guard<std::mutex> aLock(mPrefetchMutex);
+		if (*theCancelled || (mPrefetchQueued.erase(theId) == 0) || (mPrefetchMemory >= mPrefetchMemoryLimit))
+			return;
+
+		mPrefetchDecoding.insert(theId);
+	}
+
+	// An image that's cached only needs its entry read in, DoLoadImage would throw decoded bits away
+	ImageLib::Image *anImage = NULL;
+	double aDecodeTime = 0;
+	if (!mImageCache.Touch(theCacheKey, theCacheSourceFiles))
+	{
+		uint64_t aStartTicks = SDL_GetPerformanceCounter();
+		ImageLib::gAlphaComposeColor = theAlphaColor;
+		anImage = ImageLib::GetImage(thePath, true);
+		ImageLib::gAlphaComposeColor = 0xFFFFFF;
+		aDecodeTime = (SDL_GetPerformanceCounter() - aStartTicks) * 1000.0 / SDL_GetPerformanceFrequency();
+	}
+
+	std::lock_guard<std::mutex> aLock(mPrefetchMutex);
+	if (!*theCancelled)
+	{
+		mPrefetchDecoding.erase(theId);
+		mPrefetchDecoded.notify_all();
+	}
+
+	if (anImage == NULL)
+		return;
+
+	int64_t aSize = (int64_t)anImage->mWidth * anImage->mHeight * 4;
+	if (*theCancelled || (mPrefetchMemory + aSize > mPrefetchMemoryLimit) || (mPrefetchedImages.count(theId) != 0))
+	{
+		delete anImage;
+		mPrefetchStats.mImagesDiscarded++;
+		return;
+	}
+
+	PrefetchedImage &aPrefetchedImage = mPrefetchedImages[theId];
+	aPrefetchedImage.mImage = anImage;
+	aPrefetchedImage.mPath = thePath;
+	aPrefetchedImage.mDecodeTime = aDecodeTime;
+	mPrefetchMemory += aSize;
+	mPrefetchStats.mImagesPrefetched++;
+}
+
+// Reads through the file LoadSound would end up opening, so it's in the OS's file cache by then
+static void PrefetchSoundFile(const std::string &thePath)
+{
+	static const char *anExts[] = {".ogg", ".mp3", ".flac", ".wav", ".au"};
+
+	std::vector<char> aBuffer(64 * 1024);
+	for (int i = 0; i < 5; i++)
+	{
+		PFILE *aFile = p_fopen((thePath + anExts[i]).c_str(), "rb");
+		if (aFile == NULL)
+			continue;
+
+		while (p_fread(aBuffer.data(), 1, aBuffer.size(), aFile) == aBuffer.size())
+		{
+		}
+
+		p_fclose(aFile);
+		break;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::PrefetchGroup(const std::string &theGroup)
+{
+	if ((!mPrefetchEnabled) || (gJobSystem == NULL))
+		return;
+
+	std::lock_guard<std::mutex> aLock(mPrefetchMutex);
+	if (stricmp(mPrefetchGroup.c_str(), theGroup.c_str()) == 0)
+		return;
+
+	DiscardPrefetch();
+
+	ResGroupMap::iterator aGroupItr = mResGroupMap.find(theGroup);
+	if (aGroupItr == mResGroupMap.end())
+		return;
+
+	mPrefetchGroup = theGroup;
+	mPrefetchCancelled = std::make_shared<std::atomic<bool>>(false);
+	mPrefetchStats.mPredictions++;
+
+	std::shared_ptr<std::atomic<bool>> aCancelled = mPrefetchCancelled;
+	for (ResList::iterator anItr = aGroupItr->second.begin(); anItr != aGroupItr->second.end(); ++anItr)
+	{
+		BaseRes *aRes = *anItr;
+		if ((aRes->mFromProgram) || (aRes->mPath.empty()) || (aRes->mPath[0] == '!'))
+			continue;
+
+		if (aRes->mType == ResType_Image)
+		{
+			ImageRes *anImageRes = (ImageRes *)aRes;
+			if ((SDLImage *)anImageRes->mImage != NULL)
+				continue;
+
+			std::string anId = aRes->mId;
+			std::string aPath = aRes->mPath;
+			int anAlphaColor = anImageRes->mAlphaColor;
+			std::string aCacheKey;
+			std::vector<std::string> aCacheSourceFiles;
+			GetImageCacheKey(anImageRes, aCacheKey, aCacheSourceFiles);
+
+			mPrefetchQueued.insert(anId);
+			gJobSystem->RunLowPriority([this, aCancelled, anId, aPath, anAlphaColor, aCacheKey, aCacheSourceFiles]() {
+				PrefetchImage(aCancelled, anId, aPath, anAlphaColor, aCacheKey, aCacheSourceFiles);
+			});
+		}
+		else if ((aRes->mType == ResType_Sound) && (((SoundRes *)aRes)->mSoundId == -1))
+		{
+			std::string aPath = aRes->mPath;
+			gJobSystem->RunLowPriority([aCancelled, aPath]() {
+				if (!*aCancelled)
+					PrefetchSoundFile(aPath);
+			});
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::CancelPrefetch()
+{
+	std::lock_guard<std::mutex> aLock(mPrefetchMutex);
+	DiscardPrefetch();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+ResourcePrefetchStats ResourceManager::GetPrefetchStats()
+{
+	std::lock_guard<std::mutex> aLock(mPrefetchMutex);
+	return mPrefetchStats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::DumpPrefetchStats(std::string &theDestStr)
+{
+	ResourcePrefetchStats aStats = GetPrefetchStats();
+	int aNumImages = aStats.mImagesUsed + aStats.mImagesDiscarded;
+
+	theDestStr = StrFormat("Group predictions: %d/%d right\n", aStats.mPredictionHits, aStats.mPredictions);
+	theDestStr += StrFormat("Images prefetched: %d, %d used (%d%%), %d discarded\n", aStats.mImagesPrefetched,
+							aStats.mImagesUsed, (aNumImages > 0) ? (aStats.mImagesUsed * 100 / aNumImages) : 0,
+							aStats.mImagesDiscarded);
+	theDestStr += StrFormat("Stall time saved: %.1f ms\n", aStats.mStallTimeSaved);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::GetResourceFileNames(BaseRes *theRes, std::vector<std::string> &theFileNames)
+{
+	if (theRes->mFromProgram || theRes->mPath.empty() || (theRes->mPath[0] == '!'))
+		return;
+
+	switch (theRes->mType)
+	{
+	case ResType_Image:
+	{
+		ImageRes *aRes = (ImageRes *)theRes;
+		ImageLib::GetImageFileNames(aRes->mPath, true, theFileNames);
+		if (!aRes->mAlphaImage.empty())
+			ImageLib::GetImageFileNames(aRes->mAlphaImage, true, theFileNames);
+		if (!aRes->mAlphaGridImage.empty())
+			ImageLib::GetImageFileNames(aRes->mAlphaGridImage, true, theFileNames);
+		break;
+	}
+	case ResType_Sound:
+	{
+		// Whichever of these the sound manager found first
+		static const char *aSoundExts[] = {".ogg", ".mp3", ".flac", ".wav", ".au"};
+		theFileNames.push_back(theRes->mPath);
+		for (int i = 0; i < 5; i++)
+			theFileNames.push_back(theRes->mPath + aSoundExts[i]);
+		break;
+	}
+	case ResType_Font:
+	{
+		// SysFonts and !ref fonts are left alone, there's no FontData of their own to swap
+		FontRes *aRes = (FontRes *)theRes;
+		if (aRes->mSysFont || (dynamic_cast<ImageFont *>(aRes->mFont) == NULL))
+			return;
+
+		theFileNames.push_back(aRes->mPath);
+		if (!aRes->mImagePath.empty())
+			ImageLib::GetImageFileNames(aRes->mImagePath, true, theFileNames);
+		break;
+	}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::WatchResource(BaseRes *theRes)
+{
+	std::vector<std::string> aFileNames;
+	GetResourceFileNames(theRes, aFileNames);
+
+	for (const std::string &aFileName : aFileNames)
+	{
+		if (!mFileWatcher->WatchFile(aFileName))
+			continue;
+
+		std::vector<int> &aHandles = mWatchedFiles[FileWatcher::GetWatchPath(aFileName)];
+		if (std::find(aHandles.begin(), aHandles.end(), theRes->mHandle) == aHandles.end())
+			aHandles.push_back(theRes->mHandle);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::ReloadImage(ImageRes *theRes)
+{
+	SDLImage *aSDLImage = (SDLImage *)theRes->mImage;
+	if (aSDLImage == NULL)
+		return false;
+
+	ImageLib::gAlphaComposeColor = theRes->mAlphaColor;
+	ImageLib::Image *aLoadedImage = ImageLib::GetImage(theRes->mPath, true);
+	ImageLib::gAlphaComposeColor = 0xFFFFFF;
+
+	// Probably caught halfway through being written, the next change will have another go
+	if (aLoadedImage == NULL)
+		return false;
+
+	aSDLImage->TakeBits(aLoadedImage->mBits, aLoadedImage->mWidth, aLoadedImage->mHeight, false);
+	aLoadedImage->mBits = NULL;
+	delete aLoadedImage;
+
+	if ((!theRes->mAlphaImage.empty()) && (!LoadAlphaImage(theRes, aSDLImage)))
+		return false;
+	if ((!theRes->mAlphaGridImage.empty()) && (!LoadAlphaGridImage(theRes, aSDLImage)))
+		return false;
+
+	aSDLImage->CommitBits();
+	if ((theRes->mPalletize) && (!aSDLImage->mPurgeBits) && (aSDLImage->mD3DData == NULL))
+		aSDLImage->Palletize();
+
+	mApp->mImageMemoryManager.SetReloadable(aSDLImage, theRes->mAlphaImage.empty() &&
+														   theRes->mAlphaGridImage.empty() &&
+														   ((theRes->mAlphaColor & 0xFFFFFF) == 0xFFFFFF));
+
+	if (aSDLImage->mPurgeBits)
+		aSDLImage->PurgeBits();
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::ReloadSound(SoundRes *theRes)
+{
+	if (theRes->mSoundId == -1)
+		return false;
+
+	return mApp->mSoundManager->ReloadSound(theRes->mSoundId, theRes->mPath);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::ReloadFont(FontRes *theRes)
+{
+	ImageFont *anImageFont = dynamic_cast<ImageFont *>(theRes->mFont);
+	if (anImageFont == NULL)
+		return false;
+
+	ImageFont *aLoadedFont;
+	if (theRes->mImagePath.empty())
+		aLoadedFont = new ImageFont(mApp, theRes->mPath);
+	else
+	{
+		// The legacy font image belongs to the resource, so it's refreshed in place as well
+		MemoryImage *anImage = dynamic_cast<MemoryImage *>(theRes->mImage);
+		ImageLib::Image *aLoadedImage = ImageLib::GetImage(theRes->mImagePath, true);
+		if ((anImage != NULL) && (aLoadedImage != NULL))
+		{
+			anImage->TakeBits(aLoadedImage->mBits, aLoadedImage->mWidth, aLoadedImage->mHeight);
+			aLoadedImage->mBits = NULL;
+		}
+		delete aLoadedImage;
+
+		aLoadedFont = new ImageFont(theRes->mImage, theRes->mPath);
+	}
+
+	if ((aLoadedFont->mFontData == NULL) || (!aLoadedFont->mFontData->mInitialized))
+	{
+		delete aLoadedFont;
+		return false;
+	}
+
+	// The old data goes away with aLoadedFont, unless a copy of the font is still using it
+	std::swap(anImageFont->mFontData, aLoadedFont->mFontData);
+	anImageFont->mActiveListValid = false;
+	anImageFont->Prepare();
+	delete aLoadedFont;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::SetFileWatcher(FileWatcher *theFileWatcher)
+{
+	mFileWatcher = theFileWatcher;
+	mWatchedFiles.clear();
+	if (mFileWatcher == NULL)
+		return;
+
+	for (StringToStringMap::iterator anItr = mResourceFiles.begin(); anItr != mResourceFiles.end(); ++anItr)
+		mFileWatcher->WatchFile(anItr->second);
+
+	for (BaseRes *aRes : mResHandles)
+	{
+		bool isLoaded;
+		switch (aRes->mType)
+		{
+		case ResType_Image:
+			isLoaded = (SDLImage *)((ImageRes *)aRes)->mImage != NULL;
+			break;
+		case ResType_Sound:
+			isLoaded = ((SoundRes *)aRes)->mSoundId != -1;
+			break;
+		case ResType_Font:
+			isLoaded = ((FontRes *)aRes)->mFont != NULL;
+			break;
+		default:
+			isLoaded = false;
+		}
+
+		if (isLoaded)
+			WatchResource(aRes);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::ReloadChangedFile(const std::string &theWatchPath)
+{
+	StringToStringMap::iterator aFileItr = mResourceFiles.find(theWatchPath);
+	WatchedFileMap::iterator anItr = mWatchedFiles.find(theWatchPath);
+	if ((aFileItr == mResourceFiles.end()) && (anItr == mWatchedFiles.end()))
+		return false;
+
+	// Reloads go through the same code as loading, which Fail()s for good, but a broken edit shouldn't keep
+	// everything after it from loading once it's fixed
+	bool hadFailed = mHasFailed;
+
+	if (aFileItr != mResourceFiles.end())
+	{
+		std::string aFileName = aFileItr->second;
+		if (!ReparseResourcesFile(aFileName))
+			SDL_Log("Failed to reparse %s: %s", aFileName.c_str(), GetErrorText().c_str());
+	}
+	else
+	{
+		for (int aHandle : anItr->second)
+		{
+			BaseRes *aRes = mResHandles[aHandle];
+
+			bool aResult;
+			switch (aRes->mType)
+			{
+			case ResType_Image:
+				aResult = ReloadImage((ImageRes *)aRes);
+				break;
+			case ResType_Sound:
+				aResult = ReloadSound((SoundRes *)aRes);
+				break;
+			case ResType_Font:
+				aResult = ReloadFont((FontRes *)aRes);
+				break;
+			default:
+				aResult = false;
+			}
+
+			if (!aResult)
+				SDL_Log("Failed to reload %s from %s", aRes->mId.c_str(), theWatchPath.c_str());
+		}
+	}
+
+	if (!hadFailed)
+	{
+		mError = "";
+		mHasFailed = false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::LoadNextResource()
+{
+	if (HadError())
+		return false;
+
+	if (!mCurResGroupList)
+		return false;
+
+	while (mCurResGroupListItr != mCurResGroupList->end())
+	{
+		BaseRes *aRes = *mCurResGroupListItr++;
+		if (aRes->mFromProgram)
+			continue;
+
+		switch (aRes->mType)
+		{
+		case ResType_Image: {
+			ImageRes *anImageRes = (ImageRes *)aRes;
+			if ((SDLImage *)anImageRes->mImage != NULL)
+				continue;
+
+			return DoLoadImageWithPrefetch(anImageRes);
+		}
+
+		case ResType_Sound: {
+			SoundRes *aSoundRes = (SoundRes *)aRes;
+			if (aSoundRes->mSoundId != -1)
+				continue;
+
+			return DoLoadSound(aSoundRes);
+		}
+
+		case ResType_Font: {
+			FontRes *aFontRes = (FontRes *)aRes;
+			if (aFontRes->mFont != NULL)
+				continue;
+
+			return DoLoadFont(aFontRes);
+		}
+		}
+	}
+
+	// The whole group is in, so get a head start on whatever usually comes after it
+	if (!HadError())
+		GroupLoaded(mCurResGroup);
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::ResourceLoadedHook(BaseRes *theRes)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::StartLoadResources(const std::string &theGroup)
+{
+	mError = "";
+	mHasFailed = false;
+
+	mCurResGroup = theGroup;
+	mCurResGroupList = &mResGroupMap[theGroup];
+	mCurResGroupListItr = mCurResGroupList->begin();
+
+	GroupRequested(theGroup);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+void ResourceManager::DumpCurResGroup(std::string &theDestStr)
+{
+	const ResList *rl = &mResGroupMap.find(mCurResGroup)->second;
+	ResList::const_iterator it = rl->begin();
+	theDestStr =
+		StrFormat("About to dump %d elements from current res group name %s\n", rl->size(), mCurResGroup.c_str());
+
+	ResList::const_iterator rl_end = rl->end();
+	while (it != rl_end)
+	{
+		BaseRes *br = *it++;
+		std::string prefix = StrFormat("%s: %s\n", br->mId.c_str(), br->mPath.c_str());
+		theDestStr += prefix;
+		if (br->mFromProgram)
+			theDestStr += std::string("     res is from program\n");
+		else if (br->mType == ResType_Image)
+			theDestStr += std::string("     res is an image\n");
+		else if (br->mType == ResType_Sound)
+			theDestStr += std::string("     res is a sound\n");
+		else if (br->mType == ResType_Font)
+			theDestStr += std::string("     res is a font\n");
+
+		if (it == mCurResGroupListItr)
+			theDestStr += std::string("iterator has reached mCurResGroupItr\n");
+	}
+
+	theDestStr += std::string("Done dumping resources\n");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::LoadResources(const std::string &theGroup)
+{
+	mError = "";
+	mHasFailed = false;
+	StartLoadResources(theGroup);
+	while (LoadNextResource())
+	{
+	}
+
+	if (!HadError())
+	{
+		mLoadedGroups.insert(theGroup);
+		return true;
+	}
+	else
+		return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ResourceManager::GetNumResources(const std::string &theGroup, ResMap &theMap)
+{
+	if (theGroup.empty())
+		return theMap.size();
+
+	int aCount = 0;
+	for (ResMap::iterator anItr = theMap.begin(); anItr != theMap.end(); ++anItr)
+	{
+		BaseRes *aRes = anItr->second;
+		if (aRes->mResGroup == theGroup && !aRes->mFromProgram)
+			++aCount;
+	}
+
+	return aCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ResourceManager::GetNumImages(const std::string &theGroup)
+{
+	return GetNumResources(theGroup, mImageMap);
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -1185,63 +2019,94 @@ int ResourceManager::GetNumResources(const std::string &theGroup)
 ///////////////////////////////////////////////////////////////////////////////
 SharedImageRef ResourceManager::GetImage(const std::string &theId)
 {
-	ResMap::iterator anItr = mImageMap.find(theId);
-	if (anItr != mImageMap.end())
-		return ((ImageRes *)anItr->second)->mImage;
+	return GetImage(GetImageHandle(theId));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ResourceManager::GetSound(const std::string &theId)
+{
+	return GetSound(GetSoundHandle(theId));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+Font *ResourceManager::GetFont(const std::string &theId)
+{
+	return GetFont(GetFontHandle(theId));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ResourceManager::GetResourceHandle(ResType theType, const std::string &theId)
+{
+	ResHandleMap::iterator anItr = mResHandleMap[theType].find(theId);
+	if (anItr != mResHandleMap[theType].end())
+		return anItr->second;
+	else
+		return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ResourceManager::GetImageHandle(const std::string &theId)
+{
+	return GetResourceHandle(ResType_Image, theId);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ResourceManager::GetSoundHandle(const std::string &theId)
+{
+	return GetResourceHandle(ResType_Sound, theId);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ResourceManager::GetFontHandle(const std::string &theId)
+{
+	return GetResourceHandle(ResType_Font, theId);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+SharedImageRef ResourceManager::GetImage(int theHandle)
+{
+	ImageRes *aRes = (ImageRes *)GetHandleRes(theHandle, ResType_Image);
+	if (aRes != NULL)
+		return aRes->mImage;
 	else
 		return NULL;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-int ResourceManager::GetSound(const std::string &theId)
+int ResourceManager::GetSound(int theHandle)
 {
-	ResMap::iterator anItr = mSoundMap.find(theId);
-	if (anItr != mSoundMap.end())
-		return ((SoundRes *)anItr->second)->mSoundId;
+	SoundRes *aRes = (SoundRes *)GetHandleRes(theHandle, ResType_Sound);
+	if (aRes != NULL)
+		return aRes->mSoundId;
 	else
 		return -1;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-Font *ResourceManager::GetFont(const std::string &theId)
+Font *ResourceManager::GetFont(int theHandle)
 {
-	ResMap::iterator anItr = mFontMap.find(theId);
-	if (anItr != mFontMap.end())
-		return ((FontRes *)anItr->second)->mFont;
+	FontRes *aRes = (FontRes *)GetHandleRes(theHandle, ResType_Font);
+	if (aRes != NULL)
+		return aRes->mFont;
 	else
 		return NULL;
 }
 
 ResourceManager::BaseRes *ResourceManager::GetBaseRes(int type, const std::string &theId)
 {
-	switch (type)
-	{
-	case ResType_Image: {
-		ResMap::iterator anItr = mImageMap.find(theId);
-		if (anItr != mImageMap.end())
-			return (ImageRes *)anItr->second;
-		else
-			return NULL;
-	}
-	case ResType_Sound: {
-		ResMap::iterator anItr = mSoundMap.find(theId);
-		if (anItr != mSoundMap.end())
-			return (SoundRes *)anItr->second;
-		else
-			return NULL;
-	}
-	case ResType_Font: {
-		ResMap::iterator anItr = mFontMap.find(theId);
-		if (anItr != mFontMap.end())
-			return (FontRes *)anItr->second;
-		else
-			return NULL;
-	}
-	}
+	if ((type < ResType_Image) || (type > ResType_Font))
+		return NULL;
 
-	return NULL;
+	return GetHandleRes(GetResourceHandle((ResType)type, theId), (ResType)type);
 }
 
 ResourceManager::ResourceRef *ResourceManager::GetFontRef(const std::string &theId)
@@ -1328,6 +2193,57 @@ Font *ResourceManager::GetFontThrow(const std::string &theId)
 	throw ResourceManagerException(GetErrorText());
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+SharedImageRef ResourceManager::GetImageThrow(int theHandle)
+{
+	ImageRes *aRes = (ImageRes *)GetHandleRes(theHandle, ResType_Image);
+	if (aRes != NULL)
+	{
+		if ((MemoryImage *)aRes->mImage != NULL)
+			return aRes->mImage;
+
+		return GetImageThrow(aRes->mId);
+	}
+
+	Fail(StrFormat("Image resource handle not found: %d", theHandle));
+	throw ResourceManagerException(GetErrorText());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ResourceManager::GetSoundThrow(int theHandle)
+{
+	SoundRes *aRes = (SoundRes *)GetHandleRes(theHandle, ResType_Sound);
+	if (aRes != NULL)
+	{
+		if (aRes->mSoundId != -1)
+			return aRes->mSoundId;
+
+		return GetSoundThrow(aRes->mId);
+	}
+
+	Fail(StrFormat("Sound resource handle not found: %d", theHandle));
+	throw ResourceManagerException(GetErrorText());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+Font *ResourceManager::GetFontThrow(int theHandle)
+{
+	FontRes *aRes = (FontRes *)GetHandleRes(theHandle, ResType_Font);
+	if (aRes != NULL)
+	{
+		if (aRes->mFont != NULL)
+			return aRes->mFont;
+
+		return GetFontThrow(aRes->mId);
+	}
+
+	Fail(StrFormat("Font resource handle not found: %d", theHandle));
+	throw ResourceManagerException(GetErrorText());
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 void ResourceManager::SetAllowMissingProgramImages(bool allow)
@@ -7,8 +7,15 @@
 #include "common.hpp"
 #include "graphics/image.hpp"
 #include "appbase.hpp"
+#include "imagecache.hpp"
+#include "resourcemanifest.hpp"
+#include "groupusage.hpp"
+#include "misc/async.hpp"
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
 
 namespace ImageLib
 {
@@ -24,10 +31,21 @@ class Image;
 class SoundInstance;
 class AppBase;
 class Font;
+class FileWatcher;
 
 typedef std::map<std::string, std::string> StringToStringMap;
 typedef std::map<PopString, PopString> XMLParamMap;
 
+struct ResourcePrefetchStats
+{
+	int mPredictions;	 // groups prefetched for
+	int mPredictionHits; // times the next group asked for was the one being prefetched
+	int mImagesPrefetched;
+	int mImagesUsed;
+	int mImagesDiscarded;	// wrong guess, over the memory limit, or loaded some other way first
+	double mStallTimeSaved; // ms of decoding the loads that used prefetched images didn't have to do
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 class ResourceManager
@@ -43,6 +61,7 @@ class ResourceManager
 	struct BaseRes
 	{
 		int mRefCount = 0;
+		int mHandle = -1; // index into mResHandles
 		ResType mType;
 		std::string mId;
 		std::string mResGroup;
@@ -126,6 +145,8 @@ class ResourceManager
 	typedef std::map<std::string, BaseRes *> ResMap;
 	typedef std::list<BaseRes *> ResList;
 	typedef std::map<std::string, ResList, StringLessNoCase> ResGroupMap;
+	typedef std::vector<BaseRes *> ResHandleTable;
+	typedef std::unordered_map<std::string, int> ResHandleMap;
 
 	std::set<std::string, StringLessNoCase> mLoadedGroups;
 
@@ -133,6 +154,9 @@ class ResourceManager
 	ResMap mSoundMap;
 	ResMap mFontMap;
 
+	ResHandleTable mResHandles;	   // every resource ever parsed, indexed by BaseRes::mHandle
+	ResHandleMap mResHandleMap[3]; // id to handle, one per ResType
+
 	XMLParser *mXMLParser;
 	std::string mError;
 	bool mHasFailed;
@@ -148,6 +172,37 @@ class ResourceManager
 	ResList *mCurResGroupList;
 	ResList::iterator mCurResGroupListItr;
 
+	ImageCache mImageCache;
+	bool mUseResourceManifest; // use resources.rmf next to resources.xml when it's up to date
+
+	struct PrefetchedImage
+	{
+		ImageLib::Image *mImage;
+		std::string mPath;
+		double mDecodeTime;
+	};
+	typedef std::map<std::string, PrefetchedImage> PrefetchedImageMap;
+
+	// Everything here is shared with the prefetch jobs on gJobSystem's workers, so only touch it
+	// while holding mPrefetchMutex
+	std::mutex mPrefetchMutex;
+	GroupUsage mGroupUsage;
+	std::string mPrefetchGroup;
+	std::shared_ptr<std::atomic<bool>> mPrefetchCancelled; // set for every job of a prefetch that's been dropped
+	std::set<std::string> mPrefetchQueued;				   // image ids whose jobs haven't started, loads take them over
+	std::set<std::string> mPrefetchDecoding;			   // image ids being decoded right now, loads wait for them
+	std::condition_variable mPrefetchDecoded;
+	PrefetchedImageMap mPrefetchedImages; // by image id
+	int64_t mPrefetchMemory;
+	ResourcePrefetchStats mPrefetchStats;
+
+	typedef std::map<std::string, std::vector<int>> WatchedFileMap;
+
+	// Main thread only, AppBase doesn't hand over a FileWatcher until the loading thread is done
+	FileWatcher *mFileWatcher;
+	WatchedFileMap mWatchedFiles;	  // watch path to the handles of the loaded resources read from it
+	StringToStringMap mResourceFiles; // watch path to the name of a resource XML that's been parsed
+
 	bool Fail(const std::string &theErrorText);
 
 	virtual bool ParseCommonResource(XMLElement &theElement, BaseRes *theRes, ResMap &theMap);
@@ -158,6 +213,8 @@ class ResourceManager
 	virtual bool ParsePIEffectResource(XMLElement &theElement);
 	virtual bool ParseSetDefaults(XMLElement &theElement);
 	virtual bool ParseResources();
+	bool ParseResourceElement(XMLElement &theElement);
+	bool ParseResourcesManifest(ResourceManifest &theManifest);
 
 	bool DoParseResources();
 	void DeleteMap(ResMap &theMap);
@@ -165,12 +222,47 @@ class ResourceManager
 
 	bool LoadAlphaGridImage(ImageRes *theRes, SDLImage *theImage);
 	bool LoadAlphaImage(ImageRes *theRes, SDLImage *theImage);
-	virtual bool DoLoadImage(ImageRes *theRes);
+	void GetImageCacheKey(ImageRes *theRes, std::string &theKey, std::vector<std::string> &theSourceFiles);
+	// Takes theDecodedImage's bits, if there are any, instead of reading the file
+	virtual bool DoLoadImage(ImageRes *theRes, ImageLib::Image *theDecodedImage = NULL);
+	bool DoLoadImageWithPrefetch(ImageRes *theRes);
 	virtual bool DoLoadFont(FontRes *theRes);
 	virtual bool DoLoadSound(SoundRes *theRes);
 	virtual bool DoLoadResource(BaseRes *theRes, bool *fromProgram);
 
 	int GetNumResources(const std::string &theGroup, ResMap &theMap);
+	int GetResourceHandle(ResType theType, const std::string &theId);
+
+	void GroupRequested(const std::string &theGroup);
+	void GroupLoaded(const std::string &theGroup);
+	void DiscardPrefetch();
+	void WaitForPrefetch(std::unique_lock<std::mutex> &theLock, const std::string &theId);
+	bool WaitForPrefetchedImage(const std::string &theId);
+	void PrefetchImage(const std::shared_ptr<std::atomic<bool>> &theCancelled, const std::string &theId,
+					   const std::string &thePath, int theAlphaColor, const std::string &theCacheKey,
+					   const std::vector<std::string> &theCacheSourceFiles);
+
+	void GetResourceFileNames(BaseRes *theRes, std::vector<std::string> &theFileNames);
+	void WatchResource(BaseRes *theRes);
+	bool ReloadImage(ImageRes *theRes);
+	bool ReloadSound(SoundRes *theRes);
+	bool ReloadFont(FontRes *theRes);
+
+	BaseRes *GetHandleRes(int theHandle, ResType theType)
+	{
+		if ((unsigned int)theHandle >= (unsigned int)mResHandles.size())
+			return NULL;
+
+		BaseRes *aRes = mResHandles[theHandle];
+		return (aRes->mType == theType) ? aRes : NULL;
+	}
+
+  public:
+	// When a group finishes loading, the one that has most often been asked for after it (in this or
+	// earlier runs) is prefetched at low priority: image files are decoded ahead of time and held
+	// onto, up to mPrefetchMemoryLimit bytes, and sound files are read through once.
+	bool mPrefetchEnabled;
+	int64_t mPrefetchMemoryLimit;
 
   public:
 	ResourceManager(AppBase *theApp);
@@ -201,13 +293,43 @@ class ResourceManager
 	void DeleteImage(const std::string &theName);
 	SharedImageRef LoadImage(const std::string &theName);
 
+	ImageCache *GetImageCache()
+	{
+		return &mImageCache;
+	}
+
 	void DeleteFont(const std::string &theName);
 	Font *LoadFont(const std::string &theName);
+	int LoadSound(const std::string &theName);
+
+	// These return right away and resolve on the main thread at the start of a later frame.  Image files
+	// are decoded on gJobSystem's workers, sounds and fonts are loaded one per job on the main thread
+	// since the sound manager and font code aren't safe to use from anywhere else.  A failed or
+	// cancelled load resolves to NULL/-1, and LoadGroupAsync to false.
+	Async<SharedImageRef> LoadImageAsync(const std::string &theName);
+	Async<int> LoadSoundAsync(const std::string &theName);
+	Async<Font *> LoadFontAsync(const std::string &theName);
+	Async<bool> LoadGroupAsync(std::string theGroup);
 
 	SharedImageRef GetImage(const std::string &theId);
 	int GetSound(const std::string &theId);
 	Font *GetFont(const std::string &theId);
 
+	// Handles are dense indices handed out as resources are parsed, so the first file parsed numbers
+	// its resources in document order (see ResManifest --header).  Look an id up once and keep the
+	// handle, the lookups below are then just an index into a table.  -1 if the id isn't defined.
+	int GetImageHandle(const std::string &theId);
+	int GetSoundHandle(const std::string &theId);
+	int GetFontHandle(const std::string &theId);
+	int GetNumResourceHandles()
+	{
+		return (int)mResHandles.size();
+	}
+
+	SharedImageRef GetImage(int theHandle);
+	int GetSound(int theHandle);
+	Font *GetFont(int theHandle);
+
 	BaseRes *GetBaseRes(int type, const std::string &theId);
 	ResourceRef *GetFontRef(const std::string &theId);
 	ResourceRef *GetResourceRef(int type, const std::string &theId);
@@ -220,12 +342,18 @@ class ResourceManager
 	virtual SharedImageRef GetImageThrow(const std::string &theId);
 	virtual int GetSoundThrow(const std::string &theId);
 	virtual Font *GetFontThrow(const std::string &theId);
+	SharedImageRef GetImageThrow(int theHandle);
+	int GetSoundThrow(int theHandle);
+	Font *GetFontThrow(int theHandle);
 
 	void SetAllowMissingProgramImages(bool allow);
 
 	virtual void DeleteResources(const std::string &theGroup);
 	void DeleteExtraImageBuffers(const std::string &theGroup);
 
+	typedef std::map<std::string, std::pair<int64_t, int64_t>, StringLessNoCase> GroupMemoryMap; // cpu, texture
+	void GetImageMemoryByGroup(GroupMemoryMap &theMap);
+
 	const ResList *GetCurResGroupList()
 	{
 		return mCurResGroupList;
@@ -235,6 +363,18 @@ class ResourceManager
 		return mCurResGroup;
 	}
 	void DumpCurResGroup(std::string &theDestStr);
+
+	void PrefetchGroup(const std::string &theGroup);
+	void CancelPrefetch();
+	ResourcePrefetchStats GetPrefetchStats();
+	void DumpPrefetchStats(std::string &theDestStr);
+
+	// Hot reloading.  Once there's a watcher, the files of everything loaded and every resource XML
+	// parsed get watched.  A changed image is decoded again straight into the Image everyone already
+	// has, sounds are loaded again under the same id and image fonts get their FontData swapped out,
+	// so nothing holding on to a resource needs to know.  A changed XML is reparsed for new resources.
+	void SetFileWatcher(FileWatcher *theFileWatcher);
+	bool ReloadChangedFile(const std::string &theWatchPath); // false if it's none of ours
 };
 
 ///////////////////////////////////////////////////////////////////////////////
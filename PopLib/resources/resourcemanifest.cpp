@@ -0,0 +1,615 @@
+#include "resourcemanifest.hpp"
+#include "readwrite/xmlparser.hpp"
+#include "paklib/pakinterface.hpp"
+
+#include <zlib.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+
+using namespace PopLib;
+
+static const char RESMANIFEST_MAGIC[4] = {'P', 'R', 'M', 'F'};
+
+// Files in a pak are already sitting decompressed in memory
+static PakRecord *FindPakRecord(const std::string &theFileName)
+{
+	std::string aRealName;
+	if ((gPakInterface == nullptr) || (!gPakInterface->FindFile(theFileName, &aRealName)))
+		return nullptr;
+
+	PakRecordMap::iterator anItr = gPakInterface->mPakRecordMap.find(StringToUpper(aRealName));
+	if (anItr == gPakInterface->mPakRecordMap.end())
+		return nullptr;
+	return &anItr->second;
+}
+
+// The CRC means reading the whole file, so it's only worked out when theCRC is passed
+static bool GetSourceStamp(const std::string &theFileName, uint32_t &theSize, uint64_t &theTime, uint32_t *theCRC)
+{
+	PakRecord *aRecord = FindPakRecord(theFileName);
+	if (aRecord != nullptr)
+	{
+		// Paks don't keep file times
+		theSize = (uint32_t)aRecord->mSize;
+		theTime = 0;
+		if (theCRC != nullptr)
+			*theCRC = crc32(0, aRecord->mCollection->data() + aRecord->mStartPos, (uInt)aRecord->mSize);
+		return true;
+	}
+
+	std::error_code anError;
+	uintmax_t aSize = std::filesystem::file_size(theFileName, anError);
+	if (anError)
+		return false;
+
+	std::filesystem::file_time_type aTime = std::filesystem::last_write_time(theFileName, anError);
+	if (anError)
+		return false;
+
+	theSize = (uint32_t)aSize;
+	theTime = (uint64_t)aTime.time_since_epoch().count();
+	if (theCRC == nullptr)
+		return true;
+
+	FILE *aFP = fopen(theFileName.c_str(), "rb");
+	if (aFP == nullptr)
+		return false;
+
+	std::vector<uchar> aData(theSize);
+	bool aResult = (theSize == 0) || (fread(aData.data(), 1, theSize, aFP) == theSize);
+	fclose(aFP);
+
+	*theCRC = crc32(0, aData.data(), (uInt)theSize);
+	return aResult;
+}
+
+ResourceManifest::ResourceManifest()
+{
+	mData = nullptr;
+	mSize = 0;
+
+	mHeader = nullptr;
+	mStrings = nullptr;
+	mStringData = nullptr;
+	mGroups = nullptr;
+	mSortedGroups = nullptr;
+	mElements = nullptr;
+	mAttributes = nullptr;
+}
+
+ResourceManifest::~ResourceManifest()
+{
+	Close();
+}
+
+bool ResourceManifest::Open(const std::string &theFileName)
+{
+	Close();
+
+	PakRecord *aRecord = FindPakRecord(theFileName);
+	if (aRecord != nullptr)
+	{
+		mData = aRecord->mCollection->data() + aRecord->mStartPos;
+		mSize = aRecord->mSize;
+		if (((uintptr_t)mData & 3) != 0)
+		{
+			mBuffer.assign(mData, mData + mSize);
+			mData = mBuffer.data();
+		}
+		return Validate();
+	}
+
+	if (!mFile.Open(theFileName, sizeof(ResManifestHeader)))
+		return false;
+
+	mData = mFile.GetData();
+	mSize = mFile.GetSize();
+	return Validate();
+}
+
+void ResourceManifest::Close()
+{
+	mFile.Close();
+
+	mData = nullptr;
+	mSize = 0;
+	mBuffer.clear();
+	mHeader = nullptr;
+}
+
+bool ResourceManifest::Validate()
+{
+	if (mSize < sizeof(ResManifestHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const ResManifestHeader *aHeader = (const ResManifestHeader *)mData;
+
+	// Make sure none of the tables run off the end, so the accessors don't have to check
+	struct Table
+	{
+		uint32_t mOffset;
+		uint64_t mSize;
+	};
+	Table aTables[] = {
+		{aHeader->mStringsOffset, (uint64_t)aHeader->mNumStrings * sizeof(ResManifestString)},
+		{aHeader->mStringDataOffset, aHeader->mStringDataSize},
+		{aHeader->mGroupsOffset, (uint64_t)aHeader->mNumGroups * sizeof(ResManifestGroup)},
+		{aHeader->mSortedGroupsOffset, (uint64_t)aHeader->mNumGroups * sizeof(uint32_t)},
+		{aHeader->mElementsOffset, (uint64_t)aHeader->mNumElements * sizeof(ResManifestElement)},
+		{aHeader->mAttributesOffset, (uint64_t)aHeader->mNumAttributes * sizeof(ResManifestAttribute)}};
+
+	bool isValid = (memcmp(aHeader->mMagic, RESMANIFEST_MAGIC, 4) == 0) && (aHeader->mVersion == RESMANIFEST_VERSION);
+	for (int i = 0; (isValid) && (i < (int)(sizeof(aTables) / sizeof(aTables[0]))); i++)
+		isValid = ((aTables[i].mOffset & 3) == 0) && ((uint64_t)aTables[i].mOffset + aTables[i].mSize <= mSize);
+
+	if (!isValid)
+	{
+		Close();
+		return false;
+	}
+
+	mHeader = aHeader;
+	mStrings = (const ResManifestString *)(mData + aHeader->mStringsOffset);
+	mStringData = (const char *)(mData + aHeader->mStringDataOffset);
+	mGroups = (const ResManifestGroup *)(mData + aHeader->mGroupsOffset);
+	mSortedGroups = (const uint32_t *)(mData + aHeader->mSortedGroupsOffset);
+	mElements = (const ResManifestElement *)(mData + aHeader->mElementsOffset);
+	mAttributes = (const ResManifestAttribute *)(mData + aHeader->mAttributesOffset);
+	return true;
+}
+
+bool ResourceManifest::MatchesSource(const std::string &theXMLFileName)
+{
+	if (mHeader == nullptr)
+		return false;
+
+	uint32_t aSize = 0;
+	uint64_t aTime = 0;
+	if ((!GetSourceStamp(theXMLFileName, aSize, aTime, nullptr)) || (aSize != mHeader->mSourceSize))
+		return false;
+
+#ifdef RELEASEFINAL
+	// Shipped data doesn't change underneath us, so don't bother reading the XML just to checksum it
+	return true;
+#else
+	// An untouched file keeps its time, so only read it all in to checksum it when the time moved
+	// (a fresh checkout, or a copy) or there's no time to go on
+	if ((aTime != 0) && (aTime == mHeader->mSourceTime))
+		return true;
+
+	uint32_t aCRC = 0;
+	if (!GetSourceStamp(theXMLFileName, aSize, aTime, &aCRC))
+		return false;
+	return aCRC == mHeader->mSourceCRC;
+#endif
+}
+
+const char *ResourceManifest::GetString(uint32_t theIndex, uint32_t *theLength)
+{
+	if ((mHeader == nullptr) || (theIndex >= mHeader->mNumStrings))
+	{
+		if (theLength != nullptr)
+			*theLength = 0;
+		return "";
+	}
+
+	const ResManifestString &aString = mStrings[theIndex];
+	if ((uint64_t)aString.mOffset + aString.mLength >= mHeader->mStringDataSize)
+	{
+		if (theLength != nullptr)
+			*theLength = 0;
+		return "";
+	}
+
+	if (theLength != nullptr)
+		*theLength = aString.mLength;
+	return mStringData + aString.mOffset;
+}
+
+int ResourceManifest::FindGroup(const std::string &theId)
+{
+	if (mHeader == nullptr)
+		return -1;
+
+	int aLow = 0;
+	int aHigh = (int)mHeader->mNumGroups - 1;
+	while (aLow <= aHigh)
+	{
+		int aMid = (aLow + aHigh) / 2;
+		uint32_t aGroup = mSortedGroups[aMid];
+		if (aGroup >= mHeader->mNumGroups)
+			return -1;
+
+		int aCompare = _stricmp(GetString(mGroups[aGroup].mId), theId.c_str());
+		if (aCompare == 0)
+			return (int)aGroup;
+		else if (aCompare < 0)
+			aLow = aMid + 1;
+		else
+			aHigh = aMid - 1;
+	}
+
+	return -1;
+}
+
+std::string ResourceManifest::GetManifestFileName(const std::string &theXMLFileName)
+{
+	std::string::size_type aDotPos = theXMLFileName.rfind('.');
+	std::string::size_type aSlashPos = theXMLFileName.find_last_of("\\/");
+	if ((aDotPos == std::string::npos) || ((aSlashPos != std::string::npos) && (aDotPos < aSlashPos)))
+		return theXMLFileName + ".rmf";
+
+	return theXMLFileName.substr(0, aDotPos) + ".rmf";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+static std::string GetHandleName(const std::string &theId)
+{
+	std::string aName = theId;
+	for (int i = 0; i < (int)aName.length(); i++)
+	{
+		if (!isalnum((uchar)aName[i]))
+			aName[i] = '_';
+	}
+
+	if ((aName.empty()) || (isdigit((uchar)aName[0])))
+		aName = "_" + aName;
+	return aName + "_HANDLE";
+}
+
+bool ResourceManifest::WriteHandleHeader(const std::string &theHeaderFileName, std::string &theError)
+{
+	if (mHeader == nullptr)
+	{
+		theError = "No manifest open";
+		return false;
+	}
+
+	static const char *aTypeNames[3] = {"Image", "Sound", "Font"};
+
+	std::string aText = "// Generated by ResManifest, do not edit\n"
+						"#pragma once\n\n"
+						"namespace ResHandles\n{\n\n";
+
+	// Follow the same defaults and id rules as ResourceManager::ParseCommonResource, a handle is
+	// taken for each resource in document order
+	std::string aDefaultPath;
+	std::string aDefaultIdPrefix;
+	std::unordered_set<std::string> aDefinedIds[3];
+	std::unordered_set<std::string> aNames;
+	int aNumHandles = 0;
+
+	for (uint32_t aGroupIdx = 0; aGroupIdx < mHeader->mNumGroups; aGroupIdx++)
+	{
+		const ResManifestGroup &aGroup = mGroups[aGroupIdx];
+		aText += StrFormat("// %s\n", GetString(aGroup.mId));
+
+		uint32_t anEnd = std::min(aGroup.mFirstElement + aGroup.mNumElements, mHeader->mNumElements);
+		for (uint32_t anElementIdx = aGroup.mFirstElement; anElementIdx < anEnd; anElementIdx++)
+		{
+			const ResManifestElement &anElement = mElements[anElementIdx];
+			std::string aName = GetString(anElement.mName);
+
+			std::string aPath, anId, aDefaultsIdPrefix;
+			bool hasId = false, hasDefaultsPath = false, hasDefaultsIdPrefix = false;
+
+			uint32_t anAttrEnd = std::min(anElement.mFirstAttribute + anElement.mNumAttributes, mHeader->mNumAttributes);
+			for (uint32_t anAttrIdx = anElement.mFirstAttribute; anAttrIdx < anAttrEnd; anAttrIdx++)
+			{
+				std::string aKey = GetString(mAttributes[anAttrIdx].mKey);
+				const char *aValue = GetString(mAttributes[anAttrIdx].mValue);
+				if (aKey == "path")
+				{
+					aPath = aValue;
+					hasDefaultsPath = true;
+				}
+				else if (aKey == "id")
+				{
+					anId = aValue;
+					hasId = true;
+				}
+				else if (aKey == "idprefix")
+				{
+					aDefaultsIdPrefix = aValue;
+					hasDefaultsIdPrefix = true;
+				}
+			}
+
+			if (aName == "SetDefaults")
+			{
+				if (hasDefaultsPath)
+					aDefaultPath = RemoveTrailingSlash(aPath) + '/';
+				if (hasDefaultsIdPrefix)
+					aDefaultIdPrefix = RemoveTrailingSlash(aDefaultsIdPrefix);
+				continue;
+			}
+
+			int aType = -1;
+			for (int i = 0; i < 3; i++)
+			{
+				if (aName == aTypeNames[i])
+					aType = i;
+			}
+
+			if ((aType < 0) || (aPath.empty()))
+				continue;
+
+			if (aPath[0] != '!')
+				aPath = aDefaultPath + aPath;
+			anId = aDefaultIdPrefix + (hasId ? anId : GetFileName(aPath, true));
+
+			if (!aDefinedIds[aType].insert(anId).second)
+			{
+				theError = "Resource already defined: " + anId;
+				return false;
+			}
+
+			// Ids only have to be unique per type
+			std::string aHandleName = GetHandleName(anId);
+			if (!aNames.insert(aHandleName).second)
+			{
+				aHandleName = StringToUpper(aTypeNames[aType]) + "_" + aHandleName;
+				if (!aNames.insert(aHandleName).second)
+				{
+					theError = "Duplicate handle name: " + aHandleName;
+					return false;
+				}
+			}
+
+			aText += StrFormat("constexpr int %s = %d;\n", aHandleName.c_str(), aNumHandles++);
+		}
+
+		aText += "\n";
+	}
+
+	aText += StrFormat("constexpr int NUM_HANDLES = %d;\n\n} // namespace ResHandles\n", aNumHandles);
+
+	FILE *aFP = fopen(theHeaderFileName.c_str(), "wb");
+	if (aFP == nullptr)
+	{
+		theError = "Failed to write " + theHeaderFileName;
+		return false;
+	}
+
+	bool aResult = fwrite(aText.data(), 1, aText.size(), aFP) == aText.size();
+	aResult = (fclose(aFP) == 0) && aResult;
+	if (!aResult)
+		theError = "Failed to write " + theHeaderFileName;
+	return aResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+
+class ResManifestWriter
+{
+  public:
+	std::vector<ResManifestString> mStrings;
+	std::string mStringData;
+	std::unordered_map<std::string, uint32_t> mStringIndices;
+	std::vector<ResManifestGroup> mGroups;
+	std::vector<ResManifestElement> mElements;
+	std::vector<ResManifestAttribute> mAttributes;
+
+	uint32_t AddString(const std::string &theString)
+	{
+		std::unordered_map<std::string, uint32_t>::iterator anItr = mStringIndices.find(theString);
+		if (anItr != mStringIndices.end())
+			return anItr->second;
+
+		ResManifestString aString;
+		aString.mOffset = (uint32_t)mStringData.size();
+		aString.mLength = (uint32_t)theString.length();
+		mStringData.append(theString);
+		mStringData.push_back('\0');
+
+		uint32_t anIndex = (uint32_t)mStrings.size();
+		mStrings.push_back(aString);
+		mStringIndices[theString] = anIndex;
+		return anIndex;
+	}
+
+	static void Align(std::string &theData)
+	{
+		while (theData.size() & 3)
+			theData.push_back('\0');
+	}
+
+	template <typename T> static uint32_t AppendTable(std::string &theData, const std::vector<T> &theTable)
+	{
+		Align(theData);
+		uint32_t anOffset = (uint32_t)theData.size();
+		if (!theTable.empty())
+			theData.append((const char *)theTable.data(), theTable.size() * sizeof(T));
+		return anOffset;
+	}
+
+	bool Write(const std::string &theFileName, uint32_t theSourceSize, uint64_t theSourceTime, uint32_t theSourceCRC)
+	{
+		std::vector<uint32_t> aSortedGroups(mGroups.size());
+		for (uint32_t i = 0; i < (uint32_t)mGroups.size(); i++)
+			aSortedGroups[i] = i;
+
+		// Stable so duplicate ids keep document order, and FindGroup lands on one of them
+		std::stable_sort(aSortedGroups.begin(), aSortedGroups.end(), [this](uint32_t a, uint32_t b) {
+			return _stricmp(mStringData.c_str() + mStrings[mGroups[a].mId].mOffset,
+							mStringData.c_str() + mStrings[mGroups[b].mId].mOffset) < 0;
+		});
+
+		ResManifestHeader aHeader;
+		memset(&aHeader, 0, sizeof(aHeader));
+		memcpy(aHeader.mMagic, RESMANIFEST_MAGIC, 4);
+		aHeader.mVersion = RESMANIFEST_VERSION;
+		aHeader.mSourceSize = theSourceSize;
+		aHeader.mSourceCRC = theSourceCRC;
+		aHeader.mSourceTime = theSourceTime;
+		aHeader.mNumStrings = (uint32_t)mStrings.size();
+		aHeader.mNumGroups = (uint32_t)mGroups.size();
+		aHeader.mNumElements = (uint32_t)mElements.size();
+		aHeader.mNumAttributes = (uint32_t)mAttributes.size();
+
+		std::string aData((const char *)&aHeader, sizeof(aHeader));
+		aHeader.mStringsOffset = AppendTable(aData, mStrings);
+		aHeader.mGroupsOffset = AppendTable(aData, mGroups);
+		aHeader.mSortedGroupsOffset = AppendTable(aData, aSortedGroups);
+		aHeader.mElementsOffset = AppendTable(aData, mElements);
+		aHeader.mAttributesOffset = AppendTable(aData, mAttributes);
+		Align(aData);
+		aHeader.mStringDataOffset = (uint32_t)aData.size();
+		aHeader.mStringDataSize = (uint32_t)mStringData.size();
+		aData.append(mStringData);
+		memcpy(&aData[0], &aHeader, sizeof(aHeader));
+
+		std::string aTempFileName = theFileName + ".tmp";
+		FILE *aFP = fopen(aTempFileName.c_str(), "wb");
+		if (aFP == nullptr)
+			return false;
+
+		bool aResult = fwrite(aData.data(), 1, aData.size(), aFP) == aData.size();
+		aResult = (fclose(aFP) == 0) && aResult;
+
+		std::error_code anError;
+		if (aResult)
+			std::filesystem::rename(aTempFileName, theFileName, anError);
+		if ((!aResult) || (anError))
+		{
+			std::filesystem::remove(aTempFileName, anError);
+			return false;
+		}
+		return true;
+	}
+};
+
+} // namespace
+
+bool ResourceManifest::Compile(const std::string &theXMLFileName, const std::string &theManifestFileName,
+							   std::string &theError)
+{
+	uint32_t aSourceSize = 0;
+	uint64_t aSourceTime = 0;
+	uint32_t aSourceCRC = 0;
+	if (!GetSourceStamp(theXMLFileName, aSourceSize, aSourceTime, &aSourceCRC))
+	{
+		theError = "Resource file not found: " + theXMLFileName;
+		return false;
+	}
+
+	XMLParser aParser;
+	if (!aParser.OpenFile(theXMLFileName))
+	{
+		theError = "Resource file not found: " + theXMLFileName;
+		return false;
+	}
+
+	ResManifestWriter aWriter;
+	XMLNodeView aNode;
+	std::vector<const XMLAttributeView *> aSortedAttributes;
+
+	// Same structure ResourceManager::ParseResourcesFile expects, anything else is left for it to report
+	bool inManifest = false;
+	ResManifestGroup *aGroup = nullptr;
+	while (aParser.NextNode(aNode))
+	{
+		if (aNode.mType == XMLElement::TYPE_START)
+		{
+			if (!inManifest)
+			{
+				if (aNode.mValue != "ResourceManifest")
+					break;
+				inManifest = true;
+			}
+			else if (aGroup == nullptr)
+			{
+				if (aNode.mValue != "Resources")
+				{
+					theError = "Invalid Section '" + aNode.GetValue() + "'";
+					return false;
+				}
+
+				std::string anId;
+				aNode.GetAttribute("id", anId);
+
+				ResManifestGroup aNewGroup;
+				aNewGroup.mId = aWriter.AddString(anId);
+				aNewGroup.mFirstElement = (uint32_t)aWriter.mElements.size();
+				aNewGroup.mNumElements = 0;
+				aWriter.mGroups.push_back(aNewGroup);
+				aGroup = &aWriter.mGroups.back();
+			}
+			else
+			{
+				ResManifestElement aResElement;
+				aResElement.mName = aWriter.AddString(aNode.GetValue());
+				aResElement.mFirstAttribute = (uint32_t)aWriter.mAttributes.size();
+
+				// Written in XMLParamMap order with the later of any duplicates, ParseResourcesManifest relies on it
+				aSortedAttributes.clear();
+				for (const XMLAttributeView &anAttribute : aNode.mAttributes)
+					aSortedAttributes.push_back(&anAttribute);
+				std::stable_sort(aSortedAttributes.begin(), aSortedAttributes.end(),
+								 [](const XMLAttributeView *a, const XMLAttributeView *b) { return a->mKey < b->mKey; });
+
+				for (size_t i = 0; i < aSortedAttributes.size(); i++)
+				{
+					if ((i + 1 < aSortedAttributes.size()) &&
+						(aSortedAttributes[i + 1]->mKey == aSortedAttributes[i]->mKey))
+						continue;
+
+					ResManifestAttribute anAttribute;
+					anAttribute.mKey = aWriter.AddString(std::string(aSortedAttributes[i]->mKey));
+					anAttribute.mValue = aWriter.AddString(aSortedAttributes[i]->GetValue());
+					aWriter.mAttributes.push_back(anAttribute);
+				}
+				aResElement.mNumAttributes = (uint32_t)aWriter.mAttributes.size() - aResElement.mFirstAttribute;
+
+				aWriter.mElements.push_back(aResElement);
+				aGroup->mNumElements++;
+
+				if ((!aParser.NextNode(aNode)) || (aNode.mType != XMLElement::TYPE_END))
+				{
+					theError = StrFormat("Unexpected element found on Line %d", aParser.GetCurrentLineNum());
+					return false;
+				}
+			}
+		}
+		else if (aNode.mType == XMLElement::TYPE_END)
+		{
+			if (aGroup != nullptr)
+				aGroup = nullptr;
+			else
+				inManifest = false;
+		}
+		else if (aNode.mType == XMLElement::TYPE_ELEMENT)
+		{
+			theError = "Element Not Expected '" + aNode.GetValue() + "'";
+			return false;
+		}
+	}
+
+	if (aParser.HasFailed())
+	{
+		theError = aParser.GetErrorText();
+		return false;
+	}
+
+	if (aWriter.mGroups.empty())
+	{
+		theError = "Expecting ResourceManifest tag";
+		return false;
+	}
+
+	if (!aWriter.Write(theManifestFileName, aSourceSize, aSourceTime, aSourceCRC))
+	{
+		theError = "Failed to write " + theManifestFileName;
+		return false;
+	}
+
+	return true;
+}
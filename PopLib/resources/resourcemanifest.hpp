@@ -0,0 +1,110 @@
+#ifndef __RESOURCEMANIFEST_HPP__
+#define __RESOURCEMANIFEST_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+#include "misc/mappedfile.hpp"
+
+namespace PopLib
+{
+
+const uint32_t RESMANIFEST_VERSION = 2;
+
+// The file is this header followed by the tables it points at.  Every string (group ids, element
+// names, attribute keys and values) is stored once in the string table, and all offsets are from
+// the start of the file, so the whole thing can be used straight out of a mapping.
+struct ResManifestHeader
+{
+	char mMagic[4];
+	uint32_t mVersion;
+	uint32_t mSourceSize; // size and CRC of the XML file this was compiled from
+	uint32_t mSourceCRC;
+	uint32_t mNumStrings;
+	uint32_t mStringsOffset;
+	uint32_t mStringDataOffset;
+	uint32_t mStringDataSize;
+	uint32_t mNumGroups;
+	uint32_t mGroupsOffset;
+	uint32_t mSortedGroupsOffset; // group indices sorted by id, case insensitively
+	uint32_t mNumElements;
+	uint32_t mElementsOffset;
+	uint32_t mNumAttributes;
+	uint32_t mAttributesOffset;
+	uint32_t mReserved;
+	uint64_t mSourceTime; // modification time of the XML file, 0 if it came from a pak
+};
+
+struct ResManifestString
+{
+	uint32_t mOffset; // into the string data, strings are also null terminated
+	uint32_t mLength;
+};
+
+// One per <Resources> block, in document order
+struct ResManifestGroup
+{
+	uint32_t mId;
+	uint32_t mFirstElement;
+	uint32_t mNumElements;
+};
+
+struct ResManifestElement
+{
+	uint32_t mName; // Image, Sound, Font, SetDefaults...
+	uint32_t mFirstAttribute;
+	uint32_t mNumAttributes;
+};
+
+struct ResManifestAttribute
+{
+	uint32_t mKey;
+	uint32_t mValue;
+};
+
+// Read side of a compiled resources.xml.  Files inside a pak are used from the pak's memory,
+// loose files are mapped in.
+class ResourceManifest
+{
+  protected:
+	const uchar *mData;
+	size_t mSize;
+	MappedFile mFile;
+	std::vector<uchar> mBuffer; // copy of a pak record that wasn't aligned well enough to use in place
+
+  public:
+	const ResManifestHeader *mHeader;
+	const ResManifestString *mStrings;
+	const char *mStringData;
+	const ResManifestGroup *mGroups;
+	const uint32_t *mSortedGroups;
+	const ResManifestElement *mElements;
+	const ResManifestAttribute *mAttributes;
+
+  protected:
+	bool Validate();
+
+  public:
+	ResourceManifest();
+	virtual ~ResourceManifest();
+
+	bool Open(const std::string &theFileName);
+	void Close();
+	bool MatchesSource(const std::string &theXMLFileName);
+
+	const char *GetString(uint32_t theIndex, uint32_t *theLength = nullptr);
+	int FindGroup(const std::string &theId);
+
+	// Writes constexpr resource handles for every Image, Sound and Font, matching the handles
+	// ResourceManager hands out when this is the first resource file it parses
+	bool WriteHandleHeader(const std::string &theHeaderFileName, std::string &theError);
+
+	static std::string GetManifestFileName(const std::string &theXMLFileName);
+	static bool Compile(const std::string &theXMLFileName, const std::string &theManifestFileName,
+						std::string &theError);
+};
+
+} // namespace PopLib
+
+#endif // __RESOURCEMANIFEST_HPP__
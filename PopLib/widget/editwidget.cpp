@@ -40,6 +40,106 @@ EditWidget::~EditWidget()
 	ClearWidthCheckFonts();
 }
 
+static bool IsContinuationByte(PopChar theChar)
+{
+	return ((uchar)theChar & 0xC0) == 0x80;
+}
+
+void EditWidget::PrefixWidths::Update(Font *theFont, const PopString &theString)
+{
+	if (mWidths.empty())
+	{
+		mString.clear();
+		mWidths.push_back(0);
+	}
+
+	int anOldLength = (int)mString.length();
+	int aNewLength = (int)theString.length();
+	int aMinLength = std::min(anOldLength, aNewLength);
+
+	int aStart = 0;
+	while ((aStart < aMinLength) && (mString[aStart] == theString[aStart]))
+		aStart++;
+
+	if ((aStart == anOldLength) && (aStart == aNewLength))
+		return;
+
+	int aTailLength = 0;
+	while ((aTailLength < aMinLength - aStart) &&
+		   (mString[anOldLength - 1 - aTailLength] == theString[aNewLength - 1 - aTailLength]))
+		aTailLength++;
+
+	// Widths up to aStart stand, the changed span gets measured, and the unchanged tail moves over
+	int aDiff = aNewLength - anOldLength;
+	if (aDiff > 0)
+		mWidths.insert(mWidths.begin() + aStart + 1, aDiff, 0);
+	else if (aDiff < 0)
+		mWidths.erase(mWidths.begin() + aStart + 1, mWidths.begin() + aStart + 1 - aDiff);
+
+	// A char can take several bytes, so measuring starts at the char holding the first change, in either
+	// string.  Whatever the font reads, a char never starts on a UTF-8 continuation byte.
+	int aPos = aStart;
+	while ((aPos > 0) && ((IsContinuationByte(theString[aPos])) || (IsContinuationByte(mString[aPos]))))
+		aPos--;
+
+	uint32_t aPrevChar = 0;
+	if (aPos > 0)
+	{
+		ulong aPrevPos = aPos - 1;
+		while ((aPrevPos > 0) && (IsContinuationByte(theString[aPrevPos])))
+			aPrevPos--;
+		while ((int)aPrevPos < aPos)
+			aPrevChar = theFont->GetNextChar(theString, aPrevPos);
+	}
+
+	// The first tail char is measured again too, as it may kern differently against its new neighbour.
+	// Bytes inside a char get the width up to its end, so GetFitLength never cuts one in half.
+	int aTailStart = aNewLength - aTailLength;
+	while (aPos < aNewLength)
+	{
+		int aCharStart = aPos;
+		ulong aNextPos = aPos;
+		uint32_t aChar = theFont->GetNextChar(theString, aNextPos);
+		aPos = (int)aNextPos;
+
+		bool isTail =
+			(aTailLength > 0) && (aCharStart >= aTailStart) && (!IsContinuationByte(theString[aCharStart]));
+		int anOldTailWidth = mWidths[aPos];
+
+		int aWidth = mWidths[aCharStart] + theFont->CharWidthKern(aChar, aPrevChar);
+		for (int i = aCharStart + 1; i <= aPos; i++)
+			mWidths[i] = aWidth;
+		aPrevChar = aChar;
+
+		if (isTail)
+		{
+			int aDelta = aWidth - anOldTailWidth;
+			if (aDelta != 0)
+			{
+				for (int i = aPos + 1; i <= aNewLength; i++)
+					mWidths[i] += aDelta;
+			}
+			break;
+		}
+	}
+
+	mString = theString;
+}
+
+int EditWidget::PrefixWidths::GetWidth(int thePos) const
+{
+	return mWidths[std::min(std::max(thePos, 0), (int)mString.length())];
+}
+
+int EditWidget::PrefixWidths::GetFitLength(int theMaxWidth) const
+{
+	int aLength = (int)mString.length();
+	while ((aLength > 0) && (mWidths[aLength] > theMaxWidth))
+		aLength--;
+
+	return aLength;
+}
+
 void EditWidget::ClearWidthCheckFonts()
 {
 	for (WidthCheckList::iterator anItr = mWidthCheckList.begin(); anItr != mWidthCheckList.end(); ++anItr)
@@ -85,6 +185,12 @@ PopString &EditWidget::GetDisplayString()
 	return mPasswordDisplayString;
 }
 
+EditWidget::PrefixWidths &EditWidget::GetDisplayWidths()
+{
+	mDisplayWidths.Update(mFont, GetDisplayString());
+	return mDisplayWidths;
+}
+
 bool EditWidget::WantsFocus()
 {
 	return true;
@@ -101,6 +207,8 @@ void EditWidget::SetFont(Font *theFont, Font *theWidthCheckFont)
 {
 	delete mFont;
 	mFont = theFont->Duplicate();
+	mDisplayWidths = PrefixWidths();
+	mStringWidths = PrefixWidths();
 
 	ClearWidthCheckFonts();
 	if (theWidthCheckFont != NULL)
@@ -113,6 +221,7 @@ void EditWidget::Draw(Graphics *g) // Already translated
 		mFont = new SysFont(mWidgetManager->mApp, LiberationSans_Regular, LiberationSans_Regular_Size, 10, false);
 
 	PopString &aString = GetDisplayString();
+	PrefixWidths &aWidths = GetDisplayWidths();
 
 	g->SetColor(mColors[COLOR_BKG]);
 	g->FillRect(0, 0, mWidth, mHeight);
@@ -124,12 +233,10 @@ void EditWidget::Draw(Graphics *g) // Already translated
 
 		if (i == 1)
 		{
-			int aCursorX =
-				mFont->StringWidth(aString.substr(0, mCursorPos)) - mFont->StringWidth(aString.substr(0, mLeftPos));
+			int aCursorX = aWidths.GetWidth(mCursorPos) - aWidths.GetWidth(mLeftPos);
 			int aHiliteX = aCursorX + 2;
 			if ((mHilitePos != -1) && (mCursorPos != mHilitePos))
-				aHiliteX =
-					mFont->StringWidth(aString.substr(0, mHilitePos)) - mFont->StringWidth(aString.substr(0, mLeftPos));
+				aHiliteX = aWidths.GetWidth(mHilitePos) - aWidths.GetWidth(mLeftPos);
 
 			if (!mShowingCursor)
 				aCursorX += 2;
@@ -223,8 +330,9 @@ void EditWidget::EnforceMaxPixels()
 
 	if (mWidthCheckList.empty())
 	{
-		while (mFont->StringWidth(mString) > mMaxPixels)
-			mString = mString.substr(0, mString.length() - 1);
+		PrefixWidths &aWidths = (mPasswordChar == 0) ? mDisplayWidths : mStringWidths;
+		aWidths.Update(mFont, mString);
+		mString.resize(aWidths.GetFitLength(mMaxPixels));
 
 		return;
 	}
@@ -239,8 +347,8 @@ void EditWidget::EnforceMaxPixels()
 				continue;
 		}
 
-		while (anItr->mFont->StringWidth(mString) > aWidth)
-			mString = mString.substr(0, mString.length() - 1);
+		anItr->mPrefixWidths.Update(anItr->mFont, mString);
+		mString.resize(anItr->mPrefixWidths.GetFitLength(aWidth));
 	}
 }
 
@@ -310,7 +418,7 @@ void EditWidget::ProcessKey(KeyCode theKey, PopChar theChar)
 				if ((aBaseString[i] == '\r') || (aBaseString[i] == '\n'))
 					break;
 
-				if (mFont->CharWidth(aBaseString[i]) != 0 && mEditListener->AllowChar(mId, aBaseString[i]))
+				if (mFont->CharWidth((uchar)aBaseString[i]) != 0 && mEditListener->AllowChar(mId, aBaseString[i]))
 					aString += aBaseString[i];
 			}
 
@@ -549,22 +657,25 @@ void EditWidget::KeyChar(PopChar theChar)
 
 int EditWidget::GetCharAt(int x, int y)
 {
-	int aPos = 0;
-
-	PopString &aString = GetDisplayString();
+	PrefixWidths &aWidths = GetDisplayWidths();
+	int aLeftWidth = aWidths.GetWidth(mLeftPos);
 
-	for (int i = mLeftPos; i < (int)aString.length(); i++)
+	// Find the first char whose middle is past x, the widths only grow so the middles do too
+	int aLo = mLeftPos;
+	int aHi = (int)aWidths.mString.length();
+	while (aLo < aHi)
 	{
-		PopString aLoSubStr = aString.substr(mLeftPos, i - mLeftPos);
-		PopString aHiSubStr = aString.substr(mLeftPos, i - mLeftPos + 1);
+		int aMid = (aLo + aHi) / 2;
 
-		int aLoLen = mFont->StringWidth(aLoSubStr);
-		int aHiLen = mFont->StringWidth(aHiSubStr);
+		int aLoLen = aWidths.GetWidth(aMid) - aLeftWidth;
+		int aHiLen = aWidths.GetWidth(aMid + 1) - aLeftWidth;
 		if (x >= (aLoLen + aHiLen) / 2 + 5)
-			aPos = i + 1;
+			aLo = aMid + 1;
+		else
+			aHi = aMid;
 	}
 
-	return aPos;
+	return (aLo > mLeftPos) ? aLo : 0;
 }
 
 void EditWidget::FocusCursor(bool bigJump)
@@ -580,10 +691,8 @@ void EditWidget::FocusCursor(bool bigJump)
 
 	if (mFont != NULL)
 	{
-		PopString &aString = GetDisplayString();
-		while ((mWidth - 8 > 0) &&
-			   (mFont->StringWidth(aString.substr(0, mCursorPos)) - mFont->StringWidth(aString.substr(0, mLeftPos)) >=
-				mWidth - 8))
+		PrefixWidths &aWidths = GetDisplayWidths();
+		while ((mWidth - 8 > 0) && (aWidths.GetWidth(mCursorPos) - aWidths.GetWidth(mLeftPos) >= mWidth - 8))
 		{
 			if (bigJump)
 				mLeftPos = std::min(mLeftPos + 10, (int)mString.length() - 1);
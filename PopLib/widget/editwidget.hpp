@@ -30,10 +30,23 @@ class EditWidget : public Widget
 	PopString mPasswordDisplayString;
 	Font *mFont;
 
+	// Width of every prefix of a string in one font.  Update only remeasures the span that changed
+	// since the last call, everything after it just shifts.
+	struct PrefixWidths
+	{
+		PopString mString;
+		std::vector<int> mWidths; // of mString's first i bytes, plus the rest of any char they end inside
+
+		void Update(Font *theFont, const PopString &theString);
+		int GetWidth(int thePos) const;
+		int GetFitLength(int theMaxWidth) const;
+	};
+
 	struct WidthCheck
 	{
 		Font *mFont;
 		int mWidth;
+		PrefixWidths mPrefixWidths;
 	};
 	typedef std::list<WidthCheck> WidthCheckList;
 	WidthCheckList mWidthCheckList;
@@ -57,11 +70,15 @@ class EditWidget : public Widget
 	int mUndoHilitePos;
 	int mLastModifyIdx;
 
+	PrefixWidths mDisplayWidths; // of GetDisplayString() in mFont
+	PrefixWidths mStringWidths;	 // of mString in mFont, only used with a password char
+
   protected:
 	virtual void ProcessKey(KeyCode theKey, PopChar theChar);
 	PopString &GetDisplayString();
 	virtual void HiliteWord();
 	void UpdateCaretPos();
+	PrefixWidths &GetDisplayWidths();
 
   public:
 	virtual void SetFont(Font *theFont, Font *theWidthCheckFont = NULL);
@@ -10,6 +10,11 @@ using namespace PopLib;
 static int gInitialListWidgetColors[][3] = {{255, 255, 255}, {255, 255, 255}, {0, 0, 0},
 											{0, 192, 0},	 {0, 0, 128},	  {255, 255, 255}};
 
+static bool LineLess(const PopString &theLine1, const PopString &theLine2)
+{
+	return strcmp(theLine1.c_str(), theLine2.c_str()) < 0;
+}
+
 ListWidget::ListWidget(int theId, Font *theFont, ListListener *theListListener)
 {
 	mJustify = JUSTIFY_LEFT;
@@ -32,6 +37,7 @@ ListWidget::ListWidget(int theId, Font *theFont, ListListener *theListListener)
 	mPosition = 0;
 	mPageSize = 0;
 	mSortFromChild = false;
+	mLinesAscending = true;
 	mDrawOutline = true;
 	mMaxNumericPlaces = 0;
 	mDrawSelectWhenHilited = false;
@@ -53,8 +59,8 @@ PopString ListWidget::GetSortKey(int theIdx)
 {
 	PopString aString = mLines[theIdx];
 
-	while (aString.length() < (ulong)mMaxNumericPlaces)
-		aString = "0" + aString;
+	if (aString.length() < (ulong)mMaxNumericPlaces)
+		aString.insert(0, mMaxNumericPlaces - aString.length(), '0');
 
 	if (mSortFromChild)
 		return mChild->GetSortKey(theIdx) + aString;
@@ -72,8 +78,8 @@ PopString ListWidget::GetSortKey(int theIdx)
 void ListWidget::Sort(bool ascending)
 {
 	int aCount = mLines.size();
-	int *aMap = new int[aCount];
-	PopString *aKeys = new PopString[aCount];
+	std::vector<int> aMap(aCount);
+	PopStringVector aKeys(aCount);
 
 	int i;
 	for (i = 0; i < aCount; i++)
@@ -82,21 +88,11 @@ void ListWidget::Sort(bool ascending)
 		aKeys[i] = GetSortKey(i);
 	}
 
-	for (i = 1; i < aCount; i++)
-		for (int j = 0; j < aCount - i; j++)
-		{
-			int aComp = aKeys[j].compare(aKeys[j + 1]);
-			if ((ascending && (aComp > 0)) || (!ascending && (aComp < 0)))
-			{
-				int aSwapInt = aMap[j];
-				aMap[j] = aMap[j + 1];
-				aMap[j + 1] = aSwapInt;
-
-				PopString aSwapKey = aKeys[j];
-				aKeys[j] = aKeys[j + 1];
-				aKeys[j + 1] = aSwapKey;
-			}
-		}
+	// Stable, so equal keys keep their order like they did with the old bubble sort
+	if (ascending)
+		std::stable_sort(aMap.begin(), aMap.end(), [&aKeys](int a, int b) { return aKeys[a] < aKeys[b]; });
+	else
+		std::stable_sort(aMap.begin(), aMap.end(), [&aKeys](int a, int b) { return aKeys[b] < aKeys[a]; });
 
 	ListWidget *aListWidget = this;
 	while (aListWidget->mParent != NULL)
@@ -104,25 +100,27 @@ void ListWidget::Sort(bool ascending)
 
 	while (aListWidget != NULL)
 	{
-		PopStringVector aNewLines;
-		ColorVector aNewLineColors;
+		PopStringVector aNewLines(aCount);
+		ColorVector aNewLineColors(aCount);
 
-		for (int i = 0; i < aCount; i++)
+		for (i = 0; i < aCount; i++)
 		{
-			aNewLines.push_back(aListWidget->mLines[aMap[i]]);
-			aNewLineColors.push_back(aListWidget->mLineColors[aMap[i]]);
+			aNewLines[i] = std::move(aListWidget->mLines[aMap[i]]);
+			aNewLineColors[i] = aListWidget->mLineColors[aMap[i]];
 		}
 
-		aListWidget->mLines = aNewLines;
-		aListWidget->mLineColors = aNewLineColors;
+		aListWidget->mLines.swap(aNewLines);
+		aListWidget->mLineColors.swap(aNewLineColors);
+		aListWidget->mLinesAscending = false;
 
 		aListWidget->MarkDirty();
 
 		aListWidget = aListWidget->mChild;
 	}
 
-	delete aMap;
-	delete aKeys;
+	// Only a lone list's keys are its own lines as they are
+	if ((ascending) && (mParent == NULL) && (mChild == NULL) && (mMaxNumericPlaces == 0))
+		mLinesAscending = true;
 }
 
 PopString ListWidget::GetStringAt(int theIdx)
@@ -146,6 +144,20 @@ void ListWidget::Resize(int theX, int theY, int theWidth, int theHeight)
 		mScrollbar->SetPageSize(aPageSize);
 }
 
+int ListWidget::GetAlphabeticalPos(const PopString &theLine)
+{
+	// Lines in order put it after the last line that isn't greater
+	if (mLinesAscending)
+		return std::upper_bound(mLines.begin(), mLines.end(), theLine, LineLess) - mLines.begin();
+
+	// Otherwise it goes before the first greater line, wherever that is
+	for (int i = 0; i < (int)mLines.size(); i++)
+		if (LineLess(theLine, mLines[i]))
+			return i;
+
+	return mLines.size();
+}
+
 int ListWidget::AddLine(const PopString &theLine, bool alphabetical)
 {
 	int anIdx = -1;
@@ -153,32 +165,34 @@ int ListWidget::AddLine(const PopString &theLine, bool alphabetical)
 
 	if (alphabetical)
 	{
-		for (int i = 0; i < (int)mLines.size(); i++)
-			if (strcmp(theLine.c_str(), mLines[i].c_str()) < 0)
-			{
-				anIdx = i;
+		int i = GetAlphabeticalPos(theLine);
+		if (i < (int)mLines.size())
+		{
+			anIdx = i;
 
-				ListWidget *aListWidget = this;
+			ListWidget *aListWidget = this;
 
-				while (aListWidget->mParent != NULL)
-					aListWidget = aListWidget->mParent;
+			while (aListWidget->mParent != NULL)
+				aListWidget = aListWidget->mParent;
 
-				while (aListWidget != NULL)
+			while (aListWidget != NULL)
+			{
+				if (aListWidget == this)
+					aListWidget->mLines.insert(aListWidget->mLines.begin() + i, theLine);
+				else
 				{
-					if (aListWidget == this)
-						aListWidget->mLines.insert(aListWidget->mLines.begin() + i, theLine);
-					else
-						aListWidget->mLines.insert(aListWidget->mLines.begin() + i, "-");
-
-					aListWidget->mLineColors.insert(aListWidget->mLineColors.begin() + i, mColors[COLOR_TEXT]);
-					aListWidget->MarkDirty();
-
-					aListWidget = aListWidget->mChild;
+					aListWidget->mLines.insert(aListWidget->mLines.begin() + i, "-");
+					aListWidget->mLinesAscending = false;
 				}
 
-				inserted = true;
-				break;
+				aListWidget->mLineColors.insert(aListWidget->mLineColors.begin() + i, mColors[COLOR_TEXT]);
+				aListWidget->MarkDirty();
+
+				aListWidget = aListWidget->mChild;
 			}
+
+			inserted = true;
+		}
 	}
 
 	if (!inserted)
@@ -193,9 +207,16 @@ int ListWidget::AddLine(const PopString &theLine, bool alphabetical)
 		while (aListWidget != NULL)
 		{
 			if (aListWidget == this)
+			{
+				if ((!mLines.empty()) && (LineLess(theLine, mLines.back())))
+					mLinesAscending = false;
 				aListWidget->mLines.push_back(theLine);
+			}
 			else
+			{
 				aListWidget->mLines.push_back("-");
+				aListWidget->mLinesAscending = false;
+			}
 
 			aListWidget->mLineColors.push_back(mColors[COLOR_TEXT]);
 			aListWidget->MarkDirty();
@@ -210,8 +231,105 @@ int ListWidget::AddLine(const PopString &theLine, bool alphabetical)
 	return anIdx;
 }
 
+void ListWidget::AddLines(const PopStringVector &theLines, bool alphabetical)
+{
+	int aNewCount = theLines.size();
+	if (aNewCount == 0)
+		return;
+
+	int i;
+	if ((alphabetical) && (!mLinesAscending))
+	{
+		// Can't merge into lines that aren't in order, they go in one at a time like AddLine's
+		for (i = 0; i < aNewCount; i++)
+			AddLine(theLines[i], true);
+		return;
+	}
+
+	// Sort the new lines once, find where each lands among the old ones, then merge every linked list in
+	// a single pass instead of inserting line by line.  Ties go after equal lines, just like AddLine.
+	std::vector<int> anOrder(aNewCount);
+	std::vector<int> anInsertPos(aNewCount, (int)mLines.size());
+
+	for (i = 0; i < aNewCount; i++)
+		anOrder[i] = i;
+
+	if (alphabetical)
+	{
+		std::stable_sort(anOrder.begin(), anOrder.end(),
+						 [&theLines](int a, int b) { return LineLess(theLines[a], theLines[b]); });
+
+		for (i = 0; i < aNewCount; i++)
+			anInsertPos[i] =
+				std::upper_bound(mLines.begin(), mLines.end(), theLines[anOrder[i]], LineLess) - mLines.begin();
+	}
+
+	ListWidget *aListWidget = this;
+
+	while (aListWidget->mParent != NULL)
+		aListWidget = aListWidget->mParent;
+
+	while (aListWidget != NULL)
+	{
+		int anOldCount = aListWidget->mLines.size();
+
+		PopStringVector aNewLines;
+		ColorVector aNewLineColors;
+		aNewLines.reserve(anOldCount + aNewCount);
+		aNewLineColors.reserve(anOldCount + aNewCount);
+
+		int anOldIdx = 0;
+		for (i = 0; i < aNewCount; i++)
+		{
+			for (; anOldIdx < anInsertPos[i]; anOldIdx++)
+			{
+				aNewLines.push_back(std::move(aListWidget->mLines[anOldIdx]));
+				aNewLineColors.push_back(aListWidget->mLineColors[anOldIdx]);
+			}
+
+			if (aListWidget == this)
+			{
+				if ((!alphabetical) && (!aNewLines.empty()) && (LineLess(theLines[anOrder[i]], aNewLines.back())))
+					mLinesAscending = false;
+				aNewLines.push_back(theLines[anOrder[i]]);
+			}
+			else
+			{
+				aNewLines.push_back("-");
+				aListWidget->mLinesAscending = false;
+			}
+			aNewLineColors.push_back(mColors[COLOR_TEXT]);
+		}
+
+		for (; anOldIdx < anOldCount; anOldIdx++)
+		{
+			aNewLines.push_back(std::move(aListWidget->mLines[anOldIdx]));
+			aNewLineColors.push_back(aListWidget->mLineColors[anOldIdx]);
+		}
+
+		aListWidget->mLines.swap(aNewLines);
+		aListWidget->mLineColors.swap(aNewLineColors);
+		aListWidget->MarkDirty();
+
+		aListWidget = aListWidget->mChild;
+	}
+
+	if (mScrollbar != NULL)
+		mScrollbar->SetMaxValue(mLines.size());
+}
+
+void ListWidget::SetLines(const PopStringVector &theLines, bool alphabetical)
+{
+	RemoveAll();
+	AddLines(theLines, alphabetical);
+}
+
 void ListWidget::SetLine(int theIdx, const PopString &theString)
 {
+	if (((theIdx > 0) && (LineLess(theString, mLines[theIdx - 1]))) ||
+		((theIdx + 1 < (int)mLines.size()) && (LineLess(mLines[theIdx + 1], theString))))
+		mLinesAscending = false;
+
 	mLines[theIdx] = theString;
 	MarkDirty();
 }
@@ -296,6 +414,7 @@ void ListWidget::RemoveAll()
 		aListWidget->mLineColors.clear();
 		aListWidget->mSelectIdx = -1;
 		aListWidget->mHiliteIdx = -1;
+		aListWidget->mLinesAscending = true;
 
 		aListWidget->MarkDirty();
 		aListWidget = aListWidget->mChild;
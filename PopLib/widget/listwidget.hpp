@@ -53,6 +53,7 @@ class ListWidget : public Widget, public ScrollListener
 	ListWidget *mParent;
 	ListWidget *mChild;
 	bool mSortFromChild;
+	bool mLinesAscending; // mLines is known to be in strcmp order, so alphabetical adds can bisect
 	bool mDrawOutline;
 	int mMaxNumericPlaces;
 	int mItemHeight;
@@ -61,6 +62,7 @@ class ListWidget : public Widget, public ScrollListener
 	bool mDoFingerWhenHilited;
 
 	void SetHilite(int theHiliteIdx, bool notifyListener = false);
+	int GetAlphabeticalPos(const PopString &theLine);
 
   public:
 	ListWidget(int theId, Font *theFont, ListListener *theListListener);
@@ -73,6 +75,8 @@ class ListWidget : public Widget, public ScrollListener
 	virtual PopString GetStringAt(int theIdx);
 	virtual void Resize(int theX, int theY, int theWidth, int theHeight);
 	virtual int AddLine(const PopString &theLine, bool alphabetical);
+	virtual void AddLines(const PopStringVector &theLines, bool alphabetical);
+	virtual void SetLines(const PopStringVector &theLines, bool alphabetical);
 	virtual void SetLine(int theIdx, const PopString &theString);
 	virtual int GetLineCount();
 	virtual int GetLineIdx(const PopString &theLine);
@@ -6,6 +6,9 @@
 
 using namespace PopLib;
 
+// Followed by red, green and blue bytes
+static const PopChar COLOR_MARKER = (PopChar)0xFF;
+
 TextWidget::TextWidget()
 {
 	mFont = NULL;
@@ -14,22 +17,49 @@ TextWidget::TextWidget()
 	mStickToBottom = true;
 	mMaxLines = 2048;
 	mScrollbar = NULL;
+	mRowBase = 0;
+	mWrapWidth = -1;
+
+	for (int i = 0; i < 2; i++)
+	{
+		mHiliteArea[i][0] = 0;
+		mHiliteArea[i][1] = 0;
+	}
 }
 
 PopStringVector TextWidget::GetLines()
 {
-	return mLogicalLines;
+	PopStringVector aLines;
+	aLines.reserve(mLines.size());
+	for (int i = 0; i < (int)mLines.size(); i++)
+		aLines.push_back(mLines[i].mText);
+
+	return aLines;
 }
 
 void TextWidget::SetLines(PopStringVector theNewLines)
 {
-	mLogicalLines = theNewLines;
+	mLines.clear();
+	mRowBase = 0;
+
+	// Each line is a single row until it gets wrapped in view
+	for (int i = 0; i < (int)theNewLines.size(); i++)
+	{
+		TextLine &aLine = mLines.push_back();
+		aLine.mText = theNewLines[i];
+		aLine.mRows.assign(1, theNewLines[i]);
+		aLine.mFirstRow = i;
+		aLine.mWrapWidth = -1;
+	}
+
+	WrapVisibleLines();
+	MarkDirty();
 }
 
 void TextWidget::Clear()
 {
-	mLogicalLines.clear();
-	mPhysicalLines.clear();
+	mLines.clear();
+	mRowBase = 0;
 	mPosition = 0.0;
 	mScrollbar->SetMaxValue(0.0);
 	MarkDirty();
@@ -45,7 +75,7 @@ void TextWidget::DrawColorString(Graphics *g, const PopString &theString, int x,
 	PopString aCurString = "";
 	for (int i = 0; i < (int)theString.length(); i++)
 	{
-		if (theString[i] == 0x100)
+		if (theString[i] == COLOR_MARKER)
 		{
 			if (aCurString.length() > 0)
 				g->DrawString(aCurString, x + aWidth, y);
@@ -105,24 +135,36 @@ int TextWidget::GetStringIndex(const PopString &theString, int thePixel)
 
 // UNICODE
 int TextWidget::GetColorStringWidth(const PopString &theString)
+{
+	return GetColorStringWidth(theString, 0, theString.length());
+}
+
+int TextWidget::GetColorStringWidth(const PopString &theString, int theStart, int theEnd)
 {
 	int aWidth = 0;
 	PopString aTempString;
 
-	for (int i = 0; i < (int)theString.length(); i++)
+	int aRunStart = theStart;
+	for (int i = theStart; i < theEnd; i++)
 	{
-		if (theString[i] == 0x100)
+		if (theString[i] == COLOR_MARKER)
 		{
-			aWidth += mFont->StringWidth(aTempString);
-			aTempString = "";
+			if (i > aRunStart)
+			{
+				aTempString.assign(theString, aRunStart, i - aRunStart);
+				aWidth += mFont->StringWidth(aTempString);
+			}
 
 			i += 3;
+			aRunStart = i + 1;
 		}
-		else
-			aTempString += theString[i];
 	}
 
-	aWidth += mFont->StringWidth(aTempString);
+	if (theEnd > aRunStart)
+	{
+		aTempString.assign(theString, aRunStart, theEnd - aRunStart);
+		aWidth += mFont->StringWidth(aTempString);
+	}
 
 	return aWidth;
 }
@@ -136,40 +178,35 @@ void TextWidget::Resize(int theX, int theY, int theWidth, int theHeight)
 		aPageSize = (mHeight - 8.0) / mFont->GetHeight();
 
 	int aLogValue = 0;
-	if (mLineMap.size() > 0)
-	{
-		// IntIntMap::iterator anItr = mLineMap.find(mScrollbar->mValue);
-
-		aLogValue = mLineMap[(int)mScrollbar->mValue];
-	}
-
-	int aNewPhysValue = 0;
-
-	mLineMap.clear();
-	mPhysicalLines.clear();
-	for (int i = 0; i < (int)mLogicalLines.size(); i++)
-	{
-		if (i == aLogValue)
-			aNewPhysValue = mPhysicalLines.size();
-
-		AddToPhysicalLines(i, mLogicalLines[i]);
-	}
+	if (!mLines.empty())
+		aLogValue = GetLineForRow((int)mScrollbar->mValue);
 
 	bool atBottom = mScrollbar->AtBottom();
 
+	// Every line is out of date now, but only the ones coming into view get wrapped again
+	mWrapWidth = mWidth - 8;
 	mPageSize = aPageSize;
-	mScrollbar->SetMaxValue(mPhysicalLines.size());
+	WrapLines(aLogValue, (int)aPageSize + 2);
+
+	int aNewPhysValue = 0;
+	if (!mLines.empty())
+		aNewPhysValue = mLines[aLogValue].mFirstRow - mRowBase;
+
+	mScrollbar->SetMaxValue(GetNumPhysicalLines());
 	mScrollbar->SetPageSize((int)aPageSize);
 	mScrollbar->SetValue(aNewPhysValue);
 
 	if ((mStickToBottom) && (atBottom))
+	{
 		mScrollbar->GoToBottom();
+		WrapVisibleLines();
+	}
 }
 
 // UNICODE
 Color TextWidget::GetLastColor(const PopString &theString)
 {
-	int anIdx = theString.rfind((char)0xFF);
+	int anIdx = theString.rfind(COLOR_MARKER);
 	if (anIdx < 0)
 		return Color(0, 0, 0);
 
@@ -177,92 +214,192 @@ Color TextWidget::GetLastColor(const PopString &theString)
 }
 
 // UNICODE
-void TextWidget::AddToPhysicalLines(int theIdx, const PopString &theLine)
+void TextWidget::WrapLine(TextLine &theLine)
 {
-	PopString aCurString = "";
+	const PopString &aText = theLine.mText;
+	int aTextLength = (int)aText.length();
+	int aNumRows = 0;
 
-	if (GetColorStringWidth(theLine) <= mWidth - 8)
+	theLine.mWrapWidth = mWrapWidth;
+
+	if ((mWrapWidth < 0) || (GetColorStringWidth(aText) <= mWrapWidth))
 	{
-		aCurString = theLine;
+		theLine.mRows.resize(1);
+		theLine.mRows[0] = aText;
+		return;
 	}
-	else
+
+	// Rows are appended to word by word, keeping a running width instead of measuring the row again
+	if (theLine.mRows.empty())
+		theLine.mRows.resize(1);
+	PopString *aCurString = &theLine.mRows[0];
+	aCurString->clear();
+	int aCurWidth = 0;
+
+	int aCurPos = 0;
+	while (aCurPos < aTextLength)
 	{
-		int aCurPos = 0;
-		while (aCurPos < (int)theLine.length())
+		int aNextCheckPos = aCurPos;
+		while ((aNextCheckPos < aTextLength) && (aText[aNextCheckPos] == ' '))
+			aNextCheckPos++;
+
+		int aSpacePos = aText.find(' ', aNextCheckPos);
+		if (aSpacePos == -1)
+			aSpacePos = aTextLength;
+
+		int aWordWidth = GetColorStringWidth(aText, aCurPos, aSpacePos);
+		if (aCurWidth + aWordWidth > mWrapWidth)
 		{
-			int aNextCheckPos = aCurPos;
-			while ((aNextCheckPos < (int)theLine.length()) && (theLine[aNextCheckPos] == ' '))
-				aNextCheckPos++;
+			Color aColor = GetLastColor(*aCurString);
+
+			aNumRows++;
+			if ((int)theLine.mRows.size() <= aNumRows)
+				theLine.mRows.resize(aNumRows + 1);
+			aCurString = &theLine.mRows[aNumRows];
+
+			aCurString->assign("  ");
+			*aCurString += COLOR_MARKER;
+			*aCurString += (PopChar)aColor.mRed;
+			*aCurString += (PopChar)aColor.mGreen;
+			*aCurString += (PopChar)aColor.mBlue;
+			aCurString->append(aText, aNextCheckPos, aSpacePos - aNextCheckPos);
+			aCurWidth = GetColorStringWidth(*aCurString);
+		}
+		else
+		{
+			aCurString->append(aText, aCurPos, aSpacePos - aCurPos);
+			aCurWidth += aWordWidth;
+		}
+
+		aCurPos = aSpacePos;
+	}
 
-			int aSpacePos = theLine.find(" ", aNextCheckPos);
-			if (aSpacePos == -1)
-				aSpacePos = theLine.length();
+	if ((!aCurString->empty()) || (aText.empty()))
+		aNumRows++;
+	theLine.mRows.resize(aNumRows);
+}
 
-			PopString aNewString = aCurString + theLine.substr(aCurPos, aSpacePos - aCurPos);
-			if (GetColorStringWidth(aNewString) > mWidth - 8)
-			{
-				mPhysicalLines.push_back(aCurString);
-				mLineMap.push_back(theIdx);
-				Color aColor = GetLastColor(aCurString);
-				aCurString = "  " + PopChar(0xFF) + (PopChar)aColor.mRed + (PopChar)aColor.mGreen +
-							 (PopChar)aColor.mBlue + theLine.substr(aNextCheckPos, aSpacePos - aNextCheckPos);
-			}
-			else
-				aCurString = aNewString;
+void TextWidget::UpdateRowNumbers(int theFirstLine)
+{
+	for (int i = std::max(theFirstLine, 1); i < (int)mLines.size(); i++)
+		mLines[i].mFirstRow = mLines[i - 1].mFirstRow + (int)mLines[i - 1].mRows.size();
+}
+
+void TextWidget::WrapLines(int theFirstLine, int theNumRows)
+{
+	int aFirstChanged = -1;
+	int aNumRows = 0;
+
+	for (int i = theFirstLine; (i < (int)mLines.size()) && (aNumRows < theNumRows); i++)
+	{
+		TextLine &aLine = mLines[i];
+		if (aLine.mWrapWidth != mWrapWidth)
+		{
+			int anOldNumRows = (int)aLine.mRows.size();
+			WrapLine(aLine);
 
-			aCurPos = aSpacePos;
+			if (((int)aLine.mRows.size() != anOldNumRows) && (aFirstChanged == -1))
+				aFirstChanged = i + 1;
 		}
+
+		aNumRows += (int)aLine.mRows.size();
 	}
 
-	if ((aCurString.compare("") != 0) || (theLine.compare("") == 0))
+	if (aFirstChanged != -1)
+		UpdateRowNumbers(aFirstChanged);
+}
+
+void TextWidget::WrapVisibleLines()
+{
+	if ((mLines.empty()) || (mScrollbar == NULL))
+		return;
+
+	int aNumRows = GetNumPhysicalLines();
+	WrapLines(GetLineForRow((int)mPosition), (int)mPageSize + 2);
+
+	if (GetNumPhysicalLines() != aNumRows)
 	{
-		mPhysicalLines.push_back(aCurString);
-		mLineMap.push_back(theIdx);
+		bool atBottom = mScrollbar->AtBottom();
+		mScrollbar->SetMaxValue(GetNumPhysicalLines());
+		if ((mStickToBottom) && (atBottom))
+			mScrollbar->GoToBottom();
 	}
 }
 
-// UNICODE
-void TextWidget::AddLine(const PopString &theLine)
+int TextWidget::GetNumPhysicalLines()
 {
-	PopString aLine = theLine;
-
-	if (aLine.compare("") == 0)
-		aLine = " ";
+	if (mLines.empty())
+		return 0;
 
-	bool atBottom = mScrollbar->AtBottom();
+	TextLine &aLastLine = mLines.back();
+	return aLastLine.mFirstRow + (int)aLastLine.mRows.size() - mRowBase;
+}
 
-	mLogicalLines.push_back(aLine);
+int TextWidget::GetLineForRow(int theRow)
+{
+	int aRow = theRow + mRowBase;
 
-	if ((int)mLogicalLines.size() > mMaxLines)
+	// Last line starting at or before aRow
+	int aLo = 0;
+	int aHi = (int)mLines.size() - 1;
+	while (aLo < aHi)
 	{
-		// Remove an extra 10 lines, for safty
-		int aNumLinesToRemove = mLogicalLines.size() - mMaxLines + 10;
+		int aMid = (aLo + aHi + 1) / 2;
+		if (mLines[aMid].mFirstRow <= aRow)
+			aLo = aMid;
+		else
+			aHi = aMid - 1;
+	}
 
-		mLogicalLines.erase(mLogicalLines.begin(), mLogicalLines.begin() + aNumLinesToRemove);
+	return aLo;
+}
 
-		int aPhysLineRemoveCount = 0;
+const PopString &TextWidget::GetPhysicalLine(int theRow)
+{
+	TextLine &aLine = mLines[GetLineForRow(theRow)];
+	int aRowIdx = std::min(std::max(theRow + mRowBase - aLine.mFirstRow, 0), (int)aLine.mRows.size() - 1);
+	return aLine.mRows[aRowIdx];
+}
 
-		// Remove all physical lines and linemap entries relating to deleted logical lines
-		while (mLineMap[aPhysLineRemoveCount] < aNumLinesToRemove)
-		{
-			aPhysLineRemoveCount++;
-		}
+// UNICODE
+void TextWidget::AddLine(const PopString &theLine)
+{
+	bool atBottom = mScrollbar->AtBottom();
+
+	if (mLines.empty())
+		mRowBase = 0;
+
+	int aFirstRow = mRowBase;
+	if (!mLines.empty())
+		aFirstRow = mLines.back().mFirstRow + (int)mLines.back().mRows.size();
+
+	TextLine &aLine = mLines.push_back();
+	aLine.mText = theLine;
+	if (aLine.mText.empty())
+		aLine.mText = " ";
+	aLine.mFirstRow = aFirstRow;
+	WrapLine(aLine);
+
+	if ((mMaxLines > 0) && ((int)mLines.size() > mMaxLines))
+	{
+		while ((int)mLines.size() > mMaxLines)
+			mLines.pop_front();
 
-		mLineMap.erase(mLineMap.begin(), mLineMap.begin() + aPhysLineRemoveCount);
-		mPhysicalLines.erase(mPhysicalLines.begin(), mPhysicalLines.begin() + aPhysLineRemoveCount);
+		int aNumRowsRemoved = mLines.front().mFirstRow - mRowBase;
+		mRowBase = mLines.front().mFirstRow;
 
-		// Offset the line map numbers
-		int i;
-		for (i = 0; i < (int)mLineMap.size(); i++)
+		// Keep the row numbers well away from overflowing on a log that runs for days
+		if (mRowBase > 0x40000000)
 		{
-			mLineMap[i] -= aNumLinesToRemove;
+			for (int i = 0; i < (int)mLines.size(); i++)
+				mLines[i].mFirstRow -= mRowBase;
+			mRowBase = 0;
 		}
-		// mLineMap.setElementAt(new Integer(((Integer) mLineMap.elementAt(i)).intValue() - aNumLinesToRemove), i);
 
 		// Move the hilited area
-		for (i = 0; i < 2; i++)
+		for (int i = 0; i < 2; i++)
 		{
-			mHiliteArea[i][1] -= aNumLinesToRemove;
+			mHiliteArea[i][1] -= aNumRowsRemoved;
 			if (mHiliteArea[i][1] < 0)
 			{
 				mHiliteArea[i][0] = 0;
@@ -270,12 +407,10 @@ void TextWidget::AddLine(const PopString &theLine)
 			}
 		}
 
-		mScrollbar->SetValue(mScrollbar->mValue - aNumLinesToRemove);
+		mScrollbar->SetValue(mScrollbar->mValue - aNumRowsRemoved);
 	}
 
-	AddToPhysicalLines(mLogicalLines.size() - 1, aLine);
-
-	mScrollbar->SetMaxValue(mPhysicalLines.size());
+	mScrollbar->SetMaxValue(GetNumPhysicalLines());
 
 	if (atBottom)
 		mScrollbar->GoToBottom();
@@ -301,12 +436,20 @@ void TextWidget::GetSelectedIndices(int theLineIdx, int *theIndices)
 		else if (mHiliteArea[aPosIdx][1] == theLineIdx)
 			aVal = mHiliteArea[aPosIdx][0];
 		else
-			aVal = mPhysicalLines[theLineIdx].length();
+			aVal = GetPhysicalLine(theLineIdx).length();
 
 		theIndices[aPosIdx ^ aXor] = aVal;
 	}
 }
 
+void TextWidget::Update()
+{
+	Widget::Update();
+
+	// Lines scrolled into view are wrapped here rather than in Draw, as it can move the scrollbar
+	WrapVisibleLines();
+}
+
 void TextWidget::Draw(Graphics *g)
 {
 	g->SetColor(Color(255, 255, 255));
@@ -319,12 +462,12 @@ void TextWidget::Draw(Graphics *g)
 	aClipG.SetFont(mFont);
 
 	int aFirstLine = (int)mPosition;
-	int aLastLine = std::min((int)mPhysicalLines.size() - 1, (int)mPosition + (int)mPageSize + 1);
+	int aLastLine = std::min(GetNumPhysicalLines() - 1, (int)mPosition + (int)mPageSize + 1);
 
 	for (int i = aFirstLine; i <= aLastLine; i++)
 	{
 		int aYPos = 4 + (int)((i - (int)mPosition) * mFont->GetHeight()) + mFont->GetAscent();
-		PopString aString = mPhysicalLines[i];
+		const PopString &aString = GetPhysicalLine(i);
 
 		int aHilitePos[2];
 		GetSelectedIndices(i, aHilitePos);
@@ -346,17 +489,17 @@ void TextWidget::GetTextIndexAt(int x, int y, int *thePosArray)
 		thePosArray[0] = 0;
 		thePosArray[1] = 0;
 	}
-	else if (aLineNum < (int)mPhysicalLines.size())
+	else if (aLineNum < GetNumPhysicalLines())
 	{
-		thePosArray[0] = GetStringIndex(mPhysicalLines[aLineNum], x);
+		thePosArray[0] = GetStringIndex(GetPhysicalLine(aLineNum), x);
 		thePosArray[1] = aLineNum;
 	}
 	else
 	{
-		if (mPhysicalLines.size() > 0)
+		if (GetNumPhysicalLines() > 0)
 		{
-			thePosArray[0] = mPhysicalLines[mPhysicalLines.size() - 1].length();
-			thePosArray[1] = mPhysicalLines.size() - 1;
+			thePosArray[0] = GetPhysicalLine(GetNumPhysicalLines() - 1).length();
+			thePosArray[1] = GetNumPhysicalLines() - 1;
 		}
 	}
 }
@@ -388,7 +531,7 @@ PopString TextWidget::GetSelection()
 	bool reverse = SelectionReversed();
 	for (int aLineNum = mHiliteArea[reverse ? 1 : 0][1]; aLineNum <= mHiliteArea[reverse ? 0 : 1][1]; aLineNum++)
 	{
-		PopString aString = mPhysicalLines[aLineNum];
+		const PopString &aString = GetPhysicalLine(aLineNum);
 
 		GetSelectedIndices(aLineNum, aSelIndices);
 
@@ -398,7 +541,7 @@ PopString TextWidget::GetSelection()
 		for (int aStrIdx = aSelIndices[0]; aStrIdx < aSelIndices[1]; aStrIdx++)
 		{
 			PopChar aChar = aString[aStrIdx];
-			if (aChar != 0x100)
+			if (aChar != COLOR_MARKER)
 				aSelString += aChar;
 			else
 				aStrIdx += 3;
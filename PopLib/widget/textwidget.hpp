@@ -6,6 +6,7 @@
 
 #include "widget.hpp"
 #include "scrolllistener.hpp"
+#include "misc/ringbuffer.hpp"
 
 namespace PopLib
 {
@@ -19,18 +20,34 @@ typedef std::vector<int> IntVector;
 class TextWidget : public Widget, public ScrollListener
 {
   public:
+	// A logical line and the rows it wraps to
+	struct TextLine
+	{
+		PopString mText;
+		PopStringVector mRows;
+		int mFirstRow;	// counted from the first line added, minus mRowBase to get the scroll row
+		int mWrapWidth; // width mRows were wrapped to, lines are only rewrapped once they're in view
+	};
+	typedef RingBuffer<TextLine> TextLineBuffer;
+
 	Font *mFont;
 	ScrollbarWidget *mScrollbar;
 
-	PopStringVector mLogicalLines;
-	PopStringVector mPhysicalLines;
-	IntVector mLineMap;
+	TextLineBuffer mLines;
+	int mRowBase;
+	int mWrapWidth;
 	double mPosition;
 	double mPageSize;
 	bool mStickToBottom;
 	int mHiliteArea[2][2];
 	int mMaxLines;
 
+  protected:
+	int GetColorStringWidth(const PopString &theString, int theStart, int theEnd);
+	void UpdateRowNumbers(int theFirstLine);
+	void WrapLines(int theFirstLine, int theNumRows);
+	void WrapVisibleLines();
+
   public:
 	TextWidget();
 
@@ -45,11 +62,16 @@ class TextWidget : public Widget, public ScrollListener
 	virtual int GetColorStringWidth(const PopString &theString);
 	virtual void Resize(int theX, int theY, int theWidth, int theHeight);
 	virtual Color GetLastColor(const PopString &theString);
-	virtual void AddToPhysicalLines(int theIdx, const PopString &theLine);
+	virtual void WrapLine(TextLine &theLine);
+
+	int GetNumPhysicalLines();
+	int GetLineForRow(int theRow);
+	const PopString &GetPhysicalLine(int theRow);
 
 	virtual void AddLine(const PopString &theString);
 	virtual bool SelectionReversed();
 	virtual void GetSelectedIndices(int theLineIdx, int *theIndices);
+	virtual void Update();
 	virtual void Draw(Graphics *g);
 	virtual void ScrollPosition(int theId, double thePosition);
 	virtual void GetTextIndexAt(int x, int y, int *thePosArray);
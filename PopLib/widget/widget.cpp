@@ -3,6 +3,8 @@
 #include "graphics/graphics.hpp"
 #include "graphics/font.hpp"
 #include "graphics/image.hpp"
+#include "graphics/sdlimage.hpp"
+#include "graphics/sdlinterface.hpp"
 #include "appbase.hpp"
 #include "debug/debug.hpp"
 #include <cmath>
@@ -25,10 +27,18 @@ Widget::Widget()
 	mWantsFocus = false;
 	mTabPrev = NULL;
 	mTabNext = NULL;
+	mUseDrawCache = false;
+	mDrawCacheDirty = true;
+	mDrawCache = NULL;
+	mDrawCacheSize = 0;
 }
 
 Widget::~Widget()
 {
+	if (mWidgetManager != NULL)
+		mWidgetManager->ReleaseDrawCache(this);
+	delete mDrawCache;
+
 	mColors.clear();
 }
 
@@ -60,6 +70,7 @@ void Widget::WidgetRemovedHelper()
 	RemovedFromManager(mWidgetManager);
 	MarkDirtyFull(this);
 
+	mWidgetManager->ReleaseDrawCache(this);
 	mWidgetManager = NULL;
 }
 
@@ -92,6 +103,99 @@ void Widget::Draw(Graphics *g) // Already translated
 {
 }
 
+void Widget::DrawAll(ModalFlags *theFlags, Graphics *g)
+{
+	if ((mUseDrawCache) && (DrawCached(theFlags, g)))
+		return;
+
+	if ((!mUseDrawCache) && (mDrawCache != NULL) && (mWidgetManager != NULL))
+		mWidgetManager->ReleaseDrawCache(this);
+
+	WidgetContainer::DrawAll(theFlags, g);
+}
+
+bool Widget::DrawCached(ModalFlags *theFlags, Graphics *g)
+{
+	if ((mWidgetManager == NULL) || (!g->Is3D()) || (mWidth <= 0) || (mHeight <= 0))
+		return false;
+
+	if (!(GetModFlags(theFlags->GetFlags(), mWidgetFlagsMod) & WIDGETFLAGS_DRAW))
+		return false;
+
+	SDLInterface *anInterface = mWidgetManager->mApp->mSDLInterface;
+
+	if ((mDrawCache != NULL) && ((mDrawCache->mWidth != mWidth) || (mDrawCache->mHeight != mHeight)))
+		mWidgetManager->ReleaseDrawCache(this);
+
+	if (mDrawCache == NULL)
+	{
+		if (!mWidgetManager->ReserveDrawCache(this, mWidth * mHeight * sizeof(ulong)))
+			return false;
+
+		// Only ever lives on the GPU, so it gets a size but no bits
+		mDrawCache = new SDLImage(anInterface);
+		mDrawCache->mWidth = mWidth;
+		mDrawCache->mHeight = mHeight;
+		mDrawCache->mHasAlpha = true;
+		if (!anInterface->CreateRenderTarget(mDrawCache))
+		{
+			mWidgetManager->ReleaseDrawCache(this);
+			return false;
+		}
+
+		mDrawCacheDirty = true;
+	}
+	else
+		mWidgetManager->TouchDrawCache(this);
+
+	if (mDrawCacheDirty)
+	{
+		// Cleared first so children calling MarkDirty while drawing still invalidate the layer
+		mDrawCacheDirty = false;
+
+		Graphics aCacheG(*g);
+		aCacheG.mDestImage = mDrawCache;
+		aCacheG.mTransX = 0;
+		aCacheG.mTransY = 0;
+		aCacheG.mClipRect = Rect(0, 0, mWidth, mHeight);
+
+		// Cached widgets can be nested, so put back whatever target our parent was drawing into
+		MemoryImage *aPrevTarget = anInterface->GetRenderTarget();
+		anInterface->SetRenderTarget(mDrawCache, true);
+		WidgetContainer::DrawAll(theFlags, &aCacheG);
+		anInterface->SetRenderTarget(aPrevTarget);
+	}
+	else if (mPriority > mWidgetManager->mMinDeferredOverlayPriority)
+		mWidgetManager->FlushDeferredOverlayWidgets(mPriority);
+
+	g->DrawImage(mDrawCache, 0, 0);
+	return true;
+}
+
+void Widget::MarkDirty()
+{
+	mDrawCacheDirty = true;
+	WidgetContainer::MarkDirty();
+}
+
+void Widget::MarkDirtyFull()
+{
+	mDrawCacheDirty = true;
+	WidgetContainer::MarkDirtyFull();
+}
+
+void Widget::MarkDirtyFull(WidgetContainer *theWidget)
+{
+	mDrawCacheDirty = true;
+	WidgetContainer::MarkDirtyFull(theWidget);
+}
+
+void Widget::MarkDirty(WidgetContainer *theWidget)
+{
+	mDrawCacheDirty = true;
+	WidgetContainer::MarkDirty(theWidget);
+}
+
 void Widget::DrawOverlay(Graphics *g)
 {
 }
@@ -156,6 +260,7 @@ void Widget::Resize(int theX, int theY, int theWidth, int theHeight)
 	mY = theY;
 	mWidth = theWidth;
 	mHeight = theHeight;
+	HitBoundsChanged();
 
 	// Mark things dirty that are over the new position
 	MarkDirty();
@@ -414,12 +519,45 @@ bool Widget::Contains(int theX, int theY)
 	return ((theX >= mX) && (theX < mX + mWidth) && (theY >= mY) && (theY < mY + mHeight));
 }
 
+void Widget::SetMouseInsets(const Insets &theInsets)
+{
+	if ((mMouseInsets.mLeft == theInsets.mLeft) && (mMouseInsets.mTop == theInsets.mTop) &&
+		(mMouseInsets.mRight == theInsets.mRight) && (mMouseInsets.mBottom == theInsets.mBottom))
+		return;
+
+	mMouseInsets = theInsets;
+	HitBoundsChanged();
+
+	if (mWidgetManager != NULL)
+		mWidgetManager->RehupMouse();
+}
+
+const Insets &Widget::GetMouseInsets()
+{
+	return mMouseInsets;
+}
+
 Rect Widget::GetInsetRect()
 {
 	return Rect(mX + mMouseInsets.mLeft, mY + mMouseInsets.mTop, mWidth - mMouseInsets.mLeft - mMouseInsets.mRight,
 				mHeight - mMouseInsets.mTop - mMouseInsets.mBottom);
 }
 
+Rect Widget::GetHitBounds()
+{
+	if (mHitBoundsDirty)
+	{
+		WidgetContainer::GetHitBounds();
+
+		// Negative mouse insets can reach outside of the widget
+		Rect anInsetRect = GetInsetRect();
+		if ((anInsetRect.mWidth > 0) && (anInsetRect.mHeight > 0))
+			mHitBounds = mHitBounds.Union(anInsetRect);
+	}
+
+	return mHitBounds;
+}
+
 void Widget::DeferOverlay(int thePriority)
 {
 	mWidgetManager->DeferOverlay(this, thePriority);
@@ -15,6 +15,7 @@ namespace PopLib
 {
 
 class WidgetManager;
+class SDLImage;
 
 typedef std::vector<Color> ColorVector;
 
@@ -29,16 +30,27 @@ class Widget : public WidgetContainer
 	bool mIsOver;
 	bool mHasTransparencies;
 	ColorVector mColors;
-	Insets mMouseInsets;
 	bool mDoFinger;
 	bool mWantsFocus;
 
+	// When set, the widget and its children are rendered once into an offscreen layer which is
+	// then reused until something in the subtree calls MarkDirty. Widgets which animate every
+	// frame or use DeferOverlay shouldn't set this.
+	bool mUseDrawCache;
+	bool mDrawCacheDirty;
+	SDLImage *mDrawCache;
+	int mDrawCacheSize;
+
 	Widget *mTabPrev;
 	Widget *mTabNext;
 
 	static bool mWriteColoredString; // controls whether ^color^ works in calls to WriteString
 
 	void WidgetRemovedHelper();
+	bool DrawCached(ModalFlags *theFlags, Graphics *g);
+
+  protected:
+	Insets mMouseInsets; // only through SetMouseInsets, so the hit-testing grid hears about it
 
   public:
 	Widget();
@@ -59,8 +71,15 @@ class Widget : public WidgetContainer
 	virtual void Resize(int theX, int theY, int theWidth, int theHeight);
 	virtual void Resize(const Rect &theRect);
 	virtual void Move(int theNewX, int theNewY);
+	virtual void SetMouseInsets(const Insets &theInsets);
+	const Insets &GetMouseInsets();
 	virtual bool WantsFocus();
 	virtual void Draw(Graphics *g); // Already translated
+	virtual void DrawAll(ModalFlags *theFlags, Graphics *g);
+	virtual void MarkDirty();
+	virtual void MarkDirtyFull();
+	virtual void MarkDirtyFull(WidgetContainer *theWidget);
+	virtual void MarkDirty(WidgetContainer *theWidget);
 	virtual void DrawOverlay(Graphics *g);
 	virtual void DrawOverlay(Graphics *g, int thePriority);
 	virtual void Update();
@@ -98,6 +117,7 @@ class Widget : public WidgetContainer
 									  int aSpacing);
 	virtual bool Contains(int theX, int theY);
 	virtual Rect GetInsetRect();
+	virtual Rect GetHitBounds();
 	void DeferOverlay(int thePriority = 0);
 
 	//////// Layout functions
@@ -1,6 +1,7 @@
 #include "widgetcontainer.hpp"
 #include "widgetmanager.hpp"
 #include "widget.hpp"
+#include "widgetgrid.hpp"
 #include "debug/debug.hpp"
 #include <algorithm>
 
@@ -23,10 +24,13 @@ WidgetContainer::WidgetContainer()
 	mClip = true;
 	mPriority = 0;
 	mZOrder = 0;
+	mWidgetGrid = NULL;
+	mHitBoundsDirty = true;
 }
 
 WidgetContainer::~WidgetContainer()
 {
+	delete mWidgetGrid;
 }
 
 void WidgetContainer::RemoveAllWidgets(bool doDelete, bool recursive)
@@ -53,6 +57,48 @@ bool WidgetContainer::Intersects(WidgetContainer *theWidget)
 	return GetRect().Intersects(theWidget->GetRect());
 }
 
+Rect WidgetContainer::GetHitBounds()
+{
+	if (mHitBoundsDirty)
+	{
+		mHitBounds = GetRect();
+
+		// Children aren't clipped to us when hit testing, so they can stick out
+		for (WidgetList::iterator anItr = mWidgets.begin(); anItr != mWidgets.end(); ++anItr)
+		{
+			Rect aChildBounds = (*anItr)->GetHitBounds();
+			if ((aChildBounds.mWidth > 0) && (aChildBounds.mHeight > 0))
+			{
+				aChildBounds.Offset(mX, mY);
+				mHitBounds = mHitBounds.Union(aChildBounds);
+			}
+		}
+
+		mHitBoundsDirty = false;
+	}
+
+	return mHitBounds;
+}
+
+void WidgetContainer::HitBoundsChanged()
+{
+	// If we're already dirty then everything above us has already been told
+	if (mHitBoundsDirty)
+		return;
+
+	mHitBoundsDirty = true;
+	if (mParent != NULL)
+		mParent->ChildHitBoundsChanged((Widget *)this);
+}
+
+void WidgetContainer::ChildHitBoundsChanged(Widget *theWidget)
+{
+	if (mWidgetGrid != NULL)
+		mWidgetGrid->WidgetChanged(theWidget);
+
+	HitBoundsChanged();
+}
+
 void WidgetContainer::AddWidget(Widget *theWidget)
 {
 	if (std::find(mWidgets.begin(), mWidgets.end(), theWidget) == mWidgets.end())
@@ -60,6 +106,7 @@ void WidgetContainer::AddWidget(Widget *theWidget)
 		InsertWidgetHelper(mWidgets.end(), theWidget);
 		theWidget->mWidgetManager = mWidgetManager;
 		theWidget->mParent = this;
+		HitBoundsChanged();
 
 		if (mWidgetManager != NULL)
 		{
@@ -85,6 +132,10 @@ void WidgetContainer::RemoveWidget(Widget *theWidget)
 		theWidget->WidgetRemovedHelper();
 		theWidget->mParent = NULL;
 
+		if (mWidgetGrid != NULL)
+			mWidgetGrid->OrderChanged();
+		HitBoundsChanged();
+
 		bool erasedCur = (anItr == mUpdateIterator);
 		mWidgets.erase(anItr++);
 		if (erasedCur)
@@ -97,47 +148,45 @@ void WidgetContainer::RemoveWidget(Widget *theWidget)
 
 Widget *WidgetContainer::GetWidgetAtHelper(int x, int y, int theFlags, bool *found, int *theWidgetX, int *theWidgetY)
 {
-	bool belowModal = false;
+	Widget *aResult;
 
 	ModFlags(theFlags, mWidgetFlagsMod);
 
-	WidgetList::reverse_iterator anItr = mWidgets.rbegin();
-	while (anItr != mWidgets.rend())
+	if ((int)mWidgets.size() >= WIDGETGRID_MIN_WIDGETS)
 	{
-		Widget *aWidget = *anItr;
+		if (mWidgetGrid == NULL)
+			mWidgetGrid = new WidgetGrid(this);
 
-		int aCurFlags = theFlags;
-		ModFlags(aCurFlags, aWidget->mWidgetFlagsMod);
-		if (belowModal)
-			ModFlags(aCurFlags, mWidgetManager->mBelowModalFlagsMod);
+		// Only the widgets whose bounds cover the point, already in top-most first order
+		const WidgetGrid::OrderedWidgetVector &aCandidates = mWidgetGrid->GetWidgetsAt(x, y);
+		int aModalOrder = mWidgetGrid->GetOrder(mWidgetManager->mBaseModalWidget);
 
-		if (aCurFlags & WIDGETFLAGS_ALLOW_MOUSE)
+		for (int i = 0; i < (int)aCandidates.size(); i++)
 		{
-			if (aWidget->mVisible)
+			bool belowModal = aCandidates[i].first < aModalOrder;
+			if (GetWidgetAtChildHelper(aCandidates[i].second, x, y, theFlags, belowModal, &aResult, theWidgetX,
+									   theWidgetY))
 			{
-				bool childFound;
-				Widget *aCheckWidget = aWidget->GetWidgetAtHelper(x - aWidget->mX, y - aWidget->mY, aCurFlags,
-																  &childFound, theWidgetX, theWidgetY);
-				if ((aCheckWidget != NULL) || (childFound))
-				{
-					*found = true;
-					return aCheckWidget;
-				}
+				*found = true;
+				return aResult;
+			}
+		}
 
-				if ((aWidget->mMouseVisible) && (aWidget->GetInsetRect().Contains(x, y)))
-				{
-					*found = true;
+		*found = false;
+		return NULL;
+	}
 
-					if (aWidget->IsPointVisible(x - aWidget->mX, y - aWidget->mY))
-					{
-						if (theWidgetX)
-							*theWidgetX = x - aWidget->mX;
-						if (theWidgetY)
-							*theWidgetY = y - aWidget->mY;
-						return aWidget;
-					}
-				}
-			}
+	bool belowModal = false;
+
+	WidgetList::reverse_iterator anItr = mWidgets.rbegin();
+	while (anItr != mWidgets.rend())
+	{
+		Widget *aWidget = *anItr;
+
+		if (GetWidgetAtChildHelper(aWidget, x, y, theFlags, belowModal, &aResult, theWidgetX, theWidgetY))
+		{
+			*found = true;
+			return aResult;
 		}
 
 		belowModal |= aWidget == mWidgetManager->mBaseModalWidget;
@@ -149,6 +198,43 @@ Widget *WidgetContainer::GetWidgetAtHelper(int x, int y, int theFlags, bool *fou
 	return NULL;
 }
 
+bool WidgetContainer::GetWidgetAtChildHelper(Widget *theWidget, int x, int y, int theFlags, bool belowModal,
+											 Widget **theResult, int *theWidgetX, int *theWidgetY)
+{
+	*theResult = NULL;
+
+	int aCurFlags = theFlags;
+	ModFlags(aCurFlags, theWidget->mWidgetFlagsMod);
+	if (belowModal)
+		ModFlags(aCurFlags, mWidgetManager->mBelowModalFlagsMod);
+
+	if ((aCurFlags & WIDGETFLAGS_ALLOW_MOUSE) && (theWidget->mVisible))
+	{
+		bool childFound;
+		Widget *aCheckWidget = theWidget->GetWidgetAtHelper(x - theWidget->mX, y - theWidget->mY, aCurFlags,
+															&childFound, theWidgetX, theWidgetY);
+		if ((aCheckWidget != NULL) || (childFound))
+		{
+			*theResult = aCheckWidget;
+			return true;
+		}
+
+		// A point that isn't visible falls through to whatever is underneath
+		if ((theWidget->mMouseVisible) && (theWidget->GetInsetRect().Contains(x, y)) &&
+			(theWidget->IsPointVisible(x - theWidget->mX, y - theWidget->mY)))
+		{
+			if (theWidgetX)
+				*theWidgetX = x - theWidget->mX;
+			if (theWidgetY)
+				*theWidgetY = y - theWidget->mY;
+			*theResult = theWidget;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool WidgetContainer::IsBelowHelper(Widget *theWidget1, Widget *theWidget2, bool *found)
 {
 	WidgetList::iterator anItr = mWidgets.begin();
@@ -198,6 +284,9 @@ void WidgetContainer::MarkAllDirty()
 
 void WidgetContainer::InsertWidgetHelper(const WidgetList::iterator &where, Widget *theWidget)
 {
+	if (mWidgetGrid != NULL)
+		mWidgetGrid->OrderChanged();
+
 	// Search forwards
 	WidgetList::iterator anItr = where;
 	while (anItr != mWidgets.end())
@@ -14,6 +14,7 @@ namespace PopLib
 class Graphics;
 class Widget;
 class WidgetManager;
+class WidgetGrid;
 
 typedef std::list<Widget *> WidgetList;
 
@@ -39,8 +40,14 @@ class WidgetContainer
 	int mPriority;
 	int mZOrder;
 
+	WidgetGrid *mWidgetGrid; // only built once there are enough children to make it worthwhile
+	Rect mHitBounds;		 // in parent coordinates, covers all children too
+	bool mHitBoundsDirty;
+
   public:
 	Widget *GetWidgetAtHelper(int x, int y, int theFlags, bool *found, int *theWidgetX, int *theWidgetY);
+	bool GetWidgetAtChildHelper(Widget *theWidget, int x, int y, int theFlags, bool belowModal, Widget **theResult,
+								int *theWidgetX, int *theWidgetY);
 	bool IsBelowHelper(Widget *theWidget1, Widget *theWidget2, bool *found);
 	void InsertWidgetHelper(const WidgetList::iterator &where, Widget *theWidget);
 
@@ -50,6 +57,9 @@ class WidgetContainer
 
 	virtual Rect GetRect();
 	virtual bool Intersects(WidgetContainer *theWidget);
+	virtual Rect GetHitBounds();
+	void HitBoundsChanged();
+	void ChildHitBoundsChanged(Widget *theWidget);
 
 	virtual void AddWidget(Widget *theWidget);
 	virtual void RemoveWidget(Widget *theWidget);
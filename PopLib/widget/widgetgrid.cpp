@@ -0,0 +1,223 @@
+#include "widgetgrid.hpp"
+#include "widgetcontainer.hpp"
+#include "widget.hpp"
+
+using namespace PopLib;
+
+static bool OrderedWidgetGreater(const WidgetGrid::OrderedWidget &theA, const WidgetGrid::OrderedWidget &theB)
+{
+	return theA.first > theB.first;
+}
+
+WidgetGrid::WidgetGrid(WidgetContainer *theContainer)
+{
+	mContainer = theContainer;
+	mNeedsRebuild = true;
+	mCellSize = 1;
+	mCols = 0;
+	mRows = 0;
+}
+
+WidgetGrid::~WidgetGrid()
+{
+}
+
+void WidgetGrid::OrderChanged()
+{
+	// Adding, removing or reordering renumbers everything, so just start over the next time we're asked
+	mNeedsRebuild = true;
+	mPendingWidgets.clear();
+}
+
+void WidgetGrid::WidgetChanged(Widget *theWidget)
+{
+	if (!mNeedsRebuild)
+		mPendingWidgets.push_back(theWidget);
+}
+
+int WidgetGrid::GetOrder(Widget *theWidget)
+{
+	EntryMap::iterator anItr = mEntries.find(theWidget);
+	if (anItr == mEntries.end())
+		return -1;
+	return anItr->second.mOrder;
+}
+
+bool WidgetGrid::GetCellRange(const Rect &theRect, int &theLeft, int &theTop, int &theRight, int &theBottom)
+{
+	theLeft = (theRect.mX - mGridRect.mX) / mCellSize;
+	theTop = (theRect.mY - mGridRect.mY) / mCellSize;
+	theRight = (theRect.mX + theRect.mWidth - 1 - mGridRect.mX) / mCellSize;
+	theBottom = (theRect.mY + theRect.mHeight - 1 - mGridRect.mY) / mCellSize;
+
+	return (theRect.mX >= mGridRect.mX) && (theRect.mY >= mGridRect.mY) && (theRight < mCols) && (theBottom < mRows);
+}
+
+void WidgetGrid::AddEntry(Widget *theWidget, Entry &theEntry)
+{
+	OrderedWidget anOrderedWidget(theEntry.mOrder, theWidget);
+
+	theEntry.mOverflow = false;
+	if ((theEntry.mBounds.mWidth <= 0) || (theEntry.mBounds.mHeight <= 0))
+		return; // nothing can ever be under it
+
+	int aLeft, aTop, aRight, aBottom;
+	bool inGrid = GetCellRange(theEntry.mBounds, aLeft, aTop, aRight, aBottom);
+
+	// Huge widgets (backgrounds, full screen overlays) would end up in most of the cells, so keep them to the side
+	if ((!inGrid) || ((aRight - aLeft + 1) * (aBottom - aTop + 1) > 16))
+	{
+		theEntry.mOverflow = true;
+		mOverflow.insert(std::lower_bound(mOverflow.begin(), mOverflow.end(), anOrderedWidget, OrderedWidgetGreater),
+						 anOrderedWidget);
+		return;
+	}
+
+	for (int aRow = aTop; aRow <= aBottom; aRow++)
+	{
+		for (int aCol = aLeft; aCol <= aRight; aCol++)
+		{
+			OrderedWidgetVector &aCell = mCells[aRow * mCols + aCol];
+			aCell.insert(std::lower_bound(aCell.begin(), aCell.end(), anOrderedWidget, OrderedWidgetGreater),
+						 anOrderedWidget);
+		}
+	}
+}
+
+void WidgetGrid::RemoveEntry(Widget *theWidget, Entry &theEntry)
+{
+	OrderedWidget anOrderedWidget(theEntry.mOrder, theWidget);
+
+	if (theEntry.mOverflow)
+	{
+		OrderedWidgetVector::iterator anItr =
+			std::lower_bound(mOverflow.begin(), mOverflow.end(), anOrderedWidget, OrderedWidgetGreater);
+		if ((anItr != mOverflow.end()) && (anItr->second == theWidget))
+			mOverflow.erase(anItr);
+		return;
+	}
+
+	if ((theEntry.mBounds.mWidth <= 0) || (theEntry.mBounds.mHeight <= 0))
+		return;
+
+	int aLeft, aTop, aRight, aBottom;
+	GetCellRange(theEntry.mBounds, aLeft, aTop, aRight, aBottom);
+
+	for (int aRow = aTop; aRow <= aBottom; aRow++)
+	{
+		for (int aCol = aLeft; aCol <= aRight; aCol++)
+		{
+			OrderedWidgetVector &aCell = mCells[aRow * mCols + aCol];
+			OrderedWidgetVector::iterator anItr =
+				std::lower_bound(aCell.begin(), aCell.end(), anOrderedWidget, OrderedWidgetGreater);
+			if ((anItr != aCell.end()) && (anItr->second == theWidget))
+				aCell.erase(anItr);
+		}
+	}
+}
+
+void WidgetGrid::Rebuild()
+{
+	mNeedsRebuild = false;
+	mPendingWidgets.clear();
+	mEntries.clear();
+	mOverflow.clear();
+	mCells.clear();
+
+	int aNumWidgets = (int)mContainer->mWidgets.size();
+	mEntries.reserve(aNumWidgets);
+
+	// Size the grid to cover the container and all of the children
+	mGridRect = Rect(0, 0, mContainer->mWidth, mContainer->mHeight);
+
+	int anOrder = 0;
+	for (WidgetList::iterator anItr = mContainer->mWidgets.begin(); anItr != mContainer->mWidgets.end(); ++anItr)
+	{
+		Entry &anEntry = mEntries[*anItr];
+		anEntry.mOrder = anOrder++;
+		anEntry.mBounds = (*anItr)->GetHitBounds();
+		anEntry.mOverflow = false;
+
+		if ((anEntry.mBounds.mWidth > 0) && (anEntry.mBounds.mHeight > 0))
+			mGridRect = mGridRect.Union(anEntry.mBounds);
+	}
+
+	// Aim for roughly one widget per cell
+	int aCellsPerSide = std::max(1, std::min(128, (int)std::ceil(std::sqrt((double)aNumWidgets))));
+	mCellSize = std::max(8, std::max(mGridRect.mWidth, mGridRect.mHeight) / aCellsPerSide + 1);
+	mCols = std::max(1, (mGridRect.mWidth + mCellSize - 1) / mCellSize);
+	mRows = std::max(1, (mGridRect.mHeight + mCellSize - 1) / mCellSize);
+	mCells.resize(mCols * mRows);
+
+	// Going from the top down keeps every bucket sorted without any searching
+	for (WidgetList::reverse_iterator anItr = mContainer->mWidgets.rbegin(); anItr != mContainer->mWidgets.rend();
+		 ++anItr)
+	{
+		Widget *aWidget = *anItr;
+		Entry &anEntry = mEntries[aWidget];
+
+		anEntry.mOverflow = false;
+		if ((anEntry.mBounds.mWidth <= 0) || (anEntry.mBounds.mHeight <= 0))
+			continue;
+
+		int aLeft, aTop, aRight, aBottom;
+		GetCellRange(anEntry.mBounds, aLeft, aTop, aRight, aBottom);
+
+		if ((aRight - aLeft + 1) * (aBottom - aTop + 1) > 16)
+		{
+			anEntry.mOverflow = true;
+			mOverflow.push_back(OrderedWidget(anEntry.mOrder, aWidget));
+			continue;
+		}
+
+		for (int aRow = aTop; aRow <= aBottom; aRow++)
+			for (int aCol = aLeft; aCol <= aRight; aCol++)
+				mCells[aRow * mCols + aCol].push_back(OrderedWidget(anEntry.mOrder, aWidget));
+	}
+}
+
+void WidgetGrid::ProcessPending()
+{
+	for (int i = 0; i < (int)mPendingWidgets.size(); i++)
+	{
+		Widget *aWidget = mPendingWidgets[i];
+
+		EntryMap::iterator anItr = mEntries.find(aWidget);
+		if (anItr == mEntries.end())
+			continue;
+
+		Entry &anEntry = anItr->second;
+		Rect aBounds = aWidget->GetHitBounds();
+		if (aBounds == anEntry.mBounds)
+			continue;
+
+		RemoveEntry(aWidget, anEntry);
+		anEntry.mBounds = aBounds;
+		AddEntry(aWidget, anEntry);
+	}
+
+	mPendingWidgets.clear();
+}
+
+const WidgetGrid::OrderedWidgetVector &WidgetGrid::GetWidgetsAt(int x, int y)
+{
+	if (mNeedsRebuild)
+		Rebuild();
+	else if (!mPendingWidgets.empty())
+		ProcessPending();
+
+	mCandidates.clear();
+
+	if (mGridRect.Contains(x, y))
+	{
+		const OrderedWidgetVector &aCell =
+			mCells[((y - mGridRect.mY) / mCellSize) * mCols + (x - mGridRect.mX) / mCellSize];
+		mCandidates.resize(aCell.size() + mOverflow.size());
+		std::merge(aCell.begin(), aCell.end(), mOverflow.begin(), mOverflow.end(), mCandidates.begin(),
+				   OrderedWidgetGreater);
+	}
+	else
+		mCandidates = mOverflow;
+
+	return mCandidates;
+}
@@ -0,0 +1,74 @@
+#ifndef __WIDGETGRID_HPP__
+#define __WIDGETGRID_HPP__
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "common.hpp"
+#include "math/rect.hpp"
+
+#include <unordered_map>
+
+namespace PopLib
+{
+
+class Widget;
+class WidgetContainer;
+
+// Containers with fewer children than this are just walked linearly
+const int WIDGETGRID_MIN_WIDGETS = 64;
+
+// Uniform grid over the children of a WidgetContainer, used to find the widgets that could be under
+// a point without walking the entire child list. Every child is bucketed by its hit bounds (its own
+// rect, mouse insets, and the bounds of all of its descendants), and each bucket is kept sorted from
+// top-most to bottom-most so lookups come back in the same order the child list would be walked in.
+class WidgetGrid
+{
+  public:
+	typedef std::pair<int, Widget *> OrderedWidget; // z-order index into mWidgets, widget
+	typedef std::vector<OrderedWidget> OrderedWidgetVector;
+
+	struct Entry
+	{
+		int mOrder;
+		Rect mBounds;
+		bool mOverflow; // bucketed in mOverflow rather than in the cells
+	};
+
+	typedef std::unordered_map<Widget *, Entry> EntryMap;
+
+  public:
+	WidgetContainer *mContainer;
+	EntryMap mEntries;
+	std::vector<OrderedWidgetVector> mCells;
+	OrderedWidgetVector mOverflow; // widgets outside the grid area, or too large to bucket
+	std::vector<Widget *> mPendingWidgets;
+	OrderedWidgetVector mCandidates;
+	bool mNeedsRebuild;
+
+	Rect mGridRect;
+	int mCellSize;
+	int mCols;
+	int mRows;
+
+  protected:
+	void Rebuild();
+	void ProcessPending();
+	void AddEntry(Widget *theWidget, Entry &theEntry);
+	void RemoveEntry(Widget *theWidget, Entry &theEntry);
+	bool GetCellRange(const Rect &theRect, int &theLeft, int &theTop, int &theRight, int &theBottom);
+
+  public:
+	WidgetGrid(WidgetContainer *theContainer);
+	virtual ~WidgetGrid();
+
+	void OrderChanged();
+	void WidgetChanged(Widget *theWidget);
+
+	int GetOrder(Widget *theWidget);
+	const OrderedWidgetVector &GetWidgetsAt(int x, int y);
+};
+
+} // namespace PopLib
+
+#endif // __WIDGETGRID_HPP__
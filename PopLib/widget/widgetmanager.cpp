@@ -35,6 +35,9 @@ WidgetManager::WidgetManager(AppBase *theApp)
 	mActualDownButtons = 0;
 	mWidgetFlags =
 		WIDGETFLAGS_UPDATE | WIDGETFLAGS_DRAW | WIDGETFLAGS_CLIP | WIDGETFLAGS_ALLOW_MOUSE | WIDGETFLAGS_ALLOW_FOCUS;
+	mDrawCacheBudget = 32 * 1024 * 1024;
+	mDrawCacheMemUsed = 0;
+	mUpdateInterpolation = 0.0f;
 
 	for (int i = 0; i < 0xFF; i++)
 		mKeyDown[i] = false;
@@ -47,6 +50,7 @@ WidgetManager::~WidgetManager()
 
 void WidgetManager::FreeResources()
 {
+	ReleaseAllDrawCaches();
 }
 
 void WidgetManager::DisableWidget(Widget *theWidget)
@@ -176,6 +180,59 @@ void WidgetManager::FlushDeferredOverlayWidgets(int theMaxPriority)
 	}
 }
 
+bool WidgetManager::ReserveDrawCache(Widget *theWidget, int theBytes)
+{
+	if (theBytes > mDrawCacheBudget)
+		return false;
+
+	// Evict the least recently drawn layers until the new one fits
+	while ((mDrawCacheMemUsed + theBytes > mDrawCacheBudget) && (!mDrawCacheWidgets.empty()))
+		ReleaseDrawCache(mDrawCacheWidgets.back());
+
+	mDrawCacheMemUsed += theBytes;
+	theWidget->mDrawCacheSize = theBytes;
+	mDrawCacheWidgets.push_front(theWidget);
+	return true;
+}
+
+void WidgetManager::TouchDrawCache(Widget *theWidget)
+{
+	if ((!mDrawCacheWidgets.empty()) && (mDrawCacheWidgets.front() == theWidget))
+		return;
+
+	WidgetList::iterator anItr = std::find(mDrawCacheWidgets.begin(), mDrawCacheWidgets.end(), theWidget);
+	if (anItr != mDrawCacheWidgets.end())
+		mDrawCacheWidgets.splice(mDrawCacheWidgets.begin(), mDrawCacheWidgets, anItr);
+}
+
+void WidgetManager::ReleaseDrawCache(Widget *theWidget)
+{
+	WidgetList::iterator anItr = std::find(mDrawCacheWidgets.begin(), mDrawCacheWidgets.end(), theWidget);
+	if (anItr != mDrawCacheWidgets.end())
+	{
+		mDrawCacheWidgets.erase(anItr);
+		mDrawCacheMemUsed -= theWidget->mDrawCacheSize;
+	}
+
+	delete theWidget->mDrawCache;
+	theWidget->mDrawCache = NULL;
+	theWidget->mDrawCacheSize = 0;
+	theWidget->mDrawCacheDirty = true;
+}
+
+void WidgetManager::ReleaseAllDrawCaches()
+{
+	while (!mDrawCacheWidgets.empty())
+		ReleaseDrawCache(mDrawCacheWidgets.front());
+}
+
+// The textures are still there but their contents may not be, after the renderer reset its targets
+void WidgetManager::InvalidateDrawCaches()
+{
+	for (WidgetList::iterator anItr = mDrawCacheWidgets.begin(); anItr != mDrawCacheWidgets.end(); ++anItr)
+		(*anItr)->mDrawCacheDirty = true;
+}
+
 void WidgetManager::DoMouseUps(Widget *theWidget, ulong theDownCode)
 {
 	int aClickCountTable[3] = {1, -1, 3};
@@ -475,10 +532,12 @@ bool WidgetManager::UpdateFrame()
 	return mDirty;
 }
 
-bool WidgetManager::UpdateFrameF(float theFrac)
+bool WidgetManager::UpdateFrameF(float theFrac, float theInterpolation)
 {
 	AUTO_PERF("WidgetManager::UpdateFrame");
 
+	mUpdateInterpolation = theInterpolation;
+
 	ModalFlags aModalFlags;
 	InitModalFlags(&aModalFlags);
 
@@ -76,9 +76,15 @@ class WidgetManager : public WidgetContainer
 
 	bool mKeyDown[0xFF];
 	int mLastDownButtonId;
+	float mUpdateInterpolation; // how far the coming draw is into the next fixed update, 0 to 1, for UpdateF and Draw
 
 	int mWidgetFlags;
 
+	// Widgets with mUseDrawCache share this budget (in bytes) for their cached layers
+	int mDrawCacheBudget;
+	int mDrawCacheMemUsed;
+	WidgetList mDrawCacheWidgets; // most recently drawn first
+
   protected:
 	int GetWidgetFlags();
 	void MouseEnter(Widget *theWidget);
@@ -109,9 +115,15 @@ class WidgetManager : public WidgetContainer
 	void DeferOverlay(Widget *theWidget, int thePriority);
 	void FlushDeferredOverlayWidgets(int theMaxPriority);
 
+	bool ReserveDrawCache(Widget *theWidget, int theBytes);
+	void TouchDrawCache(Widget *theWidget);
+	void ReleaseDrawCache(Widget *theWidget);
+	void ReleaseAllDrawCaches();
+	void InvalidateDrawCaches();
+
 	bool DrawScreen();
 	bool UpdateFrame();
-	bool UpdateFrameF(float theFrac);
+	bool UpdateFrameF(float theFrac, float theInterpolation = 0.0f);
 	void SetPopupCommandWidget(Widget *theList);
 	void RemovePopupCommandWidget();
 	void MousePosition(int x, int y);
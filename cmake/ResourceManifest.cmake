@@ -0,0 +1,35 @@
+# Compiles XML_FILE into a binary manifest next to it (resources.xml -> resources.rmf) whenever the
+# XML changes, and makes TARGET depend on it. ResourceManager uses the manifest in place of the XML
+# as long as it was built from the same XML.
+#
+# Passing HEADER <file> also generates constexpr resource handles (see ResourceManager::GetImage(int)),
+# and adds the header's directory to TARGET's include path.
+function(add_resource_manifest TARGET XML_FILE)
+    cmake_parse_arguments(ARG "" "HEADER" "" ${ARGN})
+
+    get_filename_component(XML_PATH "${XML_FILE}" ABSOLUTE)
+    get_filename_component(XML_DIR "${XML_PATH}" DIRECTORY)
+    get_filename_component(XML_NAME "${XML_PATH}" NAME_WE)
+    set(MANIFEST_PATH "${XML_DIR}/${XML_NAME}.rmf")
+
+    set(OUTPUTS "${MANIFEST_PATH}")
+    set(HEADER_ARGS "")
+    if(ARG_HEADER)
+        get_filename_component(HEADER_PATH "${ARG_HEADER}" ABSOLUTE BASE_DIR "${CMAKE_CURRENT_BINARY_DIR}")
+        get_filename_component(HEADER_DIR "${HEADER_PATH}" DIRECTORY)
+        list(APPEND OUTPUTS "${HEADER_PATH}")
+        set(HEADER_ARGS --header "${HEADER_PATH}")
+        target_include_directories(${TARGET} PRIVATE "${HEADER_DIR}")
+    endif()
+
+    add_custom_command(
+        OUTPUT ${OUTPUTS}
+        COMMAND ResManifest "${XML_PATH}" "${MANIFEST_PATH}" ${HEADER_ARGS}
+        DEPENDS "${XML_PATH}" ResManifest
+        COMMENT "Compiling resource manifest ${XML_PATH}"
+        VERBATIM
+    )
+
+    add_custom_target(${TARGET}_ResourceManifest DEPENDS ${OUTPUTS})
+    add_dependencies(${TARGET} ${TARGET}_ResourceManifest)
+endfunction()
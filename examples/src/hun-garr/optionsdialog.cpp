@@ -18,6 +18,11 @@ OptionsDialog::OptionsDialog(Board *b)
 	mContentInsets = Insets(23, 20, 23, 20);
 	mSpaceAfterHeader = 30;
 
+	// Nothing on the dialog box itself changes after it's been laid out, so
+	// let the widget manager render it once and reuse the result each frame.
+	// Anything that calls MarkDirty on us will cause it to be re-rendered.
+	mUseDrawCache = true;
+
 	mBoard = b;
 
 	SetHeaderFont(FONT_DEFAULT);
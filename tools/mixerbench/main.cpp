@@ -0,0 +1,300 @@
+#include "audio/miniaudiomixer.hpp"
+#include "audio/miniaudiosoundmanager.hpp"
+#include "audio/miniaudiomusicinterface.hpp"
+#include "audio/soundinstance.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+using namespace PopLib;
+
+#define BENCH_SAMPLE_RATE 48000
+#define BENCH_BLOCK_FRAMES 512
+#define CHECK_SAMPLE_RATE 44100 // what a MiniaudioSoundManager's own mixer runs at without a device
+#define CHECK_TONE_FRAMES (CHECK_SAMPLE_RATE / 4)
+
+static MixerSound *MakeTestSound(int theChannels, int theSampleRate)
+{
+	MixerSound *aSound = new MixerSound();
+	aSound->mNumFrames = theSampleRate;
+	aSound->mChannels = theChannels;
+	aSound->mSampleRate = theSampleRate;
+	aSound->mSamples.resize((size_t)aSound->mNumFrames * theChannels);
+	for (size_t i = 0; i < aSound->mSamples.size(); i++)
+		aSound->mSamples[i] = (int16_t)(std::sin(i * 0.031) * 8000 + (rand() % 2000) - 1000);
+
+	return aSound;
+}
+
+// Mixes theNumVoices looping voices block by block for about a second and returns how many voices one
+// core could keep up with in real time
+static double MeasureVoicesPerCore(int theNumVoices, const MixerSound *theSound, double thePitch, bool fading)
+{
+	// The command queue makes a mixer a bit big for the stack
+	std::unique_ptr<MiniaudioMixer> aMixer = std::make_unique<MiniaudioMixer>(MixerDevice_None, BENCH_SAMPLE_RATE);
+	for (int i = 0; i < theNumVoices; i++)
+	{
+		float aGainL, aGainR;
+		GetMixerGains(0.5, (i * 1237) % 4000 - 2000, &aGainL, &aGainR);
+
+		int aVoice = i % MAX_CHANNELS;
+		aMixer->PlaySound(aVoice, theSound, true, aGainL, aGainR, thePitch);
+	}
+
+	std::vector<float> aBuffer(BENCH_BLOCK_FRAMES * 2);
+	int aNumBlocks = 0;
+	auto aStart = std::chrono::steady_clock::now();
+	double aSeconds = 0;
+	while (aSeconds < 1.0)
+	{
+		// Keeps every voice in the middle of a fade, which takes it off the SIMD path
+		if (fading && (aNumBlocks % 8 == 0))
+		{
+			for (int i = 0; i < std::min(theNumVoices, MAX_CHANNELS); i++)
+				aMixer->FadeVoice(i, (aNumBlocks % 16 == 0) ? 0.2f : 1.0f, BENCH_BLOCK_FRAMES * 8, false);
+		}
+
+		aMixer->Mix(aBuffer.data(), BENCH_BLOCK_FRAMES);
+		aNumBlocks++;
+		aSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+	}
+
+	double anAudioSeconds = (double)aNumBlocks * BENCH_BLOCK_FRAMES / BENCH_SAMPLE_RATE;
+	return std::min(theNumVoices, MAX_CHANNELS) * anAudioSeconds / aSeconds;
+}
+
+// Lets the checks see what's waiting to be freed
+class CheckMixer : public MiniaudioMixer
+{
+  public:
+	CheckMixer() : MiniaudioMixer(MixerDevice_None, CHECK_SAMPLE_RATE)
+	{
+	}
+
+	int GetNumGarbage()
+	{
+		return (int)mGarbage.size();
+	}
+};
+
+// Mixes theNumFrames block by block, updating theMusic after each block like a game would, and returns
+// the loudest sample
+static float MixPeak(MiniaudioMixer *theMixer, int theNumFrames, MiniaudioMusicInterface *theMusic = nullptr)
+{
+	std::vector<float> aBuffer(BENCH_BLOCK_FRAMES * 2);
+	float aPeak = 0.0f;
+	for (int aFramesLeft = theNumFrames; aFramesLeft > 0; aFramesLeft -= BENCH_BLOCK_FRAMES)
+	{
+		int aNumFrames = std::min(aFramesLeft, BENCH_BLOCK_FRAMES);
+		std::fill(aBuffer.begin(), aBuffer.end(), 0.0f);
+		theMixer->Mix(aBuffer.data(), aNumFrames);
+
+		for (int i = 0; i < aNumFrames * 2; i++)
+			aPeak = std::max(aPeak, std::abs(aBuffer[i]));
+
+		if (theMusic != nullptr)
+			theMusic->Update();
+	}
+
+	return aPeak;
+}
+
+// A quarter second tone as a 16 bit mono WAV, for the checks that load through the sound decoder
+static bool WriteToneFile(const std::string &theFileName)
+{
+	FILE *aFP = fopen(theFileName.c_str(), "wb");
+	if (aFP == nullptr)
+		return false;
+
+	auto aWrite16 = [aFP](uint16_t theValue) { fwrite(&theValue, 2, 1, aFP); };
+	auto aWrite32 = [aFP](uint32_t theValue) { fwrite(&theValue, 4, 1, aFP); };
+
+	uint32_t aDataSize = CHECK_TONE_FRAMES * 2;
+	fwrite("RIFF", 1, 4, aFP);
+	aWrite32(36 + aDataSize);
+	fwrite("WAVEfmt ", 1, 8, aFP);
+	aWrite32(16);
+	aWrite16(1); // PCM
+	aWrite16(1); // mono
+	aWrite32(CHECK_SAMPLE_RATE);
+	aWrite32(CHECK_SAMPLE_RATE * 2);
+	aWrite16(2);
+	aWrite16(16);
+	fwrite("data", 1, 4, aFP);
+	aWrite32(aDataSize);
+	for (int i = 0; i < CHECK_TONE_FRAMES; i++)
+		aWrite16((uint16_t)(int16_t)(std::sin(i * 0.05) * 8000));
+
+	return fclose(aFP) == 0;
+}
+
+static int gNumFailed = 0;
+
+static void Check(bool theResult, const char *theWhat)
+{
+	printf("%-60s %s\n", theWhat, theResult ? "ok" : "FAILED");
+	if (!theResult)
+		gNumFailed++;
+}
+
+// A voice is heard, stops at the end of its sound and then stays quiet
+static void CheckVoice(const MixerSound *theSound)
+{
+	CheckMixer aMixer;
+	uint32_t aTicket = aMixer.PlaySound(0, theSound, false, 1.0f, 1.0f, 1.0);
+
+	Check(MixPeak(&aMixer, BENCH_BLOCK_FRAMES) > 0.01f, "mixer: a voice is mixed in");
+	Check(aMixer.IsVoicePlaying(0, aTicket), "mixer: the voice plays until its sound runs out");
+
+	MixPeak(&aMixer, theSound->mNumFrames);
+	Check(!aMixer.IsVoicePlaying(0, aTicket), "mixer: the voice's ticket finishes at the end");
+	Check(MixPeak(&aMixer, BENCH_BLOCK_FRAMES) == 0.0f, "mixer: nothing is mixed after that");
+}
+
+// A sound handed to DeleteWhenUnused is kept for as long as a voice is on it
+static void CheckGarbage()
+{
+	CheckMixer aMixer;
+	MixerSound *aSound = MakeTestSound(1, CHECK_SAMPLE_RATE);
+	aMixer.PlaySound(0, aSound, true, 1.0f, 1.0f, 1.0);
+	MixPeak(&aMixer, BENCH_BLOCK_FRAMES);
+
+	aMixer.DeleteWhenUnused(aSound);
+	aMixer.CollectGarbage();
+	Check(aMixer.GetNumGarbage() == 1, "mixer: a playing sound isn't freed");
+	Check(MixPeak(&aMixer, BENCH_BLOCK_FRAMES) > 0.01f, "mixer: and is still mixed");
+
+	aMixer.StopVoice(0);
+	MixPeak(&aMixer, BENCH_BLOCK_FRAMES);
+	aMixer.CollectGarbage();
+	Check(aMixer.GetNumGarbage() == 0, "mixer: it's freed once the voice is stopped");
+}
+
+static void CheckSoundManager(const std::string &theTonePath)
+{
+	MiniaudioSoundManager aSoundManager(MixerDevice_None);
+	MiniaudioMixer *aMixer = aSoundManager.mMixer.get();
+
+	Check(aSoundManager.LoadSound(0, theTonePath), "sound manager: loads a WAV");
+
+	SoundInstance *anInstance = aSoundManager.GetSoundInstance(0);
+	Check((anInstance != nullptr) && anInstance->Play(false, false), "sound manager: plays it");
+	if (anInstance == nullptr)
+		return;
+
+	Check(MixPeak(aMixer, BENCH_BLOCK_FRAMES) > 0.01f, "sound manager: it's mixed in");
+	MixPeak(aMixer, CHECK_TONE_FRAMES);
+	Check(!anInstance->IsPlaying(), "sound manager: it stops at the end");
+
+	anInstance->Play(true, false);
+	MixPeak(aMixer, CHECK_TONE_FRAMES * 2);
+	Check(anInstance->IsPlaying(), "sound manager: a looping play keeps going");
+
+	// The instance is stopped but stays usable, and plays the new data
+	Check(aSoundManager.ReloadSound(0, theTonePath), "sound manager: reloads the sound");
+	MixPeak(aMixer, BENCH_BLOCK_FRAMES);
+	Check(!anInstance->IsPlaying(), "sound manager: instances are stopped by a reload");
+	Check(anInstance->Play(false, false) && (MixPeak(aMixer, BENCH_BLOCK_FRAMES) > 0.01f),
+		  "sound manager: and play the reloaded sound");
+
+	Check(!aSoundManager.ReloadSound(0, theTonePath + "_missing"), "sound manager: a failed reload is refused");
+	SoundInstance *anOldInstance = aSoundManager.GetSoundInstance(0);
+	Check(anOldInstance != nullptr, "sound manager: and leaves the old sound in place");
+	if (anOldInstance != nullptr)
+		anOldInstance->Release();
+
+	anInstance->Release();
+}
+
+static void CheckMusic(const std::string &theToneFileName)
+{
+	std::shared_ptr<CheckMixer> aMixer = std::make_shared<CheckMixer>();
+	MiniaudioMusicInterface aMusic(aMixer);
+	if (!aMusic.LoadMusic(0, theToneFileName))
+	{
+		Check(false, "music: loads a WAV");
+		return;
+	}
+
+	aMusic.PlayMusic(0, 0, true);
+	MixerStream *aStream = aMusic.mMusicMap[0]->mStream;
+	Check((aStream != nullptr) && (aStream->GetQueuedFrames() > 0), "music: the stream is filled before it plays");
+	Check(MixPeak(aMixer.get(), BENCH_BLOCK_FRAMES, &aMusic) > 0.01f, "music: it's mixed in");
+
+	MixPeak(aMixer.get(), CHECK_TONE_FRAMES, &aMusic);
+	Check(!aMusic.IsPlaying(0), "music: a song that doesn't loop stops at the end");
+
+	aMusic.PlayMusic(0, 0, false);
+	MixPeak(aMixer.get(), CHECK_TONE_FRAMES * 3, &aMusic);
+	Check(aMusic.IsPlaying(0) && (MixPeak(aMixer.get(), BENCH_BLOCK_FRAMES, &aMusic) > 0.01f),
+		  "music: a looping song keeps going past its end");
+
+	// 0.1 a step from full volume is a 100 ms fade
+	aMusic.FadeOut(0, true, 0.1);
+	MixPeak(aMixer.get(), CHECK_SAMPLE_RATE / 5, &aMusic);
+	Check(!aMusic.IsPlaying(0), "music: fading out to stop stops it");
+	Check(MixPeak(aMixer.get(), BENCH_BLOCK_FRAMES, &aMusic) == 0.0f, "music: nothing is mixed after that");
+	Check(aMixer->GetNumGarbage() == 0, "music: the stopped song's stream is freed");
+}
+
+// Measures MiniaudioMixer throughput in voices per core, checks the mixer, MiniaudioSoundManager and
+// MiniaudioMusicInterface by mixing them by hand, then checks that a mixer on miniaudio's null device runs
+// without any audio hardware.  Returns non-zero if any check fails.
+// Usage: MixerBench [voices]
+int main(int argc, char *argv[])
+{
+	int aNumVoices = (argc > 1) ? std::clamp(atoi(argv[1]), 1, MAX_CHANNELS) : MAX_CHANNELS;
+
+	MixerSound *aMonoSound = MakeTestSound(1, BENCH_SAMPLE_RATE);
+	MixerSound *aStereoSound = MakeTestSound(2, BENCH_SAMPLE_RATE);
+	MixerSound *aLowRateSound = MakeTestSound(1, 22050);
+
+	printf("%-20s %12.0f voices/core\n", "mono", MeasureVoicesPerCore(aNumVoices, aMonoSound, 1.0, false));
+	printf("%-20s %12.0f voices/core\n", "stereo", MeasureVoicesPerCore(aNumVoices, aStereoSound, 1.0, false));
+	printf("%-20s %12.0f voices/core\n", "mono 22050 Hz", MeasureVoicesPerCore(aNumVoices, aLowRateSound, 1.0, false));
+	printf("%-20s %12.0f voices/core\n", "mono pitched", MeasureVoicesPerCore(aNumVoices, aMonoSound, 1.12, false));
+	printf("%-20s %12.0f voices/core\n", "mono fading", MeasureVoicesPerCore(aNumVoices, aMonoSound, 1.0, true));
+
+	std::string aTonePath = (std::filesystem::temp_directory_path() / "mixerbench_tone").string();
+	if (WriteToneFile(aTonePath + ".wav"))
+	{
+		CheckVoice(aMonoSound);
+		CheckGarbage();
+		CheckSoundManager(aTonePath);
+		CheckMusic(aTonePath + ".wav");
+
+		std::error_code anError;
+		std::filesystem::remove(aTonePath + ".wav", anError);
+	}
+	else
+		Check(false, "writing the test tone");
+
+	std::unique_ptr<MiniaudioMixer> aNullMixer = std::make_unique<MiniaudioMixer>(MixerDevice_Null, BENCH_SAMPLE_RATE);
+	if (!aNullMixer->IsRunning())
+	{
+		fprintf(stderr, "null device: failed to start\n");
+		return 1;
+	}
+
+	aNullMixer->PlaySound(0, aMonoSound, true, 1.0f, 1.0f, 1.0);
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+	MixerStats aStats = aNullMixer->GetStats();
+	printf("null device: %llu frames mixed in 0.5 s, %d voice(s)\n", (unsigned long long)aStats.mFramesMixed,
+		   aStats.mActiveVoices);
+
+	// The device thread is still mixing aMonoSound until the mixer is gone
+	aNullMixer.reset();
+
+	delete aMonoSound;
+	delete aStereoSound;
+	delete aLowRateSound;
+	Check(aStats.mFramesMixed > 0, "null device: mixes on its own");
+	return (gNumFailed == 0) ? 0 : 1;
+}
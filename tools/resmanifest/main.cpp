@@ -0,0 +1,62 @@
+#include "resources/resourcemanifest.hpp"
+
+#include <cstdio>
+
+using namespace PopLib;
+
+// Compiles a resources.xml into the binary manifest ResourceManager::ParseResourcesFile picks up
+// in its place, and optionally a header of constexpr resource handles.
+// Usage: ResManifest <resources.xml> [output.rmf] [--header handles.hpp]
+int main(int argc, char *argv[])
+{
+	std::string anXMLFileName;
+	std::string aManifestFileName;
+	std::string aHeaderFileName;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string anArg = argv[i];
+		if ((anArg == "--header") && (i + 1 < argc))
+			aHeaderFileName = argv[++i];
+		else if (anXMLFileName.empty())
+			anXMLFileName = anArg;
+		else if (aManifestFileName.empty())
+			aManifestFileName = anArg;
+		else
+			anXMLFileName.clear();
+	}
+
+	if (anXMLFileName.empty())
+	{
+		fprintf(stderr, "usage: %s <resources.xml> [output.rmf] [--header handles.hpp]\n", argv[0]);
+		return 1;
+	}
+
+	if (aManifestFileName.empty())
+		aManifestFileName = ResourceManifest::GetManifestFileName(anXMLFileName);
+
+	std::string anError;
+	if (!ResourceManifest::Compile(anXMLFileName, aManifestFileName, anError))
+	{
+		fprintf(stderr, "%s: %s\n", anXMLFileName.c_str(), anError.c_str());
+		return 1;
+	}
+
+	if (!aHeaderFileName.empty())
+	{
+		ResourceManifest aManifest;
+		if (!aManifest.Open(aManifestFileName))
+		{
+			fprintf(stderr, "%s: failed to open\n", aManifestFileName.c_str());
+			return 1;
+		}
+
+		if (!aManifest.WriteHandleHeader(aHeaderFileName, anError))
+		{
+			fprintf(stderr, "%s: %s\n", anXMLFileName.c_str(), anError.c_str());
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+#include "widget/widget.hpp"
+#include "widget/widgetmanager.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace PopLib;
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+
+// Only takes clicks inside the circle that fits its bounds, like a round button drawn from an image
+class RoundWidget : public Widget
+{
+  public:
+	virtual bool IsPointVisible(int x, int y)
+	{
+		int aRadius = std::min(mWidth, mHeight) / 2;
+		int aDX = x - mWidth / 2;
+		int aDY = y - mHeight / 2;
+		return aDX * aDX + aDY * aDY <= aRadius * aRadius;
+	}
+};
+
+// What GetWidgetAt should come back with, found by walking every widget from the top down.  Points a
+// widget says aren't visible fall through to the ones underneath.
+static Widget *FindWidgetLinear(WidgetManager *theManager, int x, int y)
+{
+	for (WidgetList::reverse_iterator anItr = theManager->mWidgets.rbegin(); anItr != theManager->mWidgets.rend();
+		 ++anItr)
+	{
+		Widget *aWidget = *anItr;
+		if ((aWidget->mVisible) && (aWidget->mMouseVisible) && (aWidget->GetInsetRect().Contains(x, y)) &&
+			(aWidget->IsPointVisible(x - aWidget->mX, y - aWidget->mY)))
+			return aWidget->mDisabled ? NULL : aWidget;
+	}
+
+	return NULL;
+}
+
+// Times theNumQueries lookups through GetWidgetAt and through a plain walk, and returns how many of them
+// didn't agree
+static int MeasureQueries(WidgetManager *theManager, int theNumQueries)
+{
+	std::vector<int> aPoints(theNumQueries * 2);
+	for (int i = 0; i < theNumQueries; i++)
+	{
+		aPoints[i * 2] = rand() % BENCH_WIDTH;
+		aPoints[i * 2 + 1] = rand() % BENCH_HEIGHT;
+	}
+
+	std::vector<Widget *> aGridResults(theNumQueries);
+	auto aStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < theNumQueries; i++)
+		aGridResults[i] = theManager->GetWidgetAt(aPoints[i * 2], aPoints[i * 2 + 1], NULL, NULL);
+	double aGridSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+
+	int aNumMismatches = 0;
+	aStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < theNumQueries; i++)
+	{
+		if (FindWidgetLinear(theManager, aPoints[i * 2], aPoints[i * 2 + 1]) != aGridResults[i])
+			aNumMismatches++;
+	}
+	double aLinearSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+
+	printf("  GetWidgetAt %8.3f us/query   linear walk %8.3f us/query   %d mismatches\n",
+		   aGridSeconds * 1e6 / theNumQueries, aLinearSeconds * 1e6 / theNumQueries, aNumMismatches);
+	return aNumMismatches;
+}
+
+// Hit-tests a screen full of small widgets, the way a big inventory or level editor would have them.
+// Usage: WidgetBench [widgets] [queries]
+int main(int argc, char *argv[])
+{
+	int aNumWidgets = (argc > 1) ? std::max(1, atoi(argv[1])) : 10000;
+	int aNumQueries = (argc > 2) ? std::max(1, atoi(argv[2])) : 100000;
+
+	srand(1234);
+
+	WidgetManager *aManager = new WidgetManager(NULL);
+	aManager->Resize(Rect(0, 0, BENCH_WIDTH, BENCH_HEIGHT), Rect(0, 0, BENCH_WIDTH, BENCH_HEIGHT));
+
+	std::vector<Widget *> aWidgets;
+	auto aStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < aNumWidgets; i++)
+	{
+		Widget *aWidget = ((i % 4) == 0) ? new RoundWidget() : new Widget();
+		aWidget->Resize(rand() % BENCH_WIDTH, rand() % BENCH_HEIGHT, 16 + rand() % 64, 16 + rand() % 64);
+		aWidget->mMouseVisible = (i % 10) != 0;
+		aManager->AddWidget(aWidget);
+		aWidgets.push_back(aWidget);
+	}
+	double aSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+	printf("%d widgets added in %.2f ms\n", aNumWidgets, aSeconds * 1000.0);
+
+	int aNumMismatches = 0;
+
+	printf("static:\n");
+	aNumMismatches += MeasureQueries(aManager, aNumQueries);
+
+	// A tenth of them move and a few grow their hit area past their edges, as happens every frame in play
+	aStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < aNumWidgets; i += 10)
+	{
+		aWidgets[i]->Move(rand() % BENCH_WIDTH, rand() % BENCH_HEIGHT);
+		if (i + 5 < aNumWidgets)
+			aWidgets[i + 5]->SetMouseInsets(Insets(-24, -24, -24, -24));
+	}
+	aSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+	printf("moved and grew %d widgets in %.3f ms\n", (aNumWidgets + 9) / 10 * 2, aSeconds * 1000.0);
+
+	printf("after moving:\n");
+	aNumMismatches += MeasureQueries(aManager, aNumQueries);
+
+	aManager->RemoveAllWidgets(true);
+	delete aManager;
+
+	return (aNumMismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include "readwrite/xmlparser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace PopLib;
+
+// Times XMLParser over a file, through both NextNode and the XMLElement compatibility path.
+// Usage: XMLBench <file.xml> [passes]
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <file.xml> [passes]\n", argv[0]);
+		return 1;
+	}
+
+	std::string aFileName = argv[1];
+	int aNumPasses = (argc > 2) ? std::max(1, atoi(argv[2])) : 10;
+
+	FILE *aFP = fopen(aFileName.c_str(), "rb");
+	if (aFP == nullptr)
+	{
+		fprintf(stderr, "%s: unable to open\n", aFileName.c_str());
+		return 1;
+	}
+
+	std::string aData;
+	char aBuffer[65536];
+	size_t aCount;
+	while ((aCount = fread(aBuffer, 1, sizeof(aBuffer), aFP)) > 0)
+		aData.append(aBuffer, aCount);
+	fclose(aFP);
+
+	double aMegabytes = aData.size() / (1024.0 * 1024.0);
+
+	for (int aMode = 0; aMode < 2; aMode++)
+	{
+		int aNumNodes = 0;
+		auto aStart = std::chrono::steady_clock::now();
+
+		for (int aPass = 0; aPass < aNumPasses; aPass++)
+		{
+			XMLParser aParser;
+			aParser.OpenBuffer(aData);
+
+			if (aMode == 0)
+			{
+				XMLNodeView aNode;
+				while (aParser.NextNode(aNode))
+					aNumNodes++;
+			}
+			else
+			{
+				XMLElement anElement;
+				while (aParser.NextElement(&anElement))
+					aNumNodes++;
+			}
+
+			if (aParser.HasFailed())
+			{
+				fprintf(stderr, "%s(%d): %s\n", aFileName.c_str(), aParser.GetCurrentLineNum(),
+						aParser.GetErrorText().c_str());
+				return 1;
+			}
+		}
+
+		double aSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+		printf("%-11s %8d nodes  %8.2f ms/pass  %8.1f MB/s\n", (aMode == 0) ? "NextNode" : "NextElement",
+			   aNumNodes / aNumPasses, aSeconds * 1000.0 / aNumPasses, aMegabytes * aNumPasses / aSeconds);
+	}
+
+	return 0;
+}